@@ -96,6 +96,7 @@ namespace GPU_CL{
     CPU_timer = (int*) calloc((CPU_timers+1),sizeof(int)); // setup CPU timers
 
     GPU_limit_max_workgroup_size= 0;    // manually limit max workgroup size
+    GPU_async_kernels           = false;// kernel_run_async waits for kernel completion
 
 
     GPU_kernels = new kernels_hash[HASHES_SIZE];  // Hash for kernels
@@ -1346,12 +1347,7 @@ int             GPU::kernel_run(int kernel_id)
         GPU_kernels[kernel_id].kernel_number_of_starts++;
     } else {
         // run without profiling
-        size_t local_workgroup_size;
-        OpenCL_Check_Error(clGetKernelWorkGroupInfo(GPU_kernels[kernel_id].kernel,GPU_device,CL_KERNEL_WORK_GROUP_SIZE,sizeof(size_t),&local_workgroup_size,NULL),"clGetKernelWorkGroupInfo failed");
-        // limit local_workgroup_size if needed
-        if ((GPU_limit_max_workgroup_size>0) && (GPU_limit_max_workgroup_size<local_workgroup_size)) local_workgroup_size = GPU_limit_max_workgroup_size;
-        local_workgroup_size = (int) (1<<((int) floor(log((double) local_workgroup_size)/log(2.0))));
-        GPU_kernels[kernel_id].local_size[0] = local_workgroup_size;
+        kernel_local_size_setup(kernel_id);
         GPU_error = clEnqueueNDRangeKernel(GPU_queue,GPU_kernels[kernel_id].kernel,GPU_kernels[kernel_id].work_dimensions,NULL,GPU_kernels[kernel_id].global_size,GPU_kernels[kernel_id].local_size, 0, NULL, &kernel_event);
         OpenCL_Check_Error(GPU_error,"clEnqueueNDRangeKernel failed");
         OpenCL_Check_Error(clWaitForEvents(1, &kernel_event),"clWaitForEvents failed");
@@ -1359,9 +1355,23 @@ int             GPU::kernel_run(int kernel_id)
     OpenCL_Check_Error(clFinish(GPU_queue),"clFinish failed");
     return kernel_id;
 }
+void            GPU::kernel_local_size_setup(int kernel_id)
+{
+    size_t local_workgroup_size;
+    OpenCL_Check_Error(clGetKernelWorkGroupInfo(GPU_kernels[kernel_id].kernel,GPU_device,CL_KERNEL_WORK_GROUP_SIZE,sizeof(size_t),&local_workgroup_size,NULL),"clGetKernelWorkGroupInfo failed");
+    // limit local_workgroup_size if needed
+    if ((GPU_limit_max_workgroup_size>0) && (GPU_limit_max_workgroup_size<local_workgroup_size)) local_workgroup_size = GPU_limit_max_workgroup_size;
+    local_workgroup_size = (int) (1<<((int) floor(log((double) local_workgroup_size)/log(2.0))));
+    GPU_kernels[kernel_id].local_size[0] = local_workgroup_size;
+}
 int             GPU::kernel_run_async(int kernel_id)
 {
-    kernel_run(kernel_id);
+    if ((kernel_id==0)||(!GPU_async_kernels)||(GPU_debug->profiling)) return kernel_run(kernel_id);
+    // run without waiting for completion (commands of the in-order queue are finished by any blocking call)
+    kernel_local_size_setup(kernel_id);
+    GPU_error = clEnqueueNDRangeKernel(GPU_queue,GPU_kernels[kernel_id].kernel,GPU_kernels[kernel_id].work_dimensions,NULL,GPU_kernels[kernel_id].global_size,GPU_kernels[kernel_id].local_size, 0, NULL, NULL);
+    OpenCL_Check_Error(GPU_error,"clEnqueueNDRangeKernel failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
     return kernel_id;
 }
 int             GPU::kernel_profile(int kernel_id) {
@@ -1372,6 +1382,29 @@ int             GPU::wait_for_queue_finish(void) {
     OpenCL_Check_Error(clFinish(GPU_queue),"clFinish failed");
     return 0;
 }
+int             GPU::queue_marker(cl_event* event) {
+    // event is completed when all commands queued before the marker are completed
+    GPU_error = clEnqueueMarker(GPU_queue,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueMarker failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
+    return GPU_error;
+}
+bool            GPU::event_complete(cl_event event) {
+    cl_int status = CL_COMPLETE;
+    if (!event) return true;
+    GPU_error = clGetEventInfo(event,CL_EVENT_COMMAND_EXECUTION_STATUS,sizeof(cl_int),&status,NULL);
+    OpenCL_Check_Error(GPU_error,"clGetEventInfo failed");
+    if (GPU_error!=CL_SUCCESS) return true;                     // do not wait for an event which can not be queried
+    if (status<CL_COMPLETE) OpenCL_Check_Error(status,"command terminated");
+    return (status <= CL_COMPLETE);     // negative status - command was terminated with error
+}
+int             GPU::event_wait(cl_event event) {
+    if (!event) return CL_SUCCESS;
+    return clWaitForEvents(1,&event);
+}
+void            GPU::event_release(cl_event event) {
+    if (event) clReleaseEvent(event);
+}
 int             GPU::kernel_get_worksize(int kernel_id){
         size_t result;
     if (GPU_kernels[kernel_id].local_size==NULL)
@@ -1651,6 +1684,17 @@ int             GPU::buffer_wait_for_write(int buffer_id){
     return GPU_error;
 }
 
+int             GPU::buffer_read_async(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* event){
+    GPU_error = clEnqueueReadBuffer(GPU_queue,GPU_buffers[buffer_id].buffer,CL_FALSE,offset,size,ptr,0,NULL,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueReadBuffer failed");
+    return GPU_error;
+}
+int             GPU::buffer_write_async(int buffer_id, const void* ptr, size_t offset, size_t size, cl_event* event){
+    GPU_error = clEnqueueWriteBuffer(GPU_queue,GPU_buffers[buffer_id].buffer,CL_FALSE,offset,size,ptr,0,NULL,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueWriteBuffer failed");
+    return GPU_error;
+}
+
 cl_float4*      GPU::buffer_read_float4(int buffer_id)
 {
     cl_event buffer_event;
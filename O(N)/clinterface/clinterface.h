@@ -155,6 +155,7 @@ class GPU {
             GPU_device_info GPU_info;                       // GPU device info
 
             unsigned int GPU_limit_max_workgroup_size;      // manually limit max workgroup size (0 - do not limit)
+            bool GPU_async_kernels;                         // kernel_run_async does not wait for kernel completion
 
             int GPU_current_kernel;                         // current kernel counter
             int GPU_current_buffer;                         // current buffer counter
@@ -236,8 +237,13 @@ class GPU {
             int     kernel_init_constant(int kernel_id,double* host_ptr);
             int     kernel_run(int kernel_id);
             int     kernel_run_async(int kernel_id);
+           void     kernel_local_size_setup(int kernel_id);
             int     kernel_profile(int kernel_id);
             int     wait_for_queue_finish(void);
+            int     queue_marker(cl_event* event);
+            bool    event_complete(cl_event event);
+     static int     event_wait(cl_event event);
+     static void    event_release(cl_event event);
 
             int     kernel_get_worksize(int kernel_id);
  GPU_time_deviation kernel_get_execution_time(int kernel_id);
@@ -261,6 +267,8 @@ class GPU {
            void     buffer_unmap_profile(int buffer_id);
             int     buffer_wait_for_read(int buffer_id);
             int     buffer_wait_for_write(int buffer_id);
+            int     buffer_read_async(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* event);
+            int     buffer_write_async(int buffer_id, const void* ptr, size_t offset, size_t size, cl_event* event);
             int     buffer_kill(int buffer_id);
  GPU_time_deviation buffer_write_get_time(int buffer_id);
  GPU_time_deviation buffer_read_get_time(int buffer_id);
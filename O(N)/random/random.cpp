@@ -269,7 +269,7 @@ void                PRNG::initialize(void)
 }
 void                PRNG::produce(void)
 {
-        GPU0->kernel_run(PRNG_randoms_kernel_id);
+        GPU0->kernel_run_async(PRNG_randoms_kernel_id);     // blocking unless GPU0->GPU_async_kernels is set
         randoms_produced += run_PRNG->PRNG_samples * 4;
         PRNG_counter++;
 }
@@ -38,6 +38,9 @@
 #include "suncl.h"
 #include "suncpu.h"
 #include "biglattice.h"
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
 
 namespace BIG_LAT{
 using BIG_LAT::BL;
@@ -46,11 +49,26 @@ using SUN_CPU::SU;
 
 #define ND_MAX                32  // maximum dimensions
 
+// wall clock time (in seconds) for scheduler instrumentation
+static double   lattice_wall_time(void){
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return ((double) counter.QuadPart) / ((double) frequency.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return ((double) tv.tv_sec) + 1.0e-6 * ((double) tv.tv_usec);
+#endif
+}
 
                 BL::BL(void){
         big_lattice_parts      = 1; // default number of sublattices
         compute_devices_number = 1; // default number of compute devices
         single_device     = true;   // simulation on single device
+        big_lattice_schedule_time = 0.0;
+        schedule          = NULL;
         global_run        = new model_CL::model::run_parameters;
 }
                 BL::~BL(void){
@@ -64,7 +82,9 @@ using SUN_CPU::SU;
 
     for (int i=0;i<big_lattice_parts;i++){
         if (lattice_data[i]) delete lattice_data[i];
+        if ((schedule)&&(schedule[i])) delete schedule[i];
     }
+    if (schedule) delete[] schedule;
     if (compute_devices) delete[] compute_devices;
     if (models) delete[] models;
     if (SUNcpu) delete[] SUNcpu;
@@ -74,10 +94,30 @@ using SUN_CPU::SU;
                 BL::lattice_data_buffers::lattice_data_buffers(void){
     plattice_table_float  = NULL;
     plattice_table_double = NULL;
+    pfaces                = NULL;
 }
                 BL::lattice_data_buffers::~lattice_data_buffers(void){
+    if (pfaces) FREE(pfaces);
 
                   
+}
+                BL::lattice_part_schedule::lattice_part_schedule(void){
+    sweeps_done  = 0;
+    running      = false;
+    update_event = NULL;
+    faces_event  = NULL;
+    pfaces       = NULL;
+    queued_time  = 0.0;
+    free_time    = 0.0;
+    busy_time    = 0.0;
+    idle_time    = 0.0;
+}
+                BL::lattice_part_schedule::~lattice_part_schedule(void){
+    GPU_CL::GPU::event_wait(update_event);
+    GPU_CL::GPU::event_wait(faces_event);
+    GPU_CL::GPU::event_release(update_event);
+    GPU_CL::GPU::event_release(faces_event);
+    if (pfaces) FREE(pfaces);
 }
                 BL::lattice_devices::lattice_devices(void){
         lattice_domain_size = new int[ND_MAX];
@@ -248,7 +288,22 @@ void            BL::simulate(void){
         if ((models[idx]->run->INIT!=0)&&(models[idx]->ITER_counter==0)) models[idx]->ITER_counter = 1;
     }
 
+    // parts are updated by event-driven scheduler (if possible) instead of red-green passes
+    bool scheduled = lattice_schedule_enabled();
+    if (scheduled) lattice_schedule_init();
+
     // perform thermalization
+    // (parts resumed from different states are thermalized by red-green passes)
+    bool thermalization_scheduled = scheduled;
+    unsigned int NAV_start = models[lattice_data[0]->models_index]->NAV_counter;
+    for (int i=1;i<big_lattice_parts;i++)
+        if (models[lattice_data[i]->models_index]->NAV_counter!=NAV_start) thermalization_scheduled = false;
+    if (thermalization_scheduled) {
+        if (NAV_start<(unsigned int) global_run->NAV) lattice_schedule_sweeps((unsigned int) global_run->NAV - NAV_start);
+        for (int i=0;i<big_lattice_parts;i++)
+            models[lattice_data[i]->models_index]->NAV_counter = global_run->NAV;
+        printf("\rGPU thermalization [%i]",global_run->NAV);
+    } else
     for (unsigned int j=0; j<(unsigned int) global_run->NAV; j++){
         for (int i=0;i<big_lattice_red_passes;  i++) {
             int i_part = i;
@@ -290,6 +345,12 @@ void            BL::simulate(void){
 
     // perform working cycles
     for (unsigned int t=1; t<(unsigned int) global_run->ITER; t++){ // zero measurement - on initial configuration!!!
+        // all parts have to be at working cycle t (parts resumed at later cycles are skipped by red-green passes)
+        bool iteration_scheduled = ((scheduled)&&(global_run->NITER>0));
+        for (int i=0;i<big_lattice_parts;i++)
+            if (models[lattice_data[i]->models_index]->ITER_counter!=t) iteration_scheduled = false;
+        if (iteration_scheduled) lattice_schedule_sweeps((unsigned int) global_run->NITER);
+        else
         for (int j=0; j<global_run->NITER; j++){
             for (int i=0;i<big_lattice_red_passes;  i++) {
                 int i_part = i;
@@ -367,6 +428,8 @@ void            BL::simulate(void){
 
     }
 
+    if (scheduled) lattice_schedule_report();
+
     for (int i=0;i<compute_devices_number;i++){
         models[i]->lattice_print_elapsed_time();
         models[i]->lattice_analysis();
@@ -469,6 +532,26 @@ void            BL::lattice_get_high_boundary(int* i){
         }
 }
 
+void            BL::lattice_exchange_halos(int* i){
+        // faces of both neighbours are read from their devices to host and written to halos of part I
+        // (the same slices as lattice_get_low_boundary and lattice_get_high_boundary copy through host tables)
+        int idx = lattice_data[(*i)]->models_index;
+        int i_low  = ((*i) + big_lattice_parts - 1) % big_lattice_parts;
+        int i_high = ((*i) + 1) % big_lattice_parts;
+        int neighbours[2] = {i_low, i_high};
+        for (int k=0;k<2;k++){
+            lattice_data_buffers* lat = lattice_data[neighbours[k]];
+            int idx_neighbour = lat->models_index;
+            cl_event faces_event = NULL;
+            if (!lat->pfaces) lat->pfaces = malloc(2 * models[idx_neighbour]->lattice_face_size());
+            models[idx_neighbour]->lattice_faces_read_async(lat->pfaces,&faces_event);
+            GPU_CL::GPU::event_wait(faces_event);
+            GPU_CL::GPU::event_release(faces_event);
+        }
+        models[idx]->lattice_halos_write_async(lattice_data[i_low]->pfaces,lattice_data[i_high]->pfaces);
+        models[idx]->lattice_wait_for_queue_finish();   // faces of neighbours are read again for the next part
+}
+
 void            BL::lattice_setup_lattice_pointer_initial(int* i){
         models[lattice_data[(*i)]->models_index]->lattice_pointer_initial = (unsigned int*) models[lattice_data[(*i)]->models_index]->lattice_table_map_async();
 }
@@ -550,6 +633,9 @@ void            BL::lattice_copy_boundaries_red(int i){
                     lattice_get_high_boundary(&i_part);
                     // 3) copy lattice part from [host] to [GPU]
                     lattice_copy_host_to_GPU(lattice_data[i_part]);  // host->GPU
+                } else {
+                    // part stays on its device: halos are written directly from faces of neighbours
+                    lattice_exchange_halos(&i_part);
                 }
             }
         }
@@ -566,6 +652,9 @@ void            BL::lattice_copy_boundaries_green(int i){
                     lattice_get_high_boundary(&i_part);
                     // 3) copy lattice part from [host] to [GPU]
                     lattice_copy_host_to_GPU(lattice_data[i_part]);  // host->GPU
+                } else {
+                    // part stays on its device: halos are written directly from faces of neighbours
+                    lattice_exchange_halos(&i_part);
                 }
             }
         }
@@ -640,4 +729,117 @@ void            BL::lattice_orthogonalization_green(int i){
         }
 }
 
+bool            BL::lattice_schedule_enabled(void){
+    if ((!global_run->big_lattice_scheduler)||(big_lattice_parts<2)) return false;
+    for (int i=0;i<big_lattice_parts;i++)
+        if (!lattice_data[i]->one_device_one_part) return false;  // parts sharing device are swapped through host by red-green passes
+    return true;
+}
+void            BL::lattice_schedule_init(void){
+    if (!schedule) {
+        schedule = new lattice_part_schedule*[big_lattice_parts];
+        for (int i=0;i<big_lattice_parts;i++) schedule[i] = new lattice_part_schedule;
+    }
+    for (int i=0;i<big_lattice_parts;i++){
+        int idx = lattice_data[i]->models_index;
+        if (!schedule[i]->pfaces) schedule[i]->pfaces = malloc(2 * models[idx]->lattice_face_size());
+        // faces of the initial configuration
+        models[idx]->lattice_faces_read_async(schedule[i]->pfaces,&schedule[i]->faces_event);
+    }
+}
+bool            BL::lattice_schedule_ready(int i){
+    // of two neighbouring parts the red one (even) is updated first, of two parts of the same colour - the lower one,
+    // so part i may start its next sweep when neighbours updated first have finished the same sweep,
+    // the other neighbours have finished the previous one, and their boundary faces are on host
+    lattice_part_schedule* part = schedule[i];
+    if (part->running) return false;
+    int neighbours[2] = {(i + big_lattice_parts - 1) % big_lattice_parts, (i + 1) % big_lattice_parts};
+    for (int k=0;k<2;k++){
+        int j = neighbours[k];
+        bool j_first = ((j & 1) < (i & 1)) || (((j & 1) == (i & 1)) && (j < i));
+        unsigned int required = part->sweeps_done + ((j_first) ? 1 : 0);
+        if ((schedule[j]->running)||(schedule[j]->sweeps_done!=required)) return false;
+        if (!models[lattice_data[j]->models_index]->GPU0->event_complete(schedule[j]->faces_event)) return false;
+    }
+    return true;
+}
+void            BL::lattice_schedule_sweeps(unsigned int sweeps){
+    // each part's sweep waits only on boundary faces of its neighbours: parts without common face are updated
+    // concurrently, reading of faces to host and writing of halos are queued asynchronously between kernels
+    double start = lattice_wall_time();
+    unsigned int target = schedule[0]->sweeps_done + sweeps;
+    int finished = 0;
+    for (int i=0;i<big_lattice_parts;i++) {
+        schedule[i]->free_time = start;
+        models[lattice_data[i]->models_index]->GPU0->GPU_async_kernels = true;  // kernels and PRNG production do not block host
+    }
+
+    while (finished<big_lattice_parts){
+        bool progress = false;
+        for (int i=0;i<big_lattice_parts;i++){
+            lattice_part_schedule* part = schedule[i];
+            int idx = lattice_data[i]->models_index;
+            if ((part->running)&&(models[idx]->GPU0->event_complete(part->update_event))){
+                double now = lattice_wall_time();
+                GPU_CL::GPU::event_release(part->update_event);
+                part->update_event = NULL;
+                part->running      = false;
+                part->busy_time   += now - part->queued_time;
+                part->free_time    = now;
+                part->sweeps_done++;
+                if (part->sweeps_done==target) finished++;
+                // faces of the updated part are sent to neighbours
+                GPU_CL::GPU::event_release(part->faces_event);
+                models[idx]->lattice_faces_read_async(part->pfaces,&part->faces_event);
+                progress = true;
+            }
+            if ((part->sweeps_done<target)&&(lattice_schedule_ready(i))){
+                int i_low  = (i + big_lattice_parts - 1) % big_lattice_parts;
+                int i_high = (i + 1) % big_lattice_parts;
+                double now = lattice_wall_time();
+                part->idle_time += now - part->free_time;
+                models[idx]->lattice_halos_write_async(schedule[i_low]->pfaces,schedule[i_high]->pfaces);
+                models[idx]->run->part_number = lattice_data[i]->part_number;
+                models[idx]->lattice_update();
+                models[idx]->lattice_orthogonalization();
+                models[idx]->lattice_queue_marker(&part->update_event);
+                part->queued_time = now;
+                part->running     = true;
+                progress = true;
+            }
+        }
+        if (!progress) {
+            // nothing to do - wait for any queued sweep (or for faces if no sweep is queued)
+            int i_wait = -1;
+            for (int i=0;(i<big_lattice_parts)&&(i_wait<0);i++) if (schedule[i]->running) i_wait = i;
+            if (i_wait>=0) GPU_CL::GPU::event_wait(schedule[i_wait]->update_event);
+            else
+                for (int i=0;i<big_lattice_parts;i++) GPU_CL::GPU::event_wait(schedule[i]->faces_event);
+        }
+    }
+
+    // halos of all parts are refreshed with final faces (for measurements)
+    for (int i=0;i<big_lattice_parts;i++) GPU_CL::GPU::event_wait(schedule[i]->faces_event);
+    for (int i=0;i<big_lattice_parts;i++){
+        int idx = lattice_data[i]->models_index;
+        models[idx]->lattice_halos_write_async(schedule[(i + big_lattice_parts - 1) % big_lattice_parts]->pfaces,schedule[(i + 1) % big_lattice_parts]->pfaces);
+    }
+    for (int i=0;i<big_lattice_parts;i++) {
+        models[lattice_data[i]->models_index]->lattice_wait_for_queue_finish();
+        models[lattice_data[i]->models_index]->GPU0->GPU_async_kernels = false;
+    }
+
+    double finish = lattice_wall_time();
+    for (int i=0;i<big_lattice_parts;i++) schedule[i]->idle_time += finish - schedule[i]->free_time;  // waiting for other parts to finish
+    big_lattice_schedule_time += finish - start;
+}
+void            BL::lattice_schedule_report(void){
+    printf("\nBig lattice scheduler: %f seconds\n",big_lattice_schedule_time);
+    printf(" part    sweeps      busy (s)      idle (s)   idle (%%)\n");
+    for (int i=0;i<big_lattice_parts;i++){
+        double idle_percent = (big_lattice_schedule_time>0.0) ? 100.0 * schedule[i]->idle_time / big_lattice_schedule_time : 0.0;
+        printf(" %4i  %8u  %12.4f  %12.4f  %9.2f\n",i,schedule[i]->sweeps_done,schedule[i]->busy_time,schedule[i]->idle_time,idle_percent);
+    }
+}
+
 }
@@ -58,6 +58,7 @@ class BL {
 
                                     bool   one_device_one_part; // if TRUE then plattice_table_float=plattice_table_double=NULL
                                                                 // -> all are stored data in models[i]
+                                    void*  pfaces;              // boundary faces of the part read from its device (one_device_one_part): [x=0 | x=N1-1]
                             unsigned int   models_index;        // index of corresponding models[i] object
                             unsigned int   part_number;         // number of lattice part
 
@@ -83,11 +84,28 @@ class BL {
                           ~lattice_devices(void);
                     };
 
+                    class lattice_part_schedule{
+                        public:
+                            unsigned int   sweeps_done;         // number of finished update sweeps
+                                    bool   running;             // update sweep of the part is queued
+                                cl_event   update_event;        // completion of the queued update sweep
+                                cl_event   faces_event;         // completion of read of boundary faces into pfaces
+                                    void*  pfaces;              // boundary faces of the part: [x=0 | x=N1-1]
+                                  double   queued_time;         // time when the last update sweep was queued
+                                  double   free_time;           // time when the part became ready for next sweep
+                                  double   busy_time;           // total time of update sweeps (in seconds)
+                                  double   idle_time;           // total time of waiting for neighbours' boundaries (in seconds)
+
+                            lattice_part_schedule(void);
+                           ~lattice_part_schedule(void);
+                    };
+
 
                       model_CL::model** models;         // array of lattice parts
                           SUN_CPU::SU** SUNcpu;         // array of lattice parts
                  lattice_data_buffers** lattice_data;   // arrays for lattice parts
                       lattice_devices** compute_devices;// array of compute devices in cluster
+                lattice_part_schedule** schedule;       // scheduler state of lattice parts
 
                       // for big lattices
                       bool     single_device;
@@ -99,6 +117,7 @@ class BL {
 
                        int     big_lattice_red_passes;  // Number of red passes (red-green scheme)
                        int     big_lattice_green_passes;// Number of green passes (red-green scheme)
+                    double     big_lattice_schedule_time;// total time spent in scheduler (in seconds)
 
     // functions
                     BL(void);       // constructor
@@ -110,6 +129,7 @@ class BL {
             void  lattice_copy_host_to_GPU(lattice_data_buffers* lat);
             void  lattice_get_low_boundary(int* i);
             void  lattice_get_high_boundary(int* i);
+            void  lattice_exchange_halos(int* i);
 
             void  lattice_setup_lattice_pointer_initial(int* i);
             void  lattice_setup_lattice_pointer_last(int* i);
@@ -141,6 +161,12 @@ class BL {
             void  lattice_orthogonalization_red(int i);
             void  lattice_orthogonalization_green(int i);
 
+            bool  lattice_schedule_enabled(void);
+            void  lattice_schedule_init(void);
+            bool  lattice_schedule_ready(int i);
+            void  lattice_schedule_sweeps(unsigned int sweeps);
+            void  lattice_schedule_report(void);
+
 
 
     private:
@@ -142,6 +142,7 @@ char model::path_kernel[FNAME_MAX_LENGTH] = "kernel/";
         turnoff_updates     = false; // turn off lattice updates
         turnoff_gramschmidt = true;  // turn off Gram-Schmidt orthogonalization
         turnoff_boundary_extraction = true; // turn off boundary extraction for external purposes
+        big_lattice_scheduler = true; // event-driven scheduler of big lattice parts
 
         get_acceptance_rate = false; // calculate mean acceptance rate
         get_correlators     = false; // calculate correlators
@@ -236,6 +237,7 @@ void        model::run_parameters::run_parameters_copy(run_parameters* src,run_p
         dst->turnoff_prns        = src->turnoff_prns;
         dst->turnoff_gramschmidt = src->turnoff_gramschmidt;
         dst->turnoff_boundary_extraction = src->turnoff_boundary_extraction;
+        dst->big_lattice_scheduler = src->big_lattice_scheduler;
 
         dst->check_prngs         = src->check_prngs;
 
@@ -297,6 +299,7 @@ void        model::parameters_setup(char* parameter,int* ivalue,double* fvalue,c
             if (!strcmp(parameter,"REBUILDBINARY"))   run->GPU_debug->rebuild_binary = true;
             if (!strcmp(parameter,"GETWILSON"))       run->get_wilson_loop = true;
             if (!strcmp(parameter,"GETRETRACE"))      run->get_plaquettes_avr = true;
+            if (!strcmp(parameter,"BIGLATSCHEDULER")) run->big_lattice_scheduler = ((*ivalue)!=0);
             if (!strcmp(parameter,"TURNOFFFMUNU"))  {
                 run->get_Fmunu = false;
                 run->get_F0mu  = false;
@@ -2310,6 +2313,42 @@ void        model::lattice_wait_for_table_read(void){
 
 void        model::lattice_wait_for_queue_finish(void){
         GPU0->wait_for_queue_finish();
+}
+
+// boundary slices of big lattice part: face x=0 and face x=N1-1 are sent to neighbours,
+// halo x=N1 holds face x=0 of the higher part, halo x=N1+1 - face x=N1-1 of the lower part
+size_t      model::lattice_face_size(void){
+        size_t rows = (lattice_group_elements[run->lattice_group] / 4) * run->lattice_nd;
+        size_t element = (run->precision==model_precision_double) ? sizeof(cl_double4) : sizeof(cl_float4);
+        return rows * lattice_domain_n2n3n4 * element;
+}
+void        model::lattice_faces_read_async(void* ptr,cl_event* event){
+        // ptr = [face x=0 (all rows) | face x=N1-1 (all rows)], event is completed when both faces are read
+        size_t rows = (lattice_group_elements[run->lattice_group] / 4) * run->lattice_nd;
+        size_t element = (run->precision==model_precision_double) ? sizeof(cl_double4) : sizeof(cl_float4);
+        size_t slice = lattice_domain_n2n3n4 * element;
+        size_t offset_high = (run->lattice_domain_size[0] - 1) * slice;
+        for (size_t r=0;r<rows;r++){
+            GPU0->buffer_read_async(lattice_table,(char*) ptr + r * slice,                   r * lattice_table_row_size * element,               slice,NULL);
+            GPU0->buffer_read_async(lattice_table,(char*) ptr + (rows + r) * slice,          r * lattice_table_row_size * element + offset_high, slice,NULL);
+        }
+        lattice_queue_marker(event);
+}
+void        model::lattice_halos_write_async(const void* low,const void* high){
+        // low  - faces of the lower part (its face x=N1-1 goes to halo x=N1+1)
+        // high - faces of the higher part (its face x=0 goes to halo x=N1)
+        size_t rows = (lattice_group_elements[run->lattice_group] / 4) * run->lattice_nd;
+        size_t element = (run->precision==model_precision_double) ? sizeof(cl_double4) : sizeof(cl_float4);
+        size_t slice = lattice_domain_n2n3n4 * element;
+        size_t offset_halo_high = run->lattice_domain_size[0] * slice;
+        size_t offset_halo_low  = (run->lattice_domain_size[0] + 1) * slice;
+        for (size_t r=0;r<rows;r++){
+            GPU0->buffer_write_async(lattice_table,(const char*) low + (rows + r) * slice,   r * lattice_table_row_size * element + offset_halo_low,  slice,NULL);
+            GPU0->buffer_write_async(lattice_table,(const char*) high + r * slice,           r * lattice_table_row_size * element + offset_halo_high, slice,NULL);
+        }
+}
+void        model::lattice_queue_marker(cl_event* event){
+        GPU0->queue_marker(event);
 }       
 
 }
@@ -133,6 +133,7 @@ PRNG_CL::PRNG::PRNG_generators     PRNG_generator;     // PRNG to be used
                           bool     turnoff_prns;       // do not produce prns
                           bool     turnoff_gramschmidt;// do not orthogonalize lattice variables
                           bool     turnoff_boundary_extraction;// do not extract boundaries in simulations for external purposes
+                          bool     big_lattice_scheduler;// update big lattice parts by event-driven scheduler instead of red-green passes
 
                            int     Fmunu_index1;       // index for first  Fmunu
                            int     Fmunu_index2;       // index for second Fmunu
@@ -380,6 +381,11 @@ analysis_CL::analysis::data_analysis*   Analysis;            // array for all me
             void    lattice_wait_for_table_write(void);
             void    lattice_wait_for_table_read(void);
 
+            size_t  lattice_face_size(void);
+            void    lattice_faces_read_async(void* ptr,cl_event* event);
+            void    lattice_halos_write_async(const void* low,const void* high);
+            void    lattice_queue_marker(cl_event* event);
+
             void    lattice_analysis(void);
             void    lattice_print_measurements(void);
             void    lattice_write_results(void);
@@ -183,6 +183,7 @@ setenv("CUDA_CACHE_DISABLE", "1", 1); // disable nVidia cach, if needed
         model0->NITER         = 1;                  // Number of bulk iterations between measurements
         model0->NHIT          = 10;
         model0->NHITPar       = 1;
+        model0->NOR           = 0;                  // number of over-relaxation sweeps after each heat bath sweep
         model0->BETA          = 6.5;
         model0->PHI           = 0.0;//2.0E-6;    // lambda_3 (for SU(2) and SU(3) groups)
         model0->OMEGA         = 0.0;    // lambda_8 (for SU(3) group)
@@ -196,6 +197,15 @@ setenv("CUDA_CACHE_DISABLE", "1", 1); // disable nVidia cach, if needed
 #endif
         model0->wilson_R      = 7;
         model0->wilson_T      = 2;
+        model0->wilson_Rmax   = 0;                  // Wilson loops grid W(R,T), R<=wilson_Rmax, T<=wilson_Tmax (0 - off)
+        model0->wilson_Tmax   = 0;
+        model0->PL_correlator = 0;                  // Polyakov loop correlator <P(0)P^+(r)> binned by |r| (0 - off)
+        model0->smear_type    = 0;                  // smearing of spatial links before Wilson loops (0 - off, 1 - APE, 2 - stout)
+        model0->smear_steps   = 0;                  // number of smearing steps
+        model0->smear_alpha   = 0.5;                // APE weight alpha or stout parameter rho
+        model0->flow_interval = 0;                  // Wilson flow every flow_interval working iterations (0 - off)
+        model0->flow_steps    = 0;                  // number of Wilson flow steps
+        model0->flow_eps      = 0.01;               // Wilson flow time step epsilon
         model0->version       = (char*) calloc((strlen(version) + 1),sizeof(char));
         strcpy_s(model0->version,(strlen(version) + 1),version);
 
@@ -251,9 +261,12 @@ model0->check_prngs         = true;   // check PRNG production
     model0->lattice_init();
     model0->lattice_simulate();           // MC simulations on GPU
 #ifndef BIGLAT
-    LatticeCheckCPU(model0);
+    LatticeCheckCPUStart(model0);         // CPU verification of last configuration (in background)
 #endif
     model0->lattice_analysis();
+#ifndef BIGLAT
+    LatticeCheckCPUWait(model0);
+#endif
 #endif
     model0->lattice_write_results();
     model0->lattice_print_measurements();
@@ -0,0 +1,446 @@
+/******************************************************************************
+ * @file     checkpoint.cpp
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Chunked checkpoint file (.qcg v2) with parallel writer and mmap reader
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#include "checkpoint.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+#include <mutex>
+#include <vector>
+
+namespace checkpoint_CL{
+using checkpoint_CL::checkpoint;
+
+#ifdef _WIN32
+static std::mutex           checkpoint_write_mutex;     // _lseeki64 + _write pair is not atomic
+#endif
+
+static unsigned long long   checkpoint_align(unsigned long long offset,unsigned long long alignment)
+{
+    return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+// positioned write of the whole buffer (returns false on error)
+static bool                 checkpoint_pwrite(int fd,const void* data,unsigned long long size,unsigned long long offset)
+{
+    const char* ptr = (const char*) data;
+#ifdef _WIN32
+    bool result = true;
+    {
+        std::lock_guard<std::mutex> lock(checkpoint_write_mutex);
+        if (_lseeki64(fd,(__int64) offset,SEEK_SET) < 0) result = false;
+        while ((result) && (size > 0)){
+            unsigned int part = (size > (1u << 30)) ? (1u << 30) : (unsigned int) size;
+            int written = _write(fd,ptr,part);
+            if (written <= 0) {result = false; break;}
+            ptr += written; size -= written;
+        }
+    }
+    return result;
+#else
+    while (size > 0){
+        ssize_t written = pwrite(fd,ptr,(size_t) size,(off_t) offset);
+        if (written <= 0) return false;
+        ptr += written; offset += written; size -= written;
+    }
+    return true;
+#endif
+}
+
+                    checkpoint::checkpoint(void)
+{
+    threads         = 0;
+    sections_number = 0;
+    mapped          = NULL;
+    mapped_size     = 0;
+#ifdef _WIN32
+    mapped_file     = INVALID_HANDLE_VALUE;
+    mapped_mapping  = NULL;
+#endif
+    memset(&superblock,0,sizeof(superblock));
+    memset(sections,0,sizeof(sections));
+    for (int i=0; i<QCG2_MAX_SECTIONS; i++) sections_data[i] = NULL;
+}
+                    checkpoint::~checkpoint(void)
+{
+    close();
+}
+
+unsigned long long  checkpoint::checksum(const void* data,unsigned long long size)
+{
+    const unsigned char* ptr = (const unsigned char*) data;
+    unsigned long long hash = 14695981039346656037ULL;
+    unsigned long long words = size / 8;
+    for (unsigned long long i=0; i<words; i++){
+        unsigned long long w;
+        memcpy(&w,ptr + 8*i,8);
+        hash = (hash ^ w) * 1099511628211ULL;
+    }
+    for (unsigned long long i=8*words; i<size; i++) hash = (hash ^ ptr[i]) * 1099511628211ULL;
+    return hash;
+}
+
+bool                checkpoint::add_section(const char* tag,const void* data,unsigned long long size)
+{
+    if ((sections_number >= QCG2_MAX_SECTIONS) || (strlen(tag) > QCG2_TAG_LENGTH)) return false;
+    qcg2_section* s = &sections[sections_number];
+    memset(s,0,sizeof(qcg2_section));
+    memcpy(s->tag,tag,strlen(tag));
+    s->size   = size;
+    s->chunks = (size + QCG2_CHUNK_SIZE - 1) / QCG2_CHUNK_SIZE;
+    sections_data[sections_number++] = data;
+    return true;
+}
+
+bool                checkpoint::write(const char* file_name)
+{
+    // place sections
+    unsigned long long offset = sizeof(qcg2_superblock) + QCG2_MAX_SECTIONS * sizeof(qcg2_section);
+    unsigned long long jobs = 0;
+    for (unsigned int i=0; i<sections_number; i++){
+        sections[i].offset          = checkpoint_align(offset,QCG2_ALIGN);
+        sections[i].checksum_offset = checkpoint_align(sections[i].offset + sections[i].size,8);
+        offset = sections[i].checksum_offset + sections[i].chunks * sizeof(unsigned long long);
+        jobs  += sections[i].chunks;
+    }
+    memset(&superblock,0,sizeof(superblock));
+    memcpy(superblock.prefix,QCG2_PREFIX,strlen(QCG2_PREFIX));
+    superblock.version        = QCG2_VERSION;
+    superblock.sections       = sections_number;
+    superblock.chunk_size     = QCG2_CHUNK_SIZE;
+    superblock.file_size      = offset;
+
+    // chunk list: section and chunk index per job
+    unsigned int*       job_section  = (unsigned int*) calloc((size_t) jobs + 1,sizeof(unsigned int));
+    unsigned long long* job_chunk    = (unsigned long long*) calloc((size_t) jobs + 1,sizeof(unsigned long long));
+    unsigned long long** checksums   = (unsigned long long**) calloc(QCG2_MAX_SECTIONS,sizeof(unsigned long long*));
+    unsigned long long k = 0;
+    for (unsigned int i=0; i<sections_number; i++){
+        checksums[i] = (unsigned long long*) calloc((size_t) sections[i].chunks + 1,sizeof(unsigned long long));
+        for (unsigned long long c=0; c<sections[i].chunks; c++) {job_section[k] = i; job_chunk[k++] = c;}
+    }
+
+    // file is written under temporary name and renamed after fsync, so a crash never leaves a partial checkpoint
+    size_t temp_name_length = strlen(file_name) + 5;
+    char* temp_name = (char*) calloc(temp_name_length,sizeof(char));
+    sprintf_s(temp_name,temp_name_length,"%s.tmp",file_name);
+#ifdef _WIN32
+    int fd = _open(temp_name,_O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,_S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(temp_name,O_WRONLY | O_CREAT | O_TRUNC,0644);
+#endif
+    bool result = (fd >= 0);
+    if (result){
+#ifdef _WIN32
+        if (_chsize_s(fd,(__int64) superblock.file_size)) result = false;          // final size at once, chunks fill it in any order
+#else
+        if (ftruncate(fd,(off_t) superblock.file_size)) result = false;
+#endif
+        // chunks are taken from a shared counter by writer threads (calling thread is one of them)
+        unsigned long long write_threads = (threads > 0) ? (unsigned long long) threads : (unsigned long long) std::thread::hardware_concurrency();
+        if (write_threads > jobs) write_threads = jobs;
+        if (write_threads < 1)    write_threads = 1;
+        std::atomic<unsigned long long> next_job(0);
+        std::atomic<bool> chunks_written(true);
+        auto writer = [&]() {
+            for (unsigned long long j = next_job++; j < jobs; j = next_job++){
+                const qcg2_section* s = &sections[job_section[j]];
+                unsigned long long chunk_offset = job_chunk[j] * QCG2_CHUNK_SIZE;
+                unsigned long long chunk_size   = ((s->size - chunk_offset) < QCG2_CHUNK_SIZE) ? (s->size - chunk_offset) : QCG2_CHUNK_SIZE;
+                const char* data = (const char*) sections_data[job_section[j]] + chunk_offset;
+                checksums[job_section[j]][job_chunk[j]] = checksum(data,chunk_size);
+                if (!checkpoint_pwrite(fd,data,chunk_size,s->offset + chunk_offset)) chunks_written = false;
+            }
+        };
+        std::vector<std::thread> writers;
+        for (unsigned long long t=1; t<write_threads; t++) writers.push_back(std::thread(writer));
+        writer();
+        for (size_t t=0; t<writers.size(); t++) writers[t].join();
+        if (!chunks_written) result = false;
+        // checksums and section table, superblock is the last one
+        for (unsigned int i=0; i<sections_number; i++)
+            if ((sections[i].chunks) && (!checkpoint_pwrite(fd,checksums[i],sections[i].chunks * sizeof(unsigned long long),sections[i].checksum_offset))) result = false;
+        superblock.table_checksum = checksum(sections,QCG2_MAX_SECTIONS * sizeof(qcg2_section));
+        if (!checkpoint_pwrite(fd,sections,QCG2_MAX_SECTIONS * sizeof(qcg2_section),sizeof(qcg2_superblock))) result = false;
+        if (!checkpoint_pwrite(fd,&superblock,sizeof(qcg2_superblock),0)) result = false;
+#ifdef _WIN32
+        if (_commit(fd)) result = false;
+        if (_close(fd)) result = false;
+        if ((result) && (!MoveFileExA(temp_name,file_name,MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))) result = false;
+#else
+        if (fsync(fd)) result = false;
+        if (::close(fd)) result = false;
+        if ((result) && (rename(temp_name,file_name))) result = false;
+#endif
+        if (!result) remove(temp_name);
+    }
+    if (!result) printf("[ERROR] checkpoint %s was not written!\n",file_name);
+    free(temp_name);
+
+    for (unsigned int i=0; i<sections_number; i++) free(checksums[i]);
+    free(checksums);
+    free(job_section);
+    free(job_chunk);
+    return result;
+}
+
+bool                checkpoint::is_qcg2(const char* file_name)
+{
+    char prefix[8] = {0,0,0,0,0,0,0,0};
+    FILE* stream;
+    fopen_s(&stream,file_name,"rb");
+    if (!stream) return false;
+    size_t length = fread(prefix,1,sizeof(prefix),stream);
+    fclose(stream);
+    return ((length == sizeof(prefix)) && (!memcmp(prefix,QCG2_PREFIX,strlen(QCG2_PREFIX))));
+}
+
+bool                checkpoint::open(const char* file_name)
+{
+    close();
+#ifdef _WIN32
+    mapped_file = CreateFileA(file_name,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if (mapped_file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(mapped_file,&file_size);
+    mapped_size    = (unsigned long long) file_size.QuadPart;
+    mapped_mapping = CreateFileMapping(mapped_file,NULL,PAGE_READONLY,0,0,NULL);
+    if (mapped_mapping) mapped = (unsigned char*) MapViewOfFile(mapped_mapping,FILE_MAP_READ,0,0,0);
+#else
+    int fd = ::open(file_name,O_RDONLY);
+    if (fd < 0) return false;
+    struct stat file_stat;
+    if (fstat(fd,&file_stat) == 0){
+        mapped_size = (unsigned long long) file_stat.st_size;
+        void* ptr = mmap(NULL,(size_t) mapped_size,PROT_READ,MAP_PRIVATE,fd,0);   // pages are loaded on first access
+        if (ptr != MAP_FAILED) mapped = (unsigned char*) ptr;
+    }
+    ::close(fd);
+#endif
+    if (!mapped) {close(); return false;}
+
+    bool result = (mapped_size >= sizeof(qcg2_superblock) + QCG2_MAX_SECTIONS * sizeof(qcg2_section));
+    if (result){
+        memcpy(&superblock,mapped,sizeof(qcg2_superblock));
+        memcpy(sections,mapped + sizeof(qcg2_superblock),QCG2_MAX_SECTIONS * sizeof(qcg2_section));
+        result = ((!memcmp(superblock.prefix,QCG2_PREFIX,strlen(QCG2_PREFIX))) && (superblock.version == QCG2_VERSION) &&
+                  (superblock.sections <= QCG2_MAX_SECTIONS) && (superblock.file_size <= mapped_size) &&
+                  (superblock.table_checksum == checksum(sections,QCG2_MAX_SECTIONS * sizeof(qcg2_section))));
+        sections_number = superblock.sections;
+    }
+    if (!result) {printf("[ERROR] checkpoint %s is corrupted!\n",file_name); close();}
+    return result;
+}
+
+const checkpoint::qcg2_section* checkpoint::find_section(const char* tag)
+{
+    char name[QCG2_TAG_LENGTH];
+    memset(name,0,sizeof(name));
+    memcpy(name,tag,(strlen(tag) < QCG2_TAG_LENGTH) ? strlen(tag) : QCG2_TAG_LENGTH);
+    for (unsigned int i=0; i<sections_number; i++)
+        if (!memcmp(sections[i].tag,name,QCG2_TAG_LENGTH)) return &sections[i];
+    return NULL;
+}
+
+const void*         checkpoint::section(const char* tag,unsigned long long* size,bool verify)
+{
+    const qcg2_section* s = (mapped) ? find_section(tag) : NULL;
+    if ((!s) || (s->offset + s->size > mapped_size) || (s->checksum_offset + s->chunks * sizeof(unsigned long long) > mapped_size)) return NULL;
+    if (verify){
+        const unsigned char* checksums = mapped + s->checksum_offset;
+        int errors = 0;
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:errors)
+#endif
+        for (long long c=0; c<(long long) s->chunks; c++){
+            unsigned long long chunk_offset = c * superblock.chunk_size;
+            unsigned long long chunk_size   = ((s->size - chunk_offset) < superblock.chunk_size) ? (s->size - chunk_offset) : superblock.chunk_size;
+            unsigned long long stored;
+            memcpy(&stored,checksums + c * sizeof(unsigned long long),sizeof(stored));
+            if (stored != checksum(mapped + s->offset + chunk_offset,chunk_size)) errors++;
+        }
+        if (errors) {printf("[ERROR] checkpoint section %.8s: %i corrupted chunks\n",s->tag,errors); return NULL;}
+    }
+    if (size) (*size) = s->size;
+    return mapped + s->offset;
+}
+
+bool                checkpoint::read_section(const char* tag,void* data,unsigned long long size)
+{
+    unsigned long long section_size = 0;
+    const void* ptr = section(tag,&section_size,true);
+    if (!ptr) return false;
+    memcpy(data,ptr,(size_t) ((section_size < size) ? section_size : size));
+    return true;
+}
+
+void                checkpoint::close(void)
+{
+#ifdef _WIN32
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mapped_mapping) CloseHandle(mapped_mapping);
+    if (mapped_file != INVALID_HANDLE_VALUE) CloseHandle(mapped_file);
+    mapped_mapping = NULL;
+    mapped_file    = INVALID_HANDLE_VALUE;
+#else
+    if (mapped) munmap(mapped,(size_t) mapped_size);
+#endif
+    mapped      = NULL;
+    mapped_size = 0;
+}
+
+                    checkpoint_writer::checkpoint_writer(void)
+{
+    running = false;
+    result  = true;
+}
+                    checkpoint_writer::~checkpoint_writer(void)
+{
+    wait();
+}
+
+bool                checkpoint_writer::busy(void)
+{
+    return running;
+}
+
+bool                checkpoint_writer::wait(void)
+{
+    if (worker.joinable()) worker.join();
+    return result;
+}
+
+bool                checkpoint_writer::start(checkpoint* qcg,const char* file_name,std::function<bool(void)> ready)
+{
+    wait();     // at most one checkpoint in flight
+    running = true;
+    std::string name(file_name);
+    worker  = std::thread([this,qcg,name,ready]() {
+        result = (ready) ? ready() : true;
+        if (result) result = qcg->write(name.c_str());
+        delete qcg;
+        running = false;
+    });
+    return true;
+}
+
+unsigned long long  checkpoint_journal::rows_size(const qcj_buffer* index,unsigned int buffers,unsigned int rows)
+{
+    unsigned long long result = 0;
+    for (unsigned int i=0; i<buffers; i++) result += (unsigned long long) index[i].blocks * rows * index[i].element_size;
+    return result;
+}
+
+bool                checkpoint_journal::append(const char* file_name,unsigned int row_from,unsigned int row_to,const qcj_buffer* index,unsigned int buffers,const void* rows)
+{
+    if (row_to <= row_from) return true;
+    qcj_record record;
+    memset(&record,0,sizeof(record));
+    memcpy(record.prefix,QCJ_PREFIX,strlen(QCJ_PREFIX));
+    record.buffers          = buffers;
+    record.row_from         = row_from;
+    record.row_to           = row_to;
+    record.payload_size     = rows_size(index,buffers,row_to - row_from);
+    record.index_checksum   = checkpoint::checksum(index,buffers * sizeof(qcj_buffer));
+    record.payload_checksum = checkpoint::checksum(rows,record.payload_size);
+
+    FILE* stream;
+    fopen_s(&stream,file_name,"ab");
+    if (!stream) {printf("[ERROR] journal %s was not opened!\n",file_name); return false;}
+    bool result = (fwrite(&record,sizeof(record),1,stream) == 1);
+    if (result) result = (fwrite(index,sizeof(qcj_buffer),buffers,stream) == buffers);
+    if ((result) && (record.payload_size)) result = (fwrite(rows,(size_t) record.payload_size,1,stream) == 1);
+    if (fflush(stream)) result = false;
+#ifdef _WIN32
+    if (_commit(_fileno(stream))) result = false;
+#else
+    if (fsync(fileno(stream))) result = false;
+#endif
+    if (fclose(stream)) result = false;
+    if (!result) printf("[ERROR] journal %s was not written!\n",file_name);
+    return result;
+}
+
+int                 checkpoint_journal::replay(const char* file_name,unsigned int row_limit,const qcj_buffer* index,unsigned int buffers,void* const* data)
+{
+    FILE* stream;
+    fopen_s(&stream,file_name,"rb");
+    if (!stream) return -1;
+    int records = 0;
+    qcj_record record;
+    // records are applied in file order, so rows written again after a restart override older ones;
+    // reading stops at the first incomplete or corrupted record (torn tail)
+    while (fread(&record,sizeof(record),1,stream) == 1){
+        if ((memcmp(record.prefix,QCJ_PREFIX,strlen(QCJ_PREFIX))) || (record.buffers > QCG2_MAX_SECTIONS) || (record.row_to < record.row_from)) break;
+        qcj_buffer record_index[QCG2_MAX_SECTIONS];
+        if (fread(record_index,sizeof(qcj_buffer),record.buffers,stream) != record.buffers) break;
+        unsigned int rows = record.row_to - record.row_from;
+        if ((record.index_checksum != checkpoint::checksum(record_index,record.buffers * sizeof(qcj_buffer))) ||
+            (record.payload_size != rows_size(record_index,record.buffers,rows))) break;
+        unsigned char* payload = (unsigned char*) malloc((size_t) record.payload_size + 1);
+        if ((!payload) || ((record.payload_size) && (fread(payload,(size_t) record.payload_size,1,stream) != 1)) ||
+            (record.payload_checksum != checkpoint::checksum(payload,record.payload_size))) {free(payload); break;}
+
+        unsigned long long offset = 0;
+        for (unsigned int i=0; i<record.buffers; i++){
+            const qcj_buffer* r = &record_index[i];
+            for (unsigned int j=0; j<buffers; j++){
+                if ((memcmp(r->tag,index[j].tag,QCG2_TAG_LENGTH)) || (!data[j])) continue;
+                if ((r->element_size != index[j].element_size) || (r->blocks > index[j].blocks)) continue;
+                unsigned int copy_rows = (record.row_to < row_limit) ? rows : ((record.row_from < row_limit) ? (row_limit - record.row_from) : 0);
+                if ((unsigned long long) record.row_from + copy_rows > index[j].stride) continue;
+                for (unsigned int b=0; b<r->blocks; b++)
+                    memcpy((unsigned char*) data[j] + ((unsigned long long) b * index[j].stride + record.row_from) * index[j].element_size,
+                           payload + offset + (unsigned long long) b * rows * r->element_size,
+                           (size_t) copy_rows * r->element_size);
+            }
+            offset += (unsigned long long) r->blocks * rows * r->element_size;
+        }
+        free(payload);
+        records++;
+    }
+    fclose(stream);
+    return records;
+}
+
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * @file     checkpoint.h
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Chunked checkpoint file (.qcg v2) with parallel writer and mmap reader (header)
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#ifndef checkpoint_h
+#define checkpoint_h
+
+#include "../clinterface/platform.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#define QCG2_PREFIX         "QCGv2"     // first bytes of v2 file (v1 starts with "QCDGPU")
+#define QCG2_VERSION        2
+#define QCG2_TAG_LENGTH     8           // section tag length (with trailing zeros)
+#define QCG2_MAX_SECTIONS   16          // max number of sections in file
+#define QCG2_CHUNK_SIZE     (4 << 20)   // bytes per chunk (one checksum and one write job per chunk)
+#define QCG2_ALIGN          4096        // alignment of section data in file
+#define QCJ_PREFIX          "QCJrows"   // prefix of every record in measurement journal
+
+namespace checkpoint_CL{
+class checkpoint {
+        public:
+            // file layout: superblock, section table, then for every section its data
+            // (QCG2_ALIGN-aligned) followed by one 64-bit checksum per chunk
+            typedef struct qcg2_superblock {
+                      char  prefix[8];        // QCG2_PREFIX
+              unsigned int  version;          // QCG2_VERSION
+              unsigned int  sections;         // number of sections
+        unsigned long long  chunk_size;       // bytes per chunk
+        unsigned long long  file_size;        // total file size
+        unsigned long long  table_checksum;   // checksum of section table
+        unsigned long long  reserved[3];
+            } qcg2_superblock;
+
+            typedef struct qcg2_section {
+                      char  tag[QCG2_TAG_LENGTH]; // section name
+        unsigned long long  offset;           // offset of section data
+        unsigned long long  size;             // size of section data (in bytes)
+        unsigned long long  chunks;           // number of chunks
+        unsigned long long  checksum_offset;  // offset of chunk checksums
+        unsigned long long  reserved[3];
+            } qcg2_section;
+
+                    int  threads;             // writer threads (0 - all available)
+
+            checkpoint(void);
+           ~checkpoint(void);
+
+            // writer
+            bool  add_section(const char* tag,const void* data,unsigned long long size);  // register section (data has to stay valid until write)
+            bool  write(const char* file_name);                                           // write all sections in parallel chunks
+
+            // reader
+     static bool  is_qcg2(const char* file_name);                                         // check file prefix
+            bool  open(const char* file_name);                                            // map file and check section table
+      const void* section(const char* tag,unsigned long long* size,bool verify);         // pointer to mapped section data (NULL if absent or corrupted)
+            bool  read_section(const char* tag,void* data,unsigned long long size);       // copy verified section (at most size bytes)
+            void  close(void);
+
+     static unsigned long long checksum(const void* data,unsigned long long size);       // 64-bit FNV-1a over 8-byte words
+
+        private:
+           qcg2_superblock  superblock;
+              qcg2_section  sections[QCG2_MAX_SECTIONS];
+               const void*  sections_data[QCG2_MAX_SECTIONS];
+              unsigned int  sections_number;
+
+             unsigned char* mapped;            // mapped file (reader)
+        unsigned long long  mapped_size;
+#ifdef _WIN32
+                    HANDLE  mapped_file;
+                    HANDLE  mapped_mapping;
+#endif
+
+               const qcg2_section* find_section(const char* tag);
+};
+
+// background writer: one checkpoint in flight, sections have to stay valid until the write is finished
+class checkpoint_writer {
+        public:
+            checkpoint_writer(void);
+           ~checkpoint_writer(void);
+
+            bool  busy(void);                                                              // previous checkpoint is still being written
+            bool  wait(void);                                                              // wait for previous checkpoint (returns its write result)
+            bool  start(checkpoint* qcg,const char* file_name,std::function<bool(void)> ready); // wait for ready() in writer thread, write (if ready) and delete qcg
+
+        private:
+               std::thread  worker;
+         std::atomic<bool>  running;
+                      bool  result;
+};
+
+// append-only journal of measurement rows (buffers indexed by working iteration)
+// record: qcj_record, buffers * qcj_buffer (index), then rows of every buffer block after block
+class checkpoint_journal {
+        public:
+            typedef struct qcj_record {
+                      char  prefix[8];        // QCJ_PREFIX
+              unsigned int  buffers;          // number of buffers in record
+              unsigned int  row_from;         // first row
+              unsigned int  row_to;           // last row + 1
+              unsigned int  reserved;
+        unsigned long long  payload_size;     // size of rows (in bytes)
+        unsigned long long  index_checksum;
+        unsigned long long  payload_checksum;
+            } qcj_record;
+
+            typedef struct qcj_buffer {
+                      char  tag[QCG2_TAG_LENGTH]; // buffer name (same as section name in .qcg v2)
+              unsigned int  element_size;     // bytes per element
+              unsigned int  blocks;           // number of blocks (each block holds one element per row)
+        unsigned long long  stride;           // distance between blocks (in elements)
+            } qcj_buffer;
+
+     static unsigned long long rows_size(const qcj_buffer* index,unsigned int buffers,unsigned int rows); // size of rows for all buffers
+     static bool  append(const char* file_name,unsigned int row_from,unsigned int row_to,const qcj_buffer* index,unsigned int buffers,const void* rows); // append record and fsync
+     static int   replay(const char* file_name,unsigned int row_limit,const qcj_buffer* index,unsigned int buffers,void* const* data); // copy rows < row_limit of all valid records to data (returns number of records, -1 if file is absent)
+};
+};
+
+#endif
@@ -52,6 +52,10 @@
 #define FNAME_MAX_LENGTH    128
 
 #define HASHES_SIZE         64
+#define TUNING_CACHE_FILE   "tuning.inf"    // workgroup size tuning cache (in binary cache directory)
+#define TUNING_CACHE_NAME   127             // max length of device, driver and kernel names in tuning cache key
+#define BINARY_CACHE_PATH   "program_cache" // default directory of program binary cache
+#define BINARY_CACHE_DEPTH  8               // max depth of nested #include files in program cache key
 
 namespace GPU_CL{
 using GPU_CL::GPU;
@@ -69,14 +73,18 @@ using GPU_CL::GPU;
     GPU_debug.show_stage        = false;
     GPU_debug.local_run         = false;
     GPU_debug.rebuild_binary    = false;
+    GPU_debug.autotune          = false;
     
     GPU_info.device_name        = NULL;
+    GPU_info.driver_version     = NULL;
     GPU_info.local_memory_size  = 0;
     GPU_info.max_constant_size  = 0;
     GPU_info.max_memory_size    = 0;
     GPU_info.max_memory_width   = 0;
     GPU_info.max_workgroup_size = 0;
     GPU_info.memory_align_factor= 0;
+    GPU_info.compute_units      = 0;
+    GPU_info.max_clock_frequency= 0;
     GPU_info.platform_vendor    = GPU::GPU_vendor_None;
     GPU_info.device_vendor      = GPU::GPU_vendor_None;
 
@@ -101,12 +109,20 @@ using GPU_CL::GPU;
     GPU_device                  = 0;    // utilized device
     GPU_context                 = NULL; // utilized context
     GPU_queue                   = NULL; // utilized command queue
+    GPU_queue_transfer          = NULL; // command queue for overlapped transfers
 
     CPU_timers                  = 32;   // total number of reserved timers
     CPU_timer                   = NULL; // setup CPU timers
     CPU_current_timer_id        = 0;    // current timer id
 
     GPU_limit_max_workgroup_size= 0;    // manually limit max workgroup size
+    GPU_peak_gflops             = 0.0;  // device peak GFLOP/s for roofline report (0 - estimate)
+    GPU_peak_bandwidth          = 0.0;  // device peak bandwidth for roofline report (0 - unknown)
+    GPU_autotune_runs           = 3;    // timed launches per candidate local size
+    GPU_tuning_key[0]           = 0;    // problem description for tuning cache
+    GPU_binary_cache_entries    = 64;   // max number of cached program binaries
+    GPU_binary_cache_path = (char*) calloc(strlen(BINARY_CACHE_PATH) + 1, sizeof(char));
+    strcpy_s(GPU_binary_cache_path, strlen(BINARY_CACHE_PATH) + 1, BINARY_CACHE_PATH);
 
     CPU_timer = (int*) calloc((CPU_timers+1),sizeof(int));
 
@@ -129,6 +145,7 @@ using GPU_CL::GPU;
 
     free(cl_root_path);
     free(CPU_timer);
+    free(GPU_binary_cache_path);
 }
 
                 GPU::kernels_hash::kernels_hash(void)
@@ -144,6 +161,15 @@ using GPU_CL::GPU;
     kernel_number_of_starts     = 0;    // total number of kernel starts - for deviation calculation
     kernel_elapsed_time         = 0.0;  // total kernel execution time (in nanoseconds)
     kernel_elapsed_time_squared = 0.0;  // total kernel execution time squared (in nanoseconds) - for deviation calculation
+    kernel_bytes_read           = 0.0;  // bytes read per work-item (not declared)
+    kernel_bytes_written        = 0.0;  // bytes written per work-item (not declared)
+    kernel_flops                = 0.0;  // flops per work-item (not declared)
+    kernel_tune_state           = 0;    // fixed local size
+    kernel_max_workgroup_size   = 0;    // kernel work group size limit
+    kernel_tune_runs            = 0;    // timed launches with current candidate
+    kernel_tune_time            = 0.0;  // total time of current candidate
+    kernel_tune_best_time       = 0.0;  // mean time of the fastest candidate
+    kernel_tune_best_size       = 0;    // fastest candidate local size
 }
                 GPU::kernels_hash::~kernels_hash(void)
 {
@@ -408,19 +434,24 @@ int             GPU::device_initialize(void)
     OpenCL_Check_Error(GPU_error,"clCreateContext failed");
 
     cl_command_queue_properties profiling_properties = 0;
-    if (GPU_debug.profiling) profiling_properties = (CL_QUEUE_PROFILING_ENABLE);    // enable profiling for debuging
+    if ((GPU_debug.profiling)||(GPU_debug.autotune)) profiling_properties = (CL_QUEUE_PROFILING_ENABLE);    // enable profiling for debuging and autotuning
     GPU_queue = clCreateCommandQueue(GPU_context,GPU_device,profiling_properties,&GPU_error);
     OpenCL_Check_Error(GPU_error,"clCreateCommandQueue failed");
+    GPU_queue_transfer = clCreateCommandQueue(GPU_context,GPU_device,0,&GPU_error);
+    OpenCL_Check_Error(GPU_error,"clCreateCommandQueue failed");
 
 
     GPU_info.local_memory_size  =          clGetDeviceInfoUlong(GPU_device,CL_DEVICE_LOCAL_MEM_SIZE);
     GPU_info.max_constant_size  =          clGetDeviceInfoUlong(GPU_device,CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE);
     GPU_info.max_memory_size    =          clGetDeviceInfoUlong(GPU_device,CL_DEVICE_MAX_MEM_ALLOC_SIZE);
     GPU_info.max_memory_width = (size_t) clGetDeviceInfoUlong(GPU_device,CL_DEVICE_IMAGE3D_MAX_WIDTH);
+    GPU_info.compute_units       = clGetDeviceInfoUint(GPU_device,CL_DEVICE_MAX_COMPUTE_UNITS);
+    GPU_info.max_clock_frequency = clGetDeviceInfoUint(GPU_device,CL_DEVICE_MAX_CLOCK_FREQUENCY);
 
     if (!GPU_info.max_memory_width)  GPU_info.max_memory_width  = 32;
 
     GPU_info.device_name = device_get_name(GPU_device);
+    GPU_info.driver_version = device_get_driver(GPU_device);
 #ifdef BIGLAT
     GPU_info.device_ocl = device_get_OCL(GPU_device);
 #endif
@@ -480,6 +511,7 @@ int             GPU::device_finalize(int error_code)
 #endif
 
     // clean command queue and context
+    if (GPU_queue_transfer) clReleaseCommandQueue(GPU_queue_transfer);
     if (GPU_queue) clReleaseCommandQueue(GPU_queue);
     if (GPU_context) clReleaseContext(GPU_context);
 
@@ -663,6 +695,18 @@ char*           GPU::device_get_OCL(cl_device_id device){
     return result;
 }
 
+char*           GPU::device_get_driver(cl_device_id device){
+    size_t result_length = 4096;
+    size_t result_actual_size;
+
+        char* result = (char*) calloc(result_length,sizeof(char));
+        OpenCL_Check_Error(clGetDeviceInfo(device, CL_DRIVER_VERSION, result_length, (void*) result, &result_actual_size),"clGetDeviceInfo failed");
+        result = trim(result);
+        result = (char*) realloc(result,result_actual_size * sizeof(char));
+
+    return result;
+}
+
 // ___ source _____________________________________________________________________________________
 char*           GPU::source_read(const char* file_name)
 {
@@ -688,6 +732,32 @@ char*           GPU::source_read(const char* file_name)
     return cl_kernels_source;
 }
 
+char*           GPU::source_read_silent(const char* file_name)
+{
+    // reads a text file, NULL if it is absent (no error is reported)
+    FILE * stream;
+    fopen_s(&stream,file_name,"rb");
+    if (!stream) return NULL;
+    fseek(stream, 0, SEEK_END);
+    long length = ftell(stream);
+    fseek(stream, 0, SEEK_SET);
+    char* result = (char*) calloc(length + 1, sizeof(char));
+    size_t read_length = fread(result, sizeof(char), length, stream);
+    result[read_length] = 0;
+    fclose(stream);
+    return result;
+}
+
+char*           GPU::source_append(char* text, const char* add)
+{
+    // appends add to text (text is reallocated)
+    size_t text_length = (text) ? strlen(text) : 0;
+    size_t add_length  = strlen(add);
+    char* result = (char*) realloc(text, (text_length + add_length + 1) * sizeof(char));
+    memcpy(result + text_length, add, add_length + 1);
+    return result;
+}
+
 char*           GPU::source_add(char* source, const char* file_name)
 {
     int error_code = 0;
@@ -922,14 +992,11 @@ int             GPU::program_create(const char* source,const char* options){
     start_timer_CPU(10);
 
     FILE * cl_program_file = NULL;
-    char buffer[FNAME_MAX_LENGTH];
-    char buffer_inf[FNAME_MAX_LENGTH];
+    char buffer[FILENAME_MAX];
 
     GPU_current_program++;
     GPU_active_program = GPU_current_program;
 
-    int GPU_active_file = 0;
-
     // setup reserve kernel's source
     int source_length = (int) strlen(source) + 1;
     char* temporary_source = (char*) calloc(source_length + 1, sizeof(char));
@@ -951,82 +1018,48 @@ int             GPU::program_create(const char* source,const char* options){
     GPU_programs[GPU_active_program].platform = platform_get_name(GPU_platform);
     GPU_programs[GPU_active_program].datetime = get_current_datetime();
 
-    for (int i = 1; i <= GPU_inf_max_n; i++){
-       sprintf_s(buffer_inf,FNAME_MAX_LENGTH,"program%u.inf",i);
-       // get .inf-file
-       int parameters_items = 0;
-       GPU_init_parameters* parameters = get_init_file(buffer_inf);
-       if (parameters==NULL) {delete[] &buffer_inf; return 1;}
-       bool inf_number  = false;
-       bool inf_md5     = false;
-       bool inf_device  = false;
-       bool inf_platform= false;
-       bool inf_options = false;
-       int  inf_idx_md5     = 0;
-       int  inf_idx_device  = 0;
-       int  inf_idx_platform= 0;
-       int  inf_idx_options = 0;
-       bool parameters_flag = false;
-       while(!parameters_flag){
-          if (!strcmp(parameters[parameters_items].Variable,"NUMBER"))  {
-             if(parameters[parameters_items].iVarVal == GPU_active_program) inf_number = true;
-           }
-          if (!strcmp(parameters[parameters_items].Variable,"MD5"))  {
-             inf_md5 = true;
-             inf_idx_md5 = parameters_items;
-           }
-          if (!strcmp(parameters[parameters_items].Variable,"DEVICE"))  {
-             inf_device = true;
-             inf_idx_device = parameters_items;
-           }
-          if (!strcmp(parameters[parameters_items].Variable,"PLATFORM"))  {
-             inf_platform = true;
-             inf_idx_platform = parameters_items;
-           }
-          if (!strcmp(parameters[parameters_items].Variable,"OPTIONS"))  {
-             inf_options = true;
-             inf_idx_options = parameters_items;
-           }
-          parameters_flag = parameters[parameters_items].final;
-          parameters_items++;
-        }
-       // check parameters        
-       if (inf_number){
-            // check MD5
-            if (!strcmp(parameters[inf_idx_md5].txtVarVal,GPU_programs[GPU_active_program].md5)){
-                // check device and options
-                if ((!strcmp(parameters[inf_idx_device].txtVarVal,  GPU_programs[GPU_active_program].device))&&
-                    (!strcmp(parameters[inf_idx_platform].txtVarVal,GPU_programs[GPU_active_program].platform))&&
-                    (((GPU_programs[GPU_active_program].options==NULL)&&(!inf_options))||
-                     ((GPU_programs[GPU_active_program].options!=NULL)&&(!strcmp(parameters[inf_idx_options].txtVarVal,GPU_programs[GPU_active_program].options)))))
-                    {
-                        GPU_active_file = i;
-                        i = GPU_inf_max_n;
-                    }
-            // skip current .inf-file
-            } else {
-                // MD5 does not match
-                // kill current .inf-file and rename last .inf-file into current
-                inf_file_delete(i);
-                if (i < GPU_inf_max_n) inf_file_rename(GPU_inf_max_n,i);    // check if file is last
-                GPU_inf_max_n--;
-                i--;
-            }            
-        }
-     }
+    // content-addressed binary: <cache path>/<MD5 of source, included files, options, device, platform and driver>.bin
+    char* cache_key = program_cache_key(GPU_active_program);
+    sprintf_s(buffer,sizeof(buffer),"%s%s%s.bin",GPU_binary_cache_path,slash,cache_key);
 
-    // if GPU_active_file == 0 then create files
-    if (GPU_active_file == 0) GPU_active_file = GPU_inf_max_n + 1;
+    bool binary_loaded = false;
+    if (!GPU_debug.rebuild_binary) fopen_s(&cl_program_file,buffer,"rb");
+    if (cl_program_file) {
+        // load binary file
+        fseek (cl_program_file, 0, SEEK_END);
+        const size_t binary_size = ftell(cl_program_file);
+        rewind(cl_program_file);
+        unsigned char* binary;
+        binary = (unsigned char*) malloc (binary_size);
+        size_t binary_read = fread(binary, 1, binary_size, cl_program_file);
+        fclose(cl_program_file);
 
-    int j = sprintf_s(buffer,    FNAME_MAX_LENGTH,"program%u.bin",GPU_active_file);
-        j = sprintf_s(buffer_inf,FNAME_MAX_LENGTH,"program%u.inf",GPU_active_file);
-    if (GPU_active_file <= GPU_inf_max_n)  {
-        // try to open .bin-file
-        fopen_s(&cl_program_file,buffer,"rb");
-     }
+        cl_int status = CL_SUCCESS;
+        GPU_programs[GPU_active_program].program = NULL;
+        if ((binary_size > 0) && (binary_read == binary_size))
+            GPU_programs[GPU_active_program].program = clCreateProgramWithBinary(GPU_context, 1, &GPU_device, &binary_size, (const unsigned char**)&binary, &status, &GPU_error);
+        if ((GPU_programs[GPU_active_program].program) && (status == CL_SUCCESS) && (GPU_error == CL_SUCCESS) &&
+            (clBuildProgram(GPU_programs[GPU_active_program].program, 1, &GPU_device, GPU_programs[GPU_active_program].options, NULL, NULL) == CL_SUCCESS)) {
+                binary_loaded = true;
+                utime(buffer,NULL);     // mark entry as recently used
+                size_t size;
+                OpenCL_Check_Error(clGetProgramBuildInfo(GPU_programs[GPU_active_program].program, GPU_device, CL_PROGRAM_BUILD_LOG, 0, NULL, &size),"clGetProgramBuildInfo failed");
+                if (size>4) {
+                   GPU_programs[GPU_active_program].build_log = (char*) calloc(size,sizeof(char));
+                   OpenCL_Check_Error(clGetProgramBuildInfo(GPU_programs[GPU_active_program].program, GPU_device, CL_PROGRAM_BUILD_LOG, size, GPU_programs[GPU_active_program].build_log, NULL),"clGetProgramBuildInfo failed");
+                   if (GPU_debug.brief_report) printf("Program buid log: [%s]\n", GPU_programs[GPU_active_program].build_log);
+                 }
+        } else {
+            // truncated or stale entry (e.g. driver update without version change) - drop it and compile from source
+            printf("[!] cached binary %s is rejected, recompiling\n",buffer);
+            if (GPU_programs[GPU_active_program].program) clReleaseProgram(GPU_programs[GPU_active_program].program);
+            remove(buffer);
+        }
+        free(binary);
+    }
 
-    if((GPU_active_file > GPU_inf_max_n)||(!cl_program_file)){
-        printf("\nprogram%u.bin is being compiled... \n",GPU_active_program);
+    if (!binary_loaded) {
+        printf("\n%s.bin is being compiled... \n",cache_key);
         GPU_programs[GPU_active_program].program = clCreateProgramWithSource(GPU_context, 1,&GPU_programs[GPU_active_program].source_ptr, NULL, &GPU_error);
         OpenCL_Check_Error(GPU_error,"clCreateProgramWithSource failed");
         OpenCL_Check_Error(clBuildProgram(GPU_programs[GPU_active_program].program, 1, &GPU_device, GPU_programs[GPU_active_program].options, NULL, NULL),"clBuildProgram failed");
@@ -1056,63 +1089,185 @@ int             GPU::program_create(const char* source,const char* options){
         unsigned int idx = 0;
         while( idx<num_devices && devices[idx] != GPU_device ) ++idx;
 
-        // save inf file
-        fopen_s(&cl_program_file,buffer_inf,"wb");
-        if ( (cl_program_file) && (idx < num_devices) && (binary_sizes[idx]>0) ){
-            fprintf(cl_program_file,"NUMBER=%u\n",GPU_active_program);
-            fprintf(cl_program_file,"MD5=%s\n",GPU_programs[GPU_active_program].md5);
-            if (GPU_programs[GPU_active_program].options!=NULL)
-                fprintf(cl_program_file,"OPTIONS=%s\n",GPU_programs[GPU_active_program].options);
-            fprintf(cl_program_file,"DEVICE=%s\n",GPU_programs[GPU_active_program].device);
-            fprintf(cl_program_file,"PLATFORM=%s\n",GPU_programs[GPU_active_program].platform);
-            fprintf(cl_program_file,"DATE=%s",GPU_programs[GPU_active_program].datetime);
-            if ( fclose(cl_program_file) ) printf( "The file was not closed!\n" );
-        }
-
-        printf("program%u.bin compilation done (%f seconds)!\n",GPU_active_program,get_timer_CPU(10));
+        printf("%s.bin compilation done (%f seconds)!\n",cache_key,get_timer_CPU(10));
 
         // save binary file
-        fopen_s(&cl_program_file,buffer,"wb");
-        if ( (cl_program_file) && (idx < num_devices) && (binary_sizes[idx]>0) ){
-           fwrite(binary[idx],1,binary_sizes[idx],cl_program_file);
-           if ( fclose(cl_program_file) ) printf( "The file was not closed!\n" );
-        }
+        if ((idx < num_devices) && (binary_sizes[idx]>0))
+            if (program_cache_store(buffer,(const unsigned char*) binary[idx],binary_sizes[idx])) printf("[!] binary %s could not be cached\n",buffer);
         free(devices);
         free(binary_sizes);
         for( unsigned int i=0; i<num_devices; ++i) free(binary[i]);
         free(binary);
-        GPU_inf_max_n++;
-    } else {
+    }
+    free(cache_key);
 
-        // load binary file
-        fseek (cl_program_file, 0, SEEK_END);
-        const size_t binary_size = ftell(cl_program_file);
-        rewind(cl_program_file);
-        unsigned char* binary;
-        binary = (unsigned char*) malloc (binary_size);
-        fread(binary, 1, binary_size, cl_program_file);
-        fclose(cl_program_file);
+    // setup program
 
-        cl_int status;
-        GPU_programs[GPU_active_program].program = clCreateProgramWithBinary(GPU_context, 1, &GPU_device, &binary_size, (const unsigned char**)&binary, &status, &GPU_error);
-        OpenCL_Check_Error(status,"clCreateProgramWithBinary failed");
-        OpenCL_Check_Error(GPU_error,"clCreateProgramWithBinary failed");
+    return GPU_active_program;
+}
 
-        OpenCL_Check_Error(clBuildProgram(GPU_programs[GPU_active_program].program, 1, &GPU_device, GPU_programs[GPU_active_program].options, NULL, NULL),"clBuildProgram failed");
+// ___ program cache ______________________________________________________________________________
+char*           GPU::program_cache_key(int program_id){
+    // MD5 of everything the binary depends on: source with its #include files, options, device, platform and driver
+    const char* options = GPU_programs[program_id].options;
+    char* included = NULL;
+    char* text = source_append(NULL,GPU_programs[program_id].source_ptr);
+    text = program_cache_includes(text,GPU_programs[program_id].source_ptr,options,&included,0);
+    text = source_append(text,"\nOPTIONS=");
+    if (options) text = source_append(text,options);
+    text = source_append(text,"\nDEVICE=");
+    text = source_append(text,GPU_programs[program_id].device);
+    text = source_append(text,"\nPLATFORM=");
+    text = source_append(text,GPU_programs[program_id].platform);
+    text = source_append(text,"\nDRIVER=");
+    if (GPU_info.driver_version) text = source_append(text,GPU_info.driver_version);
+    char* result = MD5(text);
+    free(text);
+    free(included);
+    return result;
+}
 
-                size_t size;
-                OpenCL_Check_Error(clGetProgramBuildInfo(GPU_programs[GPU_active_program].program, GPU_device, CL_PROGRAM_BUILD_LOG, 0, NULL, &size),"clGetProgramBuildInfo failed");
-                if (size>4) {
-                   GPU_programs[GPU_active_program].build_log = (char*) calloc(size,sizeof(char));
-                   OpenCL_Check_Error(clGetProgramBuildInfo(GPU_programs[GPU_active_program].program, GPU_device, CL_PROGRAM_BUILD_LOG, size, GPU_programs[GPU_active_program].build_log, NULL),"clGetProgramBuildInfo failed");
-                   if (GPU_debug.brief_report) printf("Program buid log: [%s]\n", GPU_programs[GPU_active_program].build_log);
-                 }
-        free(binary);
+char*           GPU::program_cache_includes(char* text, const char* source, const char* options, char** included, int depth){
+    // appends files from #include "..." lines of source (searched in -I directories of options) to text;
+    // each file is appended once, included lists appended file names as |name|
+    if ((depth >= BINARY_CACHE_DEPTH)||(source==NULL)) return text;
+    const char* line = source;
+    while (line) {
+        const char* p = line;
+        while ((*p==' ')||(*p=='\t')) p++;
+        if (!strncmp(p,"#include",8)) {
+            const char* name_start = strchr(p,'"');
+            const char* line_end   = strchr(p,'\n');
+            const char* name_end   = (name_start) ? strchr(name_start + 1,'"') : NULL;
+            if ((name_start)&&(name_end)&&((!line_end)||(name_end < line_end))) {
+                char name[FILENAME_MAX];
+                char mark[FILENAME_MAX + 2];
+                size_t name_length = name_end - name_start - 1;
+                if (name_length >= sizeof(name)) name_length = sizeof(name) - 1;
+                memcpy(name,name_start + 1,name_length);
+                name[name_length] = 0;
+                sprintf_s(mark,sizeof(mark),"|%s|",name);
+                if ((*included == NULL)||(!strstr(*included,mark))) {
+                    *included = source_append(*included,mark);
+                    char* content = NULL;
+                    // search in -I directories
+                    const char* option = (options) ? strstr(options,"-I") : NULL;
+                    while ((option)&&(!content)) {
+                        option += 2;
+                        while (*option==' ') option++;
+                        size_t dir_length = strcspn(option," ");
+                        char path[FILENAME_MAX];
+                        size_t separator_length = ((dir_length > 0)&&(option[dir_length-1]!='/')&&(option[dir_length-1]!='\\')) ? strlen(slash) : 0;
+                        if (dir_length + separator_length + name_length < sizeof(path)) {
+                            memcpy(path,option,dir_length);
+                            memcpy(path + dir_length,slash,separator_length);
+                            memcpy(path + dir_length + separator_length,name,name_length + 1);
+                            content = source_read_silent(path);
+                        }
+                        option = strstr(option,"-I");
+                    }
+                    text = source_append(text,"\n#include ");
+                    text = source_append(text,name);
+                    text = source_append(text,"\n");
+                    if (content) {
+                        text = source_append(text,content);
+                        text = program_cache_includes(text,content,options,included,depth + 1);
+                        free(content);
+                    }
+                }
+            }
+        }
+        line = strchr(line,'\n');
+        if (line) line++;
     }
+    return text;
+}
 
-    // setup program
+int             GPU::program_cache_store(const char* file_name, const unsigned char* binary, size_t size){
+    // if the entry has just been stored by a concurrent job, its binary is the same
+    int result = cache_file_store(file_name,binary,size);
+    if (!result) program_cache_evict();
+    return result;
+}
 
-    return GPU_active_program;
+int             GPU::cache_file_store(const char* file_name, const void* data, size_t size){
+    // atomic write: temporary file with unique name, then rename, so that concurrent jobs never read a partial file
+    static unsigned int store_counter = 0;
+    char temporary[FILENAME_MAX];
+    FILE * stream;
+
+    _mkdir(GPU_binary_cache_path);  // fails harmlessly if the directory exists
+    sprintf_s(temporary,sizeof(temporary),"%s.%u.%u.%u.tmp",file_name,(unsigned int) getpid(),(unsigned int) time(NULL),store_counter++);
+    fopen_s(&stream,temporary,"wb");
+    if (!stream) return GPU_error_file_write;
+    size_t written = fwrite(data,1,size,stream);
+    if ((fclose(stream))||(written != size)) {
+        remove(temporary);
+        return GPU_error_file_write;
+    }
+    if (rename(temporary,file_name)) remove(temporary);
+    return 0;
+}
+
+void            GPU::program_cache_evict(void){
+    // LRU eviction: modification time of an entry is refreshed on every hit, the oldest entries above GPU_binary_cache_entries are removed
+    int     entries  = 0;
+    int     reserved = 0;
+    char**  names    = NULL;
+    double* times    = NULL;
+    char    path[FILENAME_MAX];
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    sprintf_s(path,sizeof(path),"%s%s*.bin",GPU_binary_cache_path,slash);
+    HANDLE directory = FindFirstFileA(path,&entry);
+    if (directory == INVALID_HANDLE_VALUE) return;
+    do {
+        const char* entry_name = entry.cFileName;
+        double      entry_time = ((double) entry.ftLastWriteTime.dwHighDateTime) * 4294967296.0 + (double) entry.ftLastWriteTime.dwLowDateTime;
+#else
+    DIR* directory = opendir(GPU_binary_cache_path);
+    if (!directory) return;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        const char* entry_name = entry->d_name;
+        size_t entry_length = strlen(entry_name);
+        if ((entry_length < 5)||(strcmp(entry_name + entry_length - 4,".bin"))) continue;
+        struct stat entry_stat;
+        sprintf_s(path,sizeof(path),"%s%s%s",GPU_binary_cache_path,slash,entry_name);
+        if (stat(path,&entry_stat)) continue;
+        double      entry_time = (double) entry_stat.st_mtime;
+#endif
+        if (entries >= reserved) {
+            reserved = 2 * reserved + 16;
+            names = (char**)  realloc(names, reserved * sizeof(char*));
+            times = (double*) realloc(times, reserved * sizeof(double));
+        }
+        names[entries] = (char*) calloc(strlen(entry_name) + 1, sizeof(char));
+        strcpy_s(names[entries], strlen(entry_name) + 1, entry_name);
+        times[entries] = entry_time;
+        entries++;
+#ifdef _WIN32
+    } while (FindNextFileA(directory,&entry));
+    FindClose(directory);
+#else
+    }
+    closedir(directory);
+#endif
+
+    for (int evicted = entries - (int) GPU_binary_cache_entries; evicted > 0; evicted--) {
+        int oldest = -1;
+        for (int i = 0; i < entries; i++)
+            if ((names[i])&&((oldest < 0)||(times[i] < times[oldest]))) oldest = i;
+        if (oldest < 0) break;
+        sprintf_s(path,sizeof(path),"%s%s%s",GPU_binary_cache_path,slash,names[oldest]);
+        remove(path);   // may already be removed by a concurrent job
+        free(names[oldest]);
+        names[oldest] = NULL;
+    }
+    for (int i = 0; i < entries; i++) free(names[i]);
+    free(names);
+    free(times);
 }
 
 int             GPU::program_set_active(int program_id){
@@ -1154,6 +1309,7 @@ int             GPU::kernel_init(const char* kernel_name, unsigned int work_dime
     OpenCL_Check_Error(clGetKernelWorkGroupInfo(GPU_kernels[GPU_current_kernel].kernel,GPU_device,CL_KERNEL_LOCAL_MEM_SIZE,sizeof(GPU_kernels[GPU_current_kernel].kernel_local_mem_size),&GPU_kernels[GPU_current_kernel].kernel_local_mem_size,NULL),"clGetKernelWorkGroupInfo failed");
     size_t kernel_work_group_size = 0;
     OpenCL_Check_Error(clGetKernelWorkGroupInfo(GPU_kernels[GPU_current_kernel].kernel,GPU_device,CL_KERNEL_WORK_GROUP_SIZE,sizeof(size_t),&kernel_work_group_size,NULL),"clGetKernelWorkGroupInfo failed");
+    GPU_kernels[GPU_current_kernel].kernel_max_workgroup_size = kernel_work_group_size;
     kernel_work_group_size = (unsigned int) (1<<((int) floor(log((double) kernel_work_group_size)/log(2.0))));
     
 #ifndef IGNORE_INTEL
@@ -1181,14 +1337,142 @@ int             GPU::kernel_init(const char* kernel_name, unsigned int work_dime
     GPU_kernels[GPU_current_kernel].kernel_elapsed_time         = 0.0;
     GPU_kernels[GPU_current_kernel].kernel_elapsed_time_squared = 0.0;
     GPU_kernels[GPU_current_kernel].kernel_number_of_starts     = 0;
+    GPU_kernels[GPU_current_kernel].kernel_bytes_read           = 0.0;
+    GPU_kernels[GPU_current_kernel].kernel_bytes_written        = 0.0;
+    GPU_kernels[GPU_current_kernel].kernel_flops                = 0.0;
+
+    // setup workgroup size autotuning: only kernels with free local size and without local memory,
+    // the local size of the others is tied to reduction buffers (CL_KERNEL_LOCAL_MEM_SIZE covers static __local arrays only,
+    // kernels with __local arguments are excluded by kernel_init_buffer)
+    GPU_kernels[GPU_current_kernel].kernel_tune_state           = 0;
+    if ((GPU_debug.autotune)&&(work_dimensions==1)&&((!local_size)||(local_size[0]==0))&&(GPU_kernels[GPU_current_kernel].kernel_local_mem_size==0)){
+        size_t cached_size = kernel_tune_cache_read(GPU_current_kernel);
+        size_t first_size  = kernel_tune_next(GPU_current_kernel,0);
+        GPU_kernels[GPU_current_kernel].kernel_tune_best_size = temporary_local_size[0];
+        if (cached_size) {
+            temporary_local_size[0] = cached_size;
+            GPU_kernels[GPU_current_kernel].kernel_tune_state   = 2;
+        } else if (first_size) {
+            GPU_kernels[GPU_current_kernel].kernel_tune_best_time = 0.0;
+            GPU_kernels[GPU_current_kernel].kernel_tune_runs      = 0;
+            GPU_kernels[GPU_current_kernel].kernel_tune_time      = 0.0;
+            temporary_local_size[0] = first_size;
+            GPU_kernels[GPU_current_kernel].kernel_tune_state   = 1;
+        }
+    }
 
     return GPU_current_kernel;
 }
 
+size_t          GPU::kernel_tune_next(int kernel_id, size_t local_size)
+{
+    // next candidate local size after local_size (0 - the first one): multiples of the preferred workgroup size multiple,
+    // doubled each step, within the kernel work group size limit and dividing the global size; 0 - no more candidates
+    size_t step = GPU_kernels[kernel_id].kernel_preferred_workgroup_size_multiple;
+    if (step == 0) step = 1;
+    size_t candidate = (local_size) ? 2 * local_size : step;
+    while (candidate <= GPU_kernels[kernel_id].kernel_max_workgroup_size) {
+        if (GPU_kernels[kernel_id].global_size[0] % candidate == 0) return candidate;
+        candidate *= 2;
+    }
+    return 0;
+}
+
+int             GPU::kernel_tune_cache_key(int kernel_id, char* key, size_t key_size)
+{
+    // tuning cache line: device <TAB> driver <TAB> tuning key <TAB> kernel name <TAB> global size <TAB> local size;
+    // names are cut to TUNING_CACHE_NAME characters, so the key always fits 4 * LENGTH (key_size)
+    int j  = sprintf_s(key  ,key_size,  "%.*s\t%.*s\t%s\t",TUNING_CACHE_NAME,GPU_info.device_name,TUNING_CACHE_NAME,GPU_info.driver_version,GPU_tuning_key);
+        j += sprintf_s(key+j,key_size-j,"%.*s\t%u\t",TUNING_CACHE_NAME,GPU_kernels[kernel_id].kernel_name,(unsigned int) GPU_kernels[kernel_id].global_size[0]);
+    return j;
+}
+
+size_t          GPU::kernel_tune_cache_read(int kernel_id)
+{
+    FILE *stream;
+    char file_name[FILENAME_MAX];
+    char line[4 * LENGTH];
+    char key[4 * LENGTH];
+    size_t result = 0;
+
+    sprintf_s(file_name,sizeof(file_name),"%s%s%s",GPU_binary_cache_path,slash,TUNING_CACHE_FILE);
+    size_t key_length = kernel_tune_cache_key(kernel_id,key,sizeof(key));
+
+    fopen_s(&stream,file_name,"r");
+    if (!stream) return 0;
+    while (fgets(line,sizeof(line),stream)) {
+        if (strncmp(line,key,key_length)) continue;
+        unsigned int local_size = 0;
+        if (sscanf_s(line + key_length,"%u",&local_size) != 1) continue;
+        // the latest entry wins; sizes which do not fit the kernel any more are skipped
+        if ((local_size > 0) && (local_size <= GPU_kernels[kernel_id].kernel_max_workgroup_size) && (GPU_kernels[kernel_id].global_size[0] % local_size == 0))
+            result = local_size;
+    }
+    fclose(stream);
+    return result;
+}
+
+int             GPU::kernel_tune_cache_write(int kernel_id)
+{
+    // the cache is rewritten as a whole (previous entry of the kernel is replaced) and stored by rename,
+    // so that concurrent jobs never read a partial line
+    FILE *stream;
+    char file_name[FILENAME_MAX];
+    char line[4 * LENGTH + 16];                     // key, local size digits and newline
+    char key[4 * LENGTH];
+
+    sprintf_s(file_name,sizeof(file_name),"%s%s%s",GPU_binary_cache_path,slash,TUNING_CACHE_FILE);
+    size_t key_length = kernel_tune_cache_key(kernel_id,key,sizeof(key));
+
+    size_t text_length   = 0;
+    size_t text_reserved = 4 * LENGTH;
+    char*  text = (char*) calloc(text_reserved,sizeof(char));
+    bool   entry_added = false;
+    fopen_s(&stream,file_name,"r");
+    while (!entry_added) {
+        if ((stream)&&(fgets(line,sizeof(line),stream))) {
+            if (!strncmp(line,key,key_length)) continue;
+        } else {
+            sprintf_s(line,sizeof(line),"%s%u\n",key,(unsigned int) GPU_kernels[kernel_id].local_size[0]);
+            entry_added = true;
+        }
+        size_t line_length = strlen(line);
+        if (text_length + line_length >= text_reserved) {
+            text_reserved = 2 * (text_length + line_length);
+            text = (char*) realloc(text,text_reserved);
+        }
+        memcpy(text + text_length,line,line_length);
+        text_length += line_length;
+    }
+    if (stream) fclose(stream);
+
+    int result = cache_file_store(file_name,text,text_length);
+    free(text);
+    return result;
+}
+
+void            GPU::kernel_tune_disable(int kernel_id)
+{
+    // the local memory of __local arguments is sized for the default local size, so the kernel is not tuned
+    if (GPU_kernels[kernel_id].kernel_tune_state == 0) return;
+    GPU_kernels[kernel_id].local_size[0]     = GPU_kernels[kernel_id].kernel_tune_best_size;
+    GPU_kernels[kernel_id].kernel_tune_state = 0;
+}
+
+int             GPU::kernel_init_cost(int kernel_id,double bytes_read,double bytes_written,double flops)
+{
+        // global memory traffic and flops per work-item for roofline report (see print_roofline)
+        GPU_kernels[kernel_id].kernel_bytes_read    = bytes_read;
+        GPU_kernels[kernel_id].kernel_bytes_written = bytes_written;
+        GPU_kernels[kernel_id].kernel_flops         = flops;
+        return kernel_id;
+}
+
 int             GPU::kernel_init_buffer(int kernel_id,int buffer_id)
 {
     if (GPU_buffers[buffer_id].buffer_type==buffer_type_LDS)
      {
+       kernel_tune_disable(kernel_id);
        OpenCL_Check_Error(clSetKernelArg(GPU_kernels[kernel_id].kernel, GPU_kernels[kernel_id].argument_id, GPU_buffers[buffer_id].size_in_bytes, NULL),"clSetKernelArg failed");
      } else {
        OpenCL_Check_Error(clSetKernelArg(GPU_kernels[kernel_id].kernel, GPU_kernels[kernel_id].argument_id, sizeof(GPU_buffers[buffer_id].buffer), (void*) &GPU_buffers[buffer_id].buffer),"clSetKernelArg failed");
@@ -1203,6 +1487,7 @@ int             GPU::kernel_init_buffer_Buf(int kernel_id, cl_mem buffer, int bu
 {
     if (buffer_type==buffer_type_LDS)
      {
+       kernel_tune_disable(kernel_id);
        OpenCL_Check_Error(clSetKernelArg(GPU_kernels[kernel_id].kernel, GPU_kernels[kernel_id].argument_id, buffer_size, NULL),"clSetKernelArg failed");
      } else {
        printf("::: %li\t%li\n", buffer_size, sizeof(buffer));
@@ -1251,7 +1536,7 @@ int             GPU::kernel_init_constant(int kernel_id,double* host_ptr)
 int             GPU::kernel_run(int kernel_id)
 {
     cl_event kernel_event;
-    if (GPU_debug.profiling){
+    if ((GPU_debug.profiling)||(GPU_kernels[kernel_id].kernel_tune_state == 1)){
         // run with profiling
         cl_ulong kernel_start, kernel_finish;
         OpenCL_Check_Error(clEnqueueNDRangeKernel(GPU_queue,GPU_kernels[kernel_id].kernel,GPU_kernels[kernel_id].work_dimensions,NULL,GPU_kernels[kernel_id].global_size,GPU_kernels[kernel_id].local_size, 0, NULL, &kernel_event),"clEnqueueNDRangeKernel failed");
@@ -1259,11 +1544,36 @@ int             GPU::kernel_run(int kernel_id)
         OpenCL_Check_Error(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_END,   sizeof(cl_ulong), &kernel_finish, 0),"clGetEventProfilingInfo failed");
         OpenCL_Check_Error(clGetEventProfilingInfo(kernel_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start,  0),"clGetEventProfilingInfo failed");
         double elapsed_time = (double) (kernel_finish-kernel_start);
-        GPU_kernels[kernel_id].kernel_elapsed_time          += elapsed_time;
-        GPU_kernels[kernel_id].kernel_elapsed_time_squared  += elapsed_time * elapsed_time;
-        GPU_kernels[kernel_id].kernel_start                  = kernel_start;
-        GPU_kernels[kernel_id].kernel_finish                 = kernel_finish;
-        GPU_kernels[kernel_id].kernel_number_of_starts++;
+        if (GPU_debug.profiling){
+            GPU_kernels[kernel_id].kernel_elapsed_time          += elapsed_time;
+            GPU_kernels[kernel_id].kernel_elapsed_time_squared  += elapsed_time * elapsed_time;
+            GPU_kernels[kernel_id].kernel_start                  = kernel_start;
+            GPU_kernels[kernel_id].kernel_finish                 = kernel_finish;
+            GPU_kernels[kernel_id].kernel_number_of_starts++;
+        }
+        if (GPU_kernels[kernel_id].kernel_tune_state == 1){
+            // autotuning: time GPU_autotune_runs launches of each candidate, then keep the fastest one
+            kernels_hash* tuned = &GPU_kernels[kernel_id];
+            tuned->kernel_tune_time += elapsed_time;
+            tuned->kernel_tune_runs++;
+            if (tuned->kernel_tune_runs >= GPU_autotune_runs){
+                double mean_time = tuned->kernel_tune_time / tuned->kernel_tune_runs;
+                if ((tuned->kernel_tune_best_time == 0.0)||(mean_time < tuned->kernel_tune_best_time)){
+                    tuned->kernel_tune_best_time = mean_time;
+                    tuned->kernel_tune_best_size = tuned->local_size[0];
+                }
+                tuned->kernel_tune_runs = 0;
+                tuned->kernel_tune_time = 0.0;
+                size_t next_size = kernel_tune_next(kernel_id,tuned->local_size[0]);
+                if (next_size) tuned->local_size[0] = next_size;
+                else {
+                    tuned->local_size[0]     = tuned->kernel_tune_best_size;
+                    tuned->kernel_tune_state = 2;
+                    kernel_tune_cache_write(kernel_id);
+                    printf("Autotune: kernel \"%s\" local size %u (%f ms)\n",tuned->kernel_name,(unsigned int) tuned->local_size[0],tuned->kernel_tune_best_time*1.E-6);
+                }
+            }
+        }
     } else {
         // run without profiling
         size_t local_workgroup_size;
@@ -1277,6 +1587,28 @@ int             GPU::kernel_run(int kernel_id)
     return kernel_id;
 }
 
+// non-blocking kernel run (completion is waited by queue_finish or by blocking call on the same queue)
+int             GPU::kernel_run_async(int kernel_id)
+{
+    if ((GPU_debug.profiling)||(GPU_kernels[kernel_id].kernel_tune_state == 1)) return kernel_run(kernel_id);
+    OpenCL_Check_Error(clEnqueueNDRangeKernel(GPU_queue,GPU_kernels[kernel_id].kernel,GPU_kernels[kernel_id].work_dimensions,NULL,GPU_kernels[kernel_id].global_size,GPU_kernels[kernel_id].local_size, 0, NULL, NULL),"clEnqueueNDRangeKernel failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
+    return kernel_id;
+}
+
+// non-blocking run of 1D kernel over global ids [global_offset, global_offset + global_size);
+// the kernel's (tuned) local size is used when it divides global_size, otherwise it is chosen by runtime
+int             GPU::kernel_run_range(int kernel_id, size_t global_offset, size_t global_size, cl_event* event)
+{
+    if (GPU_kernels[kernel_id].work_dimensions != 1) return CL_INVALID_WORK_DIMENSION;
+    if (global_size == 0) return CL_SUCCESS;
+    size_t* local_size = GPU_kernels[kernel_id].local_size;
+    if ((local_size) && ((local_size[0] == 0) || (global_size % local_size[0]))) local_size = NULL;
+    OpenCL_Check_Error(clEnqueueNDRangeKernel(GPU_queue,GPU_kernels[kernel_id].kernel,1,&global_offset,&global_size,local_size, 0, NULL, event),"clEnqueueNDRangeKernel failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
+    return CL_SUCCESS;
+}
+
 int             GPU::kernel_get_worksize(int kernel_id){
         size_t result;
 
@@ -1555,6 +1887,90 @@ cl_float4*      GPU::buffer_read_float4(int buffer_id)
     return ptr;
 }
 
+// blocking read of size bytes of buffer starting from offset (in bytes)
+int             GPU::buffer_read(int buffer_id, void* ptr, size_t offset, size_t size)
+{
+    if (offset >= GPU_buffers[buffer_id].size_in_bytes) return CL_SUCCESS;
+    if (offset + size > GPU_buffers[buffer_id].size_in_bytes) size = GPU_buffers[buffer_id].size_in_bytes - offset;
+    GPU_error = clEnqueueReadBuffer(GPU_queue,GPU_buffers[buffer_id].buffer,CL_TRUE,offset,size,ptr,0,NULL,NULL);
+    OpenCL_Check_Error(GPU_error,"clEnqueueReadBuffer failed");
+    return (int) GPU_error;
+}
+
+// non-blocking read (ptr has to stay valid until event is completed)
+int             GPU::buffer_read_async(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* event)
+{
+    if (offset >= GPU_buffers[buffer_id].size_in_bytes) return CL_INVALID_VALUE;
+    if (offset + size > GPU_buffers[buffer_id].size_in_bytes) size = GPU_buffers[buffer_id].size_in_bytes - offset;
+    GPU_error = clEnqueueReadBuffer(GPU_queue,GPU_buffers[buffer_id].buffer,CL_FALSE,offset,size,ptr,0,NULL,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueReadBuffer failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
+    return (int) GPU_error;
+}
+
+// wait for and release events of non-blocking reads (may be called from another host thread)
+int             GPU::buffer_read_wait(cl_event* events, int events_number)
+{
+    if (events_number <= 0) return CL_SUCCESS;
+    cl_int result = clWaitForEvents(events_number, events);
+    if (result) printf("clWaitForEvents failed: ERROR %i\n", result);
+    for (int i=0; i<events_number; i++) clReleaseEvent(events[i]);
+    return (int) result;
+}
+
+// non-blocking write of size bytes to buffer starting from offset (ptr has to stay valid until write is completed)
+int             GPU::buffer_write_async(int buffer_id, const void* ptr, size_t offset, size_t size, cl_event* event)
+{
+    if (offset >= GPU_buffers[buffer_id].size_in_bytes) return CL_INVALID_VALUE;
+    if (offset + size > GPU_buffers[buffer_id].size_in_bytes) size = GPU_buffers[buffer_id].size_in_bytes - offset;
+    GPU_error = clEnqueueWriteBuffer(GPU_queue,GPU_buffers[buffer_id].buffer,CL_FALSE,offset,size,ptr,0,NULL,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueWriteBuffer failed");
+    OpenCL_Check_Error(clFlush(GPU_queue),"clFlush failed");
+    return (int) GPU_error;
+}
+
+// non-blocking read on transfer queue after wait_event (wait_event is released), so that it overlaps kernels queued later
+int             GPU::buffer_read_transfer(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* wait_event, cl_event* event)
+{
+    if (offset >= GPU_buffers[buffer_id].size_in_bytes) return CL_INVALID_VALUE;
+    if (offset + size > GPU_buffers[buffer_id].size_in_bytes) size = GPU_buffers[buffer_id].size_in_bytes - offset;
+    GPU_error = clEnqueueReadBuffer(GPU_queue_transfer,GPU_buffers[buffer_id].buffer,CL_FALSE,offset,size,ptr,(wait_event) ? 1 : 0,wait_event,event);
+    OpenCL_Check_Error(GPU_error,"clEnqueueReadBuffer failed");
+    OpenCL_Check_Error(clFlush(GPU_queue_transfer),"clFlush failed");
+    if (wait_event) clReleaseEvent(*wait_event);
+    return (int) GPU_error;
+}
+
+// wait for all commands queued on the device
+int             GPU::queue_finish(void)
+{
+    GPU_error = clFinish(GPU_queue_transfer);
+    OpenCL_Check_Error(GPU_error,"clFinish failed");
+    GPU_error = clFinish(GPU_queue);
+    OpenCL_Check_Error(GPU_error,"clFinish failed");
+    return (int) GPU_error;
+}
+
+// page-locked host memory (mapped once and kept mapped until buffer_pinned_free)
+void*           GPU::buffer_pinned_alloc(size_t size_in_bytes, cl_mem* pinned)
+{
+    void* ptr = NULL;
+    *pinned = clCreateBuffer(GPU_context,CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,size_in_bytes,NULL,&GPU_error);
+    OpenCL_Check_Error(GPU_error,"clCreateBuffer failed");
+    if (GPU_error) {*pinned = NULL; return NULL;}
+    ptr = clEnqueueMapBuffer(GPU_queue,*pinned,CL_TRUE,CL_MAP_READ | CL_MAP_WRITE,0,size_in_bytes,0,NULL,NULL,&GPU_error);
+    OpenCL_Check_Error(GPU_error,"clEnqueueMapBuffer failed");
+    return ptr;
+}
+
+void            GPU::buffer_pinned_free(cl_mem pinned, void* ptr)
+{
+    if (!pinned) return;
+    if (ptr) OpenCL_Check_Error(clEnqueueUnmapMemObject(GPU_queue,pinned,ptr,0,NULL,NULL),"clEnqueueUnmapMemObject failed");
+    OpenCL_Check_Error(clFinish(GPU_queue),"clFinish failed");
+    clReleaseMemObject(pinned);
+}
+
 int             GPU::buffer_kill(int buffer_id)
 {
     cl_int result = CL_SUCCESS;
@@ -1662,10 +2078,109 @@ int             GPU::print_time_detailed(void){
     }
     printf("--------------------------------------------------------\n");
 
+    print_roofline();
 
     return 0;
 }
 
+double          GPU::device_peak_gflops(void){
+    if (GPU_peak_gflops > 0.0) return GPU_peak_gflops;
+    // rough single precision estimate: compute units * clock * FMA lanes per compute unit * 2 flops
+    double lanes = 4.0;
+    if (GPU_info.device_vendor == GPU_vendor_nVidia) lanes = 128.0;
+    if (GPU_info.device_vendor == GPU_vendor_AMD)    lanes =  64.0;
+    if (GPU_info.device_vendor == GPU_vendor_Intel)  lanes =   8.0;
+    return 2.0 * lanes * GPU_info.compute_units * GPU_info.max_clock_frequency * 1.E-3;
+}
+
+int             GPU::print_roofline(void){
+    double peak_gflops = device_peak_gflops();
+    bool   declared    = false;
+    for (int i=1; i<=GPU_current_kernel; i++)
+        if ((GPU_kernels[i].kernel_number_of_starts > 0) && (GPU_kernels[i].kernel_bytes_read + GPU_kernels[i].kernel_bytes_written + GPU_kernels[i].kernel_flops > 0.0)) declared = true;
+    if (!declared) return 0;
+
+    printf("Roofline: %u compute units @ %u MHz, peak %f GFLOP/s%s",GPU_info.compute_units,GPU_info.max_clock_frequency,peak_gflops,(GPU_peak_gflops > 0.0) ? "" : " (estimated)");
+    if (GPU_peak_bandwidth > 0.0) printf(", %f GB/s\n",GPU_peak_bandwidth);
+    else                          printf(", bandwidth unknown (set PEAKBANDWIDTH)\n");
+    for (int i=1; i<=GPU_current_kernel; i++){
+        if ((GPU_kernels[i].kernel_number_of_starts == 0) || (GPU_kernels[i].kernel_elapsed_time <= 0.0)) continue;
+        if (GPU_kernels[i].kernel_bytes_read + GPU_kernels[i].kernel_bytes_written + GPU_kernels[i].kernel_flops <= 0.0) continue;
+        double work_items = 1.0;
+        for (unsigned int k=0; k<GPU_kernels[i].work_dimensions; k++) work_items *= (double) GPU_kernels[i].global_size[k];
+        work_items *= GPU_kernels[i].kernel_number_of_starts;
+        // bytes (flops) per nanosecond = GB/s (GFLOP/s)
+        double gbs    = (GPU_kernels[i].kernel_bytes_read + GPU_kernels[i].kernel_bytes_written) * work_items / GPU_kernels[i].kernel_elapsed_time;
+        double gflops = GPU_kernels[i].kernel_flops * work_items / GPU_kernels[i].kernel_elapsed_time;
+        printf("[%2u] kernel \"%s\": %f GB/s",i,GPU_kernels[i].kernel_name,gbs);
+        if (GPU_peak_bandwidth > 0.0) printf(" (%.1f%%)",100.0 * gbs / GPU_peak_bandwidth);
+        printf(", %f GFLOP/s",gflops);
+        if (peak_gflops > 0.0) printf(" (%.1f%%)",100.0 * gflops / peak_gflops);
+        printf("\n");
+    }
+    printf("--------------------------------------------------------\n");
+    return 0;
+}
+
+int             GPU::write_roofline(const char* file_name){
+    // writes per-kernel roofline data in CSV format (file name ends with ".csv") or in JSON format (otherwise)
+    FILE *stream;
+    size_t length = strlen(file_name);
+    bool csv = ((length > 4) && (!strcmp(file_name + length - 4,".csv")));
+    double peak_gflops = device_peak_gflops();
+    double total_time  = 0.0;
+    for (int i=1; i<=GPU_current_kernel; i++) total_time += GPU_kernels[i].kernel_elapsed_time;
+
+    fopen_s(&stream,file_name,"w+");
+    if (!stream) return GPU_error_file_write;
+    if (csv)
+        fprintf(stream,"id,kernel,runs,work_items,time_ms,time_share,bytes_read,bytes_written,flops,gbs,gflops,intensity,peak_bandwidth_percent,peak_gflops_percent,bound\n");
+    else {
+        fprintf(stream,"{\n  \"device\": \"%s\",\n",GPU_info.device_name);
+        fprintf(stream,"  \"compute_units\": %u,\n  \"max_clock_mhz\": %u,\n",GPU_info.compute_units,GPU_info.max_clock_frequency);
+        fprintf(stream,"  \"peak_gflops\": %f,\n  \"peak_gflops_estimated\": %s,\n",peak_gflops,(GPU_peak_gflops > 0.0) ? "false" : "true");
+        if (GPU_peak_bandwidth > 0.0) fprintf(stream,"  \"peak_bandwidth_gbs\": %f,\n",GPU_peak_bandwidth);
+        else                          fprintf(stream,"  \"peak_bandwidth_gbs\": null,\n");
+        fprintf(stream,"  \"kernels\": [");
+    }
+    int written = 0;
+    for (int i=1; i<=GPU_current_kernel; i++){
+        if (GPU_kernels[i].kernel_number_of_starts == 0) continue;
+        double work_items = 1.0;
+        for (unsigned int k=0; k<GPU_kernels[i].work_dimensions; k++) work_items *= (double) GPU_kernels[i].global_size[k];
+        double time   = GPU_kernels[i].kernel_elapsed_time;
+        double bytes  = GPU_kernels[i].kernel_bytes_read + GPU_kernels[i].kernel_bytes_written;
+        double gbs    = (time > 0.0) ? bytes * work_items * GPU_kernels[i].kernel_number_of_starts / time : 0.0;
+        double gflops = (time > 0.0) ? GPU_kernels[i].kernel_flops * work_items * GPU_kernels[i].kernel_number_of_starts / time : 0.0;
+        double share  = (total_time > 0.0) ? time / total_time : 0.0;
+        double intensity = (bytes > 0.0) ? GPU_kernels[i].kernel_flops / bytes : 0.0;
+        const char* bound = "unknown";
+        if ((bytes > 0.0) && (GPU_peak_bandwidth > 0.0) && (peak_gflops > 0.0))
+            bound = (intensity < peak_gflops / GPU_peak_bandwidth) ? "memory" : "compute";
+        char percent_bandwidth[32], percent_gflops[32];
+        if ((bytes > 0.0) && (GPU_peak_bandwidth > 0.0)) sprintf_s(percent_bandwidth,sizeof(percent_bandwidth),"%f",100.0 * gbs / GPU_peak_bandwidth);
+        else sprintf_s(percent_bandwidth,sizeof(percent_bandwidth),"%s",(csv) ? "" : "null");
+        if ((GPU_kernels[i].kernel_flops > 0.0) && (peak_gflops > 0.0)) sprintf_s(percent_gflops,sizeof(percent_gflops),"%f",100.0 * gflops / peak_gflops);
+        else sprintf_s(percent_gflops,sizeof(percent_gflops),"%s",(csv) ? "" : "null");
+
+        if (csv)
+            fprintf(stream,"%u,%s,%u,%.0f,%f,%f,%f,%f,%f,%f,%f,%f,%s,%s,%s\n",
+                i,GPU_kernels[i].kernel_name,GPU_kernels[i].kernel_number_of_starts,work_items,time*1.E-6,share,
+                GPU_kernels[i].kernel_bytes_read,GPU_kernels[i].kernel_bytes_written,GPU_kernels[i].kernel_flops,
+                gbs,gflops,intensity,percent_bandwidth,percent_gflops,bound);
+        else
+            fprintf(stream,"%s\n    {\"id\": %u, \"kernel\": \"%s\", \"runs\": %u, \"work_items\": %.0f, \"time_ms\": %f, \"time_share\": %f, \"bytes_read\": %f, \"bytes_written\": %f, \"flops\": %f, \"gbs\": %f, \"gflops\": %f, \"intensity\": %f, \"peak_bandwidth_percent\": %s, \"peak_gflops_percent\": %s, \"bound\": \"%s\"}",
+                (written) ? "," : "",
+                i,GPU_kernels[i].kernel_name,GPU_kernels[i].kernel_number_of_starts,work_items,time*1.E-6,share,
+                GPU_kernels[i].kernel_bytes_read,GPU_kernels[i].kernel_bytes_written,GPU_kernels[i].kernel_flops,
+                gbs,gflops,intensity,percent_bandwidth,percent_gflops,bound);
+        written++;
+    }
+    if (!csv) fprintf(stream,"\n  ]\n}\n");
+    fclose(stream);
+    return 0;
+}
+
 int             GPU::print_mapped_buffer_uint(int buffer_id,unsigned int number_of_elements){
     unsigned int* ptr = GPU_buffers[buffer_id].mapped_ptr;
     if (ptr==NULL) return GPU_error_no_buffer;
@@ -59,6 +59,7 @@ class GPU {
                 GPU_error_no_device,                        // no OpenCL device
                 GPU_error_device_initialization_failed,     // error of device initialization
                 GPU_error_no_buffer,                        // no buffer
+                GPU_error_file_write,                       // file could not be written
             } GPU_error_codes;
 
             typedef enum enum_GPU_vendors{
@@ -106,6 +107,7 @@ class GPU {
                 bool show_stage             : 1; /**< Enable/disable the output of run stages*/
                 bool local_run              : 1; /**< Enable/disable local run option*/
                 bool rebuild_binary         : 1; /**< Enable/disable rebuilding of binary files for each run*/
+                bool autotune               : 1; /**< Enable/disable workgroup size autotuning of kernels with free local size*/
             } GPU_debug_flags;
             /**
             * Defines initial conditions for simulation, as physical as hardware
@@ -132,6 +134,9 @@ class GPU {
                 size_t      max_memory_width;               /**< The number of PRNG instances*/   // CL_DEVICE_IMAGE2D_MAX_WIDTH
                 size_t      max_workgroup_size;             /**< The greatest of the maximal numbers of OpenCL work items in work group for each compute dimension */   // max(CL_DEVICE_MAX_WORK_ITEM_SIZES)
                 size_t      memory_align_factor;            /**< The factor for buffers aligment*/   // memory align factor for buffers
+                cl_uint     compute_units;                  /**< The number of compute units of desired device*/   // CL_DEVICE_MAX_COMPUTE_UNITS
+                cl_uint     max_clock_frequency;            /**< The maximal clock frequency of desired device (in MHz)*/   // CL_DEVICE_MAX_CLOCK_FREQUENCY
+                char*       driver_version;                 /**< The OpenCL driver version of desired device*/   // CL_DRIVER_VERSION
              GPU_vendors    platform_vendor;                /**< The vendor of the platform containing the desired device*/   // active platform vendor
 #ifdef BIGLAT
                     char*   device_ocl;
@@ -149,6 +154,12 @@ class GPU {
             GPU_device_info GPU_info;                       // GPU device info
 
             unsigned int GPU_limit_max_workgroup_size;      // manually limit max workgroup size (0 - do not limit)
+            double GPU_peak_gflops;                         // device peak performance for roofline report, GFLOP/s (0 - estimate from compute units and clock)
+            double GPU_peak_bandwidth;                      // device peak global memory bandwidth for roofline report, GB/s (0 - unknown)
+            unsigned int GPU_autotune_runs;                 // timed launches per candidate local size in autotune mode
+            char   GPU_tuning_key[LENGTH];                  // problem description for tuning cache entries (lattice size, precision, etc.)
+            char*  GPU_binary_cache_path;                   // directory of program binary cache (shared by concurrent jobs)
+            unsigned int GPU_binary_cache_entries;          // max number of binaries in the cache (least recently used are evicted)
 
             int GPU_current_kernel;                         // current kernel counter
             int GPU_current_buffer;                         // current buffer counter
@@ -171,6 +182,7 @@ class GPU {
             cl_device_id     GPU_device;                   // utilized platform
             cl_context       GPU_context;                  // utilized context
             cl_command_queue GPU_queue;                    // utilized command queue
+            cl_command_queue GPU_queue_transfer;           // command queue for transfers overlapped with kernels
 
             cl_int GPU_error;
 
@@ -204,9 +216,18 @@ class GPU {
             char*   device_get_name(cl_device_id device);
             char*   platform_get_name(cl_platform_id platform);
             char*   device_get_OCL(cl_device_id device);
+            char*   device_get_driver(cl_device_id device);
 
             char*   source_read(const char* file_name);
             char*   source_add(char* source, const char* file_name);
+            char*   source_read_silent(const char* file_name);
+            char*   source_append(char* text, const char* add);
+
+            char*   program_cache_key(int program_id);
+            char*   program_cache_includes(char* text, const char* source, const char* options, char** included, int depth);
+            int     program_cache_store(const char* file_name, const unsigned char* binary, size_t size);
+            int     cache_file_store(const char* file_name, const void* data, size_t size);
+            void    program_cache_evict(void);
 
             int     program_create(const char* source);
             int     program_create(const char* source,const char* options);
@@ -226,8 +247,16 @@ class GPU {
             int     kernel_init_constant(int kernel_id,cl_uint4* host_ptr);
             int     kernel_init_constant(int kernel_id,float* host_ptr);
             int     kernel_init_constant(int kernel_id,double* host_ptr);
+            int     kernel_init_cost(int kernel_id,double bytes_read,double bytes_written,double flops);
             int     kernel_run(int kernel_id);
+            int     kernel_run_async(int kernel_id);
+            int     kernel_run_range(int kernel_id, size_t global_offset, size_t global_size, cl_event* event);
             int     kernel_get_worksize(int kernel_id);
+            size_t  kernel_tune_next(int kernel_id, size_t local_size);
+            int     kernel_tune_cache_key(int kernel_id, char* key, size_t key_size);
+            size_t  kernel_tune_cache_read(int kernel_id);
+            int     kernel_tune_cache_write(int kernel_id);
+            void    kernel_tune_disable(int kernel_id);
  GPU_time_deviation kernel_get_execution_time(int kernel_id);
 
             int     buffer_init(int buffer_type, int size, void* host_ptr, int size_of);
@@ -244,6 +273,14 @@ class GPU {
 #endif
       cl_float4*    buffer_map_float4(int buffer_id);
       cl_float4*    buffer_read_float4(int buffer_id);
+            int     buffer_read(int buffer_id, void* ptr, size_t offset, size_t size);
+            int     buffer_read_async(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* event);
+            int     buffer_read_wait(cl_event* events, int events_number);
+            int     buffer_write_async(int buffer_id, const void* ptr, size_t offset, size_t size, cl_event* event);
+            int     buffer_read_transfer(int buffer_id, void* ptr, size_t offset, size_t size, cl_event* wait_event, cl_event* event);
+            int     queue_finish(void);
+           void*    buffer_pinned_alloc(size_t size_in_bytes, cl_mem* pinned);
+           void     buffer_pinned_free(cl_mem pinned, void* ptr);
             int     buffer_kill(int buffer_id);
  GPU_time_deviation buffer_write_get_time(int buffer_id);
  GPU_time_deviation buffer_read_get_time(int buffer_id);
@@ -277,6 +314,9 @@ class GPU {
             int     print_mapped_buffer_double4(int buffer_id,unsigned int number_of_elements);
             int     print_mapped_buffer_double4(int buffer_id,unsigned int number_of_elements, unsigned int offset);
             int     print_time_detailed(void);
+            int     print_roofline(void);
+            int     write_roofline(const char* file_name);
+          double    device_peak_gflops(void);
 
             int     start_timer_CPU(void);
             int     start_timer_CPU(int timer);
@@ -308,6 +348,17 @@ class GPU {
                 int          kernel_number_of_starts;       // total number of kernel starts - for deviation calculation
                 size_t       kernel_preferred_workgroup_size_multiple; // kernel preferred work group size multiple
                 cl_ulong     kernel_local_mem_size;         // kernel local memory size
+                // roofline data (declared per work-item by kernel_init_cost, 0 - not declared)
+                double       kernel_bytes_read;             // bytes read from global memory per work-item
+                double       kernel_bytes_written;          // bytes written to global memory per work-item
+                double       kernel_flops;                  // floating point operations per work-item
+                // workgroup size autotuning data
+                int          kernel_tune_state;             // 0 - fixed local size, 1 - being tuned, 2 - tuned (or taken from tuning cache)
+                size_t       kernel_max_workgroup_size;     // kernel work group size limit (CL_KERNEL_WORK_GROUP_SIZE)
+                unsigned int kernel_tune_runs;              // timed launches with current candidate local size
+                double       kernel_tune_time;              // total time of current candidate (in nanoseconds)
+                double       kernel_tune_best_time;         // mean time of the fastest candidate (in nanoseconds)
+                size_t       kernel_tune_best_size;         // fastest candidate local size (default local size until the first candidate is timed)
 
                 kernels_hash(void);
                ~kernels_hash(void);
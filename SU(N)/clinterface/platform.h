@@ -43,14 +43,25 @@
   #include <windows.h>
   #include <conio.h>
   #include <direct.h>
+  #include <process.h>
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/utime.h>
   #define GetCurrentDir _getcwd
+  #define getpid _getpid
+  #define utime(path, times) _utime((path), (times))
   static const char slash[]="\\"; 
   #define snprintf(b,size,fmt,...) _snprintf_s((b),(size),_TRUNCATE,(fmt),##__VA_ARGS__)
 #else
   #include <string.h>
   #include <cstdlib>
   #include <unistd.h>
+  #include <dirent.h>
+  #include <utime.h>
+  #include <sys/types.h>
+  #include <sys/stat.h>
   #define GetCurrentDir getcwd
+  #define _mkdir(path) mkdir((path), 0775)
   static const char slash[]="/";
   
   #define   sprintf_s(b,size,fmt,...) sprintf((b),(fmt),##__VA_ARGS__)
@@ -50,6 +50,7 @@ namespace analysis_CL{
 using analysis_CL::analysis;
 
            bool analysis::results_verification = true;    // result of CPU-GPU verification
+           bool analysis::verification_deferred = false;  // CPU-GPU verification is postponed (CPU check runs in background)
 
             analysis::data_analysis::data_analysis(void) {
                 pointer             = NULL;
@@ -75,6 +76,7 @@ using analysis_CL::analysis;
 
 bool        analysis::CPU_GPU_verification_single(double a, double b, const char* err_str){
     bool result = true;
+    if (verification_deferred) return result;
     if ((hgpu_abs(a)>CHECKING_PRECISION_SINGLE) && (hgpu_abs(b)>CHECKING_PRECISION_SINGLE))
     {
     float c = (float) (1.0 - b/a);
@@ -88,6 +90,7 @@ bool        analysis::CPU_GPU_verification_single(double a, double b, const char
 }
 bool        analysis::CPU_GPU_verification_double(double a, double b, const char* err_str){
     bool result = true;
+    if (verification_deferred) return result;
     if ((hgpu_abs(a)>CHECKING_PRECISION_DOUBLE) && (hgpu_abs(b)>CHECKING_PRECISION_DOUBLE))
     {
     double c =1.0 - b/a;
@@ -133,6 +136,12 @@ void        analysis::lattice_data_analysis(data_analysis* data){
     else
         CPU_GPU_verification_double(data->GPU_last_value,data->CPU_last_value,data->data_name);
 }
+void        analysis::lattice_data_verification(data_analysis* data){
+    if (data->precision_single)
+        CPU_GPU_verification_single(data->GPU_last_value,data->CPU_last_value,data->data_name);
+    else
+        CPU_GPU_verification_double(data->GPU_last_value,data->CPU_last_value,data->data_name);
+}
 void        analysis::lattice_data_analysis_CPU(data_analysis* data){
     int last_index = (data->data_size - 1);
     if(data->CPU_data==NULL) {
@@ -64,12 +64,14 @@ GPU_CL::GPU::GPU_storage_type  storage_type;
             } data_analysis;
 
      static bool    results_verification;
+     static bool    verification_deferred;  // CPU values are not ready yet, verification is done later by lattice_data_verification
 
             void    lattice_data_analysis(data_analysis* data);
             void    lattice_data_analysis_CPU(data_analysis* data);
             void    lattice_data_analysis_joint(data_analysis* data,data_analysis* data1,data_analysis* data2);
             void    lattice_data_analysis_joint_CPU(data_analysis* data,data_analysis* data1,data_analysis* data2);
             void    lattice_data_analysis_joint3(data_analysis* data,data_analysis* data1,data_analysis* data2,data_analysis* data3);
+            void    lattice_data_verification(data_analysis* data);
 
         private:
              bool   CPU_GPU_verification_single(double a, double b, const char* err_str);   // CPU-GPU results verification (a?=?b with relative accuracy VDELTA_SINGLE)
@@ -0,0 +1,186 @@
+/******************************************************************************
+ * @file     fft.cpp
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Host 3D FFT for correlators of lattice fields
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#include "fft.h"
+
+#define FFT_PI 3.14159265358979323846
+
+namespace fft_CL{
+using fft_CL::fft;
+
+                    fft::fft(void)
+{
+    for (int i=0; i<3; i++) {
+        size[i]           = 0;
+        axis[i].n         = 0;
+        axis[i].radix2    = false;
+        axis[i].reverse   = NULL;
+        axis[i].twiddle   = NULL;
+    }
+    volume   = 0;
+    line     = NULL;
+    line_out = NULL;
+}
+                    fft::~fft(void)
+{
+    for (int i=0; i<3; i++) axis_free(&axis[i]);
+    free(line);
+    free(line_out);
+}
+
+void                fft::axis_free(fft_axis* a)
+{
+    free(a->reverse);
+    free(a->twiddle);
+    a->reverse = NULL;
+    a->twiddle = NULL;
+    a->n       = 0;
+}
+
+bool                fft::plan(const unsigned int* n)
+{
+    unsigned int n_max = 0;
+    volume = 1;
+    for (int i=0; i<3; i++) {
+        if (n[i] == 0) return false;
+        axis_free(&axis[i]);
+        size[i]        = n[i];
+        volume        *= n[i];
+        if (n[i] > n_max) n_max = n[i];
+
+        fft_axis* a = &axis[i];
+        a->n        = n[i];
+        a->radix2   = ((n[i] & (n[i] - 1)) == 0);
+        a->twiddle  = (double*) calloc(2 * n[i],sizeof(double));
+        for (unsigned int k=0; k<n[i]; k++) {
+            a->twiddle[2*k]     =  cos(2.0 * FFT_PI * k / n[i]);
+            a->twiddle[2*k + 1] = -sin(2.0 * FFT_PI * k / n[i]);
+        }
+        if (a->radix2) {
+            unsigned int bits = 0;
+            while ((1u << bits) < n[i]) bits++;
+            a->reverse = (unsigned int*) calloc(n[i],sizeof(unsigned int));
+            for (unsigned int k=0; k<n[i]; k++) {
+                unsigned int r = 0;
+                for (unsigned int b=0; b<bits; b++) if (k & (1u << b)) r |= 1u << (bits - 1 - b);
+                a->reverse[k] = r;
+            }
+        }
+    }
+    free(line);
+    free(line_out);
+    line     = (double*) calloc(2 * n_max,sizeof(double));
+    line_out = (double*) calloc(2 * n_max,sizeof(double));
+    return ((line) && (line_out));
+}
+
+void                fft::transform_line(const fft_axis* a,bool inverse)
+{
+    unsigned int n    = a->n;
+    double       sign = (inverse) ? -1.0 : 1.0;    // conjugated twiddles for inverse transform
+    if (a->radix2) {
+        for (unsigned int k=0; k<n; k++) {
+            unsigned int r = a->reverse[k];
+            if (r > k) {
+                double re = line[2*k], im = line[2*k + 1];
+                line[2*k]     = line[2*r];     line[2*k + 1] = line[2*r + 1];
+                line[2*r]     = re;            line[2*r + 1] = im;
+            }
+        }
+        for (unsigned int half=1; half<n; half<<=1) {
+            unsigned int step = n / (2 * half);
+            for (unsigned int start=0; start<n; start+=2*half)
+                for (unsigned int k=0; k<half; k++) {
+                    double wr = a->twiddle[2*k*step], wi = sign * a->twiddle[2*k*step + 1];
+                    unsigned int p = start + k, q = p + half;
+                    double tr = line[2*q] * wr - line[2*q + 1] * wi;
+                    double ti = line[2*q] * wi + line[2*q + 1] * wr;
+                    line[2*q]     = line[2*p]     - tr;
+                    line[2*q + 1] = line[2*p + 1] - ti;
+                    line[2*p]     += tr;
+                    line[2*p + 1] += ti;
+                }
+        }
+    } else {
+        for (unsigned int k=0; k<n; k++) {
+            double re = 0.0, im = 0.0;
+            for (unsigned int j=0; j<n; j++) {
+                unsigned int w = (unsigned int) (((unsigned long long) k * j) % n);
+                double wr = a->twiddle[2*w], wi = sign * a->twiddle[2*w + 1];
+                re += line[2*j] * wr - line[2*j + 1] * wi;
+                im += line[2*j] * wi + line[2*j + 1] * wr;
+            }
+            line_out[2*k]     = re;
+            line_out[2*k + 1] = im;
+        }
+        memcpy(line,line_out,2 * n * sizeof(double));
+    }
+}
+
+void                fft::transform(double* data,bool inverse)
+{
+    // 3D transform as 1D transforms along x, y and z lines
+    unsigned int stride[3] = {1, size[0], size[0] * size[1]};
+    for (int d=0; d<3; d++) {
+        unsigned int n = size[d];
+        if (n < 2) continue;
+        for (unsigned int base=0; base<volume; base++) {
+            if ((base / stride[d]) % n) continue;        // base runs over sites with zero coordinate along d
+            for (unsigned int k=0; k<n; k++) {
+                line[2*k]     = data[2*(base + k * stride[d])];
+                line[2*k + 1] = data[2*(base + k * stride[d]) + 1];
+            }
+            transform_line(&axis[d],inverse);
+            for (unsigned int k=0; k<n; k++) {
+                data[2*(base + k * stride[d])]     = line[2*k];
+                data[2*(base + k * stride[d]) + 1] = line[2*k + 1];
+            }
+        }
+    }
+}
+
+void                fft::correlate(double* data)
+{
+    // sum_x f(x) conj(f(x+r)) = (1/V) sum_k |F(k)|^2 exp(-i k r), i.e. forward transform of power spectrum
+    transform(data,false);
+    for (unsigned int i=0; i<volume; i++) {
+        data[2*i]     = (data[2*i] * data[2*i] + data[2*i + 1] * data[2*i + 1]) / volume;
+        data[2*i + 1] = 0.0;
+    }
+    transform(data,false);
+}
+
+};
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * @file     fft.h
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Host 3D FFT for correlators of lattice fields (header)
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#ifndef fft_h
+#define fft_h
+
+#include "../clinterface/platform.h"
+
+namespace fft_CL{
+class fft {
+        public:
+            // complex data are interleaved (re,im), x is the fastest index: element [x + n1 * (y + n2 * z)]
+                    fft(void);
+                   ~fft(void);
+
+            bool    plan(const unsigned int* size);                 // prepare transforms for n1 x n2 x n3 field
+            void    transform(double* data,bool inverse);           // in-place unnormalized 3D transform (sign -1 for forward)
+            void    correlate(double* data);                        // data[r] = sum_x f(x) * conj(f(x+r)) (periodic)
+
+            unsigned int size[3];
+            unsigned int volume;
+
+        private:
+            typedef struct fft_axis {
+                unsigned int    n;
+                        bool    radix2;                             // n = 2^k: iterative radix-2, otherwise direct DFT
+                unsigned int*   reverse;                            // bit-reversed indices (radix2 only)
+                      double*   twiddle;                            // exp(-2*pi*i*k/n), k = 0..n-1
+            } fft_axis;
+
+            fft_axis  axis[3];
+              double* line;                                         // one line of the field
+              double* line_out;                                     // output of direct DFT
+
+            void    axis_free(fft_axis* a);
+            void    transform_line(const fft_axis* a,bool inverse);
+};
+};
+
+#endif
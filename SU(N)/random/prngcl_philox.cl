@@ -0,0 +1,111 @@
+/******************************************************************************
+ * @file     prngcl_philox.cl
+ * @author   Vadim Demchik <vadimdi@yahoo.com>
+ * @version  1.1
+ *
+ * @brief    [PRNGCL library]
+ *           contains OpenCL implementation of Philox4x32-10 counter-based pseudo-random number generator
+ *
+ *
+ * @section  CREDITS
+ *
+ *   John K. Salmon, Mark A. Moraes, Ron O. Dror, David E. Shaw,
+ *   "Parallel random numbers: as easy as 1, 2, 3",
+ *   Proceedings of SC'11 (2011), 16:1--16:12.
+ *
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2017 Vadim Demchik
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+
+#ifndef PRNGCL_PHILOX_CL
+#define PRNGCL_PHILOX_CL
+
+#include "prngcl_common.cl"
+
+#define PHILOX_M0     0xD2511F53u
+#define PHILOX_M1     0xCD9E8D57u
+#define PHILOX_W0     0x9E3779B9u
+#define PHILOX_W1     0xBB67AE85u
+#define PHILOX_twom23 (1.1920928955078125E-7f)    // 1/2^23
+#define PHILOX_stream 0                           // key.y for pass-ordered buffer stream
+#define PHILOX_keyed  1                           // key.y for (sweep,site,dir,hit) keyed stream
+
+
+//________________________________________________________________________________________________________ PHILOX PRNG
+// output depends on (counter,key) only: the same numbers are produced by PRNG::PHILOX_block on host
+__attribute__((always_inline)) uint4
+philox4x32_10(uint4 ctr, uint2 key)
+{
+    for (uint r = 0; r < 10; r++) {
+        uint hi0 = mul_hi(PHILOX_M0, ctr.x);
+        uint lo0 = PHILOX_M0 * ctr.x;
+        uint hi1 = mul_hi(PHILOX_M1, ctr.z);
+        uint lo1 = PHILOX_M1 * ctr.z;
+        ctr = (uint4) (hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+        key += (uint2) (PHILOX_W0, PHILOX_W1);
+    }
+    return ctr;
+}
+
+// 23 bits + 1/2: exact in single precision, in (0;1)
+__attribute__((always_inline)) float4
+philox_to_float4(uint4 x)
+{
+    return (convert_float4(x >> 9) + 0.5f) * PHILOX_twom23;
+}
+
+// 4 PRNs for hit number hit of link (site,dir) in sweep sweep
+__attribute__((always_inline)) float4
+philox_keyed(uint seed, uint sweep, uint site, uint dir, uint hit)
+{
+    return philox_to_float4(philox4x32_10((uint4) (site, dir, hit, sweep), (uint2) (seed, PHILOX_keyed)));
+}
+
+#ifndef PRNG_INLINE_ONLY    // producer kernel is not built when the generator is included into update kernels
+__kernel void
+philox(__global hgpu_float4* randoms,
+                     const uint N,
+                     const uint seed,
+                     const uint pass)
+{
+    uint giddst = GID;
+    uint2 key = (uint2) (seed, PHILOX_stream);
+    for (uint i = 0; i < N; i++) {
+        float4 result = philox_to_float4(philox4x32_10((uint4) (i, GID, pass, 0), key));
+#ifdef PRECISION_DOUBLE // if double precision is defined
+        randoms[giddst] = convert_double4(result);
+#else
+        randoms[giddst] = result;
+#endif
+        giddst += GID_SIZE;
+    }
+}
+
+
+#endif // PRNG_INLINE_ONLY
+#endif
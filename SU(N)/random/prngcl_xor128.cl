@@ -55,6 +55,7 @@
 #define XOR128_k      (2.3283064365386962890625E-10) // 1/2^32
 #define XOR128_left   (XOR128_min_FP+XOR128_k*XOR128_max_FP)
 #define XOR128_right  (XOR128_max_FP+XOR128_k*XOR128_min_FP)
+#define XOR128_twom23 (1.1920928955078125E-7f)    // 1/2^23
 
 
 //________________________________________________________________________________________________________ XOR128 PRNG
@@ -72,6 +73,19 @@ xor128_step(uint4 seed)
     return result;
 }
 
+// 4 PRNs in (0;1) from a state kept in registers by the calling kernel (23 bits + 1/2, as philox_to_float4)
+__attribute__((always_inline)) float4
+xor128_float4(uint4* seed)
+{
+    uint4 x;
+    (*seed) = xor128_step(*seed);   x.x = (*seed).w;
+    (*seed) = xor128_step(*seed);   x.y = (*seed).w;
+    (*seed) = xor128_step(*seed);   x.z = (*seed).w;
+    (*seed) = xor128_step(*seed);   x.w = (*seed).w;
+    return (convert_float4(x >> 9) + 0.5f) * XOR128_twom23;
+}
+
+#ifndef PRNG_INLINE_ONLY    // producer kernel is not built when the generator is included into update kernels
 #ifdef PRECISION_DOUBLE  // if double precision is defined
 __attribute__((always_inline)) hgpu_double
 xor128_step_double(uint4* seed)
@@ -133,4 +147,5 @@ xor128(__global uint4* seed_table,
 }
 
 
+#endif // PRNG_INLINE_ONLY
 #endif
@@ -4,6 +4,7 @@
 #include "prngcl_common.cl"
 // #include "prngcl_constant.cl"
 // #include "prngcl_mrg32k3a.cl"
+#include "prngcl_philox.cl"
 // #include "prngcl_pm.cl"
 // #include "prngcl_ranecu.cl"
 #include "prngcl_ranlux.cl"
@@ -15,6 +15,19 @@ using PRNG_CL::PRNG;
 
 #define FNAME_MAX_LENGTH     250  // max length of filename with path
 
+// a^power mod m (square-and-multiply, m < 2^32)
+static unsigned long long   PRNG_lcg_power(unsigned long long a,unsigned long long power,unsigned long long m)
+{
+    unsigned long long result = 1;
+    a %= m;
+    while (power){
+        if (power & 1) result = (result * a) % m;
+        a = (a * a) % m;
+        power >>= 1;
+    }
+    return result;
+}
+
 
                     PRNG::PRNG(void)
 {
@@ -29,15 +42,20 @@ using PRNG_CL::PRNG;
 #ifndef CPU_RUN
     pointer_to_randoms       = NULL;
 #endif
+    ring_buffer              = NULL;
+    ring_position            = PRNG_ring_size;
 
     PRNG_generator  = PRNG_generator_none;
     PRNG_instances  = 0;     // number of PRNG instances
     PRNG_samples    = 500;   // number of prn samples per one generator
     PRNG_srandtime  = 0;
+    PRNG_stream     = 0;     // master instance
+    PRNG_stream_state = 0;
     PRNG_randseries = 0;     // Type of random series (0: time-dependent series, #_any_#: constant series for #_any_#) 
     PRNG_precision  = PRNG_precision_single; // precision to be used for PRNGs
 
     PRNG_counter      = 0;   // counter runs of subroutine PRNG_produce 
+    PRNG_inline       = false;
 #ifndef CPU_RUN
     PRNG_seeds               = NULL;
     PRNG_seed_id             = 0;    // input seeds ID
@@ -84,19 +102,26 @@ using PRNG_CL::PRNG;
     // XORSeven parameters_________________________________
     for (int i=0; i<8; i++) XOR7_state[i] = 0;
     XOR7_index = 0;
-#ifndef CPU_RUN
     // XOR128 parameters___________________________________
     XOR128_state.s[0] = 0;
     XOR128_state.s[1] = 0;
     XOR128_state.s[2] = 0;
     XOR128_state.s[3] = 0;
-#endif
     // RANECU parameters___________________________________
     RANECU_jseed1 = RANECU_seed1;
     RANECU_jseed2 = RANECU_seed2;
+    // PHILOX parameters___________________________________
+    for (int i=0; i<4; i++) PHILOX_counter[i] = PHILOX_stream_counter[i] = 0;
+    PHILOX_key[0] = 0;
+    PHILOX_key[1] = PHILOX_stream;
+    PHILOX_index  = 4;
+#ifndef CPU_RUN
+    PHILOX_pass_argument_id = 0;
+#endif
 }
                     PRNG::~PRNG(void)
 {
+    if (ring_buffer) free(ring_buffer);
 
 }
     
@@ -119,6 +144,7 @@ unsigned int PRNG::convert_generator_to_uint(PRNG::PRNG_generators generator){
     if (generator == PRNG::PRNG_generator_PM)      return  9;
     if (generator == PRNG::PRNG_generator_XOR7)    return 10;
     if (generator == PRNG::PRNG_generator_RANECU)  return 11;
+    if (generator == PRNG::PRNG_generator_PHILOX)  return 12;
     return 5; // return RANLUX3 generator otherwise
 }
 PRNG::PRNG_generators PRNG::convert_uint_to_generator(unsigned int generator){
@@ -133,6 +159,7 @@ PRNG::PRNG_generators PRNG::convert_uint_to_generator(unsigned int generator){
     if (generator == 9) return PRNG::PRNG_generator_PM;
     if (generator ==10) return PRNG::PRNG_generator_XOR7;
     if (generator ==11) return PRNG::PRNG_generator_RANECU;
+    if (generator ==12) return PRNG::PRNG_generator_PHILOX;
     return PRNG::PRNG_generator_RANLUX3; // return RANLUX3 generator otherwise
 }
 
@@ -151,6 +178,7 @@ void                PRNG::parameters_setup(char* parameter,int ivalue,char* text
                 if (!strcmp(text_value,"RANMAR"))  PRNG_generator   = PRNG_generator_RANMAR;
                 if (!strcmp(text_value,"RANECU"))  PRNG_generator   = PRNG_generator_RANECU;
                 if (!strcmp(text_value,"PM"))      PRNG_generator   = PRNG_generator_PM;
+                if (!strcmp(text_value,"PHILOX"))  PRNG_generator   = PRNG_generator_PHILOX;
             }
 }
 int                 PRNG::print_generator(char* header,int header_size){
@@ -167,6 +195,7 @@ int                 PRNG::print_generator(char* header,int header_size){
     if (PRNG_generator == PRNG_CL::PRNG::PRNG_generator_RANECU)      j  += sprintf_s(header+j,header_size-j, " PRN generator               : RANECU\n");
     if (PRNG_generator == PRNG_CL::PRNG::PRNG_generator_RANMAR)      j  += sprintf_s(header+j,header_size-j, " PRN generator               : RANMAR\n");
     if (PRNG_generator == PRNG_CL::PRNG::PRNG_generator_XOR7)        j  += sprintf_s(header+j,header_size-j, " PRN generator               : XOR7\n");
+    if (PRNG_generator == PRNG_CL::PRNG::PRNG_generator_PHILOX)      j  += sprintf_s(header+j,header_size-j, " PRN generator               : PHILOX\n");
 
     return j;
 }
@@ -179,12 +208,13 @@ void                PRNG::initialize_CPU(void){
             PRNG_srandtime = PRNG_randseries;
     }
     
-    srand(PRNG_srandtime);
-#ifndef CPU_RUN
+    // additional streams take their seeds from own splitmix64 sequence and leave global rand() alone
+    if (PRNG_stream) PRNG_stream_state = (((unsigned long long) PRNG_srandtime) << 32) | PRNG_stream;
+        else         srand(PRNG_srandtime);
+    ring_position = PRNG_ring_size;     // drop PRNs of previous series
     if (PRNG_generator==PRNG_generator_XOR128)
         // XOR128
             XOR128_initialize_CPU();
-#endif
     if ((PRNG_generator==PRNG_generator_RANLUX0)||(PRNG_generator==PRNG_generator_RANLUX1)||
             (PRNG_generator==PRNG_generator_RANLUX2)||(PRNG_generator==PRNG_generator_RANLUX3)||
             (PRNG_generator==PRNG_generator_RANLUX4)||(PRNG_generator==PRNG_generator_RANLUX)){
@@ -211,6 +241,18 @@ void                PRNG::initialize_CPU(void){
         if (PRNG_generator==PRNG_generator_RANECU)
             // RANECU
             RANECU_initialize_CPU();
+
+        if (PRNG_generator==PRNG_generator_PHILOX)
+            // PHILOX
+            PHILOX_initialize_CPU();
+}
+unsigned int        PRNG::seed_CPU(void){
+    if (!PRNG_stream) return (unsigned int) rand();
+    // splitmix64 (Steele et al., OOPSLA'14): neighbouring streams give uncorrelated seeds
+    unsigned long long z = (PRNG_stream_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int) ((z ^ (z >> 31)) & 0x7FFFFFFF);   // same range as rand() on POSIX
 }
 #ifndef CPU_RUN
 void                PRNG::initialize(void)
@@ -273,11 +315,20 @@ void                PRNG::initialize(void)
             RANECU_initialize_CPU();
             RANECU_initialize();
         }
+
+        if (PRNG_generator==PRNG_generator_PHILOX){
+            // PHILOX
+            PHILOX_initialize_CPU();
+            PHILOX_initialize();
+        }
         produce();
 }
 void                PRNG::produce(void)
 {
+        if (!PRNG_randoms_kernel_id) {PRNG_counter++; return;}     // PRNG_inline: passes are counted only
 //        int result = 
+        if (PRNG_generator==PRNG_generator_PHILOX)
+            GPU0->kernel_init_constant_reset(PRNG_randoms_kernel_id,(int*) &PRNG_counter,PHILOX_pass_argument_id);
         GPU0->kernel_run(PRNG_randoms_kernel_id);
         randoms_produced += PRNG_samples * 4;
         PRNG_counter++;
@@ -285,9 +336,7 @@ void                PRNG::produce(void)
 #endif
 void                PRNG::produce_CPU(float* randoms_cpu)
 {
-#ifndef CPU_RUN
     if (PRNG_generator==PRNG_generator_XOR128) XOR128_produce_CPU(randoms_cpu);
-#endif
     if ((PRNG_generator==PRNG_generator_RANLUX0)||(PRNG_generator==PRNG_generator_RANLUX1)||
         (PRNG_generator==PRNG_generator_RANLUX2)||(PRNG_generator==PRNG_generator_RANLUX3)||
         (PRNG_generator==PRNG_generator_RANLUX4)||(PRNG_generator==PRNG_generator_RANLUX)){
@@ -297,12 +346,11 @@ void                PRNG::produce_CPU(float* randoms_cpu)
     if (PRNG_generator==PRNG_generator_PM)     PM_produce_CPU(randoms_cpu);
     if (PRNG_generator==PRNG_generator_XOR7)   XOR7_produce_CPU(randoms_cpu);
     if (PRNG_generator==PRNG_generator_RANECU) RANECU_produce_CPU(randoms_cpu);
+    if (PRNG_generator==PRNG_generator_PHILOX) PHILOX_produce_CPU(randoms_cpu);
 }
 void                PRNG::produce_CPU(float* randoms_cpu,int number_of_prns_CPU)
 {
-#ifndef CPU_RUN
     if (PRNG_generator==PRNG_generator_XOR128) XOR128_produce_CPU(randoms_cpu,number_of_prns_CPU);
-#endif
     if ((PRNG_generator==PRNG_generator_RANLUX0)||(PRNG_generator==PRNG_generator_RANLUX1)||
         (PRNG_generator==PRNG_generator_RANLUX2)||(PRNG_generator==PRNG_generator_RANLUX3)||
         (PRNG_generator==PRNG_generator_RANLUX4)||(PRNG_generator==PRNG_generator_RANLUX)){
@@ -313,8 +361,175 @@ void                PRNG::produce_CPU(float* randoms_cpu,int number_of_prns_CPU)
     if (PRNG_generator==PRNG_generator_PM)     PM_produce_CPU(randoms_cpu,number_of_prns_CPU);
     if (PRNG_generator==PRNG_generator_XOR7)   XOR7_produce_CPU(randoms_cpu,number_of_prns_CPU);
     if (PRNG_generator==PRNG_generator_RANECU) RANECU_produce_CPU(randoms_cpu,number_of_prns_CPU);
+    if (PRNG_generator==PRNG_generator_PHILOX) PHILOX_produce_CPU(randoms_cpu,number_of_prns_CPU);
+}
+void                PRNG::produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    switch (PRNG_generator){
+        case PRNG_generator_PM:
+            PM_produce_batch_CPU(randoms_cpu,number_of_prns_CPU);
+            break;
+        case PRNG_generator_RANECU:
+            RANECU_produce_batch_CPU(randoms_cpu,number_of_prns_CPU);
+            break;
+        case PRNG_generator_PHILOX:
+            PHILOX_produce_batch_CPU(randoms_cpu,number_of_prns_CPU);
+            break;
+        default:
+            produce_CPU(randoms_cpu,number_of_prns_CPU);
+            break;
+    }
+}
+void                PRNG::produce_ring_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    // only the lane producers of the LCGs are faster than the scalar path; the serial recurrences
+    // (XOR128, RANLUX, RANMAR, XOR7) gain nothing from reading ahead, PHILOX is block-based already
+    if ((PRNG_generator!=PRNG_generator_PM)&&(PRNG_generator!=PRNG_generator_RANECU)) {produce_CPU(randoms_cpu,number_of_prns_CPU); return;}
+    if (!ring_buffer) ring_buffer = (float*) calloc(PRNG_ring_size,sizeof(float));
+    while (number_of_prns_CPU > 0){
+        if (ring_position == PRNG_ring_size){
+            produce_batch_CPU(ring_buffer,PRNG_ring_size);
+            ring_position = 0;
+        }
+        int n = PRNG_ring_size - ring_position;
+        if (n > number_of_prns_CPU) n = number_of_prns_CPU;
+        for (int i=0; i<n; i++) randoms_cpu[i] = ring_buffer[ring_position + i];
+        ring_position      += n;
+        randoms_cpu        += n;
+        number_of_prns_CPU -= n;
+    }
+}
+void                PRNG::benchmark_CPU(int number_of_prns_CPU)
+{
+    const PRNG_generators generators[] = {PRNG_generator_XOR128,
+        PRNG_generator_RANLUX0,PRNG_generator_RANLUX1,PRNG_generator_RANLUX2,PRNG_generator_RANLUX3,PRNG_generator_RANLUX4,
+        PRNG_generator_RANMAR,PRNG_generator_PM,PRNG_generator_XOR7,PRNG_generator_RANECU,PRNG_generator_PHILOX};
+    const char* names[] = {"XOR128","RANLUX0","RANLUX1","RANLUX2","RANLUX3","RANLUX4","RANMAR","PM","XOR7","RANECU","PHILOX"};
+    const int check_size = 4 * PRNG_ring_size + 3;  // not a multiple of the block sizes
+
+    float* randoms_scalar = (float*) calloc(check_size,sizeof(float));
+    float* randoms_ring   = (float*) calloc(check_size,sizeof(float));
+    float  rnd[4];
+
+    printf("PRNG throughput on CPU (%i PRNs per generator, produce_CPU(rnd,4) vs produce_ring_CPU(rnd,4)):\n",number_of_prns_CPU);
+    for (unsigned int g=0; g<sizeof(generators)/sizeof(generators[0]); g++){
+        PRNG* scalar = new(PRNG);
+        PRNG* ring   = new(PRNG);
+        scalar->PRNG_generator  = ring->PRNG_generator  = generators[g];
+        scalar->PRNG_randseries = ring->PRNG_randseries = 1;
+        scalar->initialize_CPU();
+        ring->initialize_CPU();
+
+        // both producers have to give the same sequence
+        for (int i=0; i<check_size; i+=4) scalar->produce_CPU(&randoms_scalar[i],((check_size-i)<4) ? (check_size-i) : 4);
+        for (int i=0; i<check_size; i+=4) ring->produce_ring_CPU(&randoms_ring[i],((check_size-i)<4) ? (check_size-i) : 4);
+        bool equal = (memcmp(randoms_scalar,randoms_ring,check_size*sizeof(float))==0);
+
+        // skip ahead has to land on the same position
+        PRNG* skip = new(PRNG);
+        skip->PRNG_generator  = generators[g];
+        skip->PRNG_randseries = 1;
+        skip->initialize_CPU();
+        skip->skip_CPU(check_size - 4);
+        skip->produce_CPU(rnd,4);
+        bool skipped = (memcmp(rnd,&randoms_scalar[check_size - 4],4*sizeof(float))==0);
+        delete(skip);
+
+        double sum = 0.0;
+        clock_t start = clock();
+        for (int i=0; i<number_of_prns_CPU; i+=4) {scalar->produce_CPU(rnd,4); sum += rnd[0];}
+        double time_scalar = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+        start = clock();
+        for (int i=0; i<number_of_prns_CPU; i+=4) {ring->produce_ring_CPU(rnd,4); sum += rnd[0];}
+        double time_ring = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+
+        printf(" %-8s: scalar %12.0f PRNs/s, ring %12.0f PRNs/s, sequence %s, skip %s (checksum %f)\n",names[g],
+            (time_scalar > 0.0) ? number_of_prns_CPU / time_scalar : 0.0,
+            (time_ring > 0.0) ? number_of_prns_CPU / time_ring : 0.0,
+            equal ? "ok" : "DIFFERS",skipped ? "ok" : "DIFFERS",sum);
+
+        delete(scalar);
+        delete(ring);
+    }
+
+    free(randoms_scalar);
+    free(randoms_ring);
+}
+bool                PRNG::counter_based(void)
+{
+    return (PRNG_generator==PRNG_generator_PHILOX);
+}
+void                PRNG::skip_CPU(unsigned long long number_of_prns_CPU)
+{
+    ring_position = PRNG_ring_size;     // PRNs read ahead into ring buffer are dropped
+    switch (PRNG_generator){
+        case PRNG_generator_PM:
+            PMseed = (int) ((PRNG_lcg_power(PM_a,number_of_prns_CPU,PM_m) * (unsigned long long) PMseed) % PM_m);
+            break;
+        case PRNG_generator_RANECU:
+            RANECU_jseed1 = (int) ((PRNG_lcg_power(RANECU_seedP13,number_of_prns_CPU,RANECU_icons1) * (unsigned long long) RANECU_jseed1) % RANECU_icons1);
+            RANECU_jseed2 = (int) ((PRNG_lcg_power(RANECU_seedP23,number_of_prns_CPU,RANECU_icons2) * (unsigned long long) RANECU_jseed2) % RANECU_icons2);
+            break;
+        case PRNG_generator_XOR128:
+            XOR128_skip_CPU(number_of_prns_CPU);
+            break;
+        case PRNG_generator_PHILOX: {
+            while ((number_of_prns_CPU > 0) && (PHILOX_index < 4)) {PHILOX_index++; number_of_prns_CPU--;}
+            unsigned long long blocks = number_of_prns_CPU / 4;
+            if (PHILOX_key[1] == PHILOX_keyed) {
+                PHILOX_counter[2] += (unsigned int) blocks;
+            } else {
+                unsigned long long sample = PHILOX_counter[0] + blocks;
+                PHILOX_counter[2] += (unsigned int) (sample / PRNG_samples);
+                PHILOX_counter[0]  = (unsigned int) (sample % PRNG_samples);
+            }
+            if (number_of_prns_CPU % 4) {
+                PHILOX_next_block_CPU();
+                PHILOX_index = (int) (number_of_prns_CPU % 4);
+            }
+            break;
+        }
+        default:
+            // RANLUX, RANMAR and XOR7 have no cheap jump: their position is restored from a state snapshot
+            for (unsigned long long i=0; i<number_of_prns_CPU; i++) {float rnd; produce_CPU(&rnd,1);}
+            break;
+    }
+}
+void                PRNG::set_counter(unsigned int counter)
+{
+    // O(1) positioning: the pass number is a part of the PHILOX counter
+    PRNG_counter     = counter;
+    randoms_produced = counter * PRNG_samples * 4;
+    if (PRNG_generator==PRNG_generator_PHILOX){
+        PHILOX_counter[0] = 0;
+        PHILOX_counter[1] = 0;
+        PHILOX_counter[2] = counter;
+        PHILOX_counter[3] = 0;
+        PHILOX_index = 4;
+    }
 }
 #ifndef CPU_RUN
+unsigned int        PRNG::state_size(void)
+{
+    // every generator keeps its per-instance state in the seed table (quads of uint or float)
+    if ((PRNG_generator==PRNG_generator_PHILOX)||(!PRNG_seed_table_id)) return 0;
+    return seed_table_size * 4;
+}
+unsigned int*       PRNG::state_save(void)
+{
+    if (!state_size()) return NULL;
+    return GPU0->buffer_map(PRNG_seed_table_id);
+}
+void                PRNG::state_load(unsigned int* state,unsigned int counter)
+{
+    if (state_size()) {
+        void* seed_table = (PRNG_seed_table_float4) ? (void*) PRNG_seed_table_float4 : (void*) PRNG_seed_table_uint4;
+        memcpy(seed_table,state,state_size()*sizeof(unsigned int));
+        GPU0->buffer_write(PRNG_seed_table_id);
+    }
+    set_counter(counter);
+}
 unsigned int        PRNG::check_seeds(void)
 {
     // check seeds
@@ -505,7 +720,7 @@ void                PRNG::RL_initialize_CPU(void)
 {
 // setup luxury level!!! +++
 
-        RL_jseed = rand() % 2147483647;
+        RL_jseed = seed_CPU() % 2147483647;
 
         int     RL_k;
         //
@@ -641,8 +856,9 @@ void                PRNG::XOR128_initialize(void)
                  GPU0->program_create(random);
 
         seed_table_size         = GPU0->buffer_size_align(PRNG_instances);
-        randoms_size            = GPU0->buffer_size_align(PRNG_instances * PRNG_samples);
+        randoms_size            = (PRNG_inline) ? 0 : GPU0->buffer_size_align(PRNG_instances * PRNG_samples);
         PRNG_seed_table_uint4   = (cl_uint4*)  calloc(seed_table_size,sizeof(cl_uint4));
+        if (!PRNG_inline)
         PRNG_randoms            = (void*) calloc(randoms_size,sizeof(cl_float4));
 
         PRNG_seed_table_uint4[0].s[0] = XOR128_state.s[0];    // setup first thread as CPU
@@ -659,6 +875,7 @@ void                PRNG::XOR128_initialize(void)
         }
 
         PRNG_seed_table_id = GPU0->buffer_init(GPU0->buffer_type_IO, seed_table_size, PRNG_seed_table_uint4,    sizeof(cl_uint4));
+        if (PRNG_inline) return;    // seed table is kept for state file only
         PRNG_randoms_id    = GPU0->buffer_init(GPU0->buffer_type_IO, randoms_size,    PRNG_randoms,             sizeof(cl_float4));
 
         int argument_id;
@@ -671,13 +888,12 @@ void                PRNG::XOR128_initialize(void)
         argument_id = GPU0->kernel_init_constant(PRNG_randoms_kernel_id,&PRNG_samples);
 }
 #endif
-#ifndef CPU_RUN
 void                PRNG::XOR128_initialize_CPU(void)
 {
-        XOR128_state.s[0] = rand();
-        XOR128_state.s[1] = rand();
-        XOR128_state.s[2] = rand();
-        XOR128_state.s[3] = rand();
+        XOR128_state.s[0] = seed_CPU();
+        XOR128_state.s[1] = seed_CPU();
+        XOR128_state.s[2] = seed_CPU();
+        XOR128_state.s[3] = seed_CPU();
 }
 unsigned int        PRNG::XOR128_produce_one_uint_CPU(void)
 {
@@ -690,6 +906,24 @@ unsigned int        PRNG::XOR128_produce_one_uint_CPU(void)
 
         return XOR128_state.s[0];
 }
+#ifndef CPU_RUN
+void                PRNG::XOR128_inline_states(cl_uint4* states,unsigned int size,unsigned int stream)
+{
+        // every word is a hash (murmur3 finalizer) of (random series, stream, work-item, word), so the states are
+        // independent and do not overlap along one XOR128 sequence as consecutive outputs of a generator would
+        unsigned int counter = 0;
+        for (unsigned int i=0; i<size; i++)
+            do {
+                for (int k=0; k<4; k++){
+                    unsigned int h = PRNG_srandtime ^ (stream * 0x9E3779B9u) ^ ((counter++) * 0x85EBCA6Bu);
+                    h ^= h >> 16;   h *= 0x85EBCA6Bu;
+                    h ^= h >> 13;   h *= 0xC2B2AE35u;
+                    h ^= h >> 16;
+                    states[i].s[k] = h;
+                }
+            } while ((states[i].s[0] | states[i].s[1] | states[i].s[2] | states[i].s[3]) == 0);
+}
+#endif
 float               PRNG::XOR128_produce_one_CPU(void)
 {
         return ((float) XOR128_produce_one_uint_CPU()) / 4294967295.0f;
@@ -703,7 +937,43 @@ void                PRNG::XOR128_produce_CPU(float* randoms_cpu,int number_of_pr
 {
     for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = XOR128_produce_one_CPU();
 }
-#endif
+void                PRNG::XOR128_skip_CPU(unsigned long long number_of_prns_CPU)
+{
+    // state s (128 bits) -> T^n s over GF(2); column j of a matrix is the image of unit vector j
+    typedef unsigned int xor128_matrix[128][4];
+    xor128_matrix* T = (xor128_matrix*) calloc(3,sizeof(xor128_matrix));
+    unsigned int (*step)[4] = T[0], (*power)[4] = T[1], (*product)[4] = T[2];
+    for (int j=0; j<128; j++){
+        unsigned int s[4] = {0,0,0,0};
+        s[j >> 5] = 1u << (j & 31);
+        unsigned int t = s[0] ^ (s[0] << 11);
+        step[j][0] = s[1];
+        step[j][1] = s[2];
+        step[j][2] = s[3];
+        step[j][3] = (s[3] ^ (s[3] >> 19)) ^ (t ^ (t >> 8));
+    }
+    unsigned int state[4] = {XOR128_state.s[0],XOR128_state.s[1],XOR128_state.s[2],XOR128_state.s[3]};
+    memcpy(power,step,sizeof(xor128_matrix));
+    while (number_of_prns_CPU){
+        if (number_of_prns_CPU & 1){
+            unsigned int r[4] = {0,0,0,0};
+            for (int j=0; j<128; j++) if ((state[j >> 5] >> (j & 31)) & 1)
+                for (int k=0; k<4; k++) r[k] ^= power[j][k];
+            for (int k=0; k<4; k++) state[k] = r[k];
+        }
+        number_of_prns_CPU >>= 1;
+        if (!number_of_prns_CPU) break;
+        for (int j=0; j<128; j++){      // power = power * power
+            unsigned int r[4] = {0,0,0,0};
+            for (int i=0; i<128; i++) if ((power[j][i >> 5] >> (i & 31)) & 1)
+                for (int k=0; k<4; k++) r[k] ^= power[i][k];
+            for (int k=0; k<4; k++) product[j][k] = r[k];
+        }
+        memcpy(power,product,sizeof(xor128_matrix));
+    }
+    for (int k=0; k<4; k++) XOR128_state.s[k] = state[k];
+    free(T);
+}
 #ifndef CPU_RUN
 void                PRNG::RANMAR_initialize(void)
 {
@@ -773,8 +1043,8 @@ void                PRNG::RANMAR_initialize(void)
 void                PRNG::RANMAR_initialize_CPU(void)
 {
 
-    RM_seed1 = rand() % 31328;
-    RM_seed2 = rand() % 30081;
+    RM_seed1 = seed_CPU() % 31328;
+    RM_seed2 = seed_CPU() % 30081;
 
     int i = ((RM_seed1 / 177) % 177) + 2;
     int j = (RM_seed1 % 177) + 2;
@@ -891,7 +1161,7 @@ void                PRNG::PM_initialize(void)
 #endif
 void                PRNG::PM_initialize_CPU(void)
 {
-        PMseed = rand() % 2147483647;
+        PMseed = seed_CPU() % 2147483647;
 }
 float               PRNG::PM_produce_one_CPU(void){
     unsigned int PM_lo, PM_hi;
@@ -917,6 +1187,31 @@ void                PRNG::PM_produce_CPU(float* randoms_cpu,int number_of_prns_C
 {
     for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = PM_produce_one_CPU();
 }
+void                PRNG::PM_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    // lane l holds seed n+l of the same sequence and jumps by PM_a^PRNG_lanes (mod PM_m),
+    // so the lanes are independent and give exactly the PRNs of PM_produce_one_CPU;
+    // PM_m = 2^31-1 is reduced by shift and add, so the lane loop has no division and vectorizes
+    int blocks = number_of_prns_CPU / PRNG_lanes;
+    int i = 0;
+    if (blocks > 1){
+        const unsigned long long jump = PRNG_lcg_power(PM_a,PRNG_lanes,PM_m);
+        unsigned int seed[PRNG_lanes];
+        for (int l=0; l<PRNG_lanes; l++) {randoms_cpu[l] = PM_produce_one_CPU(); seed[l] = (unsigned int) PMseed;}
+        for (int b=1; b<blocks; b++){
+            float* randoms_block = randoms_cpu + b * PRNG_lanes;
+            for (int l=0; l<PRNG_lanes; l++){
+                unsigned long long p = (unsigned long long) seed[l] * jump;
+                unsigned int r = (unsigned int) (p & PM_m) + (unsigned int) (p >> 31);
+                seed[l] = (r >= PM_m) ? (r - PM_m) : r;
+                randoms_block[l] = (float) (((double) (int) seed[l]) / PM_m_FP);
+            }
+        }
+        PMseed = (int) seed[PRNG_lanes - 1];
+        i = blocks * PRNG_lanes;
+    }
+    for (; i<number_of_prns_CPU; i++) randoms_cpu[i] = PM_produce_one_CPU();
+}
 #ifndef CPU_RUN
 void                PRNG::XOR7_initialize(void)
 {
@@ -964,15 +1259,15 @@ void                PRNG::XOR7_initialize(void)
 #endif
 void                PRNG::XOR7_initialize_CPU(void)
 {
-        XOR7_state[0] = rand();
-        XOR7_state[1] = rand();
-        XOR7_state[2] = rand();
-        XOR7_state[3] = rand();
-
-        XOR7_state[4]  = rand();
-        XOR7_state[5]  = rand();
-        XOR7_state[6]  = rand();
-        XOR7_state[7]  = rand();
+        XOR7_state[0] = seed_CPU();
+        XOR7_state[1] = seed_CPU();
+        XOR7_state[2] = seed_CPU();
+        XOR7_state[3] = seed_CPU();
+
+        XOR7_state[4]  = seed_CPU();
+        XOR7_state[5]  = seed_CPU();
+        XOR7_state[6]  = seed_CPU();
+        XOR7_state[7]  = seed_CPU();
 }
 float               PRNG::XOR7_produce_one_CPU(void)
 {
@@ -1036,8 +1331,8 @@ void                PRNG::RANECU_initialize(void)
 #endif
 void                PRNG::RANECU_initialize_CPU(void)
 {
-        RANECU_jseed1 = rand() % 2147483647;
-        RANECU_jseed2 = rand() % 2147483647;
+        RANECU_jseed1 = seed_CPU() % 2147483647;
+        RANECU_jseed2 = seed_CPU() % 2147483647;
 }
 float               PRNG::RANECU_produce_one_CPU(void)
 {
@@ -1063,10 +1358,162 @@ void                PRNG::RANECU_produce_CPU(float* randoms_cpu)
     int number_of_prns_CPU = PRNG_samples * 4;
     for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = RANECU_produce_one_CPU();
 }
+void                PRNG::RANECU_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    // both LCGs are split into PRNG_lanes interleaved lanes (see PM_produce_batch_CPU);
+    // m = 2^31-c with small c, so p = hi*2^31+lo is reduced as hi*c+lo (twice) without division
+    int blocks = number_of_prns_CPU / PRNG_lanes;
+    int i = 0;
+    if (blocks > 1){
+        const unsigned long long jump1 = PRNG_lcg_power(RANECU_seedP13,PRNG_lanes,RANECU_icons1);
+        const unsigned long long jump2 = PRNG_lcg_power(RANECU_seedP23,PRNG_lanes,RANECU_icons2);
+        const unsigned int c1 = 0x80000000u - RANECU_icons1;
+        const unsigned int c2 = 0x80000000u - RANECU_icons2;
+        unsigned int seed1[PRNG_lanes], seed2[PRNG_lanes];
+        for (int l=0; l<PRNG_lanes; l++){
+            randoms_cpu[l] = RANECU_produce_one_CPU();
+            seed1[l] = (unsigned int) RANECU_jseed1;
+            seed2[l] = (unsigned int) RANECU_jseed2;
+        }
+        for (int b=1; b<blocks; b++){
+            float* randoms_block = randoms_cpu + b * PRNG_lanes;
+            for (int l=0; l<PRNG_lanes; l++){
+                unsigned long long p1 = (unsigned long long) seed1[l] * jump1;
+                unsigned long long p2 = (unsigned long long) seed2[l] * jump2;
+                p1 = (p1 >> 31) * c1 + (p1 & 0x7FFFFFFF);
+                p2 = (p2 >> 31) * c2 + (p2 & 0x7FFFFFFF);
+                unsigned int r1 = (unsigned int) (p1 >> 31) * c1 + (unsigned int) (p1 & 0x7FFFFFFF);
+                unsigned int r2 = (unsigned int) (p2 >> 31) * c2 + (unsigned int) (p2 & 0x7FFFFFFF);
+                seed1[l] = (r1 >= RANECU_icons1) ? (r1 - RANECU_icons1) : r1;
+                seed2[l] = (r2 >= RANECU_icons2) ? (r2 - RANECU_icons2) : r2;
+                int z = (int) seed1[l] - (int) seed2[l];
+                if (z < 1) {z = z + RANECU_icons3;}
+                randoms_block[l] = (float) ((float) (z)) / ((float) RANECU_twom31);
+            }
+        }
+        RANECU_jseed1 = (int) seed1[PRNG_lanes - 1];
+        RANECU_jseed2 = (int) seed2[PRNG_lanes - 1];
+        i = blocks * PRNG_lanes;
+    }
+    for (; i<number_of_prns_CPU; i++) randoms_cpu[i] = RANECU_produce_one_CPU();
+}
 void                PRNG::RANECU_produce_CPU(float* randoms_cpu,int number_of_prns_CPU)
 {
     for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = RANECU_produce_one_CPU();
 }
+void                PRNG::PHILOX_block(const unsigned int* counter,const unsigned int* key,unsigned int* result)
+{
+    // Philox4x32-10 (Salmon et al., SC'11), same rounds as philox4x32_10 in prngcl_philox.cl
+    unsigned int c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    unsigned int k0 = key[0], k1 = key[1];
+    for (int r=0; r<PHILOX_rounds; r++){
+        unsigned long long p0 = (unsigned long long) PHILOX_M0 * c0;
+        unsigned long long p1 = (unsigned long long) PHILOX_M1 * c2;
+        unsigned int hi0 = (unsigned int) (p0 >> 32), lo0 = (unsigned int) p0;
+        unsigned int hi1 = (unsigned int) (p1 >> 32), lo1 = (unsigned int) p1;
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+#ifndef CPU_RUN
+void                PRNG::PHILOX_initialize(void)
+{
+        char buffer_prng_cl[FNAME_MAX_LENGTH];
+        int  j = sprintf_s(buffer_prng_cl  ,FNAME_MAX_LENGTH,  "%s",GPU0->cl_root_path);
+             j+= sprintf_s(buffer_prng_cl+j,FNAME_MAX_LENGTH-j,"%s",SOURCE_PRNG);
+        random = GPU0->source_read(buffer_prng_cl);
+                 GPU0->program_create(random);
+
+        // counter-based: no seed table, instance GID of pass P produces blocks (i,GID,P,0), i<PRNG_samples
+        randoms_size            = GPU0->buffer_size_align(PRNG_instances * PRNG_samples);
+        PRNG_randoms            = (void*) calloc(randoms_size,sizeof(cl_float4));
+
+        PRNG_randoms_id    = GPU0->buffer_init(GPU0->buffer_type_IO, randoms_size,    PRNG_randoms,             sizeof(cl_float4));
+
+        int argument_id;
+        const size_t global_size[]  = {(size_t)PRNG_instances};                      // global_size
+
+        PRNG_randoms_kernel_id   = GPU0->kernel_init("philox",1,global_size,NULL);
+        argument_id = GPU0->kernel_init_buffer(PRNG_randoms_kernel_id,PRNG_randoms_id);
+        argument_id = GPU0->kernel_init_constant(PRNG_randoms_kernel_id,&PRNG_samples);
+        argument_id = GPU0->kernel_init_constant(PRNG_randoms_kernel_id,(int*) &PRNG_srandtime);
+        argument_id = GPU0->kernel_init_constant(PRNG_randoms_kernel_id,(int*) &PRNG_counter);
+        PHILOX_pass_argument_id = argument_id - 1;
+}
+#endif
+void                PRNG::PHILOX_initialize_CPU(void)
+{
+        PHILOX_key[0] = PRNG_srandtime;
+        PHILOX_key[1] = PHILOX_stream;
+        set_counter(PRNG_counter);
+}
+void                PRNG::PHILOX_next_block_CPU(void)
+{
+        unsigned int x[4];
+        PHILOX_block(PHILOX_counter,PHILOX_key,x);
+        // 23 bits + 1/2: exact in float, in (0;1), same as philox_to_float in prngcl_philox.cl
+        for (int k=0; k<4; k++) PHILOX_block_float[k] = ((float) (x[k] >> 9) + 0.5f) * PHILOX_twom23;
+        PHILOX_index = 0;
+
+        if (PHILOX_key[1] == PHILOX_keyed) {
+            PHILOX_counter[2]++;                                 // next hit
+        } else if ((int) (++PHILOX_counter[0]) >= PRNG_samples) {
+            PHILOX_counter[0] = 0;                               // instance 0 of next pass
+            PHILOX_counter[2]++;
+        }
+}
+void                PRNG::PHILOX_keyed_start(unsigned int sweep,unsigned int site,unsigned int dir)
+{
+        if (PHILOX_key[1] != PHILOX_keyed)
+            for (int k=0; k<4; k++) PHILOX_stream_counter[k] = PHILOX_counter[k];
+        PHILOX_key[0] = PRNG_srandtime;
+        PHILOX_key[1] = PHILOX_keyed;
+        PHILOX_counter[0] = site;
+        PHILOX_counter[1] = dir;
+        PHILOX_counter[2] = 0;
+        PHILOX_counter[3] = sweep;
+        PHILOX_index = 4;
+}
+void                PRNG::PHILOX_keyed_stop(void)
+{
+        if (PHILOX_key[1] != PHILOX_keyed) return;
+        for (int k=0; k<4; k++) PHILOX_counter[k] = PHILOX_stream_counter[k];
+        PHILOX_key[1] = PHILOX_stream;
+        PHILOX_index = 4;
+}
+float               PRNG::PHILOX_produce_one_CPU(void)
+{
+        if (PHILOX_index == 4) PHILOX_next_block_CPU();
+        return PHILOX_block_float[PHILOX_index++];
+}
+void                PRNG::PHILOX_produce_CPU(float* randoms_cpu)
+{
+    int number_of_prns_CPU = PRNG_samples * 4;
+    for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = PHILOX_produce_one_CPU();
+}
+void                PRNG::PHILOX_produce_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    for (int i=0; i<number_of_prns_CPU; i++) randoms_cpu[i] = PHILOX_produce_one_CPU();
+}
+void                PRNG::PHILOX_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU)
+{
+    int i = 0;
+    while ((i < number_of_prns_CPU) && (PHILOX_index < 4)) randoms_cpu[i++] = PHILOX_block_float[PHILOX_index++];
+    for (; i + 4 <= number_of_prns_CPU; i += 4){
+        PHILOX_next_block_CPU();
+        for (int k=0; k<4; k++) randoms_cpu[i + k] = PHILOX_block_float[k];
+        PHILOX_index = 4;
+    }
+    for (; i<number_of_prns_CPU; i++) randoms_cpu[i] = PHILOX_produce_one_CPU();
+}
 
 
 //+++ TODO: measure PRNG performance (samples per second)
@@ -23,7 +23,8 @@ class PRNG {
                 PRNG_generator_RANMAR,                  // RANMAR generator
                 PRNG_generator_PM,                      // Park-Miller generator
                 PRNG_generator_XOR7,                    // XORSeven generator
-                PRNG_generator_RANECU                   // RANECU generator
+                PRNG_generator_RANECU,                  // RANECU generator
+                PRNG_generator_PHILOX                   // Philox4x32-10 counter-based generator
             } PRNG_generators;
 
             typedef enum enum_PRNG_precision{
@@ -41,8 +42,11 @@ class PRNG {
        PRNG_precisions PRNG_precision;      // precision to be used
 
           unsigned int PRNG_srandtime;
+          unsigned int PRNG_stream;         // stream number of additional CPU instance (0: master instance, seeded by srand/rand)
+    unsigned long long PRNG_stream_state;   // splitmix64 state of seeds of additional CPU instance
 
           unsigned int PRNG_counter;        // counter runs of subroutine PRNG_produce
+                  bool PRNG_inline;         // PRNs are generated inline by consumer kernels: no output buffer and no producer kernel (XOR128)
 #ifndef CPU_RUN
             cl_uint*   PRNG_seeds;                      // input seed table (uint)
            cl_uint4*   PRNG_seeds4;                     // input seed table (uint4)
@@ -63,10 +67,22 @@ class PRNG {
 
           double  trunc(double x);
           void  initialize_CPU(void); //Nat
+    unsigned int  seed_CPU(void);                                                // seed for CPU generator initialization (rand() or splitmix64 of stream)
             void  initialize(void);                                              // PRNG initialization
             void  produce(void);                                                 // PRNG produce on GPU
             void  produce_CPU(float* randoms_cpu);                               // PRNG produce on CPU (float)
             void  produce_CPU(float* randoms_cpu,int number_of_prns_CPU);        // PRNG produce on CPU (float)
+            void  produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU);  // PRNG produce block on CPU (float), same sequence as produce_CPU
+            void  produce_ring_CPU(float* randoms_cpu,int number_of_prns_CPU);   // PRNG take from ring buffer on CPU (float), refilled by produce_batch_CPU
+     static void  benchmark_CPU(int number_of_prns_CPU);                         // PRNG throughput of scalar and batch producers for all generators
+            bool  counter_based(void);                                           // PRNG output depends on counters only (position may be set without replay)
+            void  set_counter(unsigned int counter);                             // PRNG set number of passes done (counter-based generators only)
+            void  skip_CPU(unsigned long long number_of_prns_CPU);              // PRNG skip ahead on CPU (jump for PM, RANECU, XOR128, PHILOX; others produce)
+#ifndef CPU_RUN
+    unsigned int  state_size(void);                                              // PRNG size of GPU generator state (in uints)
+    unsigned int* state_save(void);                                              // PRNG map GPU generator state (seed table)
+            void  state_load(unsigned int* state,unsigned int counter);          // PRNG restore GPU generator state after counter passes
+#endif
     unsigned int  check(void);                                                   // PRNG compare GPU results with CPU
     unsigned int  check_seeds(void);                                             // PRNG check GPU seeds table with CPU
     unsigned int  check_range(void);                                             // PRNG check GPU produced PRNs range (0;1)
@@ -76,6 +92,15 @@ class PRNG {
         // common public parameters
              int  RL_nskip;
 
+        // ___ PHILOX (public keyed access)_____________________________________________
+     static void  PHILOX_block(const unsigned int* counter,const unsigned int* key,unsigned int* result); // Philox4x32-10 block: 4 uints from 4-word counter and 2-word key
+            void  PHILOX_keyed_start(unsigned int sweep,unsigned int site,unsigned int dir);      // PHILOX start keyed stream (seed,sweep,site,dir,hit) for one link update
+            void  PHILOX_keyed_stop(void);                                                       // PHILOX return to pass-ordered stream
+#ifndef CPU_RUN
+        // ___ XOR128 (states for generation inside other kernels)______________________
+            void  XOR128_inline_states(cl_uint4* states,unsigned int size,unsigned int stream);   // XOR128 independent nonzero states of size work-items for (random series, stream)
+#endif
+
     unsigned int      convert_generator_to_uint(PRNG::PRNG_generators generator);
 PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
 
@@ -96,6 +121,12 @@ PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
     unsigned int* pointer_to_randoms;         // pointer to output randoms
     unsigned int  randoms_produced;           // whole number of produced numbers (from first produced number)
 
+        // ___ Ring buffer (CPU)________________________________________________________
+         #define  PRNG_ring_size    4096      // PRNs per refill of ring buffer
+         #define  PRNG_lanes        8         // interleaved lanes of batch LCG producers
+           float* ring_buffer;                // ring buffer for produce_ring_CPU
+             int  ring_position;              // next unused PRN in ring buffer (PRNG_ring_size - empty)
+
         // ___ RANLUX___________________________________________________________________
          #define  RL_icons  2147483563
          #define  RL_itwo24 16777216    // 1<<24
@@ -121,6 +152,8 @@ PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
         // ___ XOR128___________________________________________________________________
 #ifndef CPU_RUN
         cl_uint4  XOR128_state;
+#else
+          struct {unsigned int s[4];} XOR128_state;
 #endif
 
             void  XOR128_initialize(void);                                       // XOR128 generator initialization on GPU
@@ -129,6 +162,7 @@ PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
            float  XOR128_produce_one_CPU(void);                                  // XOR128 produce one prn on CPU (float)
             void  XOR128_produce_CPU(float* randoms_cpu);                        // XOR128 produce on CPU (float)
             void  XOR128_produce_CPU(float* randoms_cpu,int number_of_prns_CPU); // XOR128 produce on CPU (float)
+            void  XOR128_skip_CPU(unsigned long long number_of_prns_CPU);       // XOR128 jump by GF(2) matrix power
 
         // ___ RANMAR___________________________________________________________________
          #define  RM_CD (7654321.0 / 16777216.0)
@@ -165,6 +199,7 @@ PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
            float  PM_produce_one_CPU(void);                                      // PM produce one prn on CPU (float)
             void  PM_produce_CPU(float* randoms_cpu);                            // PM produce on CPU (float)
             void  PM_produce_CPU(float* randoms_cpu,int number_of_prns_CPU);     // PM produce on CPU (float)
+            void  PM_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU);   // PM produce on CPU by PRNG_lanes interleaved lanes (float)
 
         // ___ XORSeven (XOR7)__________________________________________________________
          #define  XOR7_m_FP   (4294967296.0)
@@ -204,6 +239,34 @@ PRNG::PRNG_generators convert_uint_to_generator(unsigned int generator);
            float  RANECU_produce_one_CPU(void);                                  // RANECU produce one prn on CPU (float)
             void  RANECU_produce_CPU(float* randoms_cpu);                        // RANECU produce on CPU (float)
             void  RANECU_produce_CPU(float* randoms_cpu,int number_of_prns_CPU); // RANECU produce on CPU (float)
+            void  RANECU_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU);   // RANECU produce on CPU by PRNG_lanes interleaved lanes (float)
+
+        // ___ PHILOX___________________________________________________________________
+         #define  PHILOX_M0     0xD2511F53u
+         #define  PHILOX_M1     0xCD9E8D57u
+         #define  PHILOX_W0     0x9E3779B9u   // golden ratio
+         #define  PHILOX_W1     0xBB67AE85u   // sqrt(3)-1
+         #define  PHILOX_rounds 10
+         #define  PHILOX_twom23 0.00000011920928955078125f    // 1/2^23
+         #define  PHILOX_stream 0             // key.y for pass-ordered buffer stream
+         #define  PHILOX_keyed  1             // key.y for (sweep,site,dir,hit) keyed stream
+
+    unsigned int  PHILOX_counter[4];          // counter of next block: (sample,instance,pass,0) or (site,dir,hit,sweep)
+    unsigned int  PHILOX_key[2];              // key: (seed,stream)
+           float  PHILOX_block_float[4];      // current block converted to (0,1)
+             int  PHILOX_index;               // next unused number of current block (4 - empty)
+    unsigned int  PHILOX_stream_counter[4];   // saved pass-ordered position while keyed stream is used
+#ifndef CPU_RUN
+             int  PHILOX_pass_argument_id;    // kernel argument for pass number
+#endif
+
+            void  PHILOX_initialize(void);                                       // PHILOX generator initialization on GPU (no seed table)
+            void  PHILOX_initialize_CPU(void);                                   // PHILOX generator initialization on CPU
+           float  PHILOX_produce_one_CPU(void);                                  // PHILOX produce one prn on CPU (float)
+            void  PHILOX_next_block_CPU(void);                                   // PHILOX advance counter and fill PHILOX_block_float
+            void  PHILOX_produce_CPU(float* randoms_cpu);                        // PHILOX produce on CPU (float)
+            void  PHILOX_produce_CPU(float* randoms_cpu,int number_of_prns_CPU); // PHILOX produce on CPU (float)
+            void  PHILOX_produce_batch_CPU(float* randoms_cpu,int number_of_prns_CPU);   // PHILOX produce on CPU by whole blocks (float)
 
 };
 };
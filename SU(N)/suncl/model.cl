@@ -132,6 +132,10 @@
 #define NHIT    10
 #endif
 
+#ifndef NHITPar
+#define NHITPar 1
+#endif
+
 #ifndef PRNGSTEP
 #define PRNGSTEP    (SITES / 2)
 #endif
@@ -565,5 +565,66 @@ reduce_polyakov_diff_z_double2(__global hgpu_double2 * lattice_measurement,
  #endif
 }
 
+                       __kernel void
+lattice_polyakov_field(__global hgpu_float4  * lattice_table,
+                       __global hgpu_double2 * lattice_polyakov_field,
+                       __global hgpu_float   * lattice_parameters)
+{
+    // per-site Polyakov loop (ReTr, ImTr) for correlator, element [x + N1 * (y + N2 * z)]
+    uint gindex;
+    uint gdi = GID;
+    lattice_gid_to_gid_xyz(&gdi,&gindex);
+
+    coords_4 coord;
+    coords_4 coord10;
+    uint gdiT;
+    uint site;
+#if SUN == 2
+    gpu_su_2 m0,m1;
+    su_2 v0,v1,v2;
+    su2_twist twist;
+    twist.phi   = lattice_parameters[1];
+#elif SUN == 3
+    gpu_su_3 m0,m1;
+    su_3 v0,v1,v2;
+    su3_twist twist;
+    twist.phi   = lattice_parameters[1];
+    twist.omega = lattice_parameters[2];
+#endif
+
+    if (GID<N1N2N3) {
+       lattice_gid_to_coords(&gindex,&coord);
+       site = coord.x + N1 * (coord.y + N2 * coord.z);
+#if SUN == 2
+       m0 = lattice_table_2(lattice_table,&coord,gindex,T,&twist);       // [p,T]
+       v0 = lattice_reconstruct2(&m0);
+#elif SUN == 3
+       m0 = lattice_table_3(lattice_table,&coord,gindex,T,&twist);       // [p,T]
+       v0 = lattice_reconstruct3(&m0);
+#endif
+       for (int i = 1; i < N4; i++){
+          lattice_neighbours_gid(&coord,&coord10,&gdiT,T);
+#if SUN == 2
+          m1 = lattice_table_2(lattice_table,&coord10,gdiT,T,&twist);   // [p,T]
+          v1 = lattice_reconstruct2(&m1);
+
+          v2 = matrix_times_su2(&v0,&v1);
+#elif SUN == 3
+          m1 = lattice_table_3(lattice_table,&coord10,gdiT,T,&twist);   // [p,T]
+          v1 = lattice_reconstruct3(&m1);
+
+          v2 = matrix_times_su3(&v0,&v1);
+#endif
+          v0 = v2;
+          coord = coord10;
+       }
+#if SUN == 2
+       lattice_polyakov_field[site] = (hgpu_double2) (matrix_retrace_su2(&v0),matrix_imtrace_su2(&v0));
+#elif SUN == 3
+       lattice_polyakov_field[site] = (hgpu_double2) (matrix_retrace_su3(&v0),matrix_imtrace_su3(&v0));
+#endif
+    }
+}
+
 #endif
 
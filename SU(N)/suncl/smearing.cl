@@ -0,0 +1,241 @@
+/******************************************************************************
+ * @file     smearing.cl
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Spatial smearing (APE, stout) of a copy of the gauge field
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2017 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#ifndef SMEARING_CL
+#define SMEARING_CL
+
+#include "complex.h"
+#include "model.cl"
+#include "misc.cl"
+#include "sun_common.cl"
+#if SUN == 2
+#include "su2cl.cl"
+#include "su2_matrix_memory.cl"
+#include "su2_update_cl.cl"
+#endif
+#if SUN == 3
+#include "su3cl.cl"
+#include "su3_matrix_memory.cl"
+#include "su3_update_cl.cl"
+#endif
+
+// SMEAR       - smearing type (1 - APE, 2 - stout)
+// SMEAR_ALPHA - APE weight alpha or stout parameter rho
+#ifndef SMEAR
+#define SMEAR       1
+#endif
+#ifndef SMEAR_ALPHA
+#define SMEAR_ALPHA 0.5
+#endif
+#define SMEAR_EXP_ORDER 6
+
+#if SUN == 2
+                    HGPU_INLINE_PREFIX su_2
+lattice_smear_staple_2(__global hgpu_float4 * lattice_table, uint gindex,const uint dir)
+{
+    coords_4 coord,coordMu,coordNu,coordNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiNm,gdiNmMu;
+    gpu_su_2 m1,m2,m3;
+    su_2 staple, staple1;
+
+    lattice_zero_2(&staple);
+    lattice_gid_to_coords(&gindex,&coord);
+    lattice_neighbours_gid(&coord,&coordMu,&gdiMu,dir);
+
+    for (uint nu = X; nu <= Z; nu++) {
+        if (nu == dir) continue;
+        lattice_neighbours_gid(&coord,&coordNu,&gdiNu,nu);
+        lattice_neighbours_gid_minus(&coord,&coordNm,&gdiNm,nu);
+        lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,dir);
+
+             m1 = lattice_table_notwist_2(lattice_table,gdiMu,nu);     // [p+mu,nu]
+             m2 = lattice_table_notwist_2(lattice_table,gdiNu,dir);    // [p+nu,mu]
+             m3 = lattice_table_notwist_2(lattice_table,gindex,nu);    // [p,nu]
+        staple1 = lattice_staple_hermitian2(&m1,&m2,&m3);
+         staple = matrix_add2(&staple,&staple1);
+
+             m1 = lattice_table_notwist_2(lattice_table,gdiNmMu,nu);   // [p-nu+mu,nu]
+             m2 = lattice_table_notwist_2(lattice_table,gdiNm,dir);    // [p-nu,mu]
+             m3 = lattice_table_notwist_2(lattice_table,gdiNm,nu);     // [p-nu,nu]
+        staple1 = lattice_staple_hermitian_backward2(&m1,&m2,&m3);
+         staple = matrix_add2(&staple,&staple1);
+    }
+
+    return staple;
+}
+
+                    HGPU_INLINE_PREFIX gpu_su_2
+lattice_smear_link_2(gpu_su_2* u,su_2* staple)
+{
+    gpu_su_2 result;
+    hgpu_float alpha = (hgpu_float) SMEAR_ALPHA;
+#if SMEAR == 2
+    // stout: U' = exp(iQ) U, iQ = traceless antihermitian part of rho * (U S)^+
+    gpu_su_2 e;
+    su_2 u1, p;
+    hgpu_float theta, f;
+
+    u1 = lattice_reconstruct2(u);
+    p  = matrix_times_su2(&u1,staple);
+    theta = alpha * sqrt(p.u2.re * p.u2.re + p.u1.im * p.u1.im + p.u2.im * p.u2.im);
+    f = (theta > (hgpu_float) 1.0e-12) ? (sin(theta) / theta) : (hgpu_float) 1.0;
+    e.uv1 = (hgpu_float4) (cos(theta), -alpha * f * p.u2.re, -alpha * f * p.u1.im, -alpha * f * p.u2.im);
+    result = matrix_times2(&e,u);
+#else
+    // APE: U' = Proj[(1 - alpha) U + alpha / 4 * S^+]
+    hgpu_float4 s;
+    s = (hgpu_float4) ((*staple).u1.re, (*staple).v1.re, -(*staple).u1.im, -(*staple).v1.im);
+    result.uv1 = (*u).uv1 * ((hgpu_float4) ((hgpu_float) 1.0 - alpha)) + s * ((hgpu_float4) (alpha / (hgpu_float) 4.0));
+#endif
+    lattice_su2_Normalize(&result);
+
+    return result;
+}
+#endif
+
+#if SUN == 3
+                    HGPU_INLINE_PREFIX su_3
+lattice_smear_staple_3(__global hgpu_float4 * lattice_table, uint gindex,const uint dir)
+{
+    coords_4 coord,coordMu,coordNu,coordNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiNm,gdiNmMu;
+    gpu_su_3 m1,m2,m3;
+    su_3 staple, staple1;
+
+    lattice_zero_3(&staple);
+    lattice_gid_to_coords(&gindex,&coord);
+    lattice_neighbours_gid(&coord,&coordMu,&gdiMu,dir);
+
+    for (uint nu = X; nu <= Z; nu++) {
+        if (nu == dir) continue;
+        lattice_neighbours_gid(&coord,&coordNu,&gdiNu,nu);
+        lattice_neighbours_gid_minus(&coord,&coordNm,&gdiNm,nu);
+        lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,dir);
+
+             m1 = lattice_table_notwist_3(lattice_table,gdiMu,nu);     // [p+mu,nu]
+             m2 = lattice_table_notwist_3(lattice_table,gdiNu,dir);    // [p+nu,mu]
+             m3 = lattice_table_notwist_3(lattice_table,gindex,nu);    // [p,nu]
+        staple1 = lattice_staple_hermitian3(&m1,&m2,&m3);
+         staple = matrix_add3(&staple,&staple1);
+
+             m1 = lattice_table_notwist_3(lattice_table,gdiNmMu,nu);   // [p-nu+mu,nu]
+             m2 = lattice_table_notwist_3(lattice_table,gdiNm,dir);    // [p-nu,mu]
+             m3 = lattice_table_notwist_3(lattice_table,gdiNm,nu);     // [p-nu,nu]
+        staple1 = lattice_staple_hermitian_backward3(&m1,&m2,&m3);
+         staple = matrix_add3(&staple,&staple1);
+    }
+
+    return staple;
+}
+
+                    HGPU_INLINE_PREFIX gpu_su_3
+lattice_smear_link_3(gpu_su_3* u,su_3* staple)
+{
+    gpu_su_3 result;
+    hgpu_float alpha = (hgpu_float) SMEAR_ALPHA;
+#if SMEAR == 2
+    // stout: U' = exp(iQ) U, iQ = traceless antihermitian part of rho * (U S)^+
+    su_3 u1, p, a, e;
+
+    u1 = lattice_reconstruct3(u);
+    p  = matrix_times_su3(&u1,staple);
+    a  = lattice_antihermitian3(&p,alpha);
+    e  = lattice_exp3(&a,SMEAR_EXP_ORDER);
+    p  = matrix_times_su3(&e,&u1);
+
+    result.uv1 = (hgpu_float4) (p.u1.re, p.u2.re, p.u3.re, p.v3.re);
+    result.uv2 = (hgpu_float4) (p.u1.im, p.u2.im, p.u3.im, p.v3.im);
+    result.uv3 = (hgpu_float4) (p.v1.re, p.v2.re, p.v1.im, p.v2.im);
+#else
+    // APE: U' = Proj[(1 - alpha) U + alpha / 4 * S^+]
+    gpu_su_3 s;
+    hgpu_float4 a1 = (hgpu_float4) ((hgpu_float) 1.0 - alpha);
+    hgpu_float4 a2 = (hgpu_float4) (alpha / (hgpu_float) 4.0);
+
+    s.uv1 = (hgpu_float4) ( (*staple).u1.re,  (*staple).v1.re,  (*staple).w1.re,  (*staple).w2.re);
+    s.uv2 = (hgpu_float4) (-(*staple).u1.im, -(*staple).v1.im, -(*staple).w1.im, -(*staple).w2.im);
+    s.uv3 = (hgpu_float4) ( (*staple).u2.re,  (*staple).v2.re, -(*staple).u2.im, -(*staple).v2.im);
+
+    result.uv1 = (*u).uv1 * a1 + s.uv1 * a2;
+    result.uv2 = (*u).uv2 * a1 + s.uv2 * a2;
+    result.uv3 = (*u).uv3 * a1 + s.uv3 * a2;
+#endif
+    lattice_GramSchmidt3(&result);
+
+    return result;
+}
+#endif
+
+                                        __kernel void
+lattice_smear(__global hgpu_float4 * lattice_table,
+              __global hgpu_float4 * lattice_smeared)
+{
+    // one smearing step: spatial links of lattice_table are smeared into lattice_smeared,
+    // temporal links are copied unchanged; lattice_table is read only
+#if SUN == 2
+    gpu_su_2 matrix;
+    su_2 staple;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= Z; dir++) {
+            matrix = lattice_table_notwist_2(lattice_table,GID,dir);
+            staple = lattice_smear_staple_2(lattice_table,GID,dir);
+            matrix = lattice_smear_link_2(&matrix,&staple);
+            lattice_store_2(lattice_smeared,&matrix,GID,dir);
+        }
+        matrix = lattice_table_notwist_2(lattice_table,GID,T);
+        lattice_store_2(lattice_smeared,&matrix,GID,T);
+    }
+#endif
+
+#if SUN == 3
+    gpu_su_3 matrix;
+    su_3 staple;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= Z; dir++) {
+            matrix = lattice_table_notwist_3(lattice_table,GID,dir);
+            staple = lattice_smear_staple_3(lattice_table,GID,dir);
+            matrix = lattice_smear_link_3(&matrix,&staple);
+            lattice_store_3(lattice_smeared,&matrix,GID,dir);
+        }
+        matrix = lattice_table_notwist_3(lattice_table,GID,T);
+        lattice_store_3(lattice_smeared,&matrix,GID,T);
+    }
+#endif
+}
+
+#endif
@@ -549,6 +549,100 @@ lattice_heatbath_2(su_2* staple,gpu_su_2* m0,hgpu_float* beta,__global const hgp
     return reslt;
 }
 
+                    HGPU_INLINE_PREFIX gpu_su_2
+lattice_overrelax_2(su_2* staple,gpu_su_2* m0)
+{
+    // microcanonical over-relaxation: U -> V^+ U^+ V^+, V = staple / sqrt(det(staple)); Re Tr(U staple) is unchanged
+    gpu_su_2 aH,m1,reslt;
+    hgpu_float4 M;
+    hgpu_float det;
+
+    M.x = ((*staple).u1.re + (*staple).v2.re);
+    M.y = ((*staple).u1.im - (*staple).v2.im);
+    M.z = ((*staple).u2.re - (*staple).v1.re);
+    M.w = ((*staple).u2.im + (*staple).v1.im);
+
+    det = sqrt(M.x * M.x + M.y * M.y + M.z * M.z + M.w * M.w);
+    if (det <= (hgpu_float) 0.0) return (*m0);
+
+    aH.uv1 = (hgpu_float4) (M.x, -M.z, -M.y, -M.w) / det;     // aH = V^+
+
+    m1    = matrix_hermitian2(m0);
+    m1    = matrix_times2(&aH,&m1);
+    reslt = matrix_times2(&m1,&aH);
+
+    return reslt;
+}
+
+
+#ifdef FUSED_UPDATE
+                    HGPU_INLINE_PREFIX_VOID void
+lattice_heatbath2_inline(su_2* a,hgpu_float* beta,prn_inline* prn)
+{
+    // Kennedy-Pendleton step of lattice_heatbath2 with random numbers generated inline (4 PRNs per try)
+    gpu_su_2 aH,c,d;
+    bool flag = false;
+    hgpu_float4 rnd,M;
+    hgpu_float det,bdet,cosrnd,delta;
+    hgpu_float costh,sinth,cosal,sinal,phi,sinphi,cosphi;
+
+    uint i = 0;
+
+    M.x = ((*a).u1.re + (*a).v2.re);
+    M.y = ((*a).u1.im - (*a).v2.im);
+    M.z = ((*a).u2.re - (*a).v1.re);
+    M.w = ((*a).u2.im + (*a).v1.im);
+
+    det = sqrt(M.x * M.x + M.y * M.y + M.z * M.z + M.w * M.w);
+
+    aH.uv1 = (hgpu_float4) (M.x, -M.z, -M.y, -M.w) / det;
+
+    bdet = (*beta) * det;
+
+    while ((i < NHIT) && (flag == false)){
+        rnd    = prn_inline_next(prn);
+        cosrnd = cos(PI2 * rnd.y);
+        delta  = -(log(1.0 - rnd.x) + cosrnd * cosrnd * log(1.0 - rnd.z)) / bdet;
+        if ((rnd.w * rnd.w)<=(1.0 - 0.5 * delta)) {flag=true;}
+        i++;
+    }
+
+        if (flag) {
+            rnd   = prn_inline_next(prn);
+            cosal = 1.0 - delta;
+            costh = 2.0 * rnd.x - 1.0;
+            sinth = sqrt(1.0 - costh * costh);
+            sinal = sqrt(1.0 - cosal * cosal);
+            phi   = PI2 * rnd.y;
+            sinphi = hgpu_sincos(phi,&cosphi);
+
+            c.uv1.x = cosal;
+            c.uv1.z = sinal * costh;
+            c.uv1.y = sinal * sinth * sinphi;
+            c.uv1.w = sinal * sinth * cosphi;
+
+            d = matrix_times2(&c,&aH);
+            (*a) = lattice_reconstruct2(&d);
+
+            *beta = -1.0;
+        }
+}
+
+                    HGPU_INLINE_PREFIX gpu_su_2
+lattice_heatbath_2_inline(su_2* staple,gpu_su_2* m0,hgpu_float* beta,prn_inline* prn)
+{
+    gpu_su_2 reslt;
+    hgpu_float bet = (*beta);
+
+    lattice_heatbath2_inline(staple,&bet,prn);
+    if (bet < 0.0)
+        reslt.uv1 = (hgpu_float4)((*staple).u1.re, (*staple).u2.re, (*staple).u1.im, (*staple).u2.im);
+    else
+        reslt = (*m0);
+
+    return reslt;
+}
+#endif
 #endif
                                                                                                                                                                   
                                                                                                                                                                   
@@ -147,6 +147,64 @@ matrix_add3(su_3* u,su_3* v)
     return tmp;
 }
 
+                    HGPU_INLINE_PREFIX su_3
+lattice_unity_plus3(su_3* a,hgpu_float f)
+{
+    // 1 + f * a
+    su_3 tmp;
+
+    tmp.u1.re = (hgpu_float) 1.0 + f * (*a).u1.re;   tmp.u1.im = f * (*a).u1.im;
+    tmp.u2.re =                    f * (*a).u2.re;   tmp.u2.im = f * (*a).u2.im;
+    tmp.u3.re =                    f * (*a).u3.re;   tmp.u3.im = f * (*a).u3.im;
+    tmp.v1.re =                    f * (*a).v1.re;   tmp.v1.im = f * (*a).v1.im;
+    tmp.v2.re = (hgpu_float) 1.0 + f * (*a).v2.re;   tmp.v2.im = f * (*a).v2.im;
+    tmp.v3.re =                    f * (*a).v3.re;   tmp.v3.im = f * (*a).v3.im;
+    tmp.w1.re =                    f * (*a).w1.re;   tmp.w1.im = f * (*a).w1.im;
+    tmp.w2.re =                    f * (*a).w2.re;   tmp.w2.im = f * (*a).w2.im;
+    tmp.w3.re = (hgpu_float) 1.0 + f * (*a).w3.re;   tmp.w3.im = f * (*a).w3.im;
+
+    return tmp;
+}
+
+                    HGPU_INLINE_PREFIX su_3
+lattice_antihermitian3(su_3* p,hgpu_float rho)
+{
+    // rho/2 * (P^+ - P) minus its trace
+    su_3 a;
+    hgpu_float h  = rho / (hgpu_float) 2.0;
+    hgpu_float tr = ((*p).u1.im + (*p).v2.im + (*p).w3.im) / (hgpu_float) 3.0;
+
+    a.u1.re = 0.0;                           a.u1.im = -rho * ((*p).u1.im - tr);
+    a.v2.re = 0.0;                           a.v2.im = -rho * ((*p).v2.im - tr);
+    a.w3.re = 0.0;                           a.w3.im = -rho * ((*p).w3.im - tr);
+
+    a.u2.re = h * ((*p).v1.re - (*p).u2.re); a.u2.im = -h * ((*p).v1.im + (*p).u2.im);
+    a.u3.re = h * ((*p).w1.re - (*p).u3.re); a.u3.im = -h * ((*p).w1.im + (*p).u3.im);
+    a.v3.re = h * ((*p).w2.re - (*p).v3.re); a.v3.im = -h * ((*p).w2.im + (*p).v3.im);
+
+    a.v1.re = -a.u2.re;                      a.v1.im = a.u2.im;
+    a.w1.re = -a.u3.re;                      a.w1.im = a.u3.im;
+    a.w2.re = -a.v3.re;                      a.w2.im = a.v3.im;
+
+    return a;
+}
+
+                    HGPU_INLINE_PREFIX su_3
+lattice_exp3(su_3* a,const int order)
+{
+    // exp(a), truncated at a^order (Horner scheme)
+    su_3 e, t;
+
+    lattice_zero_3(&t);
+    e = lattice_unity_plus3(&t,(hgpu_float) 0.0);
+    for (int k = order; k > 0; k--) {
+        t = matrix_times_su3(a,&e);
+        e = lattice_unity_plus3(&t,(hgpu_float) 1.0 / (hgpu_float) k);
+    }
+
+    return e;
+}
+
                     HGPU_INLINE_PREFIX gpu_su_2
 matrix_times2(gpu_su_2* u,gpu_su_2* v)
 {
@@ -778,6 +836,187 @@ for(int j = 0; j < NHITPar; j++)
         return reslt;
 }
 
+                    HGPU_INLINE_PREFIX_VOID void
+lattice_overrelax2(su_2* a)
+{
+    // SU(2) subgroup reflection: a -> V^+ V^+, V = a / sqrt(det(a)); no random numbers are used
+    gpu_su_2 aH,d;
+    hgpu_float det;
+
+    aH.uv1.x =  ((*a).u1.re + (*a).v2.re);
+    aH.uv1.z = -((*a).u1.im - (*a).v2.im);
+    aH.uv1.y = -((*a).u2.re - (*a).v1.re);
+    aH.uv1.w = -((*a).u2.im + (*a).v1.im);
+
+    det = sqrt(aH.uv1.x * aH.uv1.x + aH.uv1.y * aH.uv1.y + aH.uv1.z * aH.uv1.z + aH.uv1.w * aH.uv1.w);
+
+    if (det > (hgpu_float) 0.0) {
+        aH.uv1 /= det;
+        d = matrix_times2(&aH,&aH);
+        (*a) = lattice_reconstruct2(&d);
+    } else
+        lattice_unity_2(a);
+}
+
+                    HGPU_INLINE_PREFIX gpu_su_3
+lattice_overrelax3(su_3* staple,gpu_su_3* m0)
+{
+    // over-relaxation in the three SU(2) subgroups (same order and embedding as lattice_heatbath3)
+    gpu_su_3 reslt, Vg, m1, m2;
+    su_3 x0, U0;
+    su_2 r0;
+
+        U0 = lattice_reconstruct3(m0);
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  u2  0  \   //
+        r0.u2.re = x0.u2.re;    r0.u2.im = x0.u2.im;                               //   |  v1  v2  0  |   //
+        r0.v1.re = x0.v1.re;    r0.v1.im = x0.v1.im;                               //   \  0   0   1  /   //
+        r0.v2.re = x0.v2.re;    r0.v2.im = x0.v2.im;
+        lattice_overrelax2(&r0);
+
+        Vg.uv1 = (hgpu_float4) (r0.u1.re, r0.u2.re, 0.0, 0.0);
+        Vg.uv2 = (hgpu_float4) (r0.u1.im, r0.u2.im, 0.0, 0.0);
+        Vg.uv3 = (hgpu_float4) (r0.v1.re, r0.v2.re, r0.v1.im, r0.v2.im);
+        m1 = matrix_times3(&Vg,m0);
+        U0 = lattice_reconstruct3(&m1);
+
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  0  u2  \   //
+        r0.u2.re = x0.u3.re;    r0.u2.im = x0.u3.im;                               //   |  0   1  0   |   //
+        r0.v1.re = x0.w1.re;    r0.v1.im = x0.w1.im;                               //   \  v1  0  v2  /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+        lattice_overrelax2(&r0);
+
+        Vg.uv1 = (hgpu_float4) (r0.u1.re, 0.0, r0.u2.re, 0.0);
+        Vg.uv2 = (hgpu_float4) (r0.u1.im, 0.0, r0.u2.im, 0.0);
+        Vg.uv3 = (hgpu_float4) (0.0, 1.0, 0.0, 0.0);
+        m2 = matrix_times3(&Vg,&m1);
+        U0 = lattice_reconstruct3(&m2);
+
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.v2.re;    r0.u1.im = x0.v2.im;                               //   /  1   0   0  \   //
+        r0.u2.re = x0.v3.re;    r0.u2.im = x0.v3.im;                               //   |  0   u1  u2 |   //
+        r0.v1.re = x0.w2.re;    r0.v1.im = x0.w2.im;                               //   \  0   v1  v2 /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+        lattice_overrelax2(&r0);
+
+        Vg.uv1 = (hgpu_float4) (1.0, 0.0, 0.0, r0.u2.re);
+        Vg.uv2 = (hgpu_float4) (0.0, 0.0, 0.0, r0.u2.im);
+        Vg.uv3 = (hgpu_float4) (0.0, r0.u1.re, 0.0, r0.u1.im);
+        reslt = matrix_times3(&Vg,&m2);
+
+        lattice_GramSchmidt3(&reslt);
+
+        return reslt;
+}
+
+
+#ifdef FUSED_UPDATE
+                    HGPU_INLINE_PREFIX_VOID void
+lattice_heatbath2_inline(su_2* a,hgpu_float* beta,prn_inline* prn)
+{
+    // Kennedy-Pendleton step of lattice_heatbath2 with random numbers generated inline (4 PRNs per try)
+    gpu_su_2 aH,c,d;
+    bool flag = false;
+    hgpu_float4 rnd;
+    hgpu_float det,bdet,cosrnd,delta;
+    hgpu_float costh,sinth,cosal,sinal,phi,sinphi,cosphi;
+
+    uint i = 0;
+
+    aH.uv1.x =  ((*a).u1.re + (*a).v2.re);
+    aH.uv1.z = -((*a).u1.im - (*a).v2.im);
+    aH.uv1.y = -((*a).u2.re - (*a).v1.re);
+    aH.uv1.w = -((*a).u2.im + (*a).v1.im);
+
+    det = sqrt(aH.uv1.x * aH.uv1.x + aH.uv1.y * aH.uv1.y + aH.uv1.z * aH.uv1.z + aH.uv1.w * aH.uv1.w);
+    aH.uv1 /= det;
+
+    bdet = (*beta) * det;
+
+    while ((i < NHIT) && (flag == false)){
+        rnd    = prn_inline_next(prn);
+        cosrnd = cos(PI2 * rnd.y);
+        delta  = -(log(1.0 - rnd.x) + cosrnd * cosrnd * log(1.0 - rnd.z)) / bdet;
+        if ((rnd.w * rnd.w)<=(1.0 - 0.5 * delta)) {flag=true;}
+        i++;
+    }
+
+        if (flag) {
+            rnd   = prn_inline_next(prn);
+            cosal = 1.0 - delta;
+            costh = 2.0 * rnd.x - 1.0;
+            sinth = sqrt(1.0 - costh * costh);
+            sinal = sqrt(1.0 - cosal * cosal);
+            phi   = PI2 * rnd.y;
+            sinphi = hgpu_sincos(phi,&cosphi);
+
+            c.uv1.x = cosal;
+            c.uv1.z = sinal * costh;
+            c.uv1.y = sinal * sinth * sinphi;
+            c.uv1.w = sinal * sinth * cosphi;
+
+            d = matrix_times2(&c,&aH);
+            (*a) = lattice_reconstruct2(&d);
+        } else
+            lattice_unity_2(a);
+}
+
+                    HGPU_INLINE_PREFIX gpu_su_3
+lattice_heatbath3_inline(su_3* staple,gpu_su_3* m0,hgpu_float* beta,prn_inline* prn)
+{
+    // lattice_heatbath3 (same subgroups, order and NHITPar passes) with inline random numbers
+    gpu_su_3 reslt, Vg, m1, m2;
+    su_3 x0, U0;
+    su_2 r0;
+
+    reslt = (*m0);
+    for (int j = 0; j < NHITPar; j++){
+        U0 = lattice_reconstruct3(&reslt);
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  u2  0  \   //
+        r0.u2.re = x0.u2.re;    r0.u2.im = x0.u2.im;                               //   |  v1  v2  0  |   //
+        r0.v1.re = x0.v1.re;    r0.v1.im = x0.v1.im;                               //   \  0   0   1  /   //
+        r0.v2.re = x0.v2.re;    r0.v2.im = x0.v2.im;
+        lattice_heatbath2_inline(&r0,beta,prn);
+
+        Vg.uv1 = (hgpu_float4) (r0.u1.re, r0.u2.re, 0.0, 0.0);
+        Vg.uv2 = (hgpu_float4) (r0.u1.im, r0.u2.im, 0.0, 0.0);
+        Vg.uv3 = (hgpu_float4) (r0.v1.re, r0.v2.re, r0.v1.im, r0.v2.im);
+        m1 = matrix_times3(&Vg,&reslt);
+        U0 = lattice_reconstruct3(&m1);
+
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  0  u2  \   //
+        r0.u2.re = x0.u3.re;    r0.u2.im = x0.u3.im;                               //   |  0   1  0   |   //
+        r0.v1.re = x0.w1.re;    r0.v1.im = x0.w1.im;                               //   \  v1  0  v2  /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+        lattice_heatbath2_inline(&r0,beta,prn);
+
+        Vg.uv1 = (hgpu_float4) (r0.u1.re, 0.0, r0.u2.re, 0.0);
+        Vg.uv2 = (hgpu_float4) (r0.u1.im, 0.0, r0.u2.im, 0.0);
+        Vg.uv3 = (hgpu_float4) (0.0, 1.0, 0.0, 0.0);
+        m2 = matrix_times3(&Vg,&m1);
+        U0 = lattice_reconstruct3(&m2);
+
+        x0 = matrix_times_su3(&U0,staple);
+        r0.u1.re = x0.v2.re;    r0.u1.im = x0.v2.im;                               //   /  1   0   0  \   //
+        r0.u2.re = x0.v3.re;    r0.u2.im = x0.v3.im;                               //   |  0   u1  u2 |   //
+        r0.v1.re = x0.w2.re;    r0.v1.im = x0.w2.im;                               //   \  0   v1  v2 /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+        lattice_heatbath2_inline(&r0,beta,prn);
+
+        Vg.uv1 = (hgpu_float4) (1.0, 0.0, 0.0, r0.u2.re);
+        Vg.uv2 = (hgpu_float4) (0.0, 0.0, 0.0, r0.u2.im);
+        Vg.uv3 = (hgpu_float4) (0.0, r0.u1.re, 0.0, r0.u1.im);
+        reslt = matrix_times3(&Vg,&m2);
+
+        lattice_GramSchmidt3(&reslt);
+    }
+
+    return reslt;
+}
+#endif
 #endif
                                                                                                                                                                   
                                                                                                                                                                   
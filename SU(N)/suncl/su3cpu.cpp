@@ -62,7 +62,9 @@ SU::SU(void)
         strcpy_s(SU::directions[2],(strlen(direction_Z) + 1),direction_Z);
         strcpy_s(SU::directions[3],(strlen(direction_T) + 1),direction_T);
 
-    lattice_data = NULL;    // lattice data for CPU simulation
+    lattice_data   = NULL;  // lattice data for CPU simulation
+    lattice_source = NULL;
+    threads        = 1;     // measurements are run in calling thread
 }
 
 SU::~SU(void)
@@ -166,7 +168,10 @@ SU::su_3        SU::lattice_matrix_reconstruct3(SU::su_3 a){
 SU::su_3        SU::lattice_table_3(model* lat,coords_4 coords,unsigned int gindex,int dir){
     SU::su_3 result;
     SU::su_3 m_omega;
-    result = lattice_data[gindex + lat->lattice_table_row_size * dir];
+    if (lattice_data != NULL)
+        result = lattice_data[gindex + lat->lattice_table_row_size * dir];
+    else
+        result = lattice_get_3(lat,lattice_source,gindex,dir);    // no CPU copy of lattice: read state directly (sampled check)
 
     if ((dir==1) && (coords.x == (lat->lattice_full_size[0]-1))) {
         double phi_p_omega_2   = 0.5 * (lat->PHI   + lat->OMEGA);
@@ -1130,11 +1135,47 @@ unsigned int    SU::lattice_odd_gid(model* lat,unsigned int gid){
     return gindex;
 }
 
+void            SU::lattice_slices_cpu(model* lat,int slices,int values,void (SU::*slice)(model*,int,double*),double* sums){
+    // slice(lat,x1,...) is run for every x1 on threads, partial sums of slices are added in order x1 = 0..slices-1
+    // (compensated summation), so the result does not depend on the number of threads
+    double* partial = (double*) calloc(slices * values + 1, sizeof(double));
+    int workers = (threads < slices) ? threads : slices;
+    if (workers > 1) {
+        std::thread* pool = new std::thread[workers - 1];
+        for (int w = 1; w < workers; w++)
+            pool[w - 1] = std::thread([this,lat,slices,values,slice,partial,workers,w]() {
+                for (int x1 = w; x1 < slices; x1 += workers) (this->*slice)(lat,x1,partial + x1 * values);
+            });
+        for (int x1 = 0; x1 < slices; x1 += workers) (this->*slice)(lat,x1,partial + x1 * values);
+        for (int w = 1; w < workers; w++) pool[w - 1].join();
+        delete[] pool;
+    } else
+        for (int x1 = 0; x1 < slices; x1++) (this->*slice)(lat,x1,partial + x1 * values);
+
+    for (int v = 0; v < values; v++) {
+        double sum = 0.0;
+        double compensation = 0.0;
+        for (int x1 = 0; x1 < slices; x1++) {
+            double y = partial[x1 * values + v] - compensation;
+            double t = sum + y;
+            compensation = (t - sum) - y;
+            sum = t;
+        }
+        sums[v] = sum;
+    }
+    free(partial);
+}
+
 void            SU::lattice_load_cpu(model* lat,unsigned int* lattice_pointer){
+    lattice_source = lattice_pointer;
+    lattice_slices_cpu(lat,lat->lattice_domain_n1,0,&SU::lattice_load_slice_cpu,NULL);
+    lattice_source = NULL;
+}
+
+void            SU::lattice_load_slice_cpu(model* lat,int x1,double* sums){
         coords_4 coords;
         unsigned int gdi;
         su_3 matrix;
-        for (int x1 = 0; x1 < lat->lattice_domain_n1; x1++)
             for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
             for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
             for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++)
@@ -1146,14 +1187,25 @@ void            SU::lattice_load_cpu(model* lat,unsigned int* lattice_pointer){
                         coords.t = x4;
 
                         gdi = lattice_coords_to_gid(lat,coords);
-                        matrix = lattice_get_3(lat,lattice_pointer,gdi,dir1);
+                        matrix = lattice_get_3(lat,lattice_source,gdi,dir1);
                         lattice_store_3(lat,matrix,gdi,dir1);
             }
-
 }
 
 double*         SU::lattice_avr_plaquette_cpu(model* lat){
     double* result = new double[2];
+    double sums[2];
+    lattice_slices_cpu(lat,lat->lattice_domain_size[0],2,&SU::lattice_avr_plaquette_slice_cpu,sums);
+    double plq_spat = sums[0];
+    double plq_temp = sums[1];
+
+        result[0] = plq_spat / ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
+        result[1] = plq_temp / ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
+
+        return result;
+}
+
+void            SU::lattice_avr_plaquette_slice_cpu(model* lat,int x1,double* sums){
     coords_4 coords,coords2,coords3;
 
     double plq_spat = 0.0;
@@ -1164,7 +1216,6 @@ double*         SU::lattice_avr_plaquette_cpu(model* lat){
     su_3 matrix_1,matrix_2,matrix_3,matrix_4,plaquette;
     double mult = lat->BETA / ((double) lat->lattice_group);
 
-    for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
         for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
             for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
                 for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++)
@@ -1203,14 +1254,76 @@ double*         SU::lattice_avr_plaquette_cpu(model* lat){
                     }
                 }
 
-        result[0] = plq_spat / ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
-        result[1] = plq_temp / ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
-
-        return result;
+    sums[0] = plq_spat;
+    sums[1] = plq_temp;
 }
 
 double*         SU::lattice_avr_plaquette_plq_cpu(model* lat){
     double* result = new double[26];
+    double sums[26];
+    lattice_slices_cpu(lat,lat->lattice_full_size[0],26,&SU::lattice_avr_plaquette_plq_slice_cpu,sums);
+    double plq_spat           = sums[ 0];
+    double plq_temp           = sums[ 1];
+    double F_xy_3_re_temp     = sums[ 2];
+    double F_xy_3_im_temp     = sums[ 3];
+    double F_xz_3_re_temp     = sums[ 4];
+    double F_xz_3_im_temp     = sums[ 5];
+    double F_yz_3_re_temp     = sums[ 6];
+    double F_yz_3_im_temp     = sums[ 7];
+    double F_xy_8_re_temp     = sums[ 8];
+    double F_xy_8_im_temp     = sums[ 9];
+    double F_xz_8_re_temp     = sums[10];
+    double F_xz_8_im_temp     = sums[11];
+    double F_yz_8_re_temp     = sums[12];
+    double F_yz_8_im_temp     = sums[13];
+    double F_xy_3_re_variance = sums[14];
+    double F_xy_3_im_variance = sums[15];
+    double F_xz_3_re_variance = sums[16];
+    double F_xz_3_im_variance = sums[17];
+    double F_yz_3_re_variance = sums[18];
+    double F_yz_3_im_variance = sums[19];
+    double F_xy_8_re_variance = sums[20];
+    double F_xy_8_im_variance = sums[21];
+    double F_xz_8_re_variance = sums[22];
+    double F_xz_8_im_variance = sums[23];
+    double F_yz_8_re_variance = sums[24];
+    double F_yz_8_im_variance = sums[25];
+
+    double denominator1 = ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
+    double denominator2 = ((double) (lat->lattice_full_site));
+
+        result[ 0] = plq_spat       / denominator1;
+        result[ 1] = plq_temp       / denominator1;
+        result[ 2] = F_xy_3_re_temp / denominator2;
+        result[ 3] = F_xy_3_im_temp / denominator2;
+        result[ 4] = F_xz_3_re_temp / denominator2;
+        result[ 5] = F_xz_3_im_temp / denominator2;
+        result[ 6] = F_yz_3_re_temp / denominator2;
+        result[ 7] = F_yz_3_im_temp / denominator2;
+        result[ 8] = F_xy_8_re_temp / denominator2;
+        result[ 9] = F_xy_8_im_temp / denominator2;
+        result[10] = F_xz_8_re_temp / denominator2;
+        result[11] = F_xz_8_im_temp / denominator2;
+        result[12] = F_yz_8_re_temp / denominator2;
+        result[13] = F_yz_8_im_temp / denominator2;
+
+        result[14] = F_xy_3_re_variance / denominator2 - result[ 2] * result[ 2];
+        result[15] = F_xy_3_im_variance / denominator2 - result[ 3] * result[ 3];
+        result[16] = F_xz_3_re_variance / denominator2 - result[ 4] * result[ 4];
+        result[17] = F_xz_3_im_variance / denominator2 - result[ 5] * result[ 5];
+        result[18] = F_yz_3_re_variance / denominator2 - result[ 6] * result[ 6];
+        result[19] = F_yz_3_im_variance / denominator2 - result[ 7] * result[ 7];
+        result[20] = F_xy_8_re_variance / denominator2 - result[ 8] * result[ 8];
+        result[21] = F_xy_8_im_variance / denominator2 - result[ 9] * result[ 9];
+        result[22] = F_xz_8_re_variance / denominator2 - result[10] * result[10];
+        result[23] = F_xz_8_im_variance / denominator2 - result[11] * result[11];
+        result[24] = F_yz_8_re_variance / denominator2 - result[12] * result[12];
+        result[25] = F_yz_8_im_variance / denominator2 - result[13] * result[13];
+
+        return result;
+}
+
+void            SU::lattice_avr_plaquette_plq_slice_cpu(model* lat,int x1,double* sums){
     coords_4 coords,coords2,coords3;
 
     double plq_spat = 0.0;
@@ -1245,14 +1358,10 @@ double*         SU::lattice_avr_plaquette_plq_cpu(model* lat){
     double F_yz_8_re_variance = 0.0;
     double F_yz_8_im_variance = 0.0;
 
-    double denominator1 = ((double) (lat->lattice_full_site * (lat->lattice_nd - 1)));
-    double denominator2 = ((double) (lat->lattice_full_site));
-
     unsigned int gdi,gdi2,gdi3;
     su_3 matrix_1,matrix_2,matrix_3,matrix_4,plaquette;
     su_3 matrix_5;
 
-    for (int x1 = 0; x1 < lat->lattice_full_size[0]; x1++)
         for (int x2 = 0; x2 < lat->lattice_full_size[1]; x2++)
             for (int x3 = 0; x3 < lat->lattice_full_size[2]; x3++)
                 for (int x4 = 0; x4 < lat->lattice_full_size[3]; x4++)
@@ -1349,39 +1458,52 @@ double*         SU::lattice_avr_plaquette_plq_cpu(model* lat){
                     }
                 }
 
-        result[ 0] = plq_spat       / denominator1;
-        result[ 1] = plq_temp       / denominator1;
-        result[ 2] = F_xy_3_re_temp / denominator2;
-        result[ 3] = F_xy_3_im_temp / denominator2;
-        result[ 4] = F_xz_3_re_temp / denominator2;
-        result[ 5] = F_xz_3_im_temp / denominator2;
-        result[ 6] = F_yz_3_re_temp / denominator2;
-        result[ 7] = F_yz_3_im_temp / denominator2;
-        result[ 8] = F_xy_8_re_temp / denominator2;
-        result[ 9] = F_xy_8_im_temp / denominator2;
-        result[10] = F_xz_8_re_temp / denominator2;
-        result[11] = F_xz_8_im_temp / denominator2;
-        result[12] = F_yz_8_re_temp / denominator2;
-        result[13] = F_yz_8_im_temp / denominator2;
-
-        result[14] = F_xy_3_re_variance / denominator2 - result[ 2] * result[ 2];
-        result[15] = F_xy_3_im_variance / denominator2 - result[ 3] * result[ 3];
-        result[16] = F_xz_3_re_variance / denominator2 - result[ 4] * result[ 4];
-        result[17] = F_xz_3_im_variance / denominator2 - result[ 5] * result[ 5];
-        result[18] = F_yz_3_re_variance / denominator2 - result[ 6] * result[ 6];
-        result[19] = F_yz_3_im_variance / denominator2 - result[ 7] * result[ 7];
-        result[20] = F_xy_8_re_variance / denominator2 - result[ 8] * result[ 8];
-        result[21] = F_xy_8_im_variance / denominator2 - result[ 9] * result[ 9];
-        result[22] = F_xz_8_re_variance / denominator2 - result[10] * result[10];
-        result[23] = F_xz_8_im_variance / denominator2 - result[11] * result[11];
-        result[24] = F_yz_8_re_variance / denominator2 - result[12] * result[12];
-        result[25] = F_yz_8_im_variance / denominator2 - result[13] * result[13];
-
-        return result;
+    sums[ 0] = plq_spat;
+    sums[ 1] = plq_temp;
+    sums[ 2] = F_xy_3_re_temp;
+    sums[ 3] = F_xy_3_im_temp;
+    sums[ 4] = F_xz_3_re_temp;
+    sums[ 5] = F_xz_3_im_temp;
+    sums[ 6] = F_yz_3_re_temp;
+    sums[ 7] = F_yz_3_im_temp;
+    sums[ 8] = F_xy_8_re_temp;
+    sums[ 9] = F_xy_8_im_temp;
+    sums[10] = F_xz_8_re_temp;
+    sums[11] = F_xz_8_im_temp;
+    sums[12] = F_yz_8_re_temp;
+    sums[13] = F_yz_8_im_temp;
+    sums[14] = F_xy_3_re_variance;
+    sums[15] = F_xy_3_im_variance;
+    sums[16] = F_xz_3_re_variance;
+    sums[17] = F_xz_3_im_variance;
+    sums[18] = F_yz_3_re_variance;
+    sums[19] = F_yz_3_im_variance;
+    sums[20] = F_xy_8_re_variance;
+    sums[21] = F_xy_8_im_variance;
+    sums[22] = F_xz_8_re_variance;
+    sums[23] = F_xz_8_im_variance;
+    sums[24] = F_yz_8_re_variance;
+    sums[25] = F_yz_8_im_variance;
 }
 
 double*         SU::lattice_avr_Polyakov_loop_cpu(model* lat){
     double* result = new double[4];
+    double sums[4];
+    lattice_slices_cpu(lat,lat->lattice_domain_size[0],4,&SU::lattice_avr_Polyakov_loop_slice_cpu,sums);
+    double polyakov_loop    = sums[0];
+    double polyakov_loop_im = sums[1];
+    double polyakov_loop_P2 = sums[2];
+    double polyakov_loop_P4 = sums[3];
+
+    result[0] = (polyakov_loop    / (lat->lattice_full_n1n2n3 * lat->lattice_group));
+    result[1] = (polyakov_loop_im / (lat->lattice_full_n1n2n3 * lat->lattice_group));
+    result[2] = (polyakov_loop_P2 / (lat->lattice_full_n1n2n3 * lat->lattice_group * lat->lattice_group));
+    result[3] = (polyakov_loop_P4 / (lat->lattice_full_n1n2n3 * lat->lattice_group * lat->lattice_group * lat->lattice_group * lat->lattice_group));
+
+    return result;
+}
+
+void            SU::lattice_avr_Polyakov_loop_slice_cpu(model* lat,int x1,double* sums){
     coords_4 coords;
     double polyakov_loop    = 0.0;
     double polyakov_loop_im = 0.0;
@@ -1394,7 +1516,6 @@ double*         SU::lattice_avr_Polyakov_loop_cpu(model* lat){
     su_3 matrix_1,matrix_2,matrix_3;
 
     int dir1 = 3;
-    for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
         for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
             for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++) {
                 coords.x = x1;
@@ -1424,16 +1545,23 @@ double*         SU::lattice_avr_Polyakov_loop_cpu(model* lat){
                 polyakov_loop_P2 += pl_loop_P2;
                 polyakov_loop_P4 += pl_loop_P2 * pl_loop_P2;
             }
-    result[0] = (polyakov_loop    / (lat->lattice_full_n1n2n3 * lat->lattice_group));
-    result[1] = (polyakov_loop_im / (lat->lattice_full_n1n2n3 * lat->lattice_group));
-    result[2] = (polyakov_loop_P2 / (lat->lattice_full_n1n2n3 * lat->lattice_group * lat->lattice_group));
-    result[3] = (polyakov_loop_P4 / (lat->lattice_full_n1n2n3 * lat->lattice_group * lat->lattice_group * lat->lattice_group * lat->lattice_group));
 
-    return result;
+    sums[0] = polyakov_loop;
+    sums[1] = polyakov_loop_im;
+    sums[2] = polyakov_loop_P2;
+    sums[3] = polyakov_loop_P4;
 }
 
 double          SU::lattice_avr_Wilson_loop_cpu(model* lat){
     double result;
+    double wilson_loop;
+    lattice_slices_cpu(lat,lat->lattice_domain_size[0],1,&SU::lattice_avr_Wilson_loop_slice_cpu,&wilson_loop);
+
+    result = wilson_loop / ((double) (lat->lattice_full_site * lat->lattice_group));
+    return result;
+}
+
+void            SU::lattice_avr_Wilson_loop_slice_cpu(model* lat,int x1,double* sums){
     coords_4 coords,coords2,coords3,coords_l,coords_r;
     coords_4 coords0,coords1;
     double wilson_loop    = 0.0;
@@ -1441,7 +1569,6 @@ double          SU::lattice_avr_Wilson_loop_cpu(model* lat){
     su_3 matrix_2,matrix_3,matrix_l,matrix_r,matrix_t,matrix_b,plaquette;
 
     int dir1 = 3;
-    for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
         for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
             for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
                 for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++) {
@@ -1517,10 +1644,188 @@ double          SU::lattice_avr_Wilson_loop_cpu(model* lat){
                         wilson_loop += lattice_retrace(plaquette);
                     }
             }
-            result = wilson_loop / ((double) (lat->lattice_full_site * lat->lattice_group));
+
+    sums[0] = wilson_loop;
+}
+
+double*         SU::lattice_avr_Wilson_loop_grid_cpu(model* lat){
+    // reference W(R,T): every loop is built from its own link products
+    int grid = lat->wilson_Rmax * lat->wilson_Tmax;
+    double* result = new double[grid];
+    coords_4 coords,coords_r,coords_t;
+    su_3 matrix_b,matrix_r,matrix_t,matrix_l,plaquette;
+
+    for (int i = 0; i < grid; i++) result[i] = 0.0;
+
+    int dir1 = 3;
+    for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
+        for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
+            for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
+                for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++) {
+                    coords.x = x1;
+                    coords.y = x2;
+                    coords.z = x3;
+                    coords.t = x4;
+                    for (int dir2 = 0; dir2 < (lat->lattice_nd - 1); dir2++){
+                        coords_r = coords;
+                        for (int x_r = 1; x_r <= lat->wilson_Rmax; x_r++){
+                            coords_r = lattice_neighbours_coords(lat,coords_r,dir2);    // p + R
+                            matrix_l = lattice_line_cpu(lat,coords,dir2,x_r);            // left link
+                            coords_t = coords;
+                            for (int x_t = 1; x_t <= lat->wilson_Tmax; x_t++){
+                                coords_t = lattice_neighbours_coords(lat,coords_t,dir1); // p + T
+                                matrix_b = lattice_line_cpu(lat,coords,dir1,x_t);       // bottom link
+                                matrix_r = lattice_line_cpu(lat,coords_t,dir2,x_r);     // right link
+                                matrix_t = lattice_line_cpu(lat,coords_r,dir1,x_t);     // top link
+                                plaquette = lattice_plaquette3(matrix_b,matrix_r,matrix_t,matrix_l);
+                                result[(x_r - 1) * lat->wilson_Tmax + (x_t - 1)] += lattice_retrace(plaquette);
+                            }
+                        }
+                    }
+            }
+    for (int i = 0; i < grid; i++) result[i] /= ((double) (lat->lattice_full_site * 3));
+    return result;
+}
+
+double*         SU::lattice_Polyakov_loop_correlator_cpu(model* lat){
+    // reference correlator: direct sum over all pairs of spatial sites, bins are taken from lat
+    int n1 = lat->lattice_domain_size[0];
+    int n2 = lat->lattice_domain_size[1];
+    int n3 = lat->lattice_domain_size[2];
+    int volume = n1 * n2 * n3;
+    double* pl_re  = new double[volume];
+    double* pl_im  = new double[volume];
+    double* result = new double[lat->polyakov_correlator_bins];
+    coords_4 coords;
+    su_3 line;
+
+    int dir1 = 3;
+    for (int x1 = 0; x1 < n1; x1++)
+        for (int x2 = 0; x2 < n2; x2++)
+            for (int x3 = 0; x3 < n3; x3++) {
+                coords.x = x1;
+                coords.y = x2;
+                coords.z = x3;
+                coords.t = 0;
+                line = lattice_line_cpu(lat,coords,dir1,lat->lattice_domain_size[3]);
+                pl_re[x1 + n1 * (x2 + n2 * x3)] = lattice_retrace(line);
+                pl_im[x1 + n1 * (x2 + n2 * x3)] = lattice_imtrace(line);
+            }
+    for (unsigned int b = 0; b < lat->polyakov_correlator_bins; b++) result[b] = 0.0;
+    for (int site = 0; site < volume; site++)
+        for (int r3 = 0; r3 < n3; r3++)
+            for (int r2 = 0; r2 < n2; r2++)
+                for (int r1 = 0; r1 < n1; r1++) {
+                    int x1 = (site % n1 + r1) % n1;
+                    int x2 = ((site / n1) % n2 + r2) % n2;
+                    int x3 = (site / (n1 * n2) + r3) % n3;
+                    int site2 = x1 + n1 * (x2 + n2 * x3);
+                    result[lat->polyakov_correlator_bin[r1 + n1 * (r2 + n2 * r3)]] += pl_re[site] * pl_re[site2] + pl_im[site] * pl_im[site2];
+                }
+    for (unsigned int b = 0; b < lat->polyakov_correlator_bins; b++)
+        result[b] /= ((double) lat->polyakov_correlator_count[b] * volume * lat->lattice_group * lat->lattice_group);
+    delete[] pl_re;
+    delete[] pl_im;
     return result;
 }
 
+SU::su_3        SU::lattice_matrix_scale3(SU::su_3 a,double c){
+    hgpu_complex* m = (hgpu_complex*) &a;
+    for (int i = 0; i < 9; i++){
+        m[i].re *= c;
+        m[i].im *= c;
+    }
+    return a;
+}
+
+SU::su_3        SU::lattice_antihermitian3(SU::su_3 p,double rho){
+    // rho/2 * (P^+ - P) minus its trace (as lattice_antihermitian3 in su3_update_cl.cl)
+    su_3 a = lattice_matrix_scale3(lattice_matrix_add3(lattice_matrix_hermitian(p),lattice_matrix_scale3(p,-1.0)),0.5 * rho);
+    double tr = (a.u1.im + a.v2.im + a.w3.im) / 3.0;
+    a.u1.im -= tr;
+    a.v2.im -= tr;
+    a.w3.im -= tr;
+    return a;
+}
+
+SU::su_3        SU::lattice_exp3(SU::su_3 a,int order){
+    // exp(a), truncated at a^order (Horner scheme)
+    su_3 e = lattice_unity3();
+    for (int k = order; k > 0; k--)
+        e = lattice_matrix_add3(lattice_unity3(),lattice_matrix_scale3(lattice_matrix_times3(a,e),1.0 / k));
+    return e;
+}
+
+SU::su_3        SU::lattice_smear_link_cpu(model* lat,SU::su_3 u,SU::su_3 staple){
+    su_3 result;
+    double alpha = lat->smear_alpha;
+    if (lat->smear_type == 2) {
+        // stout: U' = exp(iQ) U, iQ = traceless antihermitian part of alpha * (U S)^+ (exponent up to 6th order, as in smearing.cl)
+        su_3 a = lattice_antihermitian3(lattice_matrix_times3(u,staple),alpha);
+        result = lattice_matrix_times3(lattice_exp3(a,6),u);
+    } else
+        // APE: U' = Proj[(1 - alpha) U + alpha / 4 * S^+]
+        result = lattice_matrix_add3(lattice_matrix_scale3(u,1.0 - alpha),lattice_matrix_scale3(lattice_matrix_hermitian(staple),0.25 * alpha));
+    return lattice_GramSchmidt_3(result);
+}
+
+void            SU::lattice_smear_cpu(model* lat){
+    // smearing of spatial links of the CPU copy of lattice (reference for smearing.cl); lattice_data is replaced by the smeared copy
+    unsigned int row = lat->lattice_table_row_size;
+    int dir_t = lat->lattice_nd - 1;
+    coords_4 coords,coords1,coords2;
+    su_3 staple;
+    su_3* smeared = (su_3*) calloc(row * lat->lattice_nd, sizeof(su_3));
+
+    for (int step = 0; step < lat->smear_steps; step++){
+        for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
+        for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
+        for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
+        for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++) {
+            coords.x = x1;
+            coords.y = x2;
+            coords.z = x3;
+            coords.t = x4;
+            unsigned int gdi = lattice_coords_to_gid(lat,coords);
+            for (int dir1 = 0; dir1 < dir_t; dir1++){
+                staple = lattice_zero3();
+                for (int dir2 = 0; dir2 < dir_t; dir2++) if (dir2 != dir1) {
+                    coords1 = lattice_neighbours_coords(lat,coords,dir1);
+                    coords2 = lattice_neighbours_coords(lat,coords,dir2);
+                    staple = lattice_matrix_add3(staple,lattice_staple_hermitian3(lattice_data[lattice_coords_to_gid(lat,coords1) + row * dir2],
+                                                                                  lattice_data[lattice_coords_to_gid(lat,coords2) + row * dir1],
+                                                                                  lattice_data[gdi + row * dir2]));
+                    coords2 = lattice_neighbours_coords_backward(lat,coords,dir2);
+                    coords1 = lattice_neighbours_coords(lat,coords2,dir1);
+                    staple = lattice_matrix_add3(staple,lattice_staple_hermitian_backward3(lattice_data[lattice_coords_to_gid(lat,coords1) + row * dir2],
+                                                                                           lattice_data[lattice_coords_to_gid(lat,coords2) + row * dir1],
+                                                                                           lattice_data[lattice_coords_to_gid(lat,coords2) + row * dir2]));
+                }
+                smeared[gdi + row * dir1] = lattice_smear_link_cpu(lat,lattice_data[gdi + row * dir1],staple);
+            }
+            smeared[gdi + row * dir_t] = lattice_data[gdi + row * dir_t];
+        }
+        su_3* tmp    = lattice_data;
+        lattice_data = smeared;
+        smeared      = tmp;
+    }
+    free(smeared);
+}
+
+SU::su_3        SU::lattice_line_cpu(model* lat,coords_4 coords,int dir,int length){
+    unsigned int gdi = lattice_coords_to_gid(lat,coords);
+    su_3 matrix_1,matrix_2;
+    su_3 line = lattice_table_3(lat,coords,gdi,dir);
+    for (int i = 1; i < length; i++){
+        coords   = lattice_neighbours_coords(lat,coords,dir);
+        gdi      = lattice_coords_to_gid(lat,coords);
+        matrix_1 = lattice_table_3(lat,coords,gdi,dir);
+        matrix_2 = lattice_matrix_times3(line,matrix_1);
+        line     = matrix_2;
+    }
+    return line;
+}
+
 double*         SU::lattice_plaquette_cpu(model* lat,coords_4 coords){
     double* result = new double[2];
     coords_4 coords2,coords3;
@@ -1613,7 +1918,163 @@ SU::su_3        SU::lattice_get_staple_cpu(model* lat,SU::coords_4 coords,int di
         return matrix_5;
 }
 
+SU::su_3        SU::lattice_flow_clover_cpu(model* lat,SU::coords_4 coords,int mu,int nu){
+    // G_munu = (Q - Q^+)/8 without trace, Q - sum of 4 plaquettes in mu-nu plane around coords (reference for wilson_flow.cl)
+    unsigned int row = lat->lattice_table_row_size;
+    coords_4 cMu  = lattice_neighbours_coords(lat,coords,mu);
+    coords_4 cNu  = lattice_neighbours_coords(lat,coords,nu);
+    coords_4 cMm  = lattice_neighbours_coords_backward(lat,coords,mu);
+    coords_4 cNm  = lattice_neighbours_coords_backward(lat,coords,nu);
+    coords_4 cMmNu = lattice_neighbours_coords(lat,cMm,nu);
+    coords_4 cMmNm = lattice_neighbours_coords_backward(lat,cMm,nu);
+    coords_4 cNmMu = lattice_neighbours_coords(lat,cNm,mu);
+    unsigned int gdi = lattice_coords_to_gid(lat,coords);
+    su_3 clover,leaf;
+
+    // [p,mu]-[p+mu,nu]-[p+nu,mu]*-[p,nu]*
+    clover = lattice_plaquette3(lattice_data[gdi + row * mu],
+                                lattice_data[lattice_coords_to_gid(lat,cMu) + row * nu],
+                                lattice_data[lattice_coords_to_gid(lat,cNu) + row * mu],
+                                lattice_data[gdi + row * nu]);
+    // [p,nu]-[p-mu+nu,mu]*-[p-mu,nu]*-[p-mu,mu]
+    leaf   = lattice_matrix_times3(lattice_plaquette3(lattice_data[gdi + row * nu],
+                                                      lattice_unity3(),
+                                                      lattice_data[lattice_coords_to_gid(lat,cMmNu) + row * mu],
+                                                      lattice_data[lattice_coords_to_gid(lat,cMm) + row * nu]),
+                                   lattice_data[lattice_coords_to_gid(lat,cMm) + row * mu]);
+    clover = lattice_matrix_add3(clover,leaf);
+    // [p-mu,mu]*-[p-mu-nu,nu]*-[p-mu-nu,mu]-[p-nu,nu]
+    leaf   = lattice_matrix_times3(lattice_matrix_times3(lattice_matrix_hermitian(lattice_matrix_times3(lattice_data[lattice_coords_to_gid(lat,cMmNm) + row * nu],
+                                                                                                          lattice_data[lattice_coords_to_gid(lat,cMm) + row * mu])),
+                                                         lattice_data[lattice_coords_to_gid(lat,cMmNm) + row * mu]),
+                                   lattice_data[lattice_coords_to_gid(lat,cNm) + row * nu]);
+    clover = lattice_matrix_add3(clover,leaf);
+    // [p-nu,nu]*-[p-nu,mu]-[p-nu+mu,nu]-[p,mu]*
+    leaf   = lattice_matrix_times3(lattice_matrix_hermitian(lattice_data[lattice_coords_to_gid(lat,cNm) + row * nu]),
+                                   lattice_plaquette3(lattice_data[lattice_coords_to_gid(lat,cNm) + row * mu],
+                                                      lattice_data[lattice_coords_to_gid(lat,cNmMu) + row * nu],
+                                                      lattice_unity3(),
+                                                      lattice_data[gdi + row * mu]));
+    clover = lattice_matrix_add3(clover,leaf);
+
+    return lattice_antihermitian3(clover,-0.25);
+}
+
+double*         SU::lattice_wilson_flow_cpu(model* lat){
+    // Wilson flow (Luscher's RK3) of a copy of the CPU lattice (reference for wilson_flow.cl)
+    // result[3 * step + k]: k = 0 - E(t), 1 - t^2 E(t), 2 - Q(t) for t = step * eps
+    const double flow_a[3] = {0.0, -17.0 / 32.0, -32.0 / 27.0};
+    const double flow_b[3] = {1.0 / 4.0, 8.0 / 9.0, 3.0 / 4.0};
+    unsigned int row = lat->lattice_table_row_size;
+    int nd = lat->lattice_nd;
+    double eps = lat->flow_eps;
+    double sites = (double) lat->lattice_domain_size[0] * lat->lattice_domain_size[1] * lat->lattice_domain_size[2] * lat->lattice_domain_size[3];
+    double* result = new double[3 * (lat->flow_steps + 1)];
+    coords_4 coords;
+    su_3 g[6];
+
+    su_3* lattice_saved = lattice_data;
+    lattice_data = (su_3*) calloc(row * nd, sizeof(su_3));
+    memcpy(lattice_data,lattice_saved,row * nd * sizeof(su_3));
+    su_3* force = (su_3*) calloc(row * nd, sizeof(su_3));
+
+    for (int step = 0; step <= lat->flow_steps; step++){
+        if (step > 0) for (int stage = 0; stage < 3; stage++){
+            for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
+            for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
+            for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
+            for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++) {
+                coords.x = x1;
+                coords.y = x2;
+                coords.z = x3;
+                coords.t = x4;
+                unsigned int gdi = lattice_coords_to_gid(lat,coords);
+                for (int dir = 0; dir < nd; dir++){
+                    su_3 z = lattice_antihermitian3(lattice_matrix_times3(lattice_data[gdi + row * dir],lattice_get_staple_cpu(lat,coords,dir)),eps);
+                    if (stage > 0) z = lattice_matrix_add3(z,lattice_matrix_scale3(force[gdi + row * dir],flow_a[stage]));
+                    force[gdi + row * dir] = z;
+                }
+            }
+            for (unsigned int i = 0; i < row * nd; i++)
+                lattice_data[i] = lattice_GramSchmidt_3(lattice_matrix_times3(lattice_exp3(lattice_matrix_scale3(force[i],flow_b[stage]),6),lattice_data[i]));
+        }
+
+        double energy = 0.0;
+        double charge = 0.0;
+        for (int x1 = 0; x1 < lat->lattice_domain_size[0]; x1++)
+        for (int x2 = 0; x2 < lat->lattice_domain_size[1]; x2++)
+        for (int x3 = 0; x3 < lat->lattice_domain_size[2]; x3++)
+        for (int x4 = 0; x4 < lat->lattice_domain_size[3]; x4++) {
+            coords.x = x1;
+            coords.y = x2;
+            coords.z = x3;
+            coords.t = x4;
+            int plane = 0;
+            for (int mu = 0; mu < nd - 1; mu++)
+                for (int nu = mu + 1; nu < nd; nu++){
+                    g[plane] = lattice_flow_clover_cpu(lat,coords,mu,nu);
+                    energy  -= lattice_retrace(lattice_matrix_times3(g[plane],g[plane]));
+                    plane++;
+                }
+            // planes: 0 - xy, 1 - xz, 2 - xt, 3 - yz, 4 - yt, 5 - zt
+            charge -= (lattice_retrace(lattice_matrix_times3(g[0],g[5])) - lattice_retrace(lattice_matrix_times3(g[1],g[4])) + lattice_retrace(lattice_matrix_times3(g[2],g[3]))) / (4.0 * PI * PI);
+        }
+        double t = step * eps;
+        result[3 * step]     = energy / sites;
+        result[3 * step + 1] = t * t * energy / sites;
+        result[3 * step + 2] = charge;
+    }
+
+    free(force);
+    free(lattice_data);
+    lattice_data = lattice_saved;
+    return result;
+}
+
+void            SU::lattice_check_sites_cpu(model* lat){
+    // per-site values of sampled sites in order of lattice_check_sites (sun_measurements_cl.cl);
+    // lattice_data is not allocated, so links are read from last configuration and cost does not depend on lattice volume
+    coords_4 coords,coords2,coords3;
+    unsigned int gdi;
+    su_3 loop;
+
+    if (lat->lattice_pointer_last == NULL) return;
+    lattice_source = lat->lattice_pointer_last;
+    for (unsigned int i = 0; i < lat->check_samples; i++) {
+        double* values = &lat->plattice_check_cpu[i * CHECK_SITE_VALUES];
+        int k = 0;
+        gdi    = lat->plattice_check_gid[i];
+        coords = lattice_gid_to_coords(lat,gdi);
+
+        for (int dir1 = 0; dir1<(lat->lattice_nd-1); dir1++)
+            for (int dir2 = (dir1+1); dir2<lat->lattice_nd; dir2++) {
+                coords2 = lattice_neighbours_coords(lat,coords,dir1);
+                coords3 = lattice_neighbours_coords(lat,coords,dir2);
+                values[k++] = lattice_retrace(lattice_plaquette3(lattice_table_3(lat,coords, gdi,dir1),
+                                                                 lattice_table_3(lat,coords2,lattice_coords_to_gid(lat,coords2),dir2),
+                                                                 lattice_table_3(lat,coords3,lattice_coords_to_gid(lat,coords3),dir1),
+                                                                 lattice_table_3(lat,coords, gdi,dir2)));
+            }
+
+        // staples are checked as ReTr(U * staple) against lattice_staple_N of GPU update kernels
+        for (int dir1 = 0; dir1<lat->lattice_nd; dir1++)
+            values[k++] = lattice_retrace(lattice_matrix_times3(lattice_table_3(lat,coords,gdi,dir1),lattice_get_staple_cpu(lat,coords,dir1)));
+
+        coords.t = 0;
+        loop = lattice_table_3(lat,coords,lattice_coords_to_gid(lat,coords),3);
+        for (int x4 = 1; x4 < lat->lattice_domain_size[3]; x4++) {
+            coords.t = x4;
+            loop = lattice_matrix_times3(loop,lattice_table_3(lat,coords,lattice_coords_to_gid(lat,coords),3));
+        }
+        values[k++] = lattice_retrace(loop);
+        values[k++] = lattice_imtrace(loop);
+    }
+    lattice_source = NULL;
+}
+
 void            SU::lattice_check_cpu(model* lat){
+    threads = (lat->CPU_check_threads > 0) ? lat->CPU_check_threads : (int) std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
     lat->Analysis[DM_S_spat].CPU_last_value      = 0.0;
     lat->Analysis[DM_S_temp].CPU_last_value      = 0.0;
     lat->Analysis[DM_S_total].CPU_last_value     = 0.0;
@@ -1621,6 +2082,10 @@ void            SU::lattice_check_cpu(model* lat){
     lat->Analysis[DM_Plq_temp].CPU_last_value    = 0.0;
     lat->Analysis[DM_Plq_total].CPU_last_value   = 0.0;
     lat->Analysis[DM_Wilson_loop].CPU_last_value = 0.0;
+    if (lat->check_samples > 0) {
+        lattice_check_sites_cpu(lat);   // site-by-site check of sampled sites instead of full lattice
+        return;
+    }
     unsigned int lattice_measurement_s = lat->lattice_measurement_size;
     if ((lat->get_Fmunu)||((lat->get_F0mu))) lattice_measurement_s = lat->lattice_measurement_size_F;
 
@@ -1686,10 +2151,30 @@ void            SU::lattice_check_cpu(model* lat){
                 delete[] plaq_plq;
         }
 
+        if (lat->get_wilson_flow) {
+            double* flow = lattice_wilson_flow_cpu(lat);   // flow runs on its own copy, before smearing
+            for (int i = 0; i < 3 * (lat->flow_steps + 1); i++)
+                lat->Analysis_flow[i].CPU_last_value = flow[i];
+            delete[] flow;
+        }
+        if (lat->get_smearing)
+            lattice_smear_cpu(lat);                         // Wilson loops are measured on smeared copy
         if (lat->get_wilson_loop) {
             double wilson_loop = lattice_avr_Wilson_loop_cpu(lat);
             lat->Analysis[DM_Wilson_loop].CPU_last_value = wilson_loop;
         }
+        if (lat->get_wilson_grid) {
+            double* wilson_grid = lattice_avr_Wilson_loop_grid_cpu(lat);
+            for (int i = 0; i < lat->wilson_Rmax * lat->wilson_Tmax; i++)
+                lat->Analysis_wilson_grid[i].CPU_last_value = wilson_grid[i];
+            delete[] wilson_grid;
+        }
+        if (lat->get_polyakov_correlator) {
+            double* pl_corr = lattice_Polyakov_loop_correlator_cpu(lat);
+            for (unsigned int b = 0; b < lat->polyakov_correlator_bins; b++)
+                lat->Analysis_PL_corr[b].CPU_last_value = pl_corr[b];
+            delete[] pl_corr;
+        }
 
 
         double* pl_avr = lattice_avr_Polyakov_loop_cpu(lat);
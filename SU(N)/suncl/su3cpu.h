@@ -40,6 +40,7 @@
 #include "../clinterface/clinterface.h"
 #include "../random/random.h"
 #include "../kernel/complex.h"
+#include <thread>
 
 namespace SU3_CPU{
 class SU {
@@ -76,16 +77,34 @@ class SU {
 
            GPU_CL::GPU*     GPU0;                             // pointer to GPU instance
          PRNG_CL::PRNG*     PRNG0;                            // pointer to PRNG instance
+                    int     threads;                          // number of threads for measurements on CPU
 
         SU(void);
        ~SU(void);
 
            void             lattice_check_cpu(model_CL::model* lat);
+           void             lattice_check_sites_cpu(model_CL::model* lat);
+           void             lattice_slices_cpu(model_CL::model* lat,int slices,int values,void (SU::*slice)(model_CL::model*,int,double*),double* sums);
            void             lattice_load_cpu(model_CL::model* lat,unsigned int* lattice_pointer);
+           void             lattice_load_slice_cpu(model_CL::model* lat,int x1,double* sums);
+           void             lattice_avr_plaquette_slice_cpu(model_CL::model* lat,int x1,double* sums);
+           void             lattice_avr_plaquette_plq_slice_cpu(model_CL::model* lat,int x1,double* sums);
+           void             lattice_avr_Polyakov_loop_slice_cpu(model_CL::model* lat,int x1,double* sums);
+           void             lattice_avr_Wilson_loop_slice_cpu(model_CL::model* lat,int x1,double* sums);
            double*          lattice_avr_plaquette_cpu(model_CL::model* lat);
            double*          lattice_avr_plaquette_plq_cpu(model_CL::model* lat);
            double*          lattice_avr_Polyakov_loop_cpu(model_CL::model* lat);
            double           lattice_avr_Wilson_loop_cpu(model_CL::model* lat);
+           double*          lattice_avr_Wilson_loop_grid_cpu(model_CL::model* lat);
+           double*          lattice_Polyakov_loop_correlator_cpu(model_CL::model* lat);
+           void             lattice_smear_cpu(model_CL::model* lat);
+           su_3             lattice_smear_link_cpu(model_CL::model* lat,su_3 u,su_3 staple);
+           su_3             lattice_matrix_scale3(su_3 a,double c);
+           su_3             lattice_antihermitian3(su_3 p,double rho);
+           su_3             lattice_exp3(su_3 a,int order);
+           su_3             lattice_flow_clover_cpu(model_CL::model* lat,coords_4 coords,int mu,int nu);
+           double*          lattice_wilson_flow_cpu(model_CL::model* lat);
+           su_3             lattice_line_cpu(model_CL::model* lat,coords_4 coords,int dir,int length);
            double*          lattice_plaquette_cpu(model_CL::model* lat,coords_4 coords);
            su_3             lattice_get_staple_cpu(model_CL::model* lat,SU::coords_4 coords,int dir1);
            void             lattice_simulate(model_CL::model* lat,unsigned int* lattice_pointer);
@@ -133,6 +152,7 @@ class SU {
 
     private:
             su_3* lattice_data;                       // lattice data for CPU simulation
+     unsigned int* lattice_source;                     // lattice state being loaded by lattice_load_slice_cpu (or read by lattice_table_3 in sampled check)
 
 };
 }
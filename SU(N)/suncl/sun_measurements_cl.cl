@@ -44,11 +44,13 @@
 #include "su2cl.cl"
 #include "su2_matrix_memory.cl"
 #include "su2_measurements_cl.cl"
+#include "su2_update_cl.cl"
 #endif
 #if SUN == 3
 #include "su3cl.cl"
 #include "su3_matrix_memory.cl"
 #include "su3_measurements_cl.cl"
+#include "su3_update_cl.cl"
 #endif
 
                                         __kernel void
@@ -1356,6 +1358,126 @@ reduce_measurement_plq_double2(__global hgpu_double2 * lattice_measurement,
 #endif
 }
 
+                    HGPU_INLINE_PREFIX hgpu_double
+lattice_check_plaquette(__global hgpu_float4 * lattice_table,__global hgpu_float * lattice_parameters,const coords_4 * coord,const uint mu,const uint nu)
+{
+    // ReTr of plaquette [p,mu]-[p+mu,nu]-[p+nu,mu]*-[p,nu]*
+    coords_4 coordMu,coordNu;
+    uint gdi,gdiMu,gdiNu;
+
+    lattice_coords_to_gid(&gdi,coord);
+    lattice_neighbours_gid(coord,&coordMu,&gdiMu,mu);
+    lattice_neighbours_gid(coord,&coordNu,&gdiNu,nu);
+#if SUN == 2
+    gpu_su_2 m1,m2,m3,m4;
+    su2_twist twist;
+    twist.phi   = lattice_parameters[1];
+
+    m1 = lattice_table_2(lattice_table,coord,   gdi,  mu,&twist);   // [p,mu]
+    m2 = lattice_table_2(lattice_table,&coordMu,gdiMu,nu,&twist);   // [p+mu,nu]
+    m3 = lattice_table_2(lattice_table,&coordNu,gdiNu,mu,&twist);   // [p+nu,mu]
+    m4 = lattice_table_2(lattice_table,coord,   gdi,  nu,&twist);   // [p,nu]
+    return lattice_retrace_plaquette2(&m1,&m2,&m3,&m4);
+#elif SUN == 3
+    gpu_su_3 m1,m2,m3,m4;
+    su3_twist twist;
+    twist.phi   = lattice_parameters[1];
+    twist.omega = lattice_parameters[2];
+
+    m1 = lattice_table_3(lattice_table,coord,   gdi,  mu,&twist);   // [p,mu]
+    m2 = lattice_table_3(lattice_table,&coordMu,gdiMu,nu,&twist);   // [p+mu,nu]
+    m3 = lattice_table_3(lattice_table,&coordNu,gdiNu,mu,&twist);   // [p+nu,mu]
+    m4 = lattice_table_3(lattice_table,coord,   gdi,  nu,&twist);   // [p,nu]
+    return lattice_retrace_plaquette3(&m1,&m2,&m3,&m4);
+#endif
+}
+
+                                        __kernel void
+lattice_check_sites(__global hgpu_float4  * lattice_table,
+                    __global hgpu_double  * lattice_check_values,
+                    __global hgpu_float   * lattice_parameters,
+                    __global uint         * lattice_check_gid,
+                    uint samples)
+{
+    // per-site values of sampled sites for site-by-site CPU verification (CHECK_SITE_VALUES values per site):
+    // [0..5]   ReTr of plaquettes XY, XZ, XT, YZ, YT, ZT at p
+    // [6..9]   ReTr of [p,mu] * staple of the link, mu = X..T (lattice_staple_N of heatbath and overrelaxation)
+    // [10..11] Re and Im of trace of Polyakov loop through spatial point of p (starting at t = 0)
+    if (GID<samples) {
+        uint gindex = lattice_check_gid[GID];
+        __global hgpu_double* out = lattice_check_values + GID * CHECK_SITE_VALUES;
+        coords_4 coord,coord1;
+        uint gdi1;
+        uint k = 0;
+
+        lattice_gid_to_coords(&gindex,&coord);
+
+        for (uint mu = X; mu < T; mu++)
+            for (uint nu = mu + 1; nu <= T; nu++)
+                out[k++] = lattice_check_plaquette(lattice_table,lattice_parameters,&coord,mu,nu);
+
+#if SUN == 2
+        gpu_su_2 m0;
+        su_2 v0,v1,v2;
+        su2_twist twist;
+        twist.phi   = lattice_parameters[1];
+
+        for (uint mu = X; mu <= T; mu++) {
+            m0 = lattice_table_2(lattice_table,&coord,gindex,mu,&twist);    // [p,mu]
+            v0 = lattice_reconstruct2(&m0);
+            v1 = lattice_staple_2(lattice_table,gindex,mu,&twist);
+            v2 = matrix_times_su2(&v0,&v1);
+            out[k++] = matrix_retrace_su2(&v2);
+        }
+#elif SUN == 3
+        gpu_su_3 m0;
+        su_3 v0,v1,v2;
+        su3_twist twist;
+        twist.phi   = lattice_parameters[1];
+        twist.omega = lattice_parameters[2];
+
+        for (uint mu = X; mu <= T; mu++) {
+            m0 = lattice_table_3(lattice_table,&coord,gindex,mu,&twist);    // [p,mu]
+            v0 = lattice_reconstruct3(&m0);
+            v1 = lattice_staple_3(lattice_table,gindex,mu,&twist);
+            v2 = matrix_times_su3(&v0,&v1);
+            out[k++] = matrix_retrace_su3(&v2);
+        }
+#endif
+
+        coord1   = coord;
+        coord1.t = 0;
+        lattice_coords_to_gid(&gdi1,&coord1);
+#if SUN == 2
+        m0 = lattice_table_2(lattice_table,&coord1,gdi1,T,&twist);      // [p,T]
+        v0 = lattice_reconstruct2(&m0);
+        for (uint i = 1; i < N4; i++){
+            lattice_neighbours_gid(&coord1,&coord,&gdi1,T);
+            m0 = lattice_table_2(lattice_table,&coord,gdi1,T,&twist);
+            v1 = lattice_reconstruct2(&m0);
+            v2 = matrix_times_su2(&v0,&v1);
+            v0 = v2;
+            coord1 = coord;
+        }
+        out[k++] = matrix_retrace_su2(&v0);
+        out[k++] = matrix_imtrace_su2(&v0);
+#elif SUN == 3
+        m0 = lattice_table_3(lattice_table,&coord1,gdi1,T,&twist);      // [p,T]
+        v0 = lattice_reconstruct3(&m0);
+        for (uint i = 1; i < N4; i++){
+            lattice_neighbours_gid(&coord1,&coord,&gdi1,T);
+            m0 = lattice_table_3(lattice_table,&coord,gdi1,T,&twist);
+            v1 = lattice_reconstruct3(&m0);
+            v2 = matrix_times_su3(&v0,&v1);
+            v0 = v2;
+            coord1 = coord;
+        }
+        out[k++] = matrix_retrace_su3(&v0);
+        out[k++] = matrix_imtrace_su3(&v0);
+#endif
+    }
+}
+
                                         __kernel void
 clear_measurement(__global hgpu_double2 * lattice_measurement)
 {
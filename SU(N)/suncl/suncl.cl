@@ -41,6 +41,38 @@
 #include "model.cl"
 #include "misc.cl"
 #include "sun_common.cl"
+#ifdef FUSED_UPDATE
+#define PRNGCL_COMMON_CL                // hgpu types and GID are taken from complex.h and model.cl
+#define PRNG_INLINE_ONLY                // generator steps only, without producer kernels
+#ifdef INLINE_XOR128
+#include "prngcl_xor128.cl"
+#else
+#include "prngcl_philox.cl"
+#endif
+
+typedef struct prn_inline {             // source of PRNs of one link update inside the update kernel
+#ifdef INLINE_XOR128
+    uint4 state;                        // XOR128 state of the work-item, kept in registers
+#else
+    uint seed;                          // position in the keyed PHILOX stream (seed,sweep,site,dir,hit)
+    uint sweep;
+    uint site;
+    uint dir;
+    uint hit;
+#endif
+} prn_inline;
+
+                    HGPU_INLINE_PREFIX hgpu_float4
+prn_inline_next(prn_inline* prn)
+{
+#ifdef INLINE_XOR128
+    float4 rnd = xor128_float4(&prn->state);
+#else
+    float4 rnd = philox_keyed(prn->seed,prn->sweep,prn->site,prn->dir,prn->hit++);
+#endif
+    return (hgpu_float4) ((hgpu_float) rnd.x, (hgpu_float) rnd.y, (hgpu_float) rnd.z, (hgpu_float) rnd.w);
+}
+#endif
 #if SUN == 2
 #include "su2cl.cl"
 #include "su2_matrix_memory.cl"
@@ -974,6 +1006,154 @@ prns[GID].x = (float) gindex;
     }
 }
 
+                                        __kernel void
+update_overrelax(__global hgpu_float4 * lattice_table,
+                 __global hgpu_float * lattice_parameters,
+                 uint dir,
+                 uint parity)
+{
+    // microcanonical over-relaxation of links [p,dir] of given parity (0 - even, 1 - odd); no random numbers are used
+    coords_4 coord;
+#ifdef BIGLAT
+    uint gindex = (parity == 0) ? Lattice_even_gid() : Lattice_odd_gid();
+#else
+    uint gindex = (parity == 0) ? lattice_even_gid() : lattice_odd_gid();
+#endif
+#if SUN == 2
+    su2_twist twist;
+    twist.phi   = lattice_parameters[1];
+#endif
+#if SUN == 3
+    su3_twist twist;
+    twist.phi   = lattice_parameters[1];
+    twist.omega = lattice_parameters[2];
+#endif
+
+#ifdef BIGLAT
+    if (GID < (N1 - 2) * N2N3N4 / 2){
+#else
+    if (GID < SITESHALF) {
+#endif
+        lattice_gid_to_coords(&gindex,&coord);
+#if SUN == 2
+        gpu_su_2 m0,mU;
+        su_2 staple;
+
+        m0     = lattice_table_notwist_2(lattice_table,gindex,dir);
+        staple = lattice_staple_2(lattice_table,gindex,dir,&twist);
+        mU     = lattice_overrelax_2(&staple,&m0);
+        lattice_store_2(lattice_table,&mU,gindex,dir);
+#endif
+#if SUN == 3
+        gpu_su_3 m0,mU;
+        su_3 staple;
+
+        m0     = lattice_table_notwist_3(lattice_table,gindex,dir);
+        staple = lattice_staple_3(lattice_table,gindex,dir,&twist);
+        mU     = lattice_overrelax3(&staple,&m0);
+        lattice_store_3(lattice_table,&mU,gindex,dir);
+#endif
+    }
+}
+
+
+#ifdef FUSED_UPDATE
+                                        __kernel void
+update_fused(__global hgpu_float4 * lattice_table,
+             __global hgpu_float * lattice_parameters,
+             uint dir,
+             uint parity,
+#ifdef INLINE_XOR128
+             __global uint4 * prn_states)
+#else
+             uint sweep,
+             uint seed)
+#endif
+{
+    // heat bath of links [p,dir] of given parity (0 - even, 1 - odd) with PRNs generated inline
+    // (XOR128 state per work-item or keyed PHILOX stream (seed,sweep,site,dir,hit)) and reunitarization on store
+    coords_4 coord;
+    uint gindex = (parity == 0) ? lattice_even_gid() : lattice_odd_gid();
+    hgpu_float bet = lattice_parameters[0];
+    prn_inline prn;
+#if SUN == 2
+    su2_twist twist;
+    twist.phi   = lattice_parameters[1];
+#endif
+#if SUN == 3
+    su3_twist twist;
+    twist.phi   = lattice_parameters[1];
+    twist.omega = lattice_parameters[2];
+#endif
+
+    if (GID < SITESHALF) {
+        lattice_gid_to_coords(&gindex,&coord);
+#ifdef INLINE_XOR128
+        prn.state = prn_states[GID];
+#else
+        prn.seed  = seed;
+        prn.sweep = sweep;
+        prn.site  = gindex;
+        prn.dir   = dir;
+        prn.hit   = 0;
+#endif
+#if SUN == 2
+        gpu_su_2 m0,mU;
+        su_2 staple;
+
+        m0     = lattice_table_2(lattice_table,&coord,gindex,dir,&twist);
+        staple = lattice_staple_2(lattice_table,gindex,dir,&twist);
+        mU     = lattice_heatbath_2_inline(&staple,&m0,&bet,&prn);
+        lattice_su2_Normalize(&mU);
+        lattice_store_2(lattice_table,&mU,gindex,dir);
+#endif
+#if SUN == 3
+        gpu_su_3 m0,mU;
+        su_3 staple;
+
+        m0     = lattice_table_3(lattice_table,&coord,gindex,dir,&twist);
+        staple = lattice_staple_3(lattice_table,gindex,dir,&twist);
+        mU     = lattice_heatbath3_inline(&staple,&m0,&bet,&prn);    // ends with Gram-Schmidt
+        lattice_store_3(lattice_table,&mU,gindex,dir);
+#endif
+#ifdef INLINE_XOR128
+        prn_states[GID] = prn.state;
+#endif
+    }
+}
+#endif
+
+#ifdef BIGLAT
+// halo exchange between sub-lattices: lattice_halo holds two faces of HALO_ROWS rows of direction dir,
+// lattice_halo[(face * HALO_ROWS + row) * N2N3N4 + site]
+                                        __kernel void
+lattice_halo_pack(__global hgpu_float4 * lattice_table,
+                  __global hgpu_float4 * lattice_halo,
+                  uint dir)
+{
+    // face 0 - first inner slice (x = 1), face 1 - last inner slice (x = N1 - 2)
+    if (GID < 2 * HALO_ROWS * N2N3N4) {
+        uint site = GID % N2N3N4;
+        uint row  = (GID / N2N3N4) % HALO_ROWS;
+        uint face = GID / (N2N3N4 * HALO_ROWS);
+        lattice_halo[GID] = lattice_table[(1 + face * (N1 - 3)) * N2N3N4 + site + (row * ND + dir) * ROWSIZE];
+    }
+}
+
+                                        __kernel void
+lattice_halo_unpack(__global hgpu_float4 * lattice_table,
+                    __global hgpu_float4 * lattice_halo,
+                    uint dir)
+{
+    // face 0 - low halo slice (x = 0), face 1 - high halo slice (x = N1 - 1)
+    if (GID < 2 * HALO_ROWS * N2N3N4) {
+        uint site = GID % N2N3N4;
+        uint row  = (GID / N2N3N4) % HALO_ROWS;
+        uint face = GID / (N2N3N4 * HALO_ROWS);
+        lattice_table[face * (N1 - 1) * N2N3N4 + site + (row * ND + dir) * ROWSIZE] = lattice_halo[GID];
+    }
+}
+#endif
 #endif
                                                                                                                                                                  
                                                                                                                                                                  
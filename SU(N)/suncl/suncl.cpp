@@ -63,6 +63,8 @@ const char* REIM[] = {"re","im"};         // markers for re / im
 #define SOURCE_UPDATE       "suncl/suncl.cl"
 #define SOURCE_MEASUREMENTS "suncl/sun_measurements_cl.cl"
 #define SOURCE_POLYAKOV     "suncl/polyakov.cl"
+#define SOURCE_SMEARING     "suncl/smearing.cl"
+#define SOURCE_WILSON_FLOW  "suncl/wilson_flow.cl"
 #ifndef BIGLAT
 #define SOURCE_WILSON_LOOP  "suncl/wilson_loop.cl"
 #else
@@ -71,9 +73,13 @@ const char* REIM[] = {"re","im"};         // markers for re / im
 
 // SU(N) section __________________________________________________________________________________________
 #define DATA_MEASUREMENTS   32 // number of elements for measurements
+#define CHECK_SITE_SEED     2463534242u     // xorshift seed for sampled sites of site-by-site verification (same sites in every run)
+#define CHECK_SITE_DELTA_SINGLE  0.00005        // accuracy for site-by-site verification (single precision)
+#define CHECK_SITE_DELTA_DOUBLE  0.00000000001  // accuracy for site-by-site verification (double precision)
 
         char model::path_suncl[FILENAME_MAX]         = "suncl/";
         char model::path_kernel[FILENAME_MAX]        = "kernel/";
+        char model::path_random[FILENAME_MAX]        = "random/";
 
 // end of SU(N) section -----------------------------------------------------------------------------------
 
@@ -86,6 +92,8 @@ const char* REIM[] = {"re","im"};         // markers for re / im
             D_A   = new(analysis_CL::analysis);
 
             Analysis = (analysis_CL::analysis::data_analysis*) calloc(DATA_MEASUREMENTS,sizeof(analysis_CL::analysis::data_analysis));
+            psublattice_halo = NULL;
+            sublattice_halo_pending = -1;
         }
 
         SubLattice::~SubLattice(void)
@@ -110,6 +118,7 @@ const char* REIM[] = {"re","im"};         // markers for re / im
                 free(Analysis_S_Z);
             }
 
+            if (psublattice_halo) GPU0->buffer_pinned_free(sublattice_halo_pinned,psublattice_halo);
             GPU0->device_finalize(0);
             delete(GPU0);
             GPU0 = 0;
@@ -158,6 +167,24 @@ void        SubLattice::sublattice_analysis_SpatTemp(int data_size, model::enum_
         device_select       = false;
 
         write_lattice_state_every_secs = 15.0 * 60.0; // write lattice configuration every 15 minutes
+        checkpoint_format   = 2;     // chunked state file
+        checkpoint_async    = true;  // state file is written in background
+        checkpoint_queue    = NULL;
+        checkpoint_staging  = NULL;
+        checkpoint_staging_size   = 0;
+        checkpoint_staging_buffer = NULL;
+        checkpoint_journal  = false; // measurement history is stored in state file
+        CPU_check_threads   = 0;     // CPU verification uses all available threads
+        CPU_check_async     = true;  // CPU verification overlaps analysis of GPU results
+        check_samples       = 0;     // full CPU verification
+#ifdef BIGLAT
+        halo_overlap        = true;  // interior update overlaps halo exchange
+        halo_check          = false; // verify the first halo exchange of each direction only
+        halo_checked        = 0;
+#endif
+        journal_name        = NULL;
+        journal_rows        = 0;
+        journal_rows_queued = 0;
 #endif
         turnoff_config_save = false; // do not write configurations
         turnoff_prns        = false; // turn off prn production
@@ -165,11 +192,21 @@ void        SubLattice::sublattice_analysis_SpatTemp(int data_size, model::enum_
 
         get_actions_avr     = true;  // calculate mean action values
         check_prngs         = false; // check PRNG production
+#ifdef CPU_RUN
+        CPU_threads         = 0;     // use all available threads
+        CPU_neighbours_table = true; // precompute neighbour table
+        CPU_link_layout     = 0;     // array of structs
+        CPU_link_compress   = false; // store full matrices
+        CPU_simd_benchmark  = 0;     // no SIMD micro-benchmark
+        CPU_prng_benchmark  = 0;     // no PRNG benchmark
+#endif
 #ifndef CPU_RUN
         PRNG_counter = 0;   // counter runs of subroutine PRNG_produce (for load_state purposes)
         NAV_counter  = 0;   // number of performed thermalization cycles
         ITER_counter = 0;   // number of performed working cycles
         LOAD_state   = 0;
+        PRNG_state      = NULL;
+        PRNG_state_size = 0;
 #endif
         lattice_full_size   = new int[ND_MAX];
         lattice_domain_size = new int[ND_MAX];
@@ -180,10 +217,25 @@ void        SubLattice::sublattice_analysis_SpatTemp(int data_size, model::enum_
         lattice_pointer_initial      = NULL;
         lattice_pointer_measurements = NULL;
         prng_pointer                 = NULL;
+        polyakov_fft                 = NULL;
+        polyakov_correlator_bins     = 0;
+        polyakov_correlator_bin      = NULL;
+        polyakov_correlator_r2       = NULL;
+        polyakov_correlator_count    = NULL;
+        plattice_polyakov_field      = NULL;
+        plattice_polyakov_correlator = NULL;
+        plattice_flow                = NULL;
+        plattice_prn_states          = NULL;
+        plattice_check_gid           = NULL;
+        plattice_check_values        = NULL;
+        plattice_check_cpu           = NULL;
 #endif
         model_create(); // tune particular model
 
         Analysis = (analysis_CL::analysis::data_analysis*) calloc(DATA_MEASUREMENTS,sizeof(analysis_CL::analysis::data_analysis));
+        Analysis_wilson_grid = NULL;
+        Analysis_PL_corr     = NULL;
+        Analysis_flow        = NULL;
     Analysis_PL_X = (analysis_CL::analysis::data_analysis*) calloc(lattice_domain_n1+1,sizeof(analysis_CL::analysis::data_analysis));
     Analysis_PL_X_im = (analysis_CL::analysis::data_analysis*) calloc(lattice_domain_n1+1,sizeof(analysis_CL::analysis::data_analysis));
     Analysis_PL_Y = (analysis_CL::analysis::data_analysis*) calloc(lattice_domain_size[1]+1,sizeof(analysis_CL::analysis::data_analysis));
@@ -258,8 +310,32 @@ void        SubLattice::sublattice_analysis_SpatTemp(int data_size, model::enum_
     free(Analysis_S_X);
     free(Analysis_S_Y);
     free(Analysis_S_Z);
+    if (Analysis_wilson_grid) {
+        for (int i=0; i<wilson_Rmax * wilson_Tmax; i++)
+            free((void*)Analysis_wilson_grid[i].data_name);
+        free(Analysis_wilson_grid);
+    }
 
 #ifndef CPU_RUN
+    if (Analysis_PL_corr) {
+        for (unsigned int i=0; i<polyakov_correlator_bins; i++)
+            free((void*)Analysis_PL_corr[i].data_name);
+        free(Analysis_PL_corr);
+    }
+    if (Analysis_flow) {
+        for (int i=0; i<3 * (flow_steps + 1); i++)
+            free((void*)Analysis_flow[i].data_name);
+        free(Analysis_flow);
+    }
+    free(plattice_flow);
+    free(plattice_prn_states);
+    free(plattice_check_gid);
+    free(plattice_check_values);
+    free(plattice_check_cpu);
+        delete polyakov_fft;
+        free(polyakov_correlator_bin);
+        free(polyakov_correlator_r2);
+        free(polyakov_correlator_count);
         free(lattice_group_elements);
 
         if (GPU0->GPU_debug.profiling) GPU0->print_time_detailed();
@@ -267,6 +343,10 @@ void        SubLattice::sublattice_analysis_SpatTemp(int data_size, model::enum_
         // output elapsed time
         printf("Elapsed time: %f seconds\n",GPU0->get_timer_CPU(TIMER_FOR_ELAPSED));
 
+        lattice_save_state_wait(true);  // checkpoint in flight has to be written before device is released
+        delete checkpoint_queue;
+        free(journal_name);
+
         GPU0->make_finish_file(finishpath);
         GPU0->device_finalize(0);
 
@@ -368,6 +448,7 @@ void        model::lattice_get_init_file(char* file){
             if (!strcmp(parameters[parameters_items].Variable,"ITER"))  {ITER            = parameters[parameters_items].iVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"NITER")) {NITER           = parameters[parameters_items].iVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"NHIT"))  {NHIT            = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"NOR"))   {NOR             = parameters[parameters_items].iVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"BETA"))  {BETA            = parameters[parameters_items].fVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"PHI"))   {PHI             = parameters[parameters_items].fVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"OMEGA")) {OMEGA           = parameters[parameters_items].fVarVal;}
@@ -402,6 +483,38 @@ void        model::lattice_get_init_file(char* file){
             if (!strcmp(parameters[parameters_items].Variable,"REBUILDBINARY"))  {
                 GPU0->GPU_debug.rebuild_binary = true;
             }
+            if (!strcmp(parameters[parameters_items].Variable,"QCGFORMAT"))  {checkpoint_format = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"QCGASYNC"))  {checkpoint_async = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"QCGJOURNAL"))  {checkpoint_journal = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"CHECKTHREADS"))  {CPU_check_threads = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"CHECKASYNC"))  {CPU_check_async = (parameters[parameters_items].iVarVal != 0);}
+#ifndef BIGLAT
+            if (!strcmp(parameters[parameters_items].Variable,"CHECKSAMPLES"))  {check_samples = parameters[parameters_items].iVarVal;}
+#endif
+#ifdef BIGLAT
+            if (!strcmp(parameters[parameters_items].Variable,"HALOOVERLAP"))  {halo_overlap = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"CHECKHALOS"))  {halo_check = (parameters[parameters_items].iVarVal != 0);}
+#endif
+            if (!strcmp(parameters[parameters_items].Variable,"FUSEDUPDATE"))  {fused_update = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"PROFILING"))  {GPU0->GPU_debug.profiling = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"PEAKGFLOPS"))  {GPU0->GPU_peak_gflops = parameters[parameters_items].fVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"PEAKBANDWIDTH"))  {GPU0->GPU_peak_bandwidth = parameters[parameters_items].fVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"AUTOTUNE"))  {
+                GPU0->GPU_debug.autotune = (parameters[parameters_items].iVarVal > 0);
+                if (parameters[parameters_items].iVarVal > 0) GPU0->GPU_autotune_runs = parameters[parameters_items].iVarVal;
+            }
+            if (!strcmp(parameters[parameters_items].Variable,"BINARYCACHE"))  {
+                GPU0->GPU_binary_cache_path = (char*) realloc(GPU0->GPU_binary_cache_path, (strlen(parameters[parameters_items].txtVarVal) + 1) * sizeof(char));
+                strcpy_s(GPU0->GPU_binary_cache_path,(strlen(parameters[parameters_items].txtVarVal) + 1),parameters[parameters_items].txtVarVal);
+            }
+            if (!strcmp(parameters[parameters_items].Variable,"BINARYCACHESIZE"))  {if (parameters[parameters_items].iVarVal > 0) GPU0->GPU_binary_cache_entries = parameters[parameters_items].iVarVal;}
+#else
+            if (!strcmp(parameters[parameters_items].Variable,"THREADS"))  {CPU_threads = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"NEIGHBOURTABLE"))  {CPU_neighbours_table = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"LINKLAYOUT"))  {CPU_link_layout = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"LINKCOMPRESS"))  {CPU_link_compress = (parameters[parameters_items].iVarVal != 0);}
+            if (!strcmp(parameters[parameters_items].Variable,"SIMDBENCH"))  {CPU_simd_benchmark = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"PRNGBENCH"))  {CPU_prng_benchmark = parameters[parameters_items].iVarVal;}
 #endif
             if (!strcmp(parameters[parameters_items].Variable,"GETWILSON"))  {
                 get_wilson_loop = true;
@@ -452,8 +565,17 @@ void        model::lattice_get_init_file(char* file){
                 get_Fmunu6 = false;
             }
             if (!strcmp(parameters[parameters_items].Variable,"PL_LEVEL"))  {PL_level = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"PLCORR"))    {PL_correlator = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"SMEAR"))     {smear_type    = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"SMEARSTEPS")){smear_steps   = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"SMEARALPHA")){smear_alpha   = parameters[parameters_items].fVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"FLOW"))      {flow_interval = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"FLOWSTEPS")) {flow_steps    = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"FLOWEPS"))   {flow_eps      = parameters[parameters_items].fVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"WILSONR"))   {wilson_R = parameters[parameters_items].iVarVal;}
             if (!strcmp(parameters[parameters_items].Variable,"WILSONT"))   {wilson_T = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"WILSONRMAX"))   {wilson_Rmax = parameters[parameters_items].iVarVal;}
+            if (!strcmp(parameters[parameters_items].Variable,"WILSONTMAX"))   {wilson_Tmax = parameters[parameters_items].iVarVal;}
             parameters_flag = parameters[parameters_items].final;
             parameters_items++;
         }
@@ -514,6 +636,7 @@ char*       model::lattice_make_header(void){
     j  += sprintf_s(header+j,header_size-j, " iter (# of samples)         : %i\n",ITER);
     j  += sprintf_s(header+j,header_size-j, " nhit                        : %i\n",NHIT);
     j  += sprintf_s(header+j,header_size-j, " nhitPar                     : %i\n",NHITPar);
+    j  += sprintf_s(header+j,header_size-j, " nor (over-relaxation)       : %i\n",NOR);
     if (precision == model::model_precision_single) j  += sprintf_s(header+j,header_size-j, " precision                   : single\n");
     if (precision == model::model_precision_mixed)  j  += sprintf_s(header+j,header_size-j, " precision                   : mixed\n");
     if (precision == model::model_precision_double)
@@ -561,6 +684,8 @@ char*       model::lattice_make_header(void){
     j  += sprintf_s(header+j,header_size-j, " iter (# of samples)         : %i\n",ITER);
     j  += sprintf_s(header+j,header_size-j, " nhit                        : %i\n",NHIT);
     j  += sprintf_s(header+j,header_size-j, " nhitPar                     : %i\n",NHITPar);
+    j  += sprintf_s(header+j,header_size-j, " nor (over-relaxation)       : %i\n",NOR);
+    j  += sprintf_s(header+j,header_size-j, " fused update                : %i\n",fused_update);
     if (precision == model::model_precision_single) j  += sprintf_s(header+j,header_size-j, " precision                   : single\n");
     if (precision == model::model_precision_mixed)  j  += sprintf_s(header+j,header_size-j, " precision                   : mixed\n");
     if (precision == model::model_precision_double)
@@ -607,6 +732,11 @@ char*       model::lattice_make_header(void){
     j  += sprintf_s(header+j,header_size-j, " iter (# of samples)         : %i\n",ITER);
     j  += sprintf_s(header+j,header_size-j, " nhit                        : %i\n",NHIT);
     j  += sprintf_s(header+j,header_size-j, " nhitPar                     : %i\n",NHITPar);
+    j  += sprintf_s(header+j,header_size-j, " nor (over-relaxation)       : %i\n",NOR);
+    j  += sprintf_s(header+j,header_size-j, " threads                     : %i\n",CPU_threads);
+    j  += sprintf_s(header+j,header_size-j, " neighbours (1=table, 0=fly) : %i\n",CPU_neighbours_table);
+    j  += sprintf_s(header+j,header_size-j, " link layout (0=AoS, 1=SoA)  : %i\n",CPU_link_layout);
+    j  += sprintf_s(header+j,header_size-j, " compressed links            : %i\n",CPU_link_compress);
     j  += sprintf_s(header+j,header_size-j, " ***************************************************\n");
     j  += model_make_header((header+j),(header_size-j));
 
@@ -698,6 +828,11 @@ void        model::lattice_init(void)
             lattice_domain_size = new int[lattice_nd];
             for (int i=0;i<lattice_nd;i++) lattice_domain_size[i] = lattice_full_size[i];
         }
+
+    // workgroup sizes in the tuning cache are valid for this group, lattice size and precision only
+    sprintf_s(GPU0->GPU_tuning_key,sizeof(GPU0->GPU_tuning_key),"SU(%i) %ix%ix%ix%i %s",lattice_group,
+        lattice_full_size[0],lattice_full_size[1],lattice_full_size[2],lattice_full_size[3],
+        (precision == model_precision_double) ? "double" : ((precision == model_precision_mixed) ? "mixed" : "single"));
     
     model_lattice_init();   // model initialization
 #else
@@ -754,6 +889,7 @@ void        model::model_create(void){
 #endif
 
         turnoff_gramschmidt = false; // turn off Gram-Schmidt orthogonalization
+        fused_update        = false; // heat bath with inline PRNs (one launch per parity and direction)
 
         get_plaquettes_avr  = true;  // calculate mean plaquette values
 #ifndef CPU_RUN
@@ -766,6 +902,10 @@ void        model::model_create(void){
         PL_level               = 0;
 #endif
         get_F0mu            = false; // calculate Fmunu tensor for E field
+        get_wilson_grid     = false; // calculate Wilson loops W(R,T) (turned on by WILSONRMAX and WILSONTMAX)
+        get_polyakov_correlator = false; // calculate Polyakov loop correlator (turned on by PLCORR)
+        get_smearing        = false; // measure Wilson loops on smeared lattice (turned on by SMEAR and SMEARSTEPS)
+        get_wilson_flow     = false; // measure along Wilson flow (turned on by FLOW and FLOWSTEPS)
 
         get_Fmunu1          = false; // get Fmunu for lambda1 instead of lambda3
         get_Fmunu2          = false; // get Fmunu for lambda2 instead of lambda3
@@ -781,6 +921,14 @@ int         model::model_make_header(char* header,int header_size){
 
     j  += sprintf_s(header+j,header_size-j, " Wilson loop R               : %i\n",wilson_R);
     j  += sprintf_s(header+j,header_size-j, " Wilson loop T               : %i\n",wilson_T);
+    if (get_wilson_grid)
+        j  += sprintf_s(header+j,header_size-j, " Wilson loops grid (R x T)   : %i x %i\n",wilson_Rmax,wilson_Tmax);
+    if (get_polyakov_correlator)
+        j  += sprintf_s(header+j,header_size-j, " Polyakov loop correlator    : host FFT, binned by |r|\n");
+    if (get_smearing)
+        j  += sprintf_s(header+j,header_size-j, " Smearing (spatial links)    : %s, %i steps, alpha = %f\n",(smear_type==2) ? "stout" : "APE",smear_steps,smear_alpha);
+    if (get_wilson_flow)
+        j  += sprintf_s(header+j,header_size-j, " Wilson flow (RK3)           : every %i iterations, %i steps, eps = %f\n",flow_interval,flow_steps,flow_eps);
     if (get_Fmunu)
         j  += sprintf_s(header+j,header_size-j," FMUNU(%u, %u)\n",Fmunu_index1,Fmunu_index2);
     if (get_F0mu)
@@ -853,6 +1001,25 @@ char*       model::lattice_make_header2(void){
     j  += sprintf_s(header+j,header_size-j, " GPU last %-16s: % 16.13e\n",Analysis[DM_Polyakov_loop_P4].data_name,Analysis[DM_Polyakov_loop_P4].GPU_last_value);
     j  += sprintf_s(header+j,header_size-j, " CPU last %-16s: % 16.13e\n",Analysis[DM_Wilson_loop].data_name,Analysis[DM_Wilson_loop].CPU_last_value);
     j  += sprintf_s(header+j,header_size-j, " GPU last %-16s: % 16.13e\n",Analysis[DM_Wilson_loop].data_name,Analysis[DM_Wilson_loop].GPU_last_value);
+    if (get_wilson_grid) {
+        j  += sprintf_s(header+j,header_size-j, " ***************************************************\n");
+        j  += sprintf_s(header+j,header_size-j, " Mean W(R,T)  T:");
+        for (int t=0; t<wilson_Tmax; t++)
+            j  += sprintf_s(header+j,header_size-j, " %-17i",t + 1);
+        for (int r=0; r<wilson_Rmax; r++){
+            j  += sprintf_s(header+j,header_size-j, "\n          R=%-3i",r + 1);
+            for (int t=0; t<wilson_Tmax; t++)
+                j  += sprintf_s(header+j,header_size-j, " % 16.10e",Analysis_wilson_grid[r * wilson_Tmax + t].mean_value);
+        }
+        j  += sprintf_s(header+j,header_size-j, "\n");
+    }
+    if (get_wilson_flow) {
+        analysis_CL::analysis::data_analysis* flow = &Analysis_flow[3 * flow_steps];
+        j  += sprintf_s(header+j,header_size-j, " ***************************************************\n");
+        j  += sprintf_s(header+j,header_size-j, " Wilson flow at t = %-9.4f: <t^2E> = % 16.13e, <Q> = % 16.13e\n",flow_steps * flow_eps,flow[1].mean_value,flow[2].mean_value);
+        j  += sprintf_s(header+j,header_size-j, " CPU last %-16s: % 16.13e\n",flow[2].data_name,flow[2].CPU_last_value);
+        j  += sprintf_s(header+j,header_size-j, " GPU last %-16s: % 16.13e\n",flow[2].data_name,flow[2].GPU_last_value);
+    }
 #ifndef CPU_RUN
     if (analysis_CL::analysis::results_verification)
         j  += sprintf_s(header+j,header_size-j, " *** Verification successfully passed! *************\n");
@@ -1610,6 +1777,67 @@ void        model::lattice_analysis(void){
         Analysis[DM_Wilson_loop].data_name       = "Wilson_loop";
         D_A->lattice_data_analysis(&Analysis[DM_Wilson_loop]);
     }
+    if (get_wilson_grid) {
+        // Wilson loops W(R,T)
+        unsigned int* wilson_grid_pointer = GPU0->buffer_map(lattice_wilson_grid);
+        for (int r=0; r<wilson_Rmax; r++)
+            for (int t=0; t<wilson_Tmax; t++){
+                int i = r * wilson_Tmax + t;
+                Analysis_wilson_grid[i].data_size       = ITER;
+                if (precision==model_precision_double) Analysis_wilson_grid[i].precision_single = false;
+                    else                               Analysis_wilson_grid[i].precision_single = true;
+                Analysis_wilson_grid[i].storage_type    = GPU_CL::GPU::GPU_storage_double;
+                Analysis_wilson_grid[i].pointer         = wilson_grid_pointer;
+                Analysis_wilson_grid[i].pointer_offset  = lattice_energies_size * i;
+                Analysis_wilson_grid[i].denominator     = ((double) (lattice_full_site * 3));
+                Analysis_wilson_grid[i].data_name       = (char*) calloc(32,sizeof(char));
+                sprintf_s((char*) Analysis_wilson_grid[i].data_name,32,"W(%u,%u)",r + 1,t + 1);
+                D_A->lattice_data_analysis(&Analysis_wilson_grid[i]);
+            }
+    }
+    if (get_polyakov_correlator) {
+        // Polyakov loop correlator (host array)
+        for (unsigned int b=0; b<polyakov_correlator_bins; b++){
+            Analysis_PL_corr[b].data_size       = ITER;
+            if (precision==model_precision_double) Analysis_PL_corr[b].precision_single = false;
+                else                               Analysis_PL_corr[b].precision_single = true;
+            Analysis_PL_corr[b].storage_type    = GPU_CL::GPU::GPU_storage_double;
+            Analysis_PL_corr[b].pointer         = (unsigned int*) plattice_polyakov_correlator;
+            Analysis_PL_corr[b].pointer_offset  = lattice_polyakov_loop_size * b;
+            Analysis_PL_corr[b].denominator     = ((double) (lattice_group * lattice_group));
+            Analysis_PL_corr[b].data_name       = (char*) calloc(24,sizeof(char));
+            sprintf_s((char*) Analysis_PL_corr[b].data_name,24,"PL_corr(r^2=%u)",polyakov_correlator_r2[b]);
+            D_A->lattice_data_analysis(&Analysis_PL_corr[b]);
+        }
+    }
+    if (get_wilson_flow) {
+        // Wilson flow: rows of flowed iterations are gathered, element 0 stays for the initial configuration (not averaged)
+        cl_double4* flow_pointer = (cl_double4*) GPU0->buffer_map(lattice_flow);
+        unsigned int flow_runs = 1;
+        for (int i=1; i<ITER; i++)
+            if (lattice_wilson_flow_iteration(i)) flow_runs++;
+        const char* flow_names[3] = {"E","t^2E","Q"};
+        for (int step=0; step<=flow_steps; step++)
+            for (int k=0; k<3; k++){
+                int i = 3 * step + k;
+                double* flow_data = (double*) calloc(flow_runs,sizeof(double));
+                unsigned int run = 1;
+                for (int iter=1; iter<ITER; iter++)
+                    if (lattice_wilson_flow_iteration(iter)) flow_data[run++] = flow_pointer[step * lattice_energies_size + iter].s[k + 1];
+                Analysis_flow[i].data_size       = flow_runs;
+                if (precision==model_precision_double) Analysis_flow[i].precision_single = false;
+                    else                               Analysis_flow[i].precision_single = true;
+                Analysis_flow[i].storage_type    = GPU_CL::GPU::GPU_storage_double;
+                Analysis_flow[i].pointer         = (unsigned int*) flow_data;
+                Analysis_flow[i].pointer_offset  = 0;
+                Analysis_flow[i].denominator     = 1.0;
+                Analysis_flow[i].data_name       = (char*) calloc(24,sizeof(char));
+                sprintf_s((char*) Analysis_flow[i].data_name,24,"%s(t=%.4f)",flow_names[k],step * flow_eps);
+                D_A->lattice_data_analysis(&Analysis_flow[i]);
+                Analysis_flow[i].pointer         = NULL;
+                free(flow_data);
+            }
+    }
     if ((get_Fmunu)||(get_F0mu)) {
         // Fmunu_xy_3_re
         unsigned int* F_pointr;
@@ -1790,6 +2018,36 @@ void        model::lattice_write_results(void) {
       fprintf(stream,"\n");
     }
 
+    if (get_wilson_grid) {
+      fprintf(stream, " ***************************************************\n");
+      fprintf(stream,"Wilson loops W(R,T) data (R, T, W, W_variance, CPU last, GPU last):\n");
+      for (int r=0; r<wilson_Rmax; r++)
+        for (int t=0; t<wilson_Tmax; t++){
+          int i = r * wilson_Tmax + t;
+          fprintf(stream, "%2u %2u % 16.13e % 16.13e % 16.13e % 16.13e\n",r + 1,t + 1,
+                  Analysis_wilson_grid[i].mean_value,Analysis_wilson_grid[i].variance,Analysis_wilson_grid[i].CPU_last_value,Analysis_wilson_grid[i].GPU_last_value);
+        }
+    }
+
+#ifndef CPU_RUN
+    if (get_polyakov_correlator) {
+      fprintf(stream, " ***************************************************\n");
+      fprintf(stream,"Polyakov loop correlator <P(0)P^+(r)> data (r^2, |r|, sites, C, C_variance, CPU last, GPU last):\n");
+      for (unsigned int b=0; b<polyakov_correlator_bins; b++)
+          fprintf(stream, "%4u % 10.6f %6u % 16.13e % 16.13e % 16.13e % 16.13e\n",polyakov_correlator_r2[b],sqrt((double) polyakov_correlator_r2[b]),polyakov_correlator_count[b],
+                  Analysis_PL_corr[b].mean_value,Analysis_PL_corr[b].variance,Analysis_PL_corr[b].CPU_last_value,Analysis_PL_corr[b].GPU_last_value);
+    }
+    if (get_wilson_flow) {
+      fprintf(stream, " ***************************************************\n");
+      fprintf(stream,"Wilson flow data (t, E, E_variance, t^2E, t^2E_variance, Q, Q_variance, CPU last Q, GPU last Q):\n");
+      for (int step=0; step<=flow_steps; step++){
+          analysis_CL::analysis::data_analysis* flow = &Analysis_flow[3 * step];
+          fprintf(stream, "% 10.6f % 16.13e % 16.13e % 16.13e % 16.13e % 16.13e % 16.13e % 16.13e % 16.13e\n",step * flow_eps,
+                  flow[0].mean_value,flow[0].variance,flow[1].mean_value,flow[1].variance,flow[2].mean_value,flow[2].variance,flow[2].CPU_last_value,flow[2].GPU_last_value);
+      }
+    }
+#endif
+
         fprintf(stream, " ***************************************************\n");
         fprintf(stream, " Data fields:\n");
         fprintf(stream, "    #,  ");
@@ -1854,24 +2112,235 @@ void        model::lattice_write_results(void) {
 }
 
 #ifndef CPU_RUN
+void        model::lattice_save_state_wait(bool release_staging){
+    if (checkpoint_queue) {
+        if (checkpoint_queue->wait())
+            journal_rows = journal_rows_queued;
+        else
+            journal_rows_queued = journal_rows;     // rows of failed checkpoint are appended again
+    }
+    if (!release_staging) return;
+    if (checkpoint_staging_buffer) GPU0->buffer_pinned_free(checkpoint_staging_buffer,checkpoint_staging);
+    checkpoint_staging        = NULL;
+    checkpoint_staging_size   = 0;
+    checkpoint_staging_buffer = NULL;
+}
+
+bool        model::lattice_save_state_async(void){
+    // buffers are copied to pinned host memory by non-blocking reads (in queue order, i.e. after the last update),
+    // writer thread waits for the copies and writes the file while updates go on
+    if ((checkpoint_format != 2) || (!checkpoint_async)) {lattice_save_state(); return true;}
+    if (!checkpoint_queue) checkpoint_queue = new(checkpoint_CL::checkpoint_writer);
+    if (checkpoint_queue->busy()) return false;     // previous checkpoint is still being written, try later
+    lattice_save_state_wait(false);
+
+    time_t ltimesave;
+    time(&ltimesave);
+    char* timesave   = GPU0->get_current_datetime();
+
+    char buffer[250];
+    int j = 0;
+    j  = sprintf_s(buffer  ,sizeof(buffer),  "%s",path);
+    j += sprintf_s(buffer+j,sizeof(buffer)-j,"%s",fprefix);
+    j += sprintf_s(buffer+j,sizeof(buffer)-j,"%.2s-%.3s-%.2s-%.2s-%.2s-%.2s.qcg",timesave+22,timesave+4,timesave+8,timesave+11,timesave+14,timesave+17);
+
+    unsigned int* head = lattice_make_bin_header();
+    unsigned int prng_section[4];
+    lattice_make_prng_section(prng_section);
+    size_t lattice_element_size = (precision == model_precision_single) ? sizeof(cl_float4) : sizeof(cl_double4);
+
+    // sections in file order (buffer_id < 0 - section is taken from host memory)
+    const char*        section_tag[QCG2_MAX_SECTIONS];
+    int                section_buffer[QCG2_MAX_SECTIONS];
+    const void*        section_host[QCG2_MAX_SECTIONS];
+    unsigned long long section_size[QCG2_MAX_SECTIONS];
+    int n = 0;
+    section_tag[n] = "HEADER";   section_buffer[n] = -1;                    section_host[n] = head;         section_size[n++] = BIN_HEADER_SIZE * sizeof(unsigned int);
+    section_tag[n] = "MEASURE";  section_buffer[n] = lattice_measurement;   section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_measurement_size_F * sizeof(cl_double2);
+    if (checkpoint_journal) {
+    lattice_journal_file(NULL,0);
+    section_tag[n] = "JOURNAL";  section_buffer[n] = -1;                    section_host[n] = journal_name; section_size[n++] = strlen(journal_name) + 1;
+    } else {
+    section_tag[n] = "ENERGY";   section_buffer[n] = lattice_energies;      section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_energies_size * sizeof(cl_double2);
+    if ((get_plaquettes_avr) || (get_Fmunu) || (get_F0mu)) {
+    section_tag[n] = "PLQ";      section_buffer[n] = lattice_energies_plq;  section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_energies_size_F * sizeof(cl_double2);}
+    if (get_wilson_loop) {
+    section_tag[n] = "WILSON";   section_buffer[n] = lattice_wilson_loop;   section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_energies_size * sizeof(cl_double);}
+    if (get_wilson_grid) {
+    section_tag[n] = "WGRID";    section_buffer[n] = lattice_wilson_grid;   section_host[n] = NULL;         section_size[n++] = (unsigned long long) size_lattice_wilson_grid * sizeof(cl_double);}
+    if (PL_level > 0) {
+    section_tag[n] = "POLYAKOV"; section_buffer[n] = lattice_polyakov_loop; section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_polyakov_loop_size * sizeof(cl_double2);}
+    if (get_wilson_flow) {
+    section_tag[n] = "FLOW";     section_buffer[n] = lattice_flow;          section_host[n] = NULL;         section_size[n++] = (unsigned long long) size_lattice_flow * sizeof(cl_double4);}
+    }
+    if (get_polyakov_correlator) {
+    section_tag[n] = "PLCORR";   section_buffer[n] = -1;                    section_host[n] = plattice_polyakov_correlator; section_size[n++] = (unsigned long long) size_lattice_polyakov_correlator * sizeof(cl_double);}
+    section_tag[n] = "LATTICE";  section_buffer[n] = lattice_table;         section_host[n] = NULL;         section_size[n++] = (unsigned long long) lattice_table_size * lattice_element_size;
+    section_tag[n] = "PRNG";     section_buffer[n] = -1;                    section_host[n] = prng_section; section_size[n++] = sizeof(prng_section);
+    if (prng_section[3]) {
+    section_tag[n] = "PRNGSTAT"; section_buffer[n] = PRNG0->PRNG_seed_table_id; section_host[n] = NULL;     section_size[n++] = (unsigned long long) prng_section[3] * sizeof(unsigned int);}
+
+    // new measurement rows for journal (placed after sections)
+    checkpoint_CL::checkpoint_journal::qcj_buffer journal_index[QCG2_MAX_SECTIONS];
+    int          journal_buffer[QCG2_MAX_SECTIONS];
+    void*        journal_host[QCG2_MAX_SECTIONS];
+    int          journal_buffers  = (checkpoint_journal) ? lattice_journal_index(journal_index,journal_buffer,journal_host) : 0;
+    unsigned int journal_row_from = journal_rows_queued;
+    unsigned int journal_row_to   = ITER_counter;
+    size_t       journal_size     = (size_t) checkpoint_CL::checkpoint_journal::rows_size(journal_index,journal_buffers,journal_row_to - journal_row_from);
+
+    // staging memory is allocated once (sections are 64-byte aligned in it)
+    size_t staging_size = journal_size;
+    for (int i=0; i<n; i++) staging_size += (size_t) ((section_size[i] + 63) / 64) * 64;
+    if (staging_size > checkpoint_staging_size) {
+        lattice_save_state_wait(true);
+        checkpoint_staging = (unsigned char*) GPU0->buffer_pinned_alloc(staging_size,&checkpoint_staging_buffer);
+        checkpoint_staging_size = (checkpoint_staging) ? staging_size : 0;
+    }
+    if (!checkpoint_staging) {free(head); lattice_save_state(); return true;}
+
+    std::vector<cl_event> events;
+    checkpoint_CL::checkpoint* qcg = new(checkpoint_CL::checkpoint);
+    size_t offset = 0;
+    for (int i=0; i<n; i++) {
+        unsigned char* staging = checkpoint_staging + offset;
+        if (section_buffer[i] < 0)
+            memcpy(staging,section_host[i],(size_t) section_size[i]);
+        else {
+            cl_event event;
+            if (GPU0->buffer_read_async(section_buffer[i],staging,0,(size_t) section_size[i],&event) == CL_SUCCESS) events.push_back(event);
+        }
+        qcg->add_section(section_tag[i],staging,section_size[i]);
+        offset += (size_t) ((section_size[i] + 63) / 64) * 64;
+    }
+    free(head);
+
+    // journal is appended before state file is written, so state file never refers to absent rows
+    unsigned char* journal_rows_staging = checkpoint_staging + offset;
+    char journal_file[250];
+    if (checkpoint_journal) {
+        lattice_journal_read(journal_buffer,journal_index,journal_buffers,journal_row_from,journal_row_to,journal_rows_staging,&events);
+        lattice_journal_file(journal_file,sizeof(journal_file));
+        journal_rows_queued = journal_row_to;
+    }
+    std::vector<checkpoint_CL::checkpoint_journal::qcj_buffer> journal(journal_index,journal_index + journal_buffers);
+    std::string journal_file_name((checkpoint_journal) ? journal_file : "");
+
+    GPU_CL::GPU* gpu = GPU0;
+    checkpoint_queue->start(qcg,buffer,[gpu,events,journal,journal_file_name,journal_row_from,journal_row_to,journal_rows_staging]() mutable {
+        bool result = (gpu->buffer_read_wait(events.data(),(int) events.size()) == CL_SUCCESS);
+        if ((result) && (!journal.empty()))
+            result = checkpoint_CL::checkpoint_journal::append(journal_file_name.c_str(),journal_row_from,journal_row_to,journal.data(),(unsigned int) journal.size(),journal_rows_staging);
+        return result;
+    });
+    return true;
+}
+
+int         model::lattice_journal_index(checkpoint_CL::checkpoint_journal::qcj_buffer* index,int* buffer_id,void** host_data){
+    // buffers indexed by working iteration: element [block * stride + ITER_counter]
+    int n = 0;
+    memset(index,0,QCG2_MAX_SECTIONS * sizeof(checkpoint_CL::checkpoint_journal::qcj_buffer));
+    memcpy(index[n].tag,"ENERGY",6);   index[n].element_size = sizeof(cl_double2); index[n].stride = lattice_energies_size;       index[n].blocks = size_lattice_energies / lattice_energies_size;
+        buffer_id[n] = lattice_energies;      host_data[n++] = plattice_energies;
+    if ((get_plaquettes_avr) || (get_Fmunu) || (get_F0mu)) {
+    memcpy(index[n].tag,"PLQ",3);      index[n].element_size = sizeof(cl_double2); index[n].stride = lattice_energies_offset;     index[n].blocks = lattice_energies_size_F / lattice_energies_size;
+        buffer_id[n] = lattice_energies_plq;  host_data[n++] = plattice_energies_plq;}
+    if (get_wilson_loop) {
+    memcpy(index[n].tag,"WILSON",6);   index[n].element_size = sizeof(cl_double);  index[n].stride = lattice_energies_size;       index[n].blocks = 1;
+        buffer_id[n] = lattice_wilson_loop;   host_data[n++] = plattice_wilson_loop;}
+    if (get_wilson_grid) {
+    memcpy(index[n].tag,"WGRID",5);    index[n].element_size = sizeof(cl_double);  index[n].stride = lattice_energies_size;       index[n].blocks = wilson_Rmax * wilson_Tmax;
+        buffer_id[n] = lattice_wilson_grid;   host_data[n++] = plattice_wilson_grid;}
+    if (PL_level > 0) {
+    memcpy(index[n].tag,"POLYAKOV",8); index[n].element_size = sizeof(cl_double2); index[n].stride = lattice_polyakov_loop_size;  index[n].blocks = size_lattice_polyakov_loop / lattice_polyakov_loop_size;
+        buffer_id[n] = lattice_polyakov_loop; host_data[n++] = plattice_polyakov_loop;}
+    if (get_wilson_flow) {
+    memcpy(index[n].tag,"FLOW",4);     index[n].element_size = sizeof(cl_double4); index[n].stride = lattice_energies_size;       index[n].blocks = flow_steps + 1;
+        buffer_id[n] = lattice_flow;          host_data[n++] = plattice_flow;}
+    return n;
+}
+
+void        model::lattice_journal_read(const int* buffer_id,const checkpoint_CL::checkpoint_journal::qcj_buffer* index,int buffers,unsigned int row_from,unsigned int row_to,unsigned char* rows,std::vector<cl_event>* events){
+    // rows [row_from, row_to) of every block (non-blocking reads, if events are provided)
+    if (row_to <= row_from) return;
+    size_t offset = 0;
+    for (int i=0; i<buffers; i++)
+        for (unsigned int b=0; b<index[i].blocks; b++) {
+            size_t block_offset = (size_t) ((unsigned long long) b * index[i].stride + row_from) * index[i].element_size;
+            size_t block_size   = (size_t) (row_to - row_from) * index[i].element_size;
+            if (events) {
+                cl_event event;
+                if (GPU0->buffer_read_async(buffer_id[i],rows + offset,block_offset,block_size,&event) == CL_SUCCESS) events->push_back(event);
+            } else
+                GPU0->buffer_read(buffer_id[i],rows + offset,block_offset,block_size);
+            offset += block_size;
+        }
+}
+
+bool        model::lattice_journal_append(void){
+    checkpoint_CL::checkpoint_journal::qcj_buffer index[QCG2_MAX_SECTIONS];
+    int   buffer_id[QCG2_MAX_SECTIONS];
+    void* host_data[QCG2_MAX_SECTIONS];
+    int   buffers  = lattice_journal_index(index,buffer_id,host_data);
+    unsigned int row_from = journal_rows;
+    unsigned int row_to   = ITER_counter;
+    unsigned char* rows = (unsigned char*) malloc((size_t) checkpoint_CL::checkpoint_journal::rows_size(index,buffers,row_to - row_from) + 1);
+    lattice_journal_read(buffer_id,index,buffers,row_from,row_to,rows,NULL);
+
+    char buffer[250];
+    lattice_journal_file(buffer,sizeof(buffer));
+    bool result = checkpoint_CL::checkpoint_journal::append(buffer,row_from,row_to,index,buffers,rows);
+    if (result) journal_rows = journal_rows_queued = row_to;
+    free(rows);
+    return result;
+}
+
+void        model::lattice_journal_file(char* buffer,int size){
+    // journal of a new run is named after its start time and continued by resumed runs
+    char file_name[250];
+    if (!journal_name) {
+        int j = 0;
+        j  = sprintf_s(file_name  ,sizeof(file_name),  "%s",fprefix);
+        j += sprintf_s(file_name+j,sizeof(file_name)-j,"%.2s-%.3s-%.2s-%.2s-%.2s-%.2s.qcj",timestart+22,timestart+4,timestart+8,timestart+11,timestart+14,timestart+17);
+        journal_name = (char*) calloc(strlen(file_name) + 1,sizeof(char));
+        strcpy_s(journal_name,strlen(file_name) + 1,file_name);
+        sprintf_s(file_name,sizeof(file_name),"%s%s",path,journal_name);
+        remove(file_name);
+        journal_rows = journal_rows_queued = 0;
+    }
+    if (buffer) sprintf_s(buffer,size,"%s%s",path,journal_name);
+}
+
 void        model::lattice_save_state(void){
+    lattice_save_state_wait(true);  // staging memory is released, as the whole configuration is mapped here
+
     time_t ltimesave;
     time(&ltimesave);
     char* timesave   = GPU0->get_current_datetime();
 
+    bool journal = ((checkpoint_journal) && (checkpoint_format == 2));    // only new measurement rows are read
     lattice_pointer_save       = GPU0->buffer_map(lattice_table);
     unsigned int* lattice_measurement_save   = GPU0->buffer_map(lattice_measurement);
-    unsigned int* lattice_energies_save      = GPU0->buffer_map(lattice_energies);
+    unsigned int* lattice_energies_save      = NULL;
     unsigned int* lattice_energies_plq_save  = NULL;
     unsigned int* lattice_wilson_loop_save   = NULL;
+    unsigned int* lattice_wilson_grid_save   = NULL;
     unsigned int* lattice_polyakov_loop_save = NULL;
+    unsigned int* lattice_flow_save          = NULL;
 
+    if (!journal) {
+        lattice_energies_save          = GPU0->buffer_map(lattice_energies);
     if ((get_plaquettes_avr) || (get_Fmunu) || (get_F0mu))
         lattice_energies_plq_save  = GPU0->buffer_map(lattice_energies_plq);
     if (get_wilson_loop)
         lattice_wilson_loop_save   = GPU0->buffer_map(lattice_wilson_loop);
+    if (get_wilson_grid)
+        lattice_wilson_grid_save   = GPU0->buffer_map(lattice_wilson_grid);
     if (PL_level > 0)
         lattice_polyakov_loop_save = GPU0->buffer_map(lattice_polyakov_loop);
+    if (get_wilson_flow)
+        lattice_flow_save          = GPU0->buffer_map(lattice_flow);
+    }
 
     FILE *stream;
     char buffer[250];
@@ -1883,6 +2352,43 @@ void        model::lattice_save_state(void){
     j += sprintf_s(buffer+j,sizeof(buffer)-j,"%s",fprefix);
     j += sprintf_s(buffer+j,sizeof(buffer)-j,"%.2s-%.3s-%.2s-%.2s-%.2s-%.2s.qcg",timesave+22,timesave+4,timesave+8,timesave+11,timesave+14,timesave+17);
 
+    unsigned int prng_section[4];
+    lattice_make_prng_section(prng_section);
+    size_t lattice_element_size = (precision == model_precision_single) ? sizeof(cl_float4) : sizeof(cl_double4);
+
+    if (checkpoint_format == 2) {
+        // sections are split into chunks, which are written in parallel
+        if ((journal) && (!lattice_journal_append())) {free(head); return;}
+        checkpoint_CL::checkpoint* qcg = new(checkpoint_CL::checkpoint);
+        qcg->add_section("HEADER",  head,                     BIN_HEADER_SIZE * sizeof(unsigned int));
+        qcg->add_section("MEASURE", lattice_measurement_save, (unsigned long long) lattice_measurement_size_F * sizeof(cl_double2));
+        if (journal)
+            qcg->add_section("JOURNAL",  journal_name,               strlen(journal_name) + 1);
+        else {
+        qcg->add_section("ENERGY",  lattice_energies_save,    (unsigned long long) lattice_energies_size * sizeof(cl_double2));
+        if ((get_plaquettes_avr) || (get_Fmunu) || (get_F0mu))
+            qcg->add_section("PLQ",      lattice_energies_plq_save,  (unsigned long long) lattice_energies_size_F * sizeof(cl_double2));
+        if (get_wilson_loop)
+            qcg->add_section("WILSON",   lattice_wilson_loop_save,   (unsigned long long) lattice_energies_size * sizeof(cl_double));
+        if (get_wilson_grid)
+            qcg->add_section("WGRID",    lattice_wilson_grid_save,   (unsigned long long) size_lattice_wilson_grid * sizeof(cl_double));
+        if (PL_level > 0)
+            qcg->add_section("POLYAKOV", lattice_polyakov_loop_save, (unsigned long long) lattice_polyakov_loop_size * sizeof(cl_double2));
+        if (get_wilson_flow)
+            qcg->add_section("FLOW",     lattice_flow_save,          (unsigned long long) size_lattice_flow * sizeof(cl_double4));
+        }
+        if (get_polyakov_correlator)
+            qcg->add_section("PLCORR",   plattice_polyakov_correlator, (unsigned long long) size_lattice_polyakov_correlator * sizeof(cl_double));
+        qcg->add_section("LATTICE", lattice_pointer_save,     (unsigned long long) lattice_table_size * lattice_element_size);
+        qcg->add_section("PRNG",    prng_section,             sizeof(prng_section));
+        if (prng_section[3])
+            qcg->add_section("PRNGSTAT", PRNG0->state_save(), (unsigned long long) prng_section[3] * sizeof(unsigned int));
+        qcg->write(buffer);
+        delete(qcg);
+        free(head);
+        return;
+    }
+
     fopen_s(&stream,buffer,"wb");
     if(stream)
     {
@@ -1899,6 +2405,9 @@ void        model::lattice_save_state(void){
             fwrite(lattice_pointer_save, sizeof(cl_float4), lattice_table_size, stream);
         else
             fwrite(lattice_pointer_save, sizeof(cl_double4), lattice_table_size, stream);
+        fwrite(prng_section, sizeof(unsigned int), 4, stream);                                          // write PRNG state
+        if (prng_section[3])
+            fwrite(PRNG0->state_save(), sizeof(unsigned int), prng_section[3], stream);
 
         unsigned int hlen  = BIN_HEADER_SIZE*sizeof(unsigned int);
             if (GPU0->GPU_debug.brief_report) printf("Header: 0x%X-0x%X\n",0,hlen);
@@ -1929,6 +2438,9 @@ void        model::lattice_save_state(void){
             hlen2 = lattice_table_size * sizeof(cl_double4);
         if (GPU0->GPU_debug.brief_report) printf("Lattice data: 0x%X-0x%X\n",hlen,(hlen+hlen2));
         hlen += hlen2;
+        hlen2 = (4 + prng_section[3]) * sizeof(unsigned int);
+        if (GPU0->GPU_debug.brief_report) printf("PRNG state: 0x%X-0x%X\n",hlen,(hlen+hlen2));
+        hlen += hlen2;
 
 
         if ( fclose(stream) ) printf( "The file was not closed!\n" );
@@ -1936,6 +2448,18 @@ void        model::lattice_save_state(void){
     free(head);
 }
 
+void        model::lattice_make_prng_section(unsigned int* prng_section){
+    prng_section[0] = convert_str_uint("PRNG",0);
+    prng_section[1] = PRNG0->convert_generator_to_uint(PRNG0->PRNG_generator);
+    prng_section[2] = PRNG0->PRNG_counter;
+    prng_section[3] = PRNG0->state_size();
+}
+
+bool        model::lattice_check_prng_section(unsigned int* prng_section){
+    return ((prng_section[0] == convert_str_uint("PRNG",0)) &&
+            (PRNG0->convert_uint_to_generator(prng_section[1]) == PRNG0->PRNG_generator) && (prng_section[2] == PRNG_counter));
+}
+
 unsigned int*   model::lattice_make_bin_header(void){
     int k;
     // bin header structure:
@@ -2051,6 +2575,71 @@ void        model::lattice_load_state(void){
     j  = sprintf_s(buffer  ,sizeof(buffer),  "%s",path);
     j += sprintf_s(buffer+j,sizeof(buffer)-j,"%s",fstate);
 
+    if (checkpoint_CL::checkpoint::is_qcg2(buffer)) {
+        // file is mapped, only the sections needed at the current load state are read
+        checkpoint_CL::checkpoint* qcg = new(checkpoint_CL::checkpoint);
+        if (qcg->open(buffer)) {
+            result = qcg->read_section("HEADER", head, BIN_HEADER_SIZE * sizeof(unsigned int));
+            if ((result) && (LOAD_state==0)) result = lattice_load_bin_header(head);
+            if (!result) printf("[ERROR in header!!!]\n");
+            if (LOAD_state==1) {
+                size_t lattice_element_size = (precision == model_precision_single) ? sizeof(cl_float4) : sizeof(cl_double4);
+                void*  lattice_table_load   = (precision == model_precision_single) ? (void*) plattice_table_float : (void*) plattice_table_double;
+                result &= qcg->read_section("MEASURE", plattice_measurement, (unsigned long long) lattice_measurement_size_F * sizeof(cl_double2));
+                unsigned long long journal_size = 0;
+                const char* journal = (const char*) qcg->section("JOURNAL", &journal_size, true);
+                if ((journal) && (journal_size > 1) && (!journal[journal_size - 1])) {
+                    // measurement history is replayed from journal up to the saved working iteration
+                    checkpoint_CL::checkpoint_journal::qcj_buffer index[QCG2_MAX_SECTIONS];
+                    int   buffer_id[QCG2_MAX_SECTIONS];
+                    void* host_data[QCG2_MAX_SECTIONS];
+                    int   buffers = lattice_journal_index(index,buffer_id,host_data);
+                    free(journal_name);
+                    journal_name = (char*) calloc((size_t) journal_size,sizeof(char));
+                    memcpy(journal_name,journal,(size_t) journal_size);
+                    char journal_file[250];
+                    lattice_journal_file(journal_file,sizeof(journal_file));
+                    int records = checkpoint_CL::checkpoint_journal::replay(journal_file,ITER_counter,index,buffers,host_data);
+                    if (records < 0) {printf("[ERROR] journal %s is absent!\n",journal_file); result = false;}
+                    if (GPU0->GPU_debug.brief_report) printf("Journal %s: %i records\n",journal_file,records);
+                    checkpoint_journal  = true;
+                    journal_rows        = ITER_counter;
+                    journal_rows_queued = ITER_counter;
+                } else {
+                result &= qcg->read_section("ENERGY",  plattice_energies,    (unsigned long long) lattice_energies_size * sizeof(cl_double2));
+                if ((get_plaquettes_avr) || (get_Fmunu) || (get_F0mu))
+                    result &= qcg->read_section("PLQ",      plattice_energies_plq,  (unsigned long long) lattice_energies_size_F * sizeof(cl_double2));
+                if (get_wilson_loop)
+                    result &= qcg->read_section("WILSON",   plattice_wilson_loop,   (unsigned long long) lattice_energies_size * sizeof(cl_double));
+                if (get_wilson_grid)
+                    result &= qcg->read_section("WGRID",    plattice_wilson_grid,   (unsigned long long) size_lattice_wilson_grid * sizeof(cl_double));
+                if (PL_level > 0)
+                    result &= qcg->read_section("POLYAKOV", plattice_polyakov_loop, (unsigned long long) lattice_polyakov_loop_size * sizeof(cl_double2));
+                if (get_wilson_flow)
+                    result &= qcg->read_section("FLOW",     plattice_flow,          (unsigned long long) size_lattice_flow * sizeof(cl_double4));
+                }
+                if (get_polyakov_correlator)
+                    result &= qcg->read_section("PLCORR",  plattice_polyakov_correlator, (unsigned long long) size_lattice_polyakov_correlator * sizeof(cl_double));
+                result &= qcg->read_section("LATTICE", lattice_table_load,   (unsigned long long) lattice_table_size * lattice_element_size);
+                if (!result) printf("[ERROR in state file %s!!!]\n",buffer);
+
+                unsigned int prng_section[4];
+                unsigned long long prng_state_size = 0;
+                const void* prng_state = qcg->section("PRNGSTAT", &prng_state_size, true);
+                if ((qcg->read_section("PRNG", prng_section, sizeof(prng_section))) && (lattice_check_prng_section(prng_section)) &&
+                    ((prng_section[3] == 0) || ((prng_state) && (prng_state_size == (unsigned long long) prng_section[3] * sizeof(unsigned int))))) {
+                    PRNG_state_size = prng_section[3];
+                    PRNG_state      = (unsigned int*) calloc(PRNG_state_size + 1, sizeof(unsigned int));
+                    if (PRNG_state_size) memcpy(PRNG_state, prng_state, PRNG_state_size * sizeof(unsigned int));
+                }
+            }
+            LOAD_state++;
+        }
+        delete(qcg);
+        free(head);
+        return;
+    }
+
     fopen_s(&stream,buffer,"rb");
     if(stream)
     {
@@ -2070,6 +2659,15 @@ void        model::lattice_load_state(void){
                 fread(plattice_table_float,   sizeof(cl_float4),  lattice_table_size, stream);
             else
                 fread(plattice_table_double,  sizeof(cl_double4), lattice_table_size, stream);
+            unsigned int prng_section[4];                                                              // load PRNG state (absent in old files)
+            if ((fread(prng_section, sizeof(unsigned int), 4, stream) == 4) && (lattice_check_prng_section(prng_section))) {
+                PRNG_state_size = prng_section[3];
+                PRNG_state      = (unsigned int*) calloc(PRNG_state_size + 1, sizeof(unsigned int));
+                if (fread(PRNG_state, sizeof(unsigned int), PRNG_state_size, stream) != PRNG_state_size) {
+                    free(PRNG_state);
+                    PRNG_state = NULL;
+                }
+            }
 
             if ( fclose(stream) ) printf( "The file was not closed!\n" );
         }
@@ -2115,6 +2713,16 @@ void        model::Fmunu_defaults(void)
 }
 void        model::model_lattice_init(void){
     Fmunu_defaults();
+    if ((flow_interval > 0) && (flow_steps > 0))
+        printf("[!] Wilson flow is not supported for BIGLAT - turned off\n");
+    if (NOR > 0) {
+        printf("[!] Over-relaxation is not supported for BIGLAT - turned off\n");
+        NOR = 0;
+    }
+    if (fused_update) {
+        printf("[!] Fused update is not supported for BIGLAT - turned off\n");
+        fused_update = false;
+    }
 
     //size_t workgroup_factor;
     int wln;
@@ -2281,6 +2889,34 @@ void        model::model_lattice_init(void){
     lattice_measurement_size_F      = lattice_measurement_size * MODEL_energies_size;
     lattice_measurement_offset      = lattice_measurement_size;
 
+    get_wilson_grid                 = ((wilson_Rmax > 0) && (wilson_Tmax > 0));
+    get_polyakov_correlator         = (PL_correlator > 0);
+    get_smearing                    = ((smear_type > 0) && (smear_steps > 0) && ((get_wilson_loop) || (get_wilson_grid)));
+    if ((get_smearing) && (!((PHI==0.0)&&(OMEGA==0.0)))) {
+        printf("[!] Smearing is not supported with twisted boundary conditions (PHI, OMEGA) - turned off\n");
+        get_smearing                = false;
+    }
+#ifdef BIGLAT
+    if (get_smearing) {
+        printf("[!] Smearing is not supported for BIGLAT (no halo exchange of smeared links) - turned off\n");
+        get_smearing                = false;
+    }
+#endif
+    get_wilson_flow                 = ((flow_interval > 0) && (flow_steps > 0));
+    if ((get_wilson_flow) && (!((PHI==0.0)&&(OMEGA==0.0)))) {
+        printf("[!] Wilson flow is not supported with twisted boundary conditions (PHI, OMEGA) - turned off\n");
+        get_wilson_flow             = false;
+    }
+    if ((NOR > 0) && (!((PHI==0.0)&&(OMEGA==0.0)))) {
+        printf("[!] Over-relaxation is not supported with twisted boundary conditions (PHI, OMEGA) - turned off\n");
+        NOR                         = 0;
+    }
+    if ((fused_update) && (((!PRNG0->counter_based()) && (PRNG0->PRNG_generator != PRNG_CL::PRNG::PRNG_generator_XOR128)) || (ints == model_start_gid))) {
+        printf("[!] Fused update requires PRNG = PHILOX or XOR128 and INTS != 2 - turned off\n");
+        fused_update                = false;
+    }
+    lattice_wilson_grid_offset      = GPU0->buffer_size_align((unsigned int) ceil((double) lattice_table_exact_row_size / workgroup_factor));
+
     if (PL_level>2)
       lattice_polyakov_size         = GPU0->buffer_size_align((unsigned int) (lattice_domain_n2n3 * getK(lattice_domain_n1, lattice_domain_size[1], GPU0->GPU_limit_max_workgroup_size)));
     else
@@ -2300,8 +2936,12 @@ void        model::model_lattice_init(void){
 
     //_____________________________________________ PRNG preparation
         PRNG0->PRNG_instances   = 0;    // number of instances of generator (or 0 for autoselect)
+        // fused update generates its PRNs inline: PRNG output is needed for hot start only (no output buffer for XOR128 otherwise)
+        PRNG0->PRNG_inline      = ((fused_update) && (PRNG0->PRNG_generator == PRNG_CL::PRNG::PRNG_generator_XOR128) && (ints != model_start_hot));
         // number of samples produced by each generator (quads)
-        if (ints == model_start_hot)
+        if ((ints == model_start_hot) && (fused_update))
+            PRNG0->PRNG_samples     = GPU0->buffer_size_align((unsigned int) ceil(double(lattice_table_row_size * lattice_nd)));
+        else if (ints == model_start_hot)
             PRNG0->PRNG_samples     = GPU0->buffer_size_align((unsigned int) ceil(double(lattice_table_row_size * lattice_nd + 3 * lattice_table_row_size_half * (NHIT + 1))));
         else
             PRNG0->PRNG_samples     = GPU0->buffer_size_align((unsigned int) ceil(double(NHITPar * (3 * lattice_table_row_size_half * (NHIT + 1))))); // 3*(NHIT+1) PRNs per link
@@ -2444,6 +3084,7 @@ void    model::lattice_mp_Sim(void)
         options_length += sprintf_s(options + options_length, sizeof(options) - options_length, " -D NHIT=%u", NHIT);
         options_length += sprintf_s(options + options_length, sizeof(options) - options_length, " -D NHITPar=%u", NHITPar);
         options_length += sprintf_s(options + options_length, sizeof(options) - options_length, " -D PRNGSTEP=%u", SubLat[k].sublattice_table_row_size_half);
+        options_length += sprintf_s(options + options_length, sizeof(options) - options_length, " -D HALO_ROWS=%u", lattice_group_elements[lattice_group - 1] / 4);
 
         j = sprintf_s(buffer_update_cl  ,FNAME_MAX_LENGTH,  "%s",SubLat[k].GPU0->cl_root_path);
         j+= sprintf_s(buffer_update_cl+j,FNAME_MAX_LENGTH-j,"%s",SOURCE_UPDATE);
@@ -2557,6 +3198,18 @@ void    model::lattice_kern_update_Sim(void)
                 argument_id = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_update_even_T_id,SubLat[k].sublattice_table);
                 argument_id = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_update_even_T_id,SubLat[k].sublattice_parameters);
                 argument_id = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_update_even_T_id,SubLat[k].PRNG0->PRNG_randoms_id);
+
+        int halo_dir = X;
+        size_t halo_global_size[] = {SubLat[k].GPU0->buffer_size_align(2 * (lattice_group_elements[lattice_group - 1] / 4) * SubLat[k].Ny * SubLat[k].Nz * SubLat[k].Nt)};
+        SubLat[k].sun_halo_pack_id = SubLat[k].GPU0->kernel_init("lattice_halo_pack",1,halo_global_size,NULL);
+                argument_id = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_halo_pack_id,SubLat[k].sublattice_table);
+                SubLat[k].argument_halo_pack_dir = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_halo_pack_id,SubLat[k].sublattice_halo_send);
+                argument_id = SubLat[k].GPU0->kernel_init_constant(SubLat[k].sun_halo_pack_id,&halo_dir);
+
+        SubLat[k].sun_halo_unpack_id = SubLat[k].GPU0->kernel_init("lattice_halo_unpack",1,halo_global_size,NULL);
+                argument_id = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_halo_unpack_id,SubLat[k].sublattice_table);
+                SubLat[k].argument_halo_unpack_dir = SubLat[k].GPU0->kernel_init_buffer(SubLat[k].sun_halo_unpack_id,SubLat[k].sublattice_halo_recv);
+                argument_id = SubLat[k].GPU0->kernel_init_constant(SubLat[k].sun_halo_unpack_id,&halo_dir);
     }
 }
 
@@ -2628,6 +3281,7 @@ void    model::lattice_mp_Meas(void)
 
     if (get_Fmunu) options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D FMUNU");   // calculate tensor Fmunu for H field
     if (get_F0mu)  options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D F0MU");   // calculate tensor Fmunu for E field
+    options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D CHECK_SITE_VALUES=%u",CHECK_SITE_VALUES);   // per-site values of lattice_check_sites
 
     if ((get_Fmunu)||(get_F0mu)) {
         if (get_Fmunu1) options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D FMUNU1");   // calculate tensor Fmunu for lambda1 matrix
@@ -3299,6 +3953,12 @@ void        model::lattice_make_programs(void)
         options_length += sprintf_s(options + options_length,sizeof(options)-options_length," -D NHIT=%u",        NHIT);
         options_length += sprintf_s(options + options_length,sizeof(options)-options_length," -D NHITPar=%u",     NHITPar);
         options_length += sprintf_s(options + options_length,sizeof(options)-options_length," -D PRNGSTEP=%u",    lattice_table_row_size_half);
+    if (fused_update) {
+        options_length += sprintf_s(options + options_length,sizeof(options)-options_length," -D FUSED_UPDATE");
+        if (PRNG0->PRNG_generator == PRNG_CL::PRNG::PRNG_generator_XOR128)
+            options_length += sprintf_s(options + options_length,sizeof(options)-options_length," -D INLINE_XOR128");
+        options_length += snprintf (options + options_length,sizeof(options)-options_length," -I %s%s",       GPU0->cl_root_path,path_random);
+    }
 
     char buffer_update_cl[FNAME_MAX_LENGTH];
         j = sprintf_s(buffer_update_cl  ,FNAME_MAX_LENGTH,  "%s",GPU0->cl_root_path);
@@ -3315,6 +3975,7 @@ void        model::lattice_make_programs(void)
 
     const size_t measurement3_global_size[]       = {lattice_action_size};
     const size_t polyakov3_global_size[]          = {lattice_polyakov_size};
+    const size_t polyakov_field_global_size[]     = {GPU0->buffer_size_align((unsigned int) lattice_domain_exact_n1n2n3)};
     const size_t clear_measurement_global_size[]  = {lattice_measurement_size_F};
 
     const size_t reduce_measurement_global_size[] = {GPU0->GPU_info.max_workgroup_size};
@@ -3351,45 +4012,79 @@ void        model::lattice_make_programs(void)
            argument_id = GPU0->kernel_init_buffer(sun_GramSchmidt_id,lattice_table);
            argument_id = GPU0->kernel_init_buffer(sun_GramSchmidt_id,lattice_parameters);
 
-    sun_update_odd_X_id = GPU0->kernel_init("update_odd_X",1,monte_global_size,NULL);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,lattice_table);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,lattice_parameters);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_even_X_id = GPU0->kernel_init("update_even_X",1,monte_global_size,NULL);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,lattice_table);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,lattice_parameters);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_odd_Y_id = GPU0->kernel_init("update_odd_Y",1,monte_global_size,NULL);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,lattice_table);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,lattice_parameters);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_even_Y_id = GPU0->kernel_init("update_even_Y",1,monte_global_size,NULL);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,lattice_table);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,lattice_parameters);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_odd_Z_id = GPU0->kernel_init("update_odd_Z",1,monte_global_size,NULL);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,lattice_table);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,lattice_parameters);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_even_Z_id = GPU0->kernel_init("update_even_Z",1,monte_global_size,NULL);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,lattice_table);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,lattice_parameters);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_odd_T_id = GPU0->kernel_init("update_odd_T",1,monte_global_size,NULL);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,lattice_table);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,lattice_parameters);
-            argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,PRNG0->PRNG_randoms_id);
-
-    sun_update_even_T_id = GPU0->kernel_init("update_even_T",1,monte_global_size,NULL);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,lattice_table);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,lattice_parameters);
-             argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,PRNG0->PRNG_randoms_id);
+    // split heat bath (PRNs from PRNG output buffer) is not used by fused update
+    if (!fused_update) {
+        sun_update_odd_X_id = GPU0->kernel_init("update_odd_X",1,monte_global_size,NULL);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,lattice_table);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,lattice_parameters);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_X_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_even_X_id = GPU0->kernel_init("update_even_X",1,monte_global_size,NULL);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,lattice_table);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,lattice_parameters);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_X_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_odd_Y_id = GPU0->kernel_init("update_odd_Y",1,monte_global_size,NULL);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,lattice_table);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,lattice_parameters);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Y_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_even_Y_id = GPU0->kernel_init("update_even_Y",1,monte_global_size,NULL);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,lattice_table);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,lattice_parameters);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Y_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_odd_Z_id = GPU0->kernel_init("update_odd_Z",1,monte_global_size,NULL);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,lattice_table);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,lattice_parameters);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_Z_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_even_Z_id = GPU0->kernel_init("update_even_Z",1,monte_global_size,NULL);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,lattice_table);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,lattice_parameters);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_Z_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_odd_T_id = GPU0->kernel_init("update_odd_T",1,monte_global_size,NULL);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,lattice_table);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,lattice_parameters);
+                argument_id = GPU0->kernel_init_buffer(sun_update_odd_T_id,PRNG0->PRNG_randoms_id);
+
+        sun_update_even_T_id = GPU0->kernel_init("update_even_T",1,monte_global_size,NULL);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,lattice_table);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,lattice_parameters);
+                 argument_id = GPU0->kernel_init_buffer(sun_update_even_T_id,PRNG0->PRNG_randoms_id);
+    } else {
+        sun_update_odd_X_id = sun_update_odd_Y_id = sun_update_odd_Z_id = sun_update_odd_T_id = 0;
+        sun_update_even_X_id = sun_update_even_Y_id = sun_update_even_Z_id = sun_update_even_T_id = 0;
+    }
+
+    sun_update_fused_id = 0;
+    if (fused_update) {
+        int update_fused_zero = 0;
+        sun_update_fused_id = GPU0->kernel_init("update_fused",1,monte_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_update_fused_id,lattice_table);
+        argument_update_fused_dir = GPU0->kernel_init_buffer(sun_update_fused_id,lattice_parameters);
+     argument_update_fused_parity = GPU0->kernel_init_constant(sun_update_fused_id,&update_fused_zero);
+                      argument_id = GPU0->kernel_init_constant(sun_update_fused_id,&update_fused_zero);
+        argument_update_fused_sweep = argument_id;
+        if (lattice_prn_states)
+                      argument_id = GPU0->kernel_init_buffer(sun_update_fused_id,lattice_prn_states);
+        else {
+                      argument_id = GPU0->kernel_init_constant(sun_update_fused_id,&update_fused_zero);
+                      argument_id = GPU0->kernel_init_constant(sun_update_fused_id,(int*) &PRNG0->PRNG_srandtime);
+        }
+    }
+
+    sun_overrelax_id = 0;
+    if (NOR > 0) {
+        int overrelax_dir    = 0;
+        int overrelax_parity = 0;
+        sun_overrelax_id = GPU0->kernel_init("update_overrelax",1,monte_global_size,NULL);
+              argument_id = GPU0->kernel_init_buffer(sun_overrelax_id,lattice_table);
+   argument_overrelax_dir = GPU0->kernel_init_buffer(sun_overrelax_id,lattice_parameters);
+argument_overrelax_parity = GPU0->kernel_init_constant(sun_overrelax_id,&overrelax_dir);
+              argument_id = GPU0->kernel_init_constant(sun_overrelax_id,&overrelax_parity);
+    }
 
     // for all measurements _____________________________________________________________________________________________________________________________________
     char options_measurements[1024];
@@ -3397,6 +4092,7 @@ void        model::lattice_make_programs(void)
 
     if (get_Fmunu) options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D FMUNU");   // calculate tensor Fmunu for H field
     if (get_F0mu)  options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D F0MU");   // calculate tensor Fmunu for E field
+    options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D CHECK_SITE_VALUES=%u",CHECK_SITE_VALUES);   // per-site values of lattice_check_sites
 
     if ((get_Fmunu)||(get_F0mu)) {
         if (get_Fmunu1) options_measurement_length += sprintf_s(options_measurements + options_measurement_length,sizeof(options_measurements)-options_measurement_length," -D FMUNU1");   // calculate tensor Fmunu for lambda1 matrix
@@ -3429,6 +4125,18 @@ void        model::lattice_make_programs(void)
            argument_id = GPU0->kernel_init_buffer(sun_measurement_id,lattice_lds);
     int size_reduce_measurement_double2 = (int) ceil((double) lattice_table_exact_row_size / GPU0->kernel_get_worksize(sun_measurement_id));
 
+    sun_check_sites_id = 0;
+    if (check_samples > 0) {
+        const size_t check_sites_global_size[] = {GPU0->buffer_size_align(check_samples)};
+        int check_sites = (int) check_samples;
+        sun_check_sites_id = GPU0->kernel_init("lattice_check_sites",1,check_sites_global_size,NULL);
+               argument_id = GPU0->kernel_init_buffer(sun_check_sites_id,lattice_table);
+               argument_id = GPU0->kernel_init_buffer(sun_check_sites_id,lattice_check_values);
+               argument_id = GPU0->kernel_init_buffer(sun_check_sites_id,lattice_parameters);
+               argument_id = GPU0->kernel_init_buffer(sun_check_sites_id,lattice_check_gid);
+               argument_id = GPU0->kernel_init_constant(sun_check_sites_id,&check_sites);
+    }
+
     printf("GPU0->kernel_get_worksize(sun_measurement_id) = %i\n", GPU0->kernel_get_worksize(sun_measurement_id));
     
     sun_measurement_reduce_id = GPU0->kernel_init("reduce_measurement_double2",1,reduce_measurement_global_size,reduce_local_size);
@@ -3514,9 +4222,46 @@ void        model::lattice_make_programs(void)
         _getch();
     }
 
+    // for smearing of spatial links before Wilson loop measurements _____________________________________________________________________________________________
+    sun_smear_id       = 0;
+    sun_smear_forth_id = 0;
+    sun_smear_back_id  = 0;
+    unsigned int wilson_table = lattice_table;
+    if (get_smearing) {
+        char options_smear[1024];
+        int options_length_smear  = sprintf_s(options_smear,sizeof(options_smear),"%s",options);
+            options_length_smear += sprintf_s(options_smear + options_length_smear,sizeof(options_smear)-options_length_smear," -D SMEAR=%u",smear_type);
+            options_length_smear += sprintf_s(options_smear + options_length_smear,sizeof(options_smear)-options_length_smear," -D SMEAR_ALPHA=%.16e",smear_alpha);
+
+        char buffer_smear_cl[FNAME_MAX_LENGTH];
+            j = sprintf_s(buffer_smear_cl  ,FNAME_MAX_LENGTH,  "%s",GPU0->cl_root_path);
+            j+= sprintf_s(buffer_smear_cl+j,FNAME_MAX_LENGTH-j,"%s",SOURCE_SMEARING);
+        char* smear_source        = GPU0->source_read(buffer_smear_cl);
+                                    GPU0->program_create(smear_source,options_smear);
+
+        // step 1 reads lattice_table (never written), step k > 1 reads the copy written by step k - 1
+        sun_smear_id = GPU0->kernel_init("lattice_smear",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_id,lattice_table);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_id,lattice_smeared[0]);
+        if (smear_steps > 1) {
+            sun_smear_forth_id = GPU0->kernel_init("lattice_smear",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_forth_id,lattice_smeared[0]);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_forth_id,lattice_smeared[1]);
+            sun_smear_back_id  = GPU0->kernel_init("lattice_smear",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_back_id,lattice_smeared[1]);
+                      argument_id = GPU0->kernel_init_buffer(sun_smear_back_id,lattice_smeared[0]);
+        }
+        wilson_table = lattice_smeared[(smear_steps - 1) % 2];
+    }
+
     // for Wilson loop measurements _____________________________________________________________________________________________________________________________
     char options_wilson[1024];
-    sprintf_s(options_wilson,sizeof(options_wilson),"%s",options_common);
+    int options_length_wilson  = sprintf_s(options_wilson,sizeof(options_wilson),"%s",options_common);
+    if (get_wilson_grid) {
+        options_length_wilson += sprintf_s(options_wilson + options_length_wilson,sizeof(options_wilson)-options_length_wilson," -D WLRMAX=%u",wilson_Rmax);
+        options_length_wilson += sprintf_s(options_wilson + options_length_wilson,sizeof(options_wilson)-options_length_wilson," -D WLTMAX=%u",wilson_Tmax);
+        options_length_wilson += sprintf_s(options_wilson + options_length_wilson,sizeof(options_wilson)-options_length_wilson," -D WLOFFSET=%u",lattice_wilson_grid_offset);
+    }
 
     char buffer_wilson_cl[FNAME_MAX_LENGTH];
         j = sprintf_s(buffer_wilson_cl  ,FNAME_MAX_LENGTH,  "%s",GPU0->cl_root_path);
@@ -3530,7 +4275,7 @@ void        model::lattice_make_programs(void)
     sun_wilson_loop_reduce_id  = 0;
     if (get_wilson_loop) {
         sun_measurement_wilson_id = GPU0->kernel_init("lattice_measurement_wilson",1,measurement3_global_size,local_size_lattice_wilson);
-                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_id,lattice_table);
+                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_id,wilson_table);
                       argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_id,lattice_measurement);
                       argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_id,lattice_parameters);
                       argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_id,lattice_lds);
@@ -3544,6 +4289,86 @@ void        model::lattice_make_programs(void)
                       // setup index for wilson loop is before kernel run
     }
 
+    sun_measurement_wilson_grid_id = 0;
+    sun_wilson_grid_reduce_id      = 0;
+    if (get_wilson_grid) {
+        sun_measurement_wilson_grid_id = GPU0->kernel_init("lattice_measurement_wilson_grid",1,measurement3_global_size,local_size_lattice_wilson);
+                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_grid_id,wilson_table);
+                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_grid_id,lattice_wilson_grid_measurement);
+                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_grid_id,lattice_parameters);
+                      argument_id = GPU0->kernel_init_buffer(sun_measurement_wilson_grid_id,lattice_lds);
+
+        cl_uint4 wilson_grid_param;
+            wilson_grid_param.s[0] = (int) ceil((double) lattice_domain_exact_site / GPU0->kernel_get_worksize(sun_measurement_wilson_grid_id));
+            wilson_grid_param.s[1] = lattice_energies_size;
+            wilson_grid_param.s[2] = 0;
+            wilson_grid_param.s[3] = 0;
+        if (wilson_grid_param.s[0] > lattice_wilson_grid_offset){
+            printf ("buffer plattice_wilson_grid_measurement should be resized!!!\n");
+            _getch();
+        }
+
+        sun_wilson_grid_reduce_id = GPU0->kernel_init("reduce_wilson_grid_double2",1,reduce_measurement_global_size,reduce_local_size);
+                      argument_id = GPU0->kernel_init_buffer(sun_wilson_grid_reduce_id,lattice_wilson_grid_measurement);
+                      argument_id = GPU0->kernel_init_buffer(sun_wilson_grid_reduce_id,lattice_wilson_grid);
+                      argument_id = GPU0->kernel_init_buffer(sun_wilson_grid_reduce_id,lattice_lds);
+                      argument_wilson_grid_index = GPU0->kernel_init_constant(sun_wilson_grid_reduce_id,&wilson_grid_param);
+                      // setup index for wilson loops grid is before kernel run
+    }
+
+    // for Wilson flow measurements _____________________________________________________________________________________________________________________________
+    sun_flow_copy_id        = 0;
+    sun_flow_force_id       = 0;
+    sun_flow_update_id      = 0;
+    sun_flow_measurement_id = 0;
+    sun_flow_reduce_id      = 0;
+    if (get_wilson_flow) {
+        char options_flow[1024];
+        int options_length_flow  = sprintf_s(options_flow,sizeof(options_flow),"%s",options_common);
+            options_length_flow += sprintf_s(options_flow + options_length_flow,sizeof(options_flow)-options_length_flow," -D FLOW_EPS=%.16e",flow_eps);
+
+        char buffer_flow_cl[FNAME_MAX_LENGTH];
+            j = sprintf_s(buffer_flow_cl  ,FNAME_MAX_LENGTH,  "%s",GPU0->cl_root_path);
+            j+= sprintf_s(buffer_flow_cl+j,FNAME_MAX_LENGTH-j,"%s",SOURCE_WILSON_FLOW);
+        char* flow_source         = GPU0->source_read(buffer_flow_cl);
+                                    GPU0->program_create(flow_source,options_flow);
+
+        int flow_stage = 0;
+        sun_flow_copy_id = GPU0->kernel_init("lattice_flow_copy",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_copy_id,lattice_table);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_copy_id,lattice_flow_table);
+
+        sun_flow_force_id = GPU0->kernel_init("lattice_flow_force",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_force_id,lattice_flow_table);
+                      argument_flow_force_stage = GPU0->kernel_init_buffer(sun_flow_force_id,lattice_flow_force);
+                      argument_id = GPU0->kernel_init_constant(sun_flow_force_id,&flow_stage);
+
+        sun_flow_update_id = GPU0->kernel_init("lattice_flow_update",1,init_global_size,NULL);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_update_id,lattice_flow_table);
+                      argument_flow_update_stage = GPU0->kernel_init_buffer(sun_flow_update_id,lattice_flow_force);
+                      argument_id = GPU0->kernel_init_constant(sun_flow_update_id,&flow_stage);
+
+        sun_flow_measurement_id = GPU0->kernel_init("lattice_flow_measurement",1,measurement3_global_size,local_size_lattice_measurement);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_measurement_id,lattice_flow_table);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_measurement_id,lattice_measurement);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_measurement_id,lattice_lds);
+
+        cl_uint4 flow_param;
+            flow_param.s[0] = (int) ceil((double) lattice_domain_exact_site / GPU0->kernel_get_worksize(sun_flow_measurement_id));
+            flow_param.s[1] = lattice_energies_size;
+            flow_param.s[2] = 0;
+            flow_param.s[3] = 0;
+
+        sun_flow_reduce_id = GPU0->kernel_init("reduce_flow_double2",1,reduce_measurement_global_size,reduce_local_size);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_reduce_id,lattice_measurement);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_reduce_id,lattice_flow);
+                      argument_id = GPU0->kernel_init_buffer(sun_flow_reduce_id,lattice_lds);
+                      argument_flow_index = GPU0->kernel_init_constant(sun_flow_reduce_id,&flow_param);
+                      argument_flow_step  = GPU0->kernel_init_constant(sun_flow_reduce_id,&flow_stage);
+                      argument_id = GPU0->kernel_init_constant(sun_flow_reduce_id,&flow_stage);
+                      // setup of index and flow step is before kernel run
+    }
+
     // for Polyakov loop measurements ___________________________________________________________________________________________________________________________
     char options_polyakov[1024];
     int options_length_polyakov  = sprintf_s(options_polyakov,sizeof(options_polyakov),"%s",options_common);
@@ -3587,6 +4412,13 @@ void        model::lattice_make_programs(void)
             polyakov_param.s[3] = 0;
             argument_polyakov_index = GPU0->kernel_init_constant(sun_polyakov_reduce_id,&polyakov_param);
     }
+    sun_polyakov_field_id = 0;
+    if (get_polyakov_correlator) {
+        sun_polyakov_field_id = GPU0->kernel_init("lattice_polyakov_field",1,polyakov_field_global_size,NULL);
+            argument_id = GPU0->kernel_init_buffer(sun_polyakov_field_id,lattice_table);
+            argument_id = GPU0->kernel_init_buffer(sun_polyakov_field_id,lattice_polyakov_field);
+            argument_id = GPU0->kernel_init_buffer(sun_polyakov_field_id,lattice_parameters);
+    }
     if (PL_level > 2) {
         sun_polyakov_diff_x_id = GPU0->kernel_init("lattice_polyakov_diff_x",1,polyakov3_global_size,local_size_lattice_polyakov);
         offset_reduce_polyakov_diff_double2 = GPU0->buffer_size_align((unsigned int) ceil((double) lattice_polyakov_size / GPU0->kernel_get_worksize(sun_polyakov_diff_x_id)),GPU0->kernel_get_worksize(sun_polyakov_diff_x_id));
@@ -3645,6 +4477,7 @@ void        model::lattice_make_programs(void)
             polyakov_param.s[3] = 0;
             argument_polyakov_diff_z_index = GPU0->kernel_init_constant(sun_polyakov_diff_z_reduce_id,&polyakov_param);
     }
+    lattice_kernel_costs();
 }
 #endif
 
@@ -3775,6 +4608,14 @@ void        model::lattice_create_buffers(void)
         }
         
         SubLat[k].sublattice_lds = SubLat[k].GPU0->buffer_init(SubLat[k].GPU0->buffer_type_LDS, lds_size, NULL, sizeof(cl_double2)); // LDS for reduction
+
+        // halo exchange: two faces of (group elements / 4) rows of one direction
+        int halo_size    = 2 * (lattice_group_elements[lattice_group - 1] / 4) * SubLat[k].Ny * SubLat[k].Nz * SubLat[k].Nt;
+        int halo_element = (precision == model_precision_single) ? (int) sizeof(cl_float4) : (int) sizeof(cl_double4);
+        SubLat[k].sublattice_halo_face = (size_t) halo_size * halo_element / 2;
+        SubLat[k].sublattice_halo_send = SubLat[k].GPU0->buffer_init(SubLat[k].GPU0->buffer_type_IO, halo_size, NULL, halo_element);   // packed faces
+        SubLat[k].sublattice_halo_recv = SubLat[k].GPU0->buffer_init(SubLat[k].GPU0->buffer_type_IO, halo_size, NULL, halo_element);   // received halo slices
+        SubLat[k].psublattice_halo     = SubLat[k].GPU0->buffer_pinned_alloc(2 * SubLat[k].sublattice_halo_face, &SubLat[k].sublattice_halo_pinned);
         
         SubLat[k].psublattice_measurement    = (cl_double2*) calloc(SubLat[k].size_sublattice_measurement,  sizeof(cl_double2));
         SubLat[k].sublattice_measurement         = SubLat[k].GPU0->buffer_init(SubLat[k].GPU0->buffer_type_IO, SubLat[k].size_sublattice_measurement,      SubLat[k].psublattice_measurement,       sizeof(cl_double2)); // Lattice measurement
@@ -3887,6 +4728,8 @@ int fc2 = 1;
     size_lattice_measurement   = fc * lattice_measurement_size_F;
     size_lattice_energies      = fc * lattice_energies_size;
     size_lattice_wilson_loop   = fc * lattice_energies_size;
+    size_lattice_wilson_grid   = fc * lattice_energies_size * wilson_Rmax * wilson_Tmax;
+    size_lattice_flow          = fc * lattice_energies_size * (flow_steps + 1);
     size_lattice_energies_plq  = fc * lattice_energies_offset * MODEL_energies_size;
     
     if(get_actions_diff)
@@ -3911,7 +4754,23 @@ int fc2 = 1;
     plattice_energies       = (cl_double2*) calloc(size_lattice_energies,     sizeof(cl_double2));
     plattice_energies_plq   = (cl_double2*) calloc(size_lattice_energies_plq, sizeof(cl_double2));
     plattice_wilson_loop    = (cl_double*)  calloc(size_lattice_wilson_loop,  sizeof(cl_double));
+    plattice_wilson_grid    = NULL;
+    if (get_wilson_grid) {
+        plattice_wilson_grid = (cl_double*) calloc(size_lattice_wilson_grid,  sizeof(cl_double));
+        Analysis_wilson_grid = (analysis_CL::analysis::data_analysis*) calloc(wilson_Rmax * wilson_Tmax,sizeof(analysis_CL::analysis::data_analysis));
+    }
     plattice_polyakov_loop  = NULL;
+    if (get_polyakov_correlator) {
+        lattice_polyakov_correlator_init();
+        size_lattice_polyakov_correlator = fc * lattice_polyakov_loop_size * polyakov_correlator_bins;
+        plattice_polyakov_field      = (cl_double2*) calloc(lattice_domain_exact_n1n2n3,       sizeof(cl_double2));
+        plattice_polyakov_correlator = (cl_double*)  calloc(size_lattice_polyakov_correlator, sizeof(cl_double));
+        Analysis_PL_corr = (analysis_CL::analysis::data_analysis*) calloc(polyakov_correlator_bins,sizeof(analysis_CL::analysis::data_analysis));
+    }
+    if (get_wilson_flow) {
+        plattice_flow = (cl_double4*) calloc(size_lattice_flow, sizeof(cl_double4));
+        Analysis_flow = (analysis_CL::analysis::data_analysis*) calloc(3 * (flow_steps + 1),sizeof(analysis_CL::analysis::data_analysis));
+    }
     
     plattice_action_diff_x      = NULL;
     plattice_action_diff_y      = NULL;
@@ -3980,8 +4839,52 @@ int fc2 = 1;
         lattice_energies_plq    = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_energies_plq,     plattice_energies_plq,      sizeof(cl_double2)); // Lattice energies (plaquettes)
     if (get_wilson_loop)
         lattice_wilson_loop     = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_wilson_loop,      plattice_wilson_loop,       sizeof(cl_double));  // Wilson loop
+    if (get_wilson_grid) {
+        lattice_wilson_grid     = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_wilson_grid,      plattice_wilson_grid,       sizeof(cl_double));  // Wilson loops W(R,T)
+        lattice_wilson_grid_measurement = GPU0->buffer_init(GPU0->buffer_type_IO, lattice_wilson_grid_offset * ((wilson_Rmax * wilson_Tmax + 1) / 2), NULL, sizeof(cl_double2)); // Wilson loops W(R,T) partial sums
+    }
     if (PL_level > 0)
         lattice_polyakov_loop   = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_polyakov_loop,    plattice_polyakov_loop, sizeof(cl_double2)); // Polyakov loops
+    if (get_polyakov_correlator)
+        lattice_polyakov_field  = GPU0->buffer_init(GPU0->buffer_type_IO, lattice_domain_exact_n1n2n3,   plattice_polyakov_field, sizeof(cl_double2)); // Polyakov loop at every spatial site
+    lattice_smeared[0] = 0;
+    lattice_smeared[1] = 0;
+    if (get_smearing) {
+        int smeared_element = (precision == model_precision_single) ? (int) sizeof(cl_float4) : (int) sizeof(cl_double4);
+        lattice_smeared[0]      = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_table,            NULL,                       smeared_element);   // smeared copy of lattice
+        if (smear_steps > 1)
+        lattice_smeared[1]      = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_table,            NULL,                       smeared_element);   // second smeared copy (ping-pong)
+    }
+    if (get_wilson_flow) {
+        int flow_element = (precision == model_precision_single) ? (int) sizeof(cl_float4) : (int) sizeof(cl_double4);
+        lattice_flow_table      = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_table,            NULL,                       flow_element);      // flowed copy of lattice
+        lattice_flow_force      = GPU0->buffer_init(GPU0->buffer_type_IO, 2 * lattice_table_group,       NULL,                       flow_element);      // RK3 accumulator (2 rows per link for SU(3))
+        lattice_flow            = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_flow,             plattice_flow,              sizeof(cl_double4)); // (t, E, t^2 E, Q)
+    }
+    lattice_prn_states = 0;
+    if ((fused_update) && (PRNG0->PRNG_generator == PRNG_CL::PRNG::PRNG_generator_XOR128)) {
+        // states are not stored in the state file: a continued run reseeds them for its first sweep
+        plattice_prn_states = (cl_uint4*) calloc(lattice_table_exact_row_size_half, sizeof(cl_uint4));
+        PRNG0->XOR128_inline_states(plattice_prn_states, lattice_table_exact_row_size_half, NAV_counter + ITER_counter * NITER);
+        lattice_prn_states      = GPU0->buffer_init(GPU0->buffer_type_IO, lattice_table_exact_row_size_half, plattice_prn_states,   sizeof(cl_uint4));    // XOR128 states of fused update
+    }
+    lattice_check_gid    = 0;
+    lattice_check_values = 0;
+    if (check_samples > 0) {
+        // sites for site-by-site verification are drawn by xorshift from fixed seed, so every run checks the same sites
+        plattice_check_gid    = (cl_uint*)   calloc(check_samples, sizeof(cl_uint));
+        plattice_check_values = (cl_double*) calloc(check_samples * CHECK_SITE_VALUES, sizeof(cl_double));
+        plattice_check_cpu    = (cl_double*) calloc(check_samples * CHECK_SITE_VALUES, sizeof(cl_double));
+        unsigned int prn = CHECK_SITE_SEED;
+        for (unsigned int i = 0; i < check_samples; i++) {
+            prn ^= prn << 13;
+            prn ^= prn >> 17;
+            prn ^= prn << 5;
+            plattice_check_gid[i] = prn % lattice_full_site;
+        }
+        lattice_check_gid       = GPU0->buffer_init(GPU0->buffer_type_IO, check_samples,                     plattice_check_gid,    sizeof(cl_uint));     // sampled sites
+        lattice_check_values    = GPU0->buffer_init(GPU0->buffer_type_IO, check_samples * CHECK_SITE_VALUES, plattice_check_values, sizeof(cl_double));   // GPU per-site values
+    }
     if (PL_level > 2)
     {
         lattice_polyakov_loop_diff_x   = GPU0->buffer_init(GPU0->buffer_type_IO, size_lattice_polyakov_loop,    plattice_polyakov_loop_diff_x, sizeof(cl_double2));
@@ -3991,14 +4894,383 @@ int fc2 = 1;
 }
 #endif
 
+void        model::lattice_polyakov_correlator_init(void){
+    // spatial displacements r are binned by r^2 = sum_i min(r_i, N_i - r_i)^2 (periodic lattice)
+    unsigned int n[3] = {(unsigned int) lattice_domain_size[0], (unsigned int) lattice_domain_size[1], (unsigned int) lattice_domain_size[2]};
+    unsigned int volume = n[0] * n[1] * n[2];
+    unsigned int r2_max = 0;
+    for (int i=0; i<3; i++) r2_max += (n[i] / 2) * (n[i] / 2);
+
+    int* r2_bin = (int*) calloc(r2_max + 1,sizeof(int));
+    polyakov_correlator_bin = (unsigned int*) calloc(volume,sizeof(unsigned int));
+    for (unsigned int site=0; site<volume; site++) {
+        unsigned int r[3] = {site % n[0], (site / n[0]) % n[1], site / (n[0] * n[1])};
+        unsigned int r2 = 0;
+        for (int i=0; i<3; i++) {
+            unsigned int d = (r[i] < n[i] - r[i]) ? r[i] : n[i] - r[i];
+            r2 += d * d;
+        }
+        polyakov_correlator_bin[site] = r2;
+        r2_bin[r2] = 1;
+    }
+    polyakov_correlator_bins = 0;
+    for (unsigned int r2=0; r2<=r2_max; r2++)
+        r2_bin[r2] = (r2_bin[r2]) ? (int) polyakov_correlator_bins++ : -1;
+
+    polyakov_correlator_r2    = (unsigned int*) calloc(polyakov_correlator_bins,sizeof(unsigned int));
+    polyakov_correlator_count = (unsigned int*) calloc(polyakov_correlator_bins,sizeof(unsigned int));
+    for (unsigned int r2=0; r2<=r2_max; r2++)
+        if (r2_bin[r2] >= 0) polyakov_correlator_r2[r2_bin[r2]] = r2;
+    for (unsigned int site=0; site<volume; site++) {
+        polyakov_correlator_bin[site] = (unsigned int) r2_bin[polyakov_correlator_bin[site]];
+        polyakov_correlator_count[polyakov_correlator_bin[site]]++;
+    }
+    free(r2_bin);
+
+    polyakov_fft = new(fft_CL::fft);
+    polyakov_fft->plan(n);
+}
+
+void        model::lattice_polyakov_correlator(unsigned int index){
+    // C(r) = (1/V) sum_x Re P(x) P^+(x+r) is obtained from per-site Polyakov loops by FFT and averaged over bins of equal |r|
+    unsigned int volume = polyakov_fft->volume;
+    double* field = (double*) plattice_polyakov_field;
+    GPU0->buffer_read(lattice_polyakov_field,field,0,volume * sizeof(cl_double2));
+    polyakov_fft->correlate(field);
+
+    for (unsigned int b=0; b<polyakov_correlator_bins; b++)
+        plattice_polyakov_correlator[b * lattice_polyakov_loop_size + index] = 0.0;
+    for (unsigned int site=0; site<volume; site++)
+        plattice_polyakov_correlator[polyakov_correlator_bin[site] * lattice_polyakov_loop_size + index] += field[2*site];
+    for (unsigned int b=0; b<polyakov_correlator_bins; b++)
+        plattice_polyakov_correlator[b * lattice_polyakov_loop_size + index] /= ((double) polyakov_correlator_count[b] * volume);
+}
+
+void        model::lattice_smear(void){
+    // smeared copy for Wilson loops: lattice_table -> lattice_smeared[0] <-> lattice_smeared[1], the Markov chain is not touched
+    if (!get_smearing) return;
+    GPU0->kernel_run(sun_smear_id);
+    for (int k=1; k<smear_steps; k++)
+        GPU0->kernel_run((k % 2) ? sun_smear_forth_id : sun_smear_back_id);
+}
+
+bool        model::lattice_wilson_flow_iteration(unsigned int index){
+    // flow is run every flow_interval working iterations and on the last one (the configuration checked on CPU)
+    return ((get_wilson_flow) && (index > 0) && ((index % flow_interval == 0) || (index == (unsigned int) (ITER - 1))));
+}
+
+void        model::lattice_wilson_flow(unsigned int index){
+    // RK3 Wilson flow of a copy of lattice_table, E(t), t^2 E(t) and Q(t) are stored at lattice_flow[step * lattice_energies_size + index]
+    if (!lattice_wilson_flow_iteration(index)) return;
+    int flow_index = index;
+    GPU0->kernel_run(sun_flow_copy_id);
+    for (int step=0; step<=flow_steps; step++){
+        if (step > 0)
+            for (int stage=0; stage<3; stage++){
+                GPU0->kernel_init_constant_reset(sun_flow_force_id,&stage,argument_flow_force_stage);
+                GPU0->kernel_run(sun_flow_force_id);
+                GPU0->kernel_init_constant_reset(sun_flow_update_id,&stage,argument_flow_update_stage);
+                GPU0->kernel_run(sun_flow_update_id);
+            }
+        GPU0->kernel_run(sun_flow_measurement_id);
+            GPU0->kernel_init_constant_reset(sun_flow_reduce_id,&flow_index,argument_flow_index);
+            GPU0->kernel_init_constant_reset(sun_flow_reduce_id,&step,argument_flow_step);
+        GPU0->kernel_run(sun_flow_reduce_id);
+    }
+}
+
+void        model::lattice_overrelax(void){
+    // NOR over-relaxation sweeps after each heat bath sweep (odd, then even links, X..T as in the heat bath); no PRNs are produced
+    for (int k=0; k<NOR; k++){
+        for (int parity=1; parity>=0; parity--)
+            for (int dir=0; dir<lattice_nd; dir++){
+                GPU0->kernel_init_constant_reset(sun_overrelax_id,&dir,argument_overrelax_dir);
+                GPU0->kernel_init_constant_reset(sun_overrelax_id,&parity,argument_overrelax_parity);
+                GPU0->kernel_run(sun_overrelax_id);
+            }
+        if (!turnoff_gramschmidt)
+            GPU0->kernel_run(sun_GramSchmidt_id);               // Lattice reunitarization
+    }
+}
+
+void        model::lattice_sweep(unsigned int sweep){
+    // one heat bath sweep (odd, then even links, X..T), followed by NOR over-relaxation sweeps
+    if (fused_update) {
+        // one launch per (parity, direction): PRNs are generated inline (XOR128 state per work-item in lattice_prn_states,
+        // or keyed PHILOX stream (seed,sweep,site,dir,hit)) and links are reunitarized on store; directions of one parity can not share a launch without a global barrier,
+        // because the staple of [x,mu] reads the link [x-mu+nu,nu] of the same parity
+        if (!lattice_prn_states)
+            GPU0->kernel_init_constant_reset(sun_update_fused_id,(int*) &sweep,argument_update_fused_sweep);
+        for (int parity=1; parity>=0; parity--)
+            for (int dir=0; dir<lattice_nd; dir++){
+                GPU0->kernel_init_constant_reset(sun_update_fused_id,&dir,argument_update_fused_dir);
+                GPU0->kernel_init_constant_reset(sun_update_fused_id,&parity,argument_update_fused_parity);
+                if (!turnoff_updates) GPU0->kernel_run(sun_update_fused_id);
+            }
+    } else {
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_X_id);     // Update odd X links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Y_id);     // Update odd Y links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Z_id);     // Update odd Z links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_T_id);     // Update odd T links
+
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_X_id);    // Update even X links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Y_id);    // Update even Y links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Z_id);    // Update even Z links
+               if (!turnoff_prns) PRNG0->produce();
+            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_T_id);    // Update even T links
+
+            if (!turnoff_gramschmidt)
+                GPU0->kernel_run(sun_GramSchmidt_id);              // Lattice reunitarization
+    }
+    if (NOR > 0) lattice_overrelax();                           // Over-relaxation sweeps
+    update_sweeps++;
+}
+
+unsigned int model::lattice_sweep_launches(void){
+    unsigned int launches = 0;
+    if (!turnoff_updates) launches += 2 * lattice_nd;
+    if (!fused_update) {
+        if (!turnoff_prns)        launches += 2 * lattice_nd;
+        if (!turnoff_gramschmidt) launches++;
+    }
+    if (NOR > 0) launches += NOR * (2 * lattice_nd + ((turnoff_gramschmidt) ? 0 : 1));
+    return launches;
+}
+
+#ifndef BIGLAT
+void        model::lattice_kernel_costs(void){
+    // nominal global memory traffic (no cache reuse) and flops per work-item for the roofline report
+    double real      = (precision == model_precision_double) ? sizeof(cl_double) : sizeof(cl_float);
+    double link      = lattice_group_elements[lattice_group-1] * real;             // one stored link
+    double prn       = 4 * ((PRNG0->PRNG_precision == PRNG_CL::PRNG::PRNG_precision_double) ? sizeof(cl_double) : sizeof(cl_float));
+    double force     = ((lattice_group == 3) ? 8 : 4) * real;                       // one Wilson flow force entry
+    double mult      = (lattice_group == 3) ? 198.0 : 28.0;                        // one SU(N) matrix product
+    double subgroups = (lattice_group == 3) ? 3.0 : 1.0;                           // SU(2) subgroups per link update
+    double staple_links = 6.0 * (lattice_nd - 1);                                  // links in the staple sum of one link
+    double staple    = 2.0 * (lattice_nd - 1) * (2.0 * mult + 2.0 * lattice_group * lattice_group);
+    double heatbath  = staple + subgroups * (2.0 * mult + 50.0 * NHIT);
+    double overrelax = staple + subgroups * 3.0 * mult;
+    double plaquettes = lattice_nd * (lattice_nd - 1) / 2;
+
+    int update_ids[] = {sun_update_odd_X_id, sun_update_even_X_id, sun_update_odd_Y_id, sun_update_even_Y_id,
+                        sun_update_odd_Z_id, sun_update_even_Z_id, sun_update_odd_T_id, sun_update_even_T_id};
+    for (int i=0; i<8; i++) if (update_ids[i])
+        GPU0->kernel_init_cost(update_ids[i], (1.0 + staple_links) * link + subgroups * NHIT * prn, link, heatbath);
+    if (sun_update_fused_id) {
+        double state = (lattice_prn_states) ? sizeof(cl_uint4) : 0.0;          // XOR128 state per work-item
+        GPU0->kernel_init_cost(sun_update_fused_id, (1.0 + staple_links) * link + state, link + state, heatbath + subgroups * NHIT * 40.0);
+    }
+    if (sun_overrelax_id)
+        GPU0->kernel_init_cost(sun_overrelax_id, (1.0 + staple_links) * link, link, overrelax);
+    GPU0->kernel_init_cost(sun_GramSchmidt_id, lattice_nd * link, lattice_nd * link, lattice_nd * ((lattice_group == 3) ? 66.0 : 11.0));
+    GPU0->kernel_init_cost(sun_measurement_id, lattice_nd * lattice_nd * link, 0.0, plaquettes * (3.0 * mult + lattice_group * 2));
+    if (sun_measurement_plq_id)
+        GPU0->kernel_init_cost(sun_measurement_plq_id, lattice_nd * lattice_nd * link, 0.0, plaquettes * (3.0 * mult + lattice_group * 2));
+    if (sun_smear_id) {
+        double smear_links = (lattice_nd - 1) * (1.0 + 6.0 * (lattice_nd - 2)) + 1.0;
+        double smear_flops = (lattice_nd - 1) * (2.0 * (lattice_nd - 2) * 2.0 * mult + ((smear_type == 2) ? 8.0 : 2.0) * mult);
+        GPU0->kernel_init_cost(sun_smear_id, smear_links * link, lattice_nd * link, smear_flops);
+        if (sun_smear_forth_id) {
+            GPU0->kernel_init_cost(sun_smear_forth_id, smear_links * link, lattice_nd * link, smear_flops);
+            GPU0->kernel_init_cost(sun_smear_back_id,  smear_links * link, lattice_nd * link, smear_flops);
+        }
+    }
+    if (sun_flow_force_id) {
+        GPU0->kernel_init_cost(sun_flow_force_id, lattice_nd * ((1.0 + staple_links) * link + force), lattice_nd * force, lattice_nd * (staple + mult));
+        GPU0->kernel_init_cost(sun_flow_update_id, lattice_nd * (link + force), lattice_nd * link, lattice_nd * (((lattice_group == 3) ? 8.0 : 2.0) * mult));
+        GPU0->kernel_init_cost(sun_flow_measurement_id, (lattice_nd + 3.0 * lattice_nd * (lattice_nd - 1)) * link, 0.0, plaquettes * 4.0 * 3.0 * mult);
+    }
+}
+
+void        model::lattice_verify(void){
+    // CPU-GPU verification of last values, postponed while CPU check was running in background
+    for (int i = 0; i <= DM_max; i++)
+        D_A->lattice_data_verification(&Analysis[i]);
+    if (get_wilson_grid)
+        for (int i = 0; i < wilson_Rmax * wilson_Tmax; i++)
+            D_A->lattice_data_verification(&Analysis_wilson_grid[i]);
+    if (get_polyakov_correlator)
+        for (unsigned int b = 0; b < polyakov_correlator_bins; b++)
+            D_A->lattice_data_verification(&Analysis_PL_corr[b]);
+    if (get_wilson_flow)
+        for (int i = 0; i < 3 * (flow_steps + 1); i++)
+            D_A->lattice_data_verification(&Analysis_flow[i]);
+}
+
+void        model::lattice_check_sites_report(void){
+    // site-by-site verification of sampled sites: GPU values (lattice_check_sites) vs CPU values (lattice_check_cpu);
+    // relative error is taken with respect to max(|CPU value|,1), so vanishing values (Polyakov loop) are compared absolutely
+    if (check_samples == 0) return;
+    const char* check_name[]  = {"plaquettes","staples","Polyakov loops"};
+    const int   check_first[] = {0, 6, 10, CHECK_SITE_VALUES};
+    double delta = (precision == model_precision_single) ? CHECK_SITE_DELTA_SINGLE : CHECK_SITE_DELTA_DOUBLE;
+    bool result = true;
+
+    printf("Site-by-site verification of %u sampled sites:\n",check_samples);
+    for (int c = 0; c < 3; c++) {
+        double max_abs = 0.0;
+        double max_rel = 0.0;
+        unsigned int worst = 0;
+        for (unsigned int i = 0; i < check_samples; i++)
+            for (int k = check_first[c]; k < check_first[c + 1]; k++) {
+                double cpu = plattice_check_cpu[i * CHECK_SITE_VALUES + k];
+                double err = fabs(plattice_check_values[i * CHECK_SITE_VALUES + k] - cpu);
+                double rel = err / ((fabs(cpu) > 1.0) ? fabs(cpu) : 1.0);
+                if (err > max_abs) max_abs = err;
+                if (rel > max_rel) {max_rel = rel; worst = i;}
+            }
+        printf(" %-16s: max abs error = %e, max rel error = %e\n",check_name[c],max_abs,max_rel);
+        if (max_rel > delta) {
+            printf("%s test failed at site %u!\n",check_name[c],plattice_check_gid[worst]);
+            result = false;
+        }
+    }
+    analysis_CL::analysis::results_verification &= result;
+}
+
+void        model::lattice_write_roofline(void){
+    // per-kernel roofline report next to the results file: <path><prefix>roofline-<time>.json and .csv
+    char buffer[250];
+    int j;
+    const char* extensions[] = {"json", "csv"};
+    for (int i=0; i<2; i++){
+        j  = sprintf_s(buffer  ,sizeof(buffer),  "%s",path);
+        j += sprintf_s(buffer+j,sizeof(buffer)-j,"%s",fprefix);
+        j += sprintf_s(buffer+j,sizeof(buffer)-j,"roofline-%.2s-%.3s-%.2s-%.2s-%.2s-%.2s.%s",timeend+22,timeend+4,timeend+8,timeend+11,timeend+14,timeend+17,extensions[i]);
+        if (GPU0->write_roofline(buffer)) printf("[!] roofline report %s could not be written\n",buffer);
+        else printf("Roofline report             : %s\n",buffer);
+    }
+}
+#endif
+
 #ifdef BIGLAT
-#define VER8 //gives incorrect results on AMD GPUs when OpenMP is switched on
+//#define VER8 //gives incorrect results on AMD GPUs when OpenMP is switched on
+#define VER10 //halo exchange: pack/unpack kernels, one non-blocking read and write per face
 //#define VER9 //works on AMD and nVidia GPUs with OpenMP turned on
 //#define VER5 //bulk function
 #ifdef VER5
 void        model::UpdateEdges(int dir)
 {
     
+}
+#endif
+#ifdef VER10
+void        model::UpdateEdges(int dir)
+{
+    // faces x = 1 and x = Nx of every part are packed on its device and read into pinned host memory;
+    // the low face goes to the right halo of the previous part, the high face - to the left halo of the next one.
+    // Parts may live in different contexts, so the transfer is forwarded through the host
+    cl_event* read_event = (cl_event*) calloc(lattice_Nparts, sizeof(cl_event));
+    int* faces_received  = (int*) calloc(lattice_Nparts, sizeof(int));
+
+    for (int k = 0; k < lattice_Nparts; k++){
+        if (SubLat[k].sublattice_halo_pending == dir){  // already started by UpdateRun
+            read_event[k] = SubLat[k].sublattice_halo_event;
+            SubLat[k].sublattice_halo_pending = -1;
+            continue;
+        }
+        SubLat[k].GPU0->kernel_init_constant_reset(SubLat[k].sun_halo_pack_id, &dir, SubLat[k].argument_halo_pack_dir);
+        SubLat[k].GPU0->kernel_run_async(SubLat[k].sun_halo_pack_id);
+        SubLat[k].GPU0->buffer_read_async(SubLat[k].sublattice_halo_send, SubLat[k].psublattice_halo, 0, 2 * SubLat[k].sublattice_halo_face, &read_event[k]);
+    }
+
+    for (int k = 0; k < lattice_Nparts; k++){
+        int k_prev = (k + lattice_Nparts - 1) % lattice_Nparts;
+        int k_next = (k + 1) % lattice_Nparts;
+        size_t face = SubLat[k].sublattice_halo_face;
+
+        SubLat[k].GPU0->buffer_read_wait(&read_event[k], 1);
+        SubLat[k_prev].GPU0->buffer_write_async(SubLat[k_prev].sublattice_halo_recv, SubLat[k].psublattice_halo, face, face, NULL);
+        SubLat[k_next].GPU0->buffer_write_async(SubLat[k_next].sublattice_halo_recv, (char*) SubLat[k].psublattice_halo + face, 0, face, NULL);
+        faces_received[k_prev]++;
+        faces_received[k_next]++;
+
+        for (int j = 0; j < ((k_next == k_prev) ? 1 : 2); j++){
+            int kk = (j == 0) ? k_prev : k_next;
+            if (faces_received[kk] != 2) continue;
+            SubLat[kk].GPU0->kernel_init_constant_reset(SubLat[kk].sun_halo_unpack_id, &dir, SubLat[kk].argument_halo_unpack_dir);
+            SubLat[kk].GPU0->kernel_run_async(SubLat[kk].sun_halo_unpack_id);
+        }
+    }
+
+    for (int k = 0; k < lattice_Nparts; k++)
+        SubLat[k].GPU0->queue_finish();
+
+    free(faces_received);
+    free(read_event);
+
+    if ((halo_check) || ((halo_checked & (1 << dir)) == 0)) {
+        UpdateEdgesCheck(dir);
+        halo_checked |= (1 << dir);
+    }
+}
+
+// compares halo slices of direction dir with the faces of neighbour parts they were received from
+void        model::UpdateEdgesCheck(int dir)
+{
+    int n2n3n4 = lattice_full_size[1] * lattice_full_size[2] * lattice_full_size[3];
+    int el_nn  = (lattice_group_elements[lattice_group - 1] / 4);
+    size_t element = (precision == model_precision_single) ? sizeof(cl_float4) : sizeof(cl_double4);
+    size_t slice   = n2n3n4 * element;
+    char* halo = (char*) malloc(slice);
+    char* face = (char*) malloc(slice);
+    int failed = 0;
+
+    for (int k = 0; k < lattice_Nparts; k++){
+        int k_next = (k + 1) % lattice_Nparts;
+        for (int i = 0; i < el_nn; i++){
+            size_t row_k      = (i * lattice_nd + dir) * SubLat[k].sublattice_table_row_Size * element;
+            size_t row_k_next = (i * lattice_nd + dir) * SubLat[k_next].sublattice_table_row_Size * element;
+
+            // right halo of k (x = Nx + 1) <- x = 1 of k_next
+            SubLat[k].GPU0->buffer_read(SubLat[k].sublattice_table, halo, row_k + (SubLat[k].Nx + 1) * slice, slice);
+            SubLat[k_next].GPU0->buffer_read(SubLat[k_next].sublattice_table, face, row_k_next + slice, slice);
+            if (memcmp(halo, face, slice)) failed++;
+
+            // left halo of k_next (x = 0) <- x = Nx of k
+            SubLat[k_next].GPU0->buffer_read(SubLat[k_next].sublattice_table, halo, row_k_next, slice);
+            SubLat[k].GPU0->buffer_read(SubLat[k].sublattice_table, face, row_k + SubLat[k].Nx * slice, slice);
+            if (memcmp(halo, face, slice)) failed++;
+        }
+    }
+    if (failed) printf("[!] halo exchange check failed for direction %i: %i halo slices differ from neighbour faces\n", dir, failed);
+
+    free(face);
+    free(halo);
+}
+
+// update of links of direction dir of part k: with halo_overlap the boundary slices x = 1 and x = Nx are updated first,
+// their halo exchange is started on the transfer queue and the interior is updated meanwhile (UpdateEdges(dir) completes the exchange)
+void        model::UpdateRun(int k, int kernel_id, int dir)
+{
+    size_t slice = (size_t) SubLat[k].Ny * SubLat[k].Nz * SubLat[k].Nt;
+    if ((!halo_overlap) || (SubLat[k].Nx < 2) || (slice & 1) || (SubLat[k].GPU0->GPU_debug.profiling)){
+        SubLat[k].GPU0->kernel_run(kernel_id);
+        return;
+    }
+    slice /= 2;     // one parity of x slice
+    size_t halo_size = 2 * (lattice_group_elements[lattice_group - 1] / 4) * 2 * slice;
+
+    cl_event pack_event;
+    SubLat[k].GPU0->kernel_run_range(kernel_id, 0, slice, NULL);                               // x = 1
+    SubLat[k].GPU0->kernel_run_range(kernel_id, (SubLat[k].Nx - 1) * slice, slice, NULL);      // x = Nx
+    SubLat[k].GPU0->kernel_init_constant_reset(SubLat[k].sun_halo_pack_id, &dir, SubLat[k].argument_halo_pack_dir);
+    SubLat[k].GPU0->kernel_run_range(SubLat[k].sun_halo_pack_id, 0, halo_size, &pack_event);
+    SubLat[k].GPU0->buffer_read_transfer(SubLat[k].sublattice_halo_send, SubLat[k].psublattice_halo, 0, 2 * SubLat[k].sublattice_halo_face, &pack_event, &SubLat[k].sublattice_halo_event);
+    SubLat[k].GPU0->kernel_run_range(kernel_id, slice, (SubLat[k].Nx - 2) * slice, NULL);     // x = 2 ... Nx - 1
+    SubLat[k].sublattice_halo_pending = dir;
+}
+#else
+void        model::UpdateRun(int k, int kernel_id, int dir)
+{
+    SubLat[k].GPU0->kernel_run(kernel_id);
 }
 #endif
 #ifdef VER8
@@ -4571,7 +5843,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_X_id);     // Update odd X links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_X_id, X);     // Update odd X links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(X);
@@ -4584,7 +5856,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Y_id);     // Update odd Y links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_Y_id, Y);     // Update odd Y links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Y);
@@ -4597,7 +5869,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Z_id);     // Update odd Z links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_Z_id, Z);     // Update odd Z links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Z);
@@ -4610,7 +5882,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_T_id);     // Update odd T links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_T_id, T);     // Update odd T links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(T);
@@ -4623,7 +5895,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_X_id);    // Update even X links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_X_id, X);    // Update even X links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(X);
@@ -4636,7 +5908,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Y_id);    // Update even Y links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_Y_id, Y);    // Update even Y links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Y);
@@ -4649,7 +5921,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Z_id);    // Update even Z links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_Z_id, Z);    // Update even Z links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Z);
@@ -4662,7 +5934,7 @@ void        model::lattice_simulate(void)
                 for (int k = 0; k < lattice_Nparts; k++){
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                    if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_T_id);    // Update even T links
+                    if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_T_id, T);    // Update even T links
                 }
                 if (!turnoff_updates)
                     UpdateEdges(T);
@@ -4916,7 +6188,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_X_id);     // Update odd X links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_X_id, X);     // Update odd X links
             }
             if (!turnoff_updates)
                 UpdateEdges(X);
@@ -4929,7 +6201,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Y_id);     // Update odd Y links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_Y_id, Y);     // Update odd Y links
             }
             if (!turnoff_updates)
                 UpdateEdges(Y);
@@ -4942,7 +6214,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Z_id);     // Update odd Z links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_Z_id, Z);     // Update odd Z links
             }
             if (!turnoff_updates)
                 UpdateEdges(Z);
@@ -4955,7 +6227,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_T_id);     // Update odd T links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_odd_T_id, T);     // Update odd T links
             }
             if (!turnoff_updates)
                 UpdateEdges(T);
@@ -4968,7 +6240,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_X_id);    // Update even X links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_X_id, X);    // Update even X links
             }
             if (!turnoff_updates)
                 UpdateEdges(X);
@@ -4981,7 +6253,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Y_id);    // Update even Y links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_Y_id, Y);    // Update even Y links
             }
             if (!turnoff_updates)
                 UpdateEdges(Y);
@@ -4994,7 +6266,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Z_id);    // Update even Z links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_Z_id, Z);    // Update even Z links
             }
             if (!turnoff_updates)
                 UpdateEdges(Z);
@@ -5007,7 +6279,7 @@ void        model::lattice_simulate(void)
             for (int k = 0; k < lattice_Nparts; k++){
 #endif
                 if (!turnoff_prns) SubLat[k].PRNG0->produce();
-                if (!turnoff_updates) SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_T_id);    // Update even T links
+                if (!turnoff_updates) UpdateRun(k, SubLat[k].sun_update_even_T_id, T);    // Update even T links
             }
             if (!turnoff_updates)
                 UpdateEdges(T);
@@ -5033,7 +6305,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_X_id);
+                        UpdateRun(k, SubLat[k].sun_update_odd_X_id, X);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(X);
@@ -5047,7 +6319,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Y_id);
+                        UpdateRun(k, SubLat[k].sun_update_odd_Y_id, Y);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Y);
@@ -5061,7 +6333,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_Z_id);
+                        UpdateRun(k, SubLat[k].sun_update_odd_Z_id, Z);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Z);
@@ -5075,7 +6347,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_odd_T_id);
+                        UpdateRun(k, SubLat[k].sun_update_odd_T_id, T);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(T);
@@ -5089,7 +6361,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_X_id);
+                        UpdateRun(k, SubLat[k].sun_update_even_X_id, X);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(X);
@@ -5103,7 +6375,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Y_id);
+                        UpdateRun(k, SubLat[k].sun_update_even_Y_id, Y);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Y);
@@ -5117,7 +6389,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_Z_id);
+                        UpdateRun(k, SubLat[k].sun_update_even_Z_id, Z);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(Z);
@@ -5131,7 +6403,7 @@ void        model::lattice_simulate(void)
 #endif
                     if (!turnoff_prns) SubLat[k].PRNG0->produce();
                     if (!turnoff_updates) 
-                        SubLat[k].GPU0->kernel_run(SubLat[k].sun_update_even_T_id);
+                        UpdateRun(k, SubLat[k].sun_update_even_T_id, T);
                 }
                 if (!turnoff_updates)
                     UpdateEdges(T);
@@ -5233,6 +6505,7 @@ void        model::lattice_simulate(void)
     GPU0->start_timer_CPU(TIMER_FOR_SIMULATIONS); // start GPU execution timer
     GPU0->start_timer_CPU(TIMER_FOR_SAVE);        // start timer for lattice_state save
 
+    update_sweeps = 0;
     if (ints==model_start_hot) PRNG0->produce();
 
     int NAV_start  = 0;
@@ -5263,6 +6536,7 @@ void        model::lattice_simulate(void)
             GPU0->print_stage("measurement reduce done (plaquettes)");
         }
     
+        lattice_smear();                                       // smeared copy of lattice for Wilson loops
         if (get_wilson_loop) {
             GPU0->kernel_run(sun_measurement_wilson_id);       // Lattice Wilson loop measurement
             GPU0->print_stage("Wilson loop measurement done");
@@ -5272,6 +6546,15 @@ void        model::lattice_simulate(void)
             GPU0->print_stage("Wilson loop measurement reduce done");
         }
 
+        if (get_wilson_grid) {
+            GPU0->kernel_run(sun_measurement_wilson_grid_id);  // Lattice Wilson loops W(R,T) measurement
+            GPU0->print_stage("Wilson loops grid measurement done");
+                wilson_index = ITER_counter;
+                GPU0->kernel_init_constant_reset(sun_wilson_grid_reduce_id,&wilson_index,argument_wilson_grid_index);
+            GPU0->kernel_run(sun_wilson_grid_reduce_id);       // Lattice Wilson loops W(R,T) measurement reduction
+            GPU0->print_stage("Wilson loops grid measurement reduce done");
+        }
+
         if (get_actions_avr) {
             GPU0->kernel_run(sun_measurement_id);                  // Lattice measurement
             GPU0->print_stage("measurement done");
@@ -5313,6 +6596,13 @@ void        model::lattice_simulate(void)
             GPU0->kernel_run(sun_polyakov_reduce_id);              // Lattice Polyakov loop measurement reduction
             GPU0->print_stage("Polyakov loop reduce done");
         }
+
+        if (get_polyakov_correlator) {
+            GPU0->kernel_run(sun_polyakov_field_id);               // Lattice Polyakov loop field
+            GPU0->print_stage("Polyakov loop field done");
+            lattice_polyakov_correlator(ITER_counter);             // Polyakov loop correlator (host FFT)
+            GPU0->print_stage("Polyakov loop correlator done");
+        }
         
         if (PL_level > 2) {
             GPU0->kernel_run(sun_polyakov_diff_x_id);                     // Lattice Polyakov loop measurement
@@ -5347,7 +6637,12 @@ void        model::lattice_simulate(void)
     ITER_start = ITER_counter;
 
     if (INIT==0) {
-        while (PRNG_counter>PRNG0->PRNG_counter) PRNG0->produce();    // adjust PRNG
+        if ((PRNG_state) && (PRNG_state_size == PRNG0->state_size()))
+            PRNG0->state_load(PRNG_state,PRNG_counter);                // restore PRNG from state file
+        else if (PRNG0->counter_based())
+            PRNG0->set_counter(PRNG_counter);                           // adjust PRNG without replay
+        if (PRNG_state) {free(PRNG_state); PRNG_state = NULL;}
+        while (PRNG_counter>PRNG0->PRNG_counter) PRNG0->produce();    // adjust PRNG (old state files)
         if (GPU0->GPU_debug.brief_report) printf("NAV_start=%u, ITER_start=%u\n",NAV_start,ITER_start);
 
         wilson_index = ITER_start + 1;
@@ -5355,65 +6650,29 @@ void        model::lattice_simulate(void)
 
     // perform thermalization
     for (int i=NAV_start; i<NAV; i++){
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_X_id);     // Update odd X links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Y_id);     // Update odd Y links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Z_id);     // Update odd Z links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_T_id);     // Update odd T links
-
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_even_X_id);    // Update even X links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Y_id);    // Update even Y links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Z_id);    // Update even Z links
-           if (!turnoff_prns) PRNG0->produce();
-        if (!turnoff_updates) GPU0->kernel_run(sun_update_even_T_id);    // Update even T links
-
-            if (!turnoff_gramschmidt)
-                GPU0->kernel_run(sun_GramSchmidt_id);          // Lattice reunitarization
+        lattice_sweep(i);                                       // Heat bath (and over-relaxation) sweep
 
         if (i % 10 == 0) printf("\rGPU thermalization [%i]",i);
         NAV_counter++;
 
         // write lattice state every [write_lattice_state_every_secs] seconds
         if ((!turnoff_config_save)&&(GPU0->timer_in_seconds_CPU(TIMER_FOR_SAVE)>write_lattice_state_every_secs)) {
-            lattice_save_state();
-            printf("\ncurrent configuration saved\n");
-            GPU0->start_timer_CPU(TIMER_FOR_SAVE);      // restart timer for lattice_state save
+            if (lattice_save_state_async()) {
+                printf("\ncurrent configuration saved\n");
+                GPU0->start_timer_CPU(TIMER_FOR_SAVE);  // restart timer for lattice_state save
+            }
         } 
     }
 
     // perform working cycles
     for (int i=ITER_start; i<ITER; i++){ // zero measurement - on initial configuration!
         for (int j=0; j<NITER; j++){
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_X_id);     // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Y_id);     // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_Z_id);     // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_odd_T_id);     // Lattice measurement staples
-
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_X_id);    // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Y_id);    // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_Z_id);    // Lattice measurement staples
-               if (!turnoff_prns) PRNG0->produce();
-            if (!turnoff_updates) GPU0->kernel_run(sun_update_even_T_id);    // Lattice measurement staples
-            
-            if (!turnoff_gramschmidt)
-                GPU0->kernel_run(sun_GramSchmidt_id);           // Lattice reunitarization
+            lattice_sweep(NAV + i * NITER + j);                 // Heat bath (and over-relaxation) sweep
 
             if (i % 10 == 0) printf("\rGPU working iteration [%u]",i);
         }
 
+        lattice_smear();                                        // smeared copy of lattice for Wilson loops
         if (get_wilson_loop) {
             GPU0->kernel_run(sun_measurement_wilson_id);        // Lattice Wilson loop measurement
                 wilson_index = ITER_counter;
@@ -5421,6 +6680,13 @@ void        model::lattice_simulate(void)
             GPU0->kernel_run(sun_wilson_loop_reduce_id);        // Lattice Wilson loop measurement reduction
         }
 
+        if (get_wilson_grid) {
+            GPU0->kernel_run(sun_measurement_wilson_grid_id);   // Lattice Wilson loops W(R,T) measurement
+                wilson_index = ITER_counter;
+                GPU0->kernel_init_constant_reset(sun_wilson_grid_reduce_id,&wilson_index,argument_wilson_grid_index);
+            GPU0->kernel_run(sun_wilson_grid_reduce_id);        // Lattice Wilson loops W(R,T) measurement reduction
+        }
+
         // measurements
         if (get_actions_avr) {
             GPU0->kernel_run(sun_measurement_id);                 // Lattice measurement
@@ -5454,6 +6720,11 @@ GPU0->kernel_run(sun_clear_measurement_id);
                 GPU0->kernel_init_constant_reset(sun_polyakov_reduce_id,&polyakov_index,argument_polyakov_index);
             GPU0->kernel_run(sun_polyakov_reduce_id);             // Lattice Polyakov loop measurement reduction
         }
+        if (get_polyakov_correlator) {
+            GPU0->kernel_run(sun_polyakov_field_id);              // Lattice Polyakov loop field
+            lattice_polyakov_correlator(ITER_counter);            // Polyakov loop correlator (host FFT)
+        }
+        lattice_wilson_flow(ITER_counter);                        // Wilson flow of a copy of lattice (every FLOW iterations)
         
 GPU0->kernel_run(sun_clear_measurement_id);
         if (PL_level > 2) {
@@ -5486,14 +6757,23 @@ GPU0->kernel_run(sun_clear_measurement_id);
 
         // write lattice state every [write_lattice_state_every_secs] seconds
         if ((!turnoff_config_save)&&(GPU0->timer_in_seconds_CPU(TIMER_FOR_SAVE)>write_lattice_state_every_secs)) {
-            lattice_save_state();
-            printf("\ncurrent configuration saved\n");
-            GPU0->start_timer_CPU(TIMER_FOR_SAVE);      // restart timer for lattice_state save
+            if (lattice_save_state_async()) {
+                printf("\ncurrent configuration saved\n");
+                GPU0->start_timer_CPU(TIMER_FOR_SAVE);  // restart timer for lattice_state save
+            }
         } 
     }
     printf("\rGPU simulations are done (%f seconds)\n",GPU0->get_timer_CPU(1));
+    if (update_sweeps > 0)
+        printf("Update sweeps               : %u (%u kernel launches per sweep, %s; %f sweeps per second incl. measurements)\n",
+            update_sweeps,lattice_sweep_launches(),(fused_update) ? "fused" : "split",update_sweeps / GPU0->get_timer_CPU(1));
     time(&ltimeend);
     timeend   = GPU0->get_current_datetime();
+    if (GPU0->GPU_debug.profiling) lattice_write_roofline();
+    if (check_samples > 0) {
+        GPU0->kernel_run(sun_check_sites_id);     // per-site values of last configuration for site-by-site verification
+        GPU0->buffer_read(lattice_check_values,plattice_check_values,0,check_samples * CHECK_SITE_VALUES * sizeof(cl_double));
+    }
 
     if (!turnoff_config_save) {
         lattice_save_state();
@@ -5501,7 +6781,7 @@ GPU0->kernel_run(sun_clear_measurement_id);
     } else {
         lattice_pointer_last = GPU0->buffer_map(lattice_table);
     }
-    prng_pointer = GPU0->buffer_map_float4(PRNG0->PRNG_randoms_id);
+    if (PRNG0->PRNG_randoms_id) prng_pointer = GPU0->buffer_map_float4(PRNG0->PRNG_randoms_id);
 }
 #endif
 #endif//CPU_RUN
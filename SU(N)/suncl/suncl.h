@@ -39,6 +39,9 @@
 
 #ifndef CPU_RUN
 #include "../clinterface/clinterface.h"
+#include "../checkpoint/checkpoint.h"
+#include "../fft/fft.h"
+#include <vector>
 #else
 #include "../suncpp/IO/io.h"
 #endif
@@ -94,17 +97,28 @@ class model {
               unsigned int     Ndevices;
               unsigned int*    devParts;
               unsigned int*    devLeftParts;
+                      bool     halo_overlap;          // update boundary slices first and overlap their halo exchange with interior update
+                      bool     halo_check;            // verify every halo exchange (otherwise the first exchange of each direction only)
+              unsigned int     halo_checked;          // bit mask of directions whose halo exchange has been verified
 
                 SubLattice*    SubLat;
 
                       void     Fmunu_defaults(void);
                       void     UpdateEdges(void);
                       void     UpdateEdges(int dir);
+                      void     UpdateRun(int k, int kernel_id, int dir);
+                      void     UpdateEdgesCheck(int dir);
 #endif
 
                        int     lattice_group;         // Lattice group
 #ifdef CPU_RUN
                        int     lattice_sites;
+                       int     CPU_threads;           // number of threads for CPU run (0 - all available)
+                      bool     CPU_neighbours_table;  // precompute neighbour table for CPU run (false - compute neighbours on the fly)
+                       int     CPU_link_layout;       // link layout for CPU run (0 - array of structs, 1 - structure of arrays for SIMD kernels)
+                      bool     CPU_link_compress;     // store links without the last row for CPU run (it is reconstructed on load, as on GPU)
+                       int     CPU_simd_benchmark;    // number of matrix products for SU(3) SIMD micro-benchmark before CPU run (0 - skip)
+                       int     CPU_prng_benchmark;    // number of PRNs per generator for PRNG throughput benchmark before CPU run (0 - skip)
 #endif
                        
         unsigned int     lattice_full_site;     // Total number of lattice sites
@@ -128,6 +142,10 @@ class model {
                       bool     get_actions_avr;    // calculate mean actions
                       bool     get_plaquettes_avr; // calculate mean plaquettes
                       bool     get_wilson_loop;    // calculate wilson loop
+                      bool     get_wilson_grid;    // calculate wilson loops W(R,T) for all R<=wilson_Rmax, T<=wilson_Tmax
+                      bool     get_polyakov_correlator; // calculate Polyakov loop correlator <P(0)P^+(r)> (host FFT)
+                      bool     get_smearing;       // measure Wilson loops on smeared copy of lattice (spatial links only)
+                      bool     get_wilson_flow;    // measure E(t), t^2 E(t) and Q(t) along Wilson flow of a copy of lattice
                       bool     get_Fmunu;          // calculate Fmunu tensor for H field
                       bool     get_F0mu;           // calculate Fmunu tensor for E field
 
@@ -157,22 +175,49 @@ class model {
               unsigned int*    lattice_data;       // Lattice data
                        int     NHIT;               // parameter for multihit
                        int     NHITPar;               // parameter for multihit Parisi
+                       int     NOR;                // number of over-relaxation sweeps per heat bath sweep
+                      bool     fused_update;       // heat bath with inline PRNs and reunitarization on store (PRNG = PHILOX)
                     double     BETA;               // beta
                        int     NAV;                // number of thermalization cycles
                        int     wilson_R;           // R size for Wilson loop
                        int     wilson_T;           // T size for Wilson loop
+                       int     wilson_Rmax;        // maximal R size for Wilson loops grid (0 - grid is not measured)
+                       int     wilson_Tmax;        // maximal T size for Wilson loops grid (0 - grid is not measured)
            model_precision     precision;          // precision to be used
               unsigned int     PL_level;           // level for calculation Polyakov loops (0 - do not calculate PL, 1 - PL only, 2 - PL, PL^2, PL^4)
+                       int     PL_correlator;      // calculate Polyakov loop correlator binned by |r| (0 - correlator is not measured)
+                       int     smear_type;         // smearing of spatial links before Wilson loops (0 - off, 1 - APE, 2 - stout)
+                       int     smear_steps;        // number of smearing steps
+                    double     smear_alpha;        // APE weight alpha or stout parameter rho
+                       int     flow_interval;      // Wilson flow is run every flow_interval working iterations (0 - off)
+                       int     flow_steps;         // number of Wilson flow steps
+                    double     flow_eps;           // Wilson flow time step epsilon
                     double     PHI;                // phi angle (lambda_3)
                     double     OMEGA;              // omega angle (lambda_8)
 #ifndef CPU_RUN
                     double     write_lattice_state_every_secs;  // write lattice state every ... seconds
+                       int     checkpoint_format;  // format of state file (1 - sequential .qcg, 2 - chunked .qcg v2)
+                      bool     checkpoint_async;   // write .qcg v2 in background from pinned snapshot of buffers
+ checkpoint_CL::checkpoint_writer* checkpoint_queue;   // background writer (one checkpoint in flight)
+              unsigned char*   checkpoint_staging;         // pinned host memory for buffers snapshot
+                    size_t     checkpoint_staging_size;    // size of checkpoint_staging (in bytes)
+                    cl_mem     checkpoint_staging_buffer;  // OpenCL buffer behind checkpoint_staging
+                      bool     checkpoint_journal; // measurement history is appended to journal (.qcj) instead of .qcg v2 sections
+                       int     CPU_check_threads;  // number of threads for CPU verification of GPU results (0 - all available)
+                      bool     CPU_check_async;    // CPU verification runs in background during analysis of GPU results
+              unsigned int     check_samples;      // number of random sites for site-by-site CPU verification (0 - full verification)
+                      char*    journal_name;       // journal file name (in path)
+              unsigned int     journal_rows;       // number of working iterations written to journal
+              unsigned int     journal_rows_queued;// number of working iterations queued to journal by background writer
 
               // runtime counters
               unsigned int     PRNG_counter;       // counter runs of subroutine PRNG_produce (for load_state purposes)
               unsigned int     NAV_counter;        // number of performed thermalization cycles
               unsigned int     ITER_counter;       // number of performed working cycles
+              unsigned int     update_sweeps;      // number of heat bath sweeps performed in this run
               unsigned int     LOAD_state;         // current load state
+              unsigned int*    PRNG_state;         // PRNG state loaded from state file (NULL - replay PRNG on resume)
+              unsigned int     PRNG_state_size;    // size of loaded PRNG state (in uints)
 
               // additional recalculating data
               unsigned int     lattice_table_size;      // Length of lattice table
@@ -188,8 +233,11 @@ class model {
               unsigned int     size_lattice_measurement;    // size of buffer lattice_measurement
               unsigned int     size_lattice_energies;       // size of buffer lattice_energies
               unsigned int     size_lattice_wilson_loop;    // size of buffer lattice_wilson_loop
+              unsigned int     size_lattice_wilson_grid;    // size of buffer lattice_wilson_grid
               unsigned int     size_lattice_energies_plq;   // size of buffer lattice_energies_plq
               unsigned int     size_lattice_polyakov_loop;  // size of buffer lattice_polyakov_loop
+              unsigned int     size_lattice_polyakov_correlator; // size of host array plattice_polyakov_correlator
+              unsigned int     size_lattice_flow;           // size of buffer lattice_flow
               unsigned int     size_lattice_boundary;       // size of buffer lattice_boundary
               unsigned int     size_lattice_parameters;     // size of buffer lattice_parameters
 
@@ -207,6 +255,12 @@ class model {
               unsigned int     lattice_measurement_size;
               unsigned int     lattice_measurement_offset;
               unsigned int     lattice_measurement_size_F;
+              unsigned int     lattice_wilson_grid_offset;  // offset between (R,T) pairs in lattice_wilson_grid_measurement
+              unsigned int     polyakov_correlator_bins;    // number of distinct |r| on periodic spatial lattice
+              unsigned int*    polyakov_correlator_bin;     // bin of every spatial displacement r, index x + N1 * (y + N2 * z)
+              unsigned int*    polyakov_correlator_r2;      // r^2 of every bin (ascending)
+              unsigned int*    polyakov_correlator_count;   // number of displacements in every bin
+        fft_CL::fft*           polyakov_fft;                // host FFT for Polyakov loop correlator
                  cl_float4*    prng_pointer;
               unsigned int     prngstep;            // step between two threads in prng table
 
@@ -220,6 +274,7 @@ class model {
 
 #define MODEL_parameter_size    6   // number of parameters for parameters buffer
 #define MODEL_energies_size     7   // number of measurements in energy buffer
+#define CHECK_SITE_VALUES      12   // number of values per sampled site for site-by-site verification (lattice_check_sites, passed to kernel as -D)
 
 #define DM_Wilson_loop       0 // index for data measurement for Wilson_loop
 #define DM_S_total           1 // index for data measurement for S_total
@@ -262,6 +317,9 @@ analysis_CL::analysis::data_analysis*   Analysis_PL_Y;         // array for diff
 analysis_CL::analysis::data_analysis*   Analysis_PL_Y_im;      // array for differentiated Polyakov loop measurements (Im)
 analysis_CL::analysis::data_analysis*   Analysis_PL_Z;         // array for differentiated Polyakov loop measurements (Re)
 analysis_CL::analysis::data_analysis*   Analysis_PL_Z_im;      // array for differentiated Polyakov loop measurements (Im)
+analysis_CL::analysis::data_analysis*   Analysis_wilson_grid;  // array for Wilson loops W(R,T) measurements, index (R-1)*wilson_Tmax+(T-1)
+analysis_CL::analysis::data_analysis*   Analysis_PL_corr;      // array for Polyakov loop correlator measurements (one per |r| bin)
+analysis_CL::analysis::data_analysis*   Analysis_flow;         // array for Wilson flow measurements, index 3*step+k (k: 0 - E, 1 - t^2 E, 2 - Q)
 
 analysis_CL::analysis::data_analysis*   Analysis_S_X_s;         // array for differentiated S measurements (spat)
 analysis_CL::analysis::data_analysis*   Analysis_S_X_t;      // array for differentiated S measurements (temp)
@@ -304,6 +362,8 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
              int    sun_update_even_Y_id;
              int    sun_update_even_Z_id;
              int    sun_update_even_T_id;
+             int    sun_overrelax_id;              // over-relaxation of one (direction, parity) block
+             int    sun_update_fused_id;           // heat bath of one (direction, parity) block with inline PRNs
              int    sun_clear_measurement_id;
              int    sun_get_boundary_low_id;
              int    sun_put_boundary_low_id;
@@ -319,17 +379,39 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
              int    sun_measurement_plq_reduce_id;
              int    sun_measurement_wilson_id;
              int    sun_wilson_loop_reduce_id;
+             int    sun_measurement_wilson_grid_id;
+             int    sun_wilson_grid_reduce_id;
              int    sun_polyakov_id;
              int    sun_polyakov_diff_x_id;
              int    sun_polyakov_diff_y_id;
              int    sun_polyakov_diff_z_id;
              int    sun_polyakov_reduce_id;
+             int    sun_polyakov_field_id;
+             int    sun_smear_id;                  // smearing step lattice_table -> lattice_smeared[0]
+             int    sun_smear_forth_id;            // smearing step lattice_smeared[0] -> lattice_smeared[1]
+             int    sun_smear_back_id;             // smearing step lattice_smeared[1] -> lattice_smeared[0]
+             int    sun_flow_copy_id;              // Wilson flow: lattice_table -> lattice_flow_table
+             int    sun_flow_force_id;             // Wilson flow: RK3 stage force
+             int    sun_flow_update_id;            // Wilson flow: RK3 stage update
+             int    sun_flow_measurement_id;       // Wilson flow: clover E and Q
+             int    sun_flow_reduce_id;
              int    sun_polyakov_diff_x_reduce_id;
              int    sun_polyakov_diff_y_reduce_id;
              int    sun_polyakov_diff_z_reduce_id;
              int    sun_update_indices_id;
+             int    sun_check_sites_id;            // per-site values of sampled sites for CPU verification
 
              int    argument_wilson_index;
+             int    argument_wilson_grid_index;
+             int    argument_flow_force_stage;
+             int    argument_flow_update_stage;
+             int    argument_flow_index;
+             int    argument_flow_step;
+             int    argument_overrelax_dir;
+             int    argument_overrelax_parity;
+             int    argument_update_fused_dir;
+             int    argument_update_fused_parity;
+             int    argument_update_fused_sweep;
              int    argument_plq_index;
              int    argument_polyakov_index;
              int    argument_polyakov_diff_x_index;
@@ -355,7 +437,17 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
     unsigned int    lattice_energies;
     unsigned int    lattice_energies_plq;
     unsigned int    lattice_wilson_loop;
+    unsigned int    lattice_wilson_grid;
+    unsigned int    lattice_wilson_grid_measurement;
     unsigned int    lattice_polyakov_loop;
+    unsigned int    lattice_polyakov_field;
+    unsigned int    lattice_smeared[2];            // ping-pong copies of lattice_table for smearing
+    unsigned int    lattice_flow_table;            // copy of lattice_table evolved by Wilson flow
+    unsigned int    lattice_flow_force;            // RK3 accumulator X (traceless antihermitian, per link)
+    unsigned int    lattice_flow;                  // (t, E, t^2 E, Q) for every flow step and working iteration
+    unsigned int    lattice_prn_states;            // XOR128 state of every work-item of the fused update
+    unsigned int    lattice_check_gid;             // sampled sites for site-by-site CPU verification
+    unsigned int    lattice_check_values;          // GPU per-site values of sampled sites (CHECK_SITE_VALUES per site)
     unsigned int    lattice_polyakov_loop_diff_x;
     unsigned int    lattice_polyakov_loop_diff_y;
     unsigned int    lattice_polyakov_loop_diff_z;
@@ -372,7 +464,15 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
     cl_double2*     plattice_energies;
     cl_double2*     plattice_energies_plq;
     cl_double*      plattice_wilson_loop;
+    cl_double*      plattice_wilson_grid;
     cl_double2*     plattice_polyakov_loop;
+    cl_double2*     plattice_polyakov_field;
+    cl_double*      plattice_polyakov_correlator;
+    cl_double4*     plattice_flow;
+    cl_uint4*       plattice_prn_states;
+    cl_uint*        plattice_check_gid;
+    cl_double*      plattice_check_values;
+    cl_double*      plattice_check_cpu;            // CPU per-site values of sampled sites (filled by lattice_check_cpu)
     cl_double2*     plattice_polyakov_loop_diff_x;
     cl_double2*     plattice_polyakov_loop_diff_y;
     cl_double2*     plattice_polyakov_loop_diff_z;
@@ -389,14 +489,40 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
             void    lattice_write_results(void);
             void    lattice_get_init_file(char* file);
             void    lattice_save_state(void);
+            bool    lattice_save_state_async(void);
+            void    lattice_save_state_wait(bool release_staging);
+#ifndef CPU_RUN
+            int     lattice_journal_index(checkpoint_CL::checkpoint_journal::qcj_buffer* index,int* buffer_id,void** host_data);
+            void    lattice_journal_read(const int* buffer_id,const checkpoint_CL::checkpoint_journal::qcj_buffer* index,int buffers,unsigned int row_from,unsigned int row_to,unsigned char* rows,std::vector<cl_event>* events);
+            bool    lattice_journal_append(void);
+            void    lattice_journal_file(char* buffer,int size);
+#endif
             void    lattice_load_state(void);
 
             char*   lattice_make_header(void);
             char*   lattice_make_header2(void);
     unsigned int*   lattice_make_bin_header(void);
             bool    lattice_load_bin_header(unsigned int* head);
+            void    lattice_make_prng_section(unsigned int* prng_section);
+            bool    lattice_check_prng_section(unsigned int* prng_section);
              int    model_make_header(char* header,int header_size);
             void    lattice_make_programs(void);
+#ifndef CPU_RUN
+            void    lattice_polyakov_correlator_init(void);
+            void    lattice_polyakov_correlator(unsigned int index);
+            void    lattice_smear(void);
+            bool    lattice_wilson_flow_iteration(unsigned int index);
+            void    lattice_wilson_flow(unsigned int index);
+            void    lattice_overrelax(void);
+            void    lattice_sweep(unsigned int sweep);
+    unsigned int    lattice_sweep_launches(void);
+#ifndef BIGLAT
+            void    lattice_kernel_costs(void);
+            void    lattice_write_roofline(void);
+            void    lattice_verify(void);
+            void    lattice_check_sites_report(void);
+#endif
+#endif
 #ifdef BIGLAT
             void    lattice_set_devParts(void);
             void    lattice_mp_Sim(void);
@@ -448,6 +574,7 @@ analysis_CL::analysis::data_analysis*   Analysis_S_Z;
 
            static char path_suncl[FILENAME_MAX];            // Relative path to SUNCL kernels
            static char path_kernel[FILENAME_MAX];           // Relative path to KERNELS kernels
+           static char path_random[FILENAME_MAX];           // Relative path to PRNG kernels
 
            int lattice_full_link;
            int lattice_domain_link;
@@ -585,6 +712,13 @@ public:
     unsigned int    sublattice_action_diff_x;
     unsigned int    sublattice_action_diff_y;
     unsigned int    sublattice_action_diff_z;
+    unsigned int    sublattice_halo_send;          // faces x = 1 and x = Nx packed for halo exchange
+    unsigned int    sublattice_halo_recv;          // halo slices x = 0 and x = Nx + 1 received from neighbour parts
+          cl_mem    sublattice_halo_pinned;        // OpenCL buffer behind psublattice_halo
+            void*   psublattice_halo;              // pinned host staging for sublattice_halo_send
+          size_t    sublattice_halo_face;          // size of one face (in bytes)
+        cl_event    sublattice_halo_event;         // read of packed faces started by model::UpdateRun
+             int    sublattice_halo_pending;       // direction of halo exchange started by model::UpdateRun (-1 - none)
 
           size_t    local_size_intel;
              
@@ -603,6 +737,10 @@ public:
              int    sun_update_even_Y_id;
              int    sun_update_even_Z_id;
              int    sun_update_even_T_id;
+             int    sun_halo_pack_id;
+             int    sun_halo_unpack_id;
+             int    argument_halo_pack_dir;
+             int    argument_halo_unpack_dir;
 
              int    sun_tables_id;
              int    sun_measurement_plq_id;
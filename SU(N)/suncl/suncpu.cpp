@@ -55,3 +55,29 @@ void LatticeCheckCPU(model_CL::model* lat)
   }
   
 }
+
+#ifndef BIGLAT
+static std::thread  check_worker;   // background CPU verification (see LatticeCheckCPUStart)
+
+void LatticeCheckCPUStart(model_CL::model* lat)
+{
+  // CPU check only reads host copy of last configuration and writes CPU_last_* fields,
+  // so it may run while GPU results are analyzed; verification is postponed until LatticeCheckCPUWait
+  if (!lat->CPU_check_async) {
+    LatticeCheckCPU(lat);
+    return;
+  }
+  analysis_CL::analysis::verification_deferred = true;
+  check_worker = std::thread(LatticeCheckCPU, lat);
+}
+
+void LatticeCheckCPUWait(model_CL::model* lat)
+{
+  if (check_worker.joinable()) {
+    check_worker.join();
+    analysis_CL::analysis::verification_deferred = false;
+    lat->lattice_verify();
+  }
+  lat->lattice_check_sites_report();
+}
+#endif
@@ -50,5 +50,9 @@
  };
  
  void LatticeCheckCPU(model_CL::model* lat);
+#ifndef BIGLAT
+ void LatticeCheckCPUStart(model_CL::model* lat);
+ void LatticeCheckCPUWait(model_CL::model* lat);
+#endif
  
 #endif
@@ -0,0 +1,491 @@
+/******************************************************************************
+ * @file     wilson_flow.cl
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Wilson (gradient) flow of a copy of the gauge field, energy density and topological charge
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2017 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+#ifndef WILSON_FLOW_CL
+#define WILSON_FLOW_CL
+
+#include "complex.h"
+#include "model.cl"
+#include "misc.cl"
+#include "sun_common.cl"
+#if SUN == 2
+#include "su2cl.cl"
+#include "su2_matrix_memory.cl"
+#include "su2_update_cl.cl"
+#endif
+#if SUN == 3
+#include "su3cl.cl"
+#include "su3_matrix_memory.cl"
+#include "su3_update_cl.cl"
+#endif
+
+// FLOW_EPS - flow time step epsilon
+// integration: 3rd order Runge-Kutta scheme of M.Luscher (JHEP 1008:071, 2010) in low-storage form
+//    X <- a[stage] * X + eps * Z(W),  W <- exp(b[stage] * X) * W
+// Z(W) = -P_ah(W * S) is the force of the Wilson action (S - sum of 6 staples)
+#ifndef FLOW_EPS
+#define FLOW_EPS 0.01
+#endif
+#define FLOW_EXP_ORDER 6
+
+                    HGPU_INLINE_PREFIX hgpu_float
+lattice_flow_a(const uint stage)
+{
+    return (stage == 0) ? (hgpu_float) 0.0 : ((stage == 1) ? (hgpu_float) (-17.0 / 32.0) : (hgpu_float) (-32.0 / 27.0));
+}
+
+                    HGPU_INLINE_PREFIX hgpu_float
+lattice_flow_b(const uint stage)
+{
+    return (stage == 0) ? (hgpu_float) (1.0 / 4.0) : ((stage == 1) ? (hgpu_float) (8.0 / 9.0) : (hgpu_float) (3.0 / 4.0));
+}
+
+#if SUN == 2
+                    HGPU_INLINE_PREFIX su_2
+lattice_flow_staple_2(__global hgpu_float4 * lattice_table, uint gindex,const uint dir)
+{
+    coords_4 coord,coordMu,coordNu,coordNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiNm,gdiNmMu;
+    gpu_su_2 m1,m2,m3;
+    su_2 staple, staple1;
+
+    lattice_zero_2(&staple);
+    lattice_gid_to_coords(&gindex,&coord);
+    lattice_neighbours_gid(&coord,&coordMu,&gdiMu,dir);
+
+    for (uint nu = X; nu <= T; nu++) {
+        if (nu == dir) continue;
+        lattice_neighbours_gid(&coord,&coordNu,&gdiNu,nu);
+        lattice_neighbours_gid_minus(&coord,&coordNm,&gdiNm,nu);
+        lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,dir);
+
+             m1 = lattice_table_notwist_2(lattice_table,gdiMu,nu);     // [p+mu,nu]
+             m2 = lattice_table_notwist_2(lattice_table,gdiNu,dir);    // [p+nu,mu]
+             m3 = lattice_table_notwist_2(lattice_table,gindex,nu);    // [p,nu]
+        staple1 = lattice_staple_hermitian2(&m1,&m2,&m3);
+         staple = matrix_add2(&staple,&staple1);
+
+             m1 = lattice_table_notwist_2(lattice_table,gdiNmMu,nu);   // [p-nu+mu,nu]
+             m2 = lattice_table_notwist_2(lattice_table,gdiNm,dir);    // [p-nu,mu]
+             m3 = lattice_table_notwist_2(lattice_table,gdiNm,nu);     // [p-nu,nu]
+        staple1 = lattice_staple_hermitian_backward2(&m1,&m2,&m3);
+         staple = matrix_add2(&staple,&staple1);
+    }
+
+    return staple;
+}
+
+                    HGPU_INLINE_PREFIX hgpu_float4
+lattice_flow_clover_2(__global hgpu_float4 * lattice_table,const coords_4 * coord,uint gindex,const uint mu,const uint nu)
+{
+    // G_munu = (Q - Q^+)/8, Q - sum of 4 plaquettes in mu-nu plane around p; returned in gpu_su_2 layout
+    coords_4 coordMu,coordNu,coordMm,coordNm,coordMmNu,coordMmNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiMm,gdiNm,gdiMmNu,gdiMmNm,gdiNmMu;
+    gpu_su_2 m1,m2,m3,m4,leaf;
+    hgpu_float4 clover;
+
+    lattice_neighbours_gid(coord,&coordMu,&gdiMu,mu);
+    lattice_neighbours_gid(coord,&coordNu,&gdiNu,nu);
+    lattice_neighbours_gid_minus(coord,&coordMm,&gdiMm,mu);
+    lattice_neighbours_gid_minus(coord,&coordNm,&gdiNm,nu);
+    lattice_neighbours_gid(&coordMm,&coordMmNu,&gdiMmNu,nu);
+    lattice_neighbours_gid_minus(&coordMm,&coordMmNm,&gdiMmNm,nu);
+    lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,mu);
+
+    // [p,mu]-[p+mu,nu]-[p+nu,mu]*-[p,nu]*
+    m1 = lattice_table_notwist_2(lattice_table,gindex,mu);
+    m2 = lattice_table_notwist_2(lattice_table,gdiMu,nu);
+    m3 = lattice_table_notwist_2(lattice_table,gdiNu,mu);       m3 = matrix_hermitian2(&m3);
+    m4 = lattice_table_notwist_2(lattice_table,gindex,nu);      m4 = matrix_hermitian2(&m4);
+    leaf = matrix_times2(&m1,&m2);  leaf = matrix_times2(&leaf,&m3);  leaf = matrix_times2(&leaf,&m4);
+    clover = leaf.uv1;
+
+    // [p,nu]-[p-mu+nu,mu]*-[p-mu,nu]*-[p-mu,mu]
+    m1 = lattice_table_notwist_2(lattice_table,gindex,nu);
+    m2 = lattice_table_notwist_2(lattice_table,gdiMmNu,mu);     m2 = matrix_hermitian2(&m2);
+    m3 = lattice_table_notwist_2(lattice_table,gdiMm,nu);       m3 = matrix_hermitian2(&m3);
+    m4 = lattice_table_notwist_2(lattice_table,gdiMm,mu);
+    leaf = matrix_times2(&m1,&m2);  leaf = matrix_times2(&leaf,&m3);  leaf = matrix_times2(&leaf,&m4);
+    clover += leaf.uv1;
+
+    // [p-mu,mu]*-[p-mu-nu,nu]*-[p-mu-nu,mu]-[p-nu,nu]
+    m1 = lattice_table_notwist_2(lattice_table,gdiMm,mu);       m1 = matrix_hermitian2(&m1);
+    m2 = lattice_table_notwist_2(lattice_table,gdiMmNm,nu);     m2 = matrix_hermitian2(&m2);
+    m3 = lattice_table_notwist_2(lattice_table,gdiMmNm,mu);
+    m4 = lattice_table_notwist_2(lattice_table,gdiNm,nu);
+    leaf = matrix_times2(&m1,&m2);  leaf = matrix_times2(&leaf,&m3);  leaf = matrix_times2(&leaf,&m4);
+    clover += leaf.uv1;
+
+    // [p-nu,nu]*-[p-nu,mu]-[p-nu+mu,nu]-[p,mu]*
+    m1 = lattice_table_notwist_2(lattice_table,gdiNm,nu);       m1 = matrix_hermitian2(&m1);
+    m2 = lattice_table_notwist_2(lattice_table,gdiNm,mu);
+    m3 = lattice_table_notwist_2(lattice_table,gdiNmMu,nu);
+    m4 = lattice_table_notwist_2(lattice_table,gindex,mu);      m4 = matrix_hermitian2(&m4);
+    leaf = matrix_times2(&m1,&m2);  leaf = matrix_times2(&leaf,&m3);  leaf = matrix_times2(&leaf,&m4);
+    clover += leaf.uv1;
+
+    // sum of SU(2) matrices is proportional to SU(2) matrix, so its antihermitian part is the imaginary part
+    clover.x = 0.0;
+    return clover * ((hgpu_float4) ((hgpu_float) 0.25));
+}
+
+                    HGPU_INLINE_PREFIX hgpu_double
+lattice_flow_trace_2(hgpu_float4 * a,hgpu_float4 * b)
+{
+    // tr(A B) for A, B in su(2)
+    return -2.0 * ((hgpu_double) (*a).y * (*b).y + (hgpu_double) (*a).z * (*b).z + (hgpu_double) (*a).w * (*b).w);
+}
+#endif
+
+#if SUN == 3
+                    HGPU_INLINE_PREFIX su_3
+lattice_flow_staple_3(__global hgpu_float4 * lattice_table, uint gindex,const uint dir)
+{
+    coords_4 coord,coordMu,coordNu,coordNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiNm,gdiNmMu;
+    gpu_su_3 m1,m2,m3;
+    su_3 staple, staple1;
+
+    lattice_zero_3(&staple);
+    lattice_gid_to_coords(&gindex,&coord);
+    lattice_neighbours_gid(&coord,&coordMu,&gdiMu,dir);
+
+    for (uint nu = X; nu <= T; nu++) {
+        if (nu == dir) continue;
+        lattice_neighbours_gid(&coord,&coordNu,&gdiNu,nu);
+        lattice_neighbours_gid_minus(&coord,&coordNm,&gdiNm,nu);
+        lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,dir);
+
+             m1 = lattice_table_notwist_3(lattice_table,gdiMu,nu);     // [p+mu,nu]
+             m2 = lattice_table_notwist_3(lattice_table,gdiNu,dir);    // [p+nu,mu]
+             m3 = lattice_table_notwist_3(lattice_table,gindex,nu);    // [p,nu]
+        staple1 = lattice_staple_hermitian3(&m1,&m2,&m3);
+         staple = matrix_add3(&staple,&staple1);
+
+             m1 = lattice_table_notwist_3(lattice_table,gdiNmMu,nu);   // [p-nu+mu,nu]
+             m2 = lattice_table_notwist_3(lattice_table,gdiNm,dir);    // [p-nu,mu]
+             m3 = lattice_table_notwist_3(lattice_table,gdiNm,nu);     // [p-nu,nu]
+        staple1 = lattice_staple_hermitian_backward3(&m1,&m2,&m3);
+         staple = matrix_add3(&staple,&staple1);
+    }
+
+    return staple;
+}
+
+                    HGPU_INLINE_PREFIX su_3
+lattice_flow_force_load_3(__global hgpu_float4 * lattice_force,uint gindex,const uint dir,hgpu_float f)
+{
+    // f * X for traceless antihermitian X, stored as (u1.im, v2.im, u2.re, u2.im) and (u3.re, u3.im, v3.re, v3.im)
+    su_3 a;
+    hgpu_float4 x1 = lattice_force[gindex + dir * ROWSIZE] * ((hgpu_float4) f);
+    hgpu_float4 x2 = lattice_force[gindex + dir * ROWSIZE + ROWLINKS] * ((hgpu_float4) f);
+
+    a.u1.re = 0.0;       a.u1.im = x1.x;
+    a.v2.re = 0.0;       a.v2.im = x1.y;
+    a.w3.re = 0.0;       a.w3.im = -x1.x - x1.y;
+    a.u2.re = x1.z;      a.u2.im = x1.w;
+    a.u3.re = x2.x;      a.u3.im = x2.y;
+    a.v3.re = x2.z;      a.v3.im = x2.w;
+    a.v1.re = -x1.z;     a.v1.im = x1.w;
+    a.w1.re = -x2.x;     a.w1.im = x2.y;
+    a.w2.re = -x2.z;     a.w2.im = x2.w;
+
+    return a;
+}
+
+                    HGPU_INLINE_PREFIX su_3
+lattice_flow_clover_3(__global hgpu_float4 * lattice_table,const coords_4 * coord,uint gindex,const uint mu,const uint nu)
+{
+    // G_munu = (Q - Q^+)/8 without trace, Q - sum of 4 plaquettes in mu-nu plane around p
+    coords_4 coordMu,coordNu,coordMm,coordNm,coordMmNu,coordMmNm,coordNmMu;
+    uint gdiMu,gdiNu,gdiMm,gdiNm,gdiMmNu,gdiMmNm,gdiNmMu;
+    gpu_su_3 m1,m2,m3,m4,leaf;
+    su_3 clover, leaf1;
+
+    lattice_neighbours_gid(coord,&coordMu,&gdiMu,mu);
+    lattice_neighbours_gid(coord,&coordNu,&gdiNu,nu);
+    lattice_neighbours_gid_minus(coord,&coordMm,&gdiMm,mu);
+    lattice_neighbours_gid_minus(coord,&coordNm,&gdiNm,nu);
+    lattice_neighbours_gid(&coordMm,&coordMmNu,&gdiMmNu,nu);
+    lattice_neighbours_gid_minus(&coordMm,&coordMmNm,&gdiMmNm,nu);
+    lattice_neighbours_gid(&coordNm,&coordNmMu,&gdiNmMu,mu);
+
+    // [p,mu]-[p+mu,nu]-[p+nu,mu]*-[p,nu]*
+    m1 = lattice_table_notwist_3(lattice_table,gindex,mu);
+    m2 = lattice_table_notwist_3(lattice_table,gdiMu,nu);
+    m3 = lattice_table_notwist_3(lattice_table,gdiNu,mu);       m3 = matrix_hermitian3(&m3);
+    m4 = lattice_table_notwist_3(lattice_table,gindex,nu);      m4 = matrix_hermitian3(&m4);
+    leaf = matrix_times3(&m1,&m2);  leaf = matrix_times3(&leaf,&m3);  leaf = matrix_times3(&leaf,&m4);
+    clover = lattice_reconstruct3(&leaf);
+
+    // [p,nu]-[p-mu+nu,mu]*-[p-mu,nu]*-[p-mu,mu]
+    m1 = lattice_table_notwist_3(lattice_table,gindex,nu);
+    m2 = lattice_table_notwist_3(lattice_table,gdiMmNu,mu);     m2 = matrix_hermitian3(&m2);
+    m3 = lattice_table_notwist_3(lattice_table,gdiMm,nu);       m3 = matrix_hermitian3(&m3);
+    m4 = lattice_table_notwist_3(lattice_table,gdiMm,mu);
+    leaf = matrix_times3(&m1,&m2);  leaf = matrix_times3(&leaf,&m3);  leaf = matrix_times3(&leaf,&m4);
+    leaf1  = lattice_reconstruct3(&leaf);
+    clover = matrix_add3(&clover,&leaf1);
+
+    // [p-mu,mu]*-[p-mu-nu,nu]*-[p-mu-nu,mu]-[p-nu,nu]
+    m1 = lattice_table_notwist_3(lattice_table,gdiMm,mu);       m1 = matrix_hermitian3(&m1);
+    m2 = lattice_table_notwist_3(lattice_table,gdiMmNm,nu);     m2 = matrix_hermitian3(&m2);
+    m3 = lattice_table_notwist_3(lattice_table,gdiMmNm,mu);
+    m4 = lattice_table_notwist_3(lattice_table,gdiNm,nu);
+    leaf = matrix_times3(&m1,&m2);  leaf = matrix_times3(&leaf,&m3);  leaf = matrix_times3(&leaf,&m4);
+    leaf1  = lattice_reconstruct3(&leaf);
+    clover = matrix_add3(&clover,&leaf1);
+
+    // [p-nu,nu]*-[p-nu,mu]-[p-nu+mu,nu]-[p,mu]*
+    m1 = lattice_table_notwist_3(lattice_table,gdiNm,nu);       m1 = matrix_hermitian3(&m1);
+    m2 = lattice_table_notwist_3(lattice_table,gdiNm,mu);
+    m3 = lattice_table_notwist_3(lattice_table,gdiNmMu,nu);
+    m4 = lattice_table_notwist_3(lattice_table,gindex,mu);      m4 = matrix_hermitian3(&m4);
+    leaf = matrix_times3(&m1,&m2);  leaf = matrix_times3(&leaf,&m3);  leaf = matrix_times3(&leaf,&m4);
+    leaf1  = lattice_reconstruct3(&leaf);
+    clover = matrix_add3(&clover,&leaf1);
+
+    return lattice_antihermitian3(&clover,(hgpu_float) -0.25);
+}
+
+                    HGPU_INLINE_PREFIX hgpu_double
+lattice_flow_trace_3(su_3 * a,su_3 * b)
+{
+    // Re tr(A B)
+    hgpu_double result;
+
+    result  = (hgpu_double) (*a).u1.re * (*b).u1.re - (hgpu_double) (*a).u1.im * (*b).u1.im;
+    result += (hgpu_double) (*a).u2.re * (*b).v1.re - (hgpu_double) (*a).u2.im * (*b).v1.im;
+    result += (hgpu_double) (*a).u3.re * (*b).w1.re - (hgpu_double) (*a).u3.im * (*b).w1.im;
+    result += (hgpu_double) (*a).v1.re * (*b).u2.re - (hgpu_double) (*a).v1.im * (*b).u2.im;
+    result += (hgpu_double) (*a).v2.re * (*b).v2.re - (hgpu_double) (*a).v2.im * (*b).v2.im;
+    result += (hgpu_double) (*a).v3.re * (*b).w2.re - (hgpu_double) (*a).v3.im * (*b).w2.im;
+    result += (hgpu_double) (*a).w1.re * (*b).u3.re - (hgpu_double) (*a).w1.im * (*b).u3.im;
+    result += (hgpu_double) (*a).w2.re * (*b).v3.re - (hgpu_double) (*a).w2.im * (*b).v3.im;
+    result += (hgpu_double) (*a).w3.re * (*b).w3.re - (hgpu_double) (*a).w3.im * (*b).w3.im;
+
+    return result;
+}
+#endif
+
+                                        __kernel void
+lattice_flow_copy(__global hgpu_float4 * lattice_table,
+                  __global hgpu_float4 * lattice_flow_table)
+{
+    // flow starts from a copy of the current configuration, the Markov chain is not touched
+#if SUN == 2
+    gpu_su_2 matrix;
+#endif
+#if SUN == 3
+    gpu_su_3 matrix;
+#endif
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= T; dir++) {
+#if SUN == 2
+            matrix = lattice_table_notwist_2(lattice_table,GID,dir);
+            lattice_store_2(lattice_flow_table,&matrix,GID,dir);
+#endif
+#if SUN == 3
+            matrix = lattice_table_notwist_3(lattice_table,GID,dir);
+            lattice_store_3(lattice_flow_table,&matrix,GID,dir);
+#endif
+        }
+    }
+}
+
+                                        __kernel void
+lattice_flow_force(__global hgpu_float4 * lattice_flow_table,
+                   __global hgpu_float4 * lattice_flow_force,
+                   uint stage)
+{
+    // X <- a[stage] * X + eps * Z(W) for all links; X is not read at the first stage
+    hgpu_float a   = lattice_flow_a(stage);
+    hgpu_float eps = (hgpu_float) FLOW_EPS;
+#if SUN == 2
+    gpu_su_2 matrix;
+    su_2 staple, u1, p;
+    hgpu_float4 z;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= T; dir++) {
+            matrix = lattice_table_notwist_2(lattice_flow_table,GID,dir);
+            staple = lattice_flow_staple_2(lattice_flow_table,GID,dir);
+            u1 = lattice_reconstruct2(&matrix);
+            p  = matrix_times_su2(&u1,&staple);
+            // eps/2 * (P^+ - P) without trace, stored as (u1.im, u2.re, u2.im, 0)
+            z = (hgpu_float4) (-(p.u1.im - p.v2.im), p.v1.re - p.u2.re, -(p.v1.im + p.u2.im), 0.0) * ((hgpu_float4) (eps / (hgpu_float) 2.0));
+            if (stage > 0) z += lattice_flow_force[GID + dir * ROWSIZE] * ((hgpu_float4) a);
+            lattice_flow_force[GID + dir * ROWSIZE] = z;
+        }
+    }
+#endif
+#if SUN == 3
+    gpu_su_3 matrix;
+    su_3 staple, u1, p, z;
+    hgpu_float4 z1, z2;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= T; dir++) {
+            matrix = lattice_table_notwist_3(lattice_flow_table,GID,dir);
+            staple = lattice_flow_staple_3(lattice_flow_table,GID,dir);
+            u1 = lattice_reconstruct3(&matrix);
+            p  = matrix_times_su3(&u1,&staple);
+            z  = lattice_antihermitian3(&p,eps);
+            z1 = (hgpu_float4) (z.u1.im, z.v2.im, z.u2.re, z.u2.im);
+            z2 = (hgpu_float4) (z.u3.re, z.u3.im, z.v3.re, z.v3.im);
+            if (stage > 0) {
+                z1 += lattice_flow_force[GID + dir * ROWSIZE]            * ((hgpu_float4) a);
+                z2 += lattice_flow_force[GID + dir * ROWSIZE + ROWLINKS] * ((hgpu_float4) a);
+            }
+            lattice_flow_force[GID + dir * ROWSIZE]            = z1;
+            lattice_flow_force[GID + dir * ROWSIZE + ROWLINKS] = z2;
+        }
+    }
+#endif
+}
+
+                                        __kernel void
+lattice_flow_update(__global hgpu_float4 * lattice_flow_table,
+                    __global hgpu_float4 * lattice_flow_force,
+                    uint stage)
+{
+    // W <- exp(b[stage] * X) * W for all links
+    hgpu_float b = lattice_flow_b(stage);
+#if SUN == 2
+    gpu_su_2 matrix, e;
+    hgpu_float4 x;
+    hgpu_float theta, f;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= T; dir++) {
+            matrix = lattice_table_notwist_2(lattice_flow_table,GID,dir);
+            x = lattice_flow_force[GID + dir * ROWSIZE] * ((hgpu_float4) b);
+            theta = sqrt(x.x * x.x + x.y * x.y + x.z * x.z);
+            f = (theta > (hgpu_float) 1.0e-12) ? (sin(theta) / theta) : (hgpu_float) 1.0;
+            e.uv1 = (hgpu_float4) (cos(theta), f * x.y, f * x.x, f * x.z);
+            matrix = matrix_times2(&e,&matrix);
+            lattice_su2_Normalize(&matrix);
+            lattice_store_2(lattice_flow_table,&matrix,GID,dir);
+        }
+    }
+#endif
+#if SUN == 3
+    gpu_su_3 matrix;
+    su_3 u1, a, e, p;
+
+    if (GID < SITES) {
+        for (uint dir = X; dir <= T; dir++) {
+            matrix = lattice_table_notwist_3(lattice_flow_table,GID,dir);
+            a  = lattice_flow_force_load_3(lattice_flow_force,GID,dir,b);
+            e  = lattice_exp3(&a,FLOW_EXP_ORDER);
+            u1 = lattice_reconstruct3(&matrix);
+            p  = matrix_times_su3(&e,&u1);
+
+            matrix.uv1 = (hgpu_float4) (p.u1.re, p.u2.re, p.u3.re, p.v3.re);
+            matrix.uv2 = (hgpu_float4) (p.u1.im, p.u2.im, p.u3.im, p.v3.im);
+            matrix.uv3 = (hgpu_float4) (p.v1.re, p.v2.re, p.v1.im, p.v2.im);
+            lattice_GramSchmidt3(&matrix);
+            lattice_store_3(lattice_flow_table,&matrix,GID,dir);
+        }
+    }
+#endif
+}
+
+                                        __kernel void
+lattice_flow_measurement(__global hgpu_float4  * lattice_flow_table,
+                         __global hgpu_double2 * lattice_flow_measurement,
+                         __local hgpu_double2  * lattice_lds)
+{
+    // clover energy density E(p) = -sum_{mu<nu} tr(G_munu G_munu) and
+    // topological charge density q(p) = -1/(4 pi^2) [tr(G_xy G_zt) - tr(G_xz G_yt) + tr(G_xt G_yz)]
+    hgpu_double2 out  = (hgpu_double2) 0.0;
+    hgpu_double2 out2 = (hgpu_double2) 0.0;
+    uint gindex = GID;
+    coords_4 coord;
+#if SUN == 2
+    hgpu_float4 g[6];
+#endif
+#if SUN == 3
+    su_3 g[6];
+#endif
+    uint plane = 0;
+
+    if (GID < SITES) {
+        lattice_gid_to_coords(&gindex,&coord);
+        for (uint mu = X; mu < T; mu++)
+            for (uint nu = mu + 1; nu <= T; nu++) {
+#if SUN == 2
+                g[plane] = lattice_flow_clover_2(lattice_flow_table,&coord,gindex,mu,nu);
+                out.x -= lattice_flow_trace_2(&g[plane],&g[plane]);
+#endif
+#if SUN == 3
+                g[plane] = lattice_flow_clover_3(lattice_flow_table,&coord,gindex,mu,nu);
+                out.x -= lattice_flow_trace_3(&g[plane],&g[plane]);
+#endif
+                plane++;
+            }
+        // planes: 0 - xy, 1 - xz, 2 - xt, 3 - yz, 4 - yt, 5 - zt
+#if SUN == 2
+        out.y = lattice_flow_trace_2(&g[0],&g[5]) - lattice_flow_trace_2(&g[1],&g[4]) + lattice_flow_trace_2(&g[2],&g[3]);
+#endif
+#if SUN == 3
+        out.y = lattice_flow_trace_3(&g[0],&g[5]) - lattice_flow_trace_3(&g[1],&g[4]) + lattice_flow_trace_3(&g[2],&g[3]);
+#endif
+        out.y *= -1.0 / (4.0 * PI * PI);
+    }
+
+    reduce_first_step_val_double2(lattice_lds,&out, &out2);
+
+    if(TID == 0) lattice_flow_measurement[BID] = out2;
+}
+
+                                        __kernel void
+reduce_flow_double2(__global hgpu_double2 * lattice_flow_measurement,
+                    __global hgpu_double4 * lattice_flow,
+                    __local hgpu_double2  * lattice_lds,
+                    uint4 param,
+                    uint index,
+                    uint step)
+{
+    // param.x - number of partial sums, param.y - offset between flow steps in lattice_flow
+    // lattice_flow[step * param.y + index] = (t, E(t), t^2 E(t), Q(t))
+    hgpu_double t = (hgpu_double) step * FLOW_EPS;
+    reduce_final_step_double2(lattice_lds,lattice_flow_measurement,param.x);
+    if (GID==0) lattice_flow[step * param.y + index] = (hgpu_double4) (t, lattice_lds[0].x / SITES, t * t * lattice_lds[0].x / SITES, lattice_lds[0].y);
+}
+
+#endif
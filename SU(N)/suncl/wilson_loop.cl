@@ -463,6 +463,210 @@ reduce_wilson_double2(__global hgpu_double2 * lattice_measurement,
     reduce_final_step_double2(lattice_lds,lattice_measurement,size);
     if (GID==0) lattice_wilson_loop[index] = lattice_lds[0].x;
 }
+#if defined(WLRMAX) && defined(WLTMAX)
+// Wilson loops W(R,T) for all R<=WLRMAX, T<=WLTMAX in one pass:
+// temporal lines from p are built once per site, spatial lines are extended by one link per R step,
+// temporal lines at p+R are extended by one link per T step
+#define WLGRID  (WLRMAX * WLTMAX)
+#define WLPAIRS ((WLGRID + 1) >> 1)
+
+                                        __kernel void
+lattice_measurement_wilson_grid(__global hgpu_float4  * lattice_table,
+                                __global hgpu_double2 * lattice_wilson_grid_measurement,
+                                __global hgpu_float   * lattice_parameters,
+                                __local hgpu_double2  * lattice_lds)
+{
+    hgpu_double  wilson_loop[WLGRID];
+    hgpu_double2 out  = (hgpu_double2) 0.0;
+    hgpu_double2 out2 = (hgpu_double2) 0.0;
+    uint gdi = GID;
+    coords_4 coord, coord_0, coord_b, coord_f;
+    coords_4 coord_t[WLTMAX];       // p + (t+1)*T
+    coords_4 coord_s[WLTMAX];       // p + (t+1)*T + r*dir
+    uint gdi_0, gdi_b, gdi_f;
+    uint gdi_t[WLTMAX];
+    uint gdi_s[WLTMAX];
+    uint dir, r, t;
+
+#if SUN == 2
+    gpu_su_2 u1;
+    double_su_2 m5, w1, mb, mf;
+    double_su_2 ml[WLTMAX];         // temporal lines [p, p+(t+1)*T]
+    double_su_2 mt[WLTMAX];         // spatial lines  [p+(t+1)*T, p+(t+1)*T+(r+1)*dir]
+
+    su2_twist twist;
+        twist.phi   = lattice_parameters[1];
+
+    for (r = 0; r < WLGRID; r++) wilson_loop[r] = 0.0;
+
+    if (GID<SITES) {
+        lattice_gid_to_coords(&gdi,&coord_0);
+        gdi_0 = gdi;
+
+        // _______________________________ temporal lines from p (common for all directions)
+        u1 = lattice_table_2(lattice_table,&coord_0,gdi_0,T,&twist);        // [p,T]
+        ml[0] = lattice_reconstruct2_double(&u1);
+        lattice_neighbours_gid(&coord_0,&coord_t[0],&gdi_t[0],T);
+        for (t = 1; t < WLTMAX; t++){
+            u1 = lattice_table_2(lattice_table,&coord_t[t-1],gdi_t[t-1],T,&twist);
+            m5 = lattice_reconstruct2_double(&u1);
+            ml[t] = matrix_times_su2_double(&ml[t-1],&m5);
+            lattice_neighbours_gid(&coord_t[t-1],&coord_t[t],&gdi_t[t],T);
+        }
+
+        for (dir = X; dir <= Z; dir++){
+            coord_b = coord_0;
+            gdi_b   = gdi_0;
+            for (t = 0; t < WLTMAX; t++){
+                coord_s[t] = coord_t[t];
+                gdi_s[t]   = gdi_t[t];
+            }
+            for (r = 0; r < WLRMAX; r++){
+                // _______________________________ bottom and top spatial lines
+                u1 = lattice_table_2(lattice_table,&coord_b,gdi_b,dir,&twist);   // [p+r*dir,dir]
+                m5 = lattice_reconstruct2_double(&u1);
+                if (r == 0) mb = m5;
+                else {
+                    w1 = matrix_times_su2_double(&mb,&m5);
+                    mb = w1;
+                }
+                coord = coord_b;
+                lattice_neighbours_gid(&coord,&coord_b,&gdi_b,dir);
+                for (t = 0; t < WLTMAX; t++){
+                    u1 = lattice_table_2(lattice_table,&coord_s[t],gdi_s[t],dir,&twist);
+                    m5 = lattice_reconstruct2_double(&u1);
+                    if (r == 0) mt[t] = m5;
+                    else {
+                        w1 = matrix_times_su2_double(&mt[t],&m5);
+                        mt[t] = w1;
+                    }
+                    coord = coord_s[t];
+                    lattice_neighbours_gid(&coord,&coord_s[t],&gdi_s[t],dir);
+                }
+
+                // _______________________________ temporal line at p+(r+1)*dir
+                coord_f = coord_b;
+                gdi_f   = gdi_b;
+                for (t = 0; t < WLTMAX; t++){
+                    u1 = lattice_table_2(lattice_table,&coord_f,gdi_f,T,&twist);
+                    m5 = lattice_reconstruct2_double(&u1);
+                    if (t == 0) mf = m5;
+                    else {
+                        w1 = matrix_times_su2_double(&mf,&m5);
+                        mf = w1;
+                    }
+                    wilson_loop[r * WLTMAX + t] += lattice_retrace_plaquette2_double(&ml[t],&mt[t],&mf,&mb);
+                    coord = coord_f;
+                    lattice_neighbours_gid(&coord,&coord_f,&gdi_f,T);
+                }
+            }
+        }
+    }
+#endif
+
+#if SUN == 3
+    gpu_su_3 u1;
+    double_su_3 m5, w1, mb, mf;
+    double_su_3 ml[WLTMAX];         // temporal lines [p, p+(t+1)*T]
+    double_su_3 mt[WLTMAX];         // spatial lines  [p+(t+1)*T, p+(t+1)*T+(r+1)*dir]
+
+    su3_twist twist;
+        twist.phi   = lattice_parameters[1];
+        twist.omega = lattice_parameters[2];
+
+    for (r = 0; r < WLGRID; r++) wilson_loop[r] = 0.0;
+
+    if (GID<SITES) {
+        lattice_gid_to_coords(&gdi,&coord_0);
+        gdi_0 = gdi;
+
+        // _______________________________ temporal lines from p (common for all directions)
+        u1 = lattice_table_3(lattice_table,&coord_0,gdi_0,T,&twist);        // [p,T]
+        ml[0] = lattice_reconstruct3_double(&u1);
+        lattice_neighbours_gid(&coord_0,&coord_t[0],&gdi_t[0],T);
+        for (t = 1; t < WLTMAX; t++){
+            u1 = lattice_table_3(lattice_table,&coord_t[t-1],gdi_t[t-1],T,&twist);
+            m5 = lattice_reconstruct3_double(&u1);
+            ml[t] = matrix_times_su3_double(&ml[t-1],&m5);
+            lattice_neighbours_gid(&coord_t[t-1],&coord_t[t],&gdi_t[t],T);
+        }
+
+        for (dir = X; dir <= Z; dir++){
+            coord_b = coord_0;
+            gdi_b   = gdi_0;
+            for (t = 0; t < WLTMAX; t++){
+                coord_s[t] = coord_t[t];
+                gdi_s[t]   = gdi_t[t];
+            }
+            for (r = 0; r < WLRMAX; r++){
+                // _______________________________ bottom and top spatial lines
+                u1 = lattice_table_3(lattice_table,&coord_b,gdi_b,dir,&twist);   // [p+r*dir,dir]
+                m5 = lattice_reconstruct3_double(&u1);
+                if (r == 0) mb = m5;
+                else {
+                    w1 = matrix_times_su3_double(&mb,&m5);
+                    mb = w1;
+                }
+                coord = coord_b;
+                lattice_neighbours_gid(&coord,&coord_b,&gdi_b,dir);
+                for (t = 0; t < WLTMAX; t++){
+                    u1 = lattice_table_3(lattice_table,&coord_s[t],gdi_s[t],dir,&twist);
+                    m5 = lattice_reconstruct3_double(&u1);
+                    if (r == 0) mt[t] = m5;
+                    else {
+                        w1 = matrix_times_su3_double(&mt[t],&m5);
+                        mt[t] = w1;
+                    }
+                    coord = coord_s[t];
+                    lattice_neighbours_gid(&coord,&coord_s[t],&gdi_s[t],dir);
+                }
+
+                // _______________________________ temporal line at p+(r+1)*dir
+                coord_f = coord_b;
+                gdi_f   = gdi_b;
+                for (t = 0; t < WLTMAX; t++){
+                    u1 = lattice_table_3(lattice_table,&coord_f,gdi_f,T,&twist);
+                    m5 = lattice_reconstruct3_double(&u1);
+                    if (t == 0) mf = m5;
+                    else {
+                        w1 = matrix_times_su3_double(&mf,&m5);
+                        mf = w1;
+                    }
+                    wilson_loop[r * WLTMAX + t] += lattice_retrace_plaquette3_double(&ml[t],&mt[t],&mf,&mb);
+                    coord = coord_f;
+                    lattice_neighbours_gid(&coord,&coord_f,&gdi_f,T);
+                }
+            }
+        }
+    }
+#endif
+
+    // first reduction (two (R,T) entries per double2)
+    for (r = 0; r < WLPAIRS; r++){
+        out.x = wilson_loop[2 * r];
+        out.y = ((2 * r + 1) < WLGRID) ? wilson_loop[2 * r + 1] : 0.0;
+        reduce_first_step_val_double2(lattice_lds,&out,&out2);
+        if (TID == 0) lattice_wilson_grid_measurement[r * WLOFFSET + BID] = out2;
+    }
+}
+
+                                        __kernel void
+reduce_wilson_grid_double2(__global hgpu_double2 * lattice_wilson_grid_measurement,
+                           __global hgpu_double  * lattice_wilson_grid,
+                           __local hgpu_double2  * lattice_lds,
+                           uint4 param,
+                           uint index)
+{
+    // param.x - number of partial sums, param.y - offset between (R,T) entries in lattice_wilson_grid
+    for (uint i = 0; i < WLPAIRS; i++){
+        reduce_final_step_double2_offset(lattice_lds,lattice_wilson_grid_measurement,param.x,i * WLOFFSET);
+        if (GID==0) {
+                                            lattice_wilson_grid[(2 * i)     * param.y + index] = lattice_lds[0].x;
+            if ((2 * i + 1) < WLGRID)       lattice_wilson_grid[(2 * i + 1) * param.y + index] = lattice_lds[0].y;
+        }
+    }
+}
+#endif
 #endif
 
 
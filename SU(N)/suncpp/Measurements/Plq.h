@@ -43,49 +43,101 @@
 #include "../su2/algebra_su2.h"
 #include "../su3/algebra_su3.h"
 
+#include "../su3/simd_su3.h"
+
+// Re Tr of the plaquettes in plane (dir, dir1) at SIMD_WIDTH sites
 template <typename su_n>
-hgpu_complex plqConf(modelCPU<su_n> *latCPU, hgpu_double *pplq){
-    hgpu_complex result;
-    result.re = 0.0; //spat
-    result.im = 0.0;//temp
-    
-    int nd = latCPU->lattice_ndCPU;
-    
+void plaquette_scalar(modelCPU<su_n> *latCPU, const int *gid, int dir, int dir1, hgpu_double *retr){
     su_n m1, m2, m3, m4;
     int gid1;
     
-    coords_4 lsize;
-    lsize.x = latCPU->lattice_size[0];
-    lsize.y = latCPU->lattice_size[1];
-    lsize.z = latCPU->lattice_size[2];
-    lsize.t = latCPU->lattice_size[3];
-    
-    for (int gid = 0; gid < latCPU->lattice_sitesCPU; gid++){
-    //--- spat ---------------------------------------------------------------------
-    for (int dir = 0; dir < nd - 2; dir++)
-        for (int dir1 = dir + 1; dir1 < nd - 1; dir1++){
-            m1 = latCPU->lattice_tableCPU[gid * nd + dir];
-            gid1 = lattice_neighbours_coords(lsize, gid, dir);
-            m2 = latCPU->lattice_tableCPU[gid1 * nd + dir1];
-            gid1 = lattice_neighbours_coords(lsize, gid, dir1);
-            m3 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-            m4 = Herm(latCPU->lattice_tableCPU[gid * nd + dir1]);
+    for (int l = 0; l < SIMD_WIDTH; l++){
+        m1 = latCPU->get_link(gid[l], dir);
+        gid1 = latCPU->neighbour(gid[l], dir);
+        m2 = latCPU->get_link(gid1, dir1);
+        gid1 = latCPU->neighbour(gid[l], dir1);
+        m3 = Herm(latCPU->get_link(gid1, dir));
+        m4 = Herm(latCPU->get_link(gid[l], dir1));
         
-        result.re += ReTr(m1 * m2 * m3 * m4);
+        retr[l] = ReTr(m1 * m2 * m3 * m4);
     }
-    //--- temp ---------------------------------------------------------------------
-    for (int dir = 0; dir < nd - 1; dir++){
-        m1 = latCPU->lattice_tableCPU[gid * nd + dir];
-        gid1 = lattice_neighbours_coords(lsize, gid, dir);
-        m2 = latCPU->lattice_tableCPU[gid1 * nd + nd - 1];
-        gid1 = lattice_neighbours_coords(lsize, gid, nd - 1);
-        m3 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-        m4 = Herm(latCPU->lattice_tableCPU[gid * nd + nd - 1]);
-        
-        result.im += ReTr(m1 * m2 * m3 * m4);
+}
+
+template <typename su_n>
+void plaquette_batch(modelCPU<su_n> *latCPU, const int *gid, int dir, int dir1, hgpu_double *retr){
+    plaquette_scalar(latCPU, gid, dir, dir1, retr);
+}
+
+// SU(3) in SoA layout: links are gathered from the planes and multiplied on su3_pack
+template <>
+inline void plaquette_batch<su_3>(modelCPU<su_3> *latCPU, const int *gid, int dir, int dir1, hgpu_double *retr){
+    if (latCPU->layout != 1){
+        plaquette_scalar(latCPU, gid, dir, dir1, retr);
+        return;
+    }
+    
+    int ps = latCPU->lattice_planes_stride;
+    int reals = latCPU->link_reals;
+    const hgpu_float *planes = latCPU->lattice_planes;
+    int i1[SIMD_WIDTH], i2[SIMD_WIDTH], i3[SIMD_WIDTH], i4[SIMD_WIDTH];
+    hgpu_float lane[SIMD_WIDTH];
+    su3_pack m1, m2, m3, m4, m12, m123, m1234;
+    
+    for (int l = 0; l < SIMD_WIDTH; l++){
+        i1[l] = latCPU->link_index(gid[l], dir);
+        i2[l] = latCPU->link_index(latCPU->neighbour(gid[l], dir), dir1);
+        i3[l] = latCPU->link_index(latCPU->neighbour(gid[l], dir1), dir);
+        i4[l] = latCPU->link_index(gid[l], dir1);
     }
-    //-------------------------------------------------------------------------------
+    su3_pack_gather(&m1, planes, ps, i1, reals);
+    su3_pack_gather(&m2, planes, ps, i2, reals);
+    su3_pack_gather(&m3, planes, ps, i3, reals);
+    su3_pack_gather(&m4, planes, ps, i4, reals);
+    su3_pack_mul<false, false>(&m12, &m1, &m2);
+    su3_pack_mul<false, true>(&m123, &m12, &m3);
+    su3_pack_mul<false, true>(&m1234, &m123, &m4);
+    
+    simd_store(lane, su3_pack_retr(&m1234));
+    for (int l = 0; l < SIMD_WIDTH; l++)
+        retr[l] = (hgpu_double) lane[l];
+}
+
+// Re Tr of spatial and temporal plaquettes, summed site by site in gid order (same order for both layouts)
+template <typename su_n>
+void plaquette_sums(modelCPU<su_n> *latCPU, hgpu_float *spat, hgpu_float *temp){
+    int nd = latCPU->lattice_ndCPU;
+    int sites = latCPU->lattice_sitesCPU;
+    hgpu_double retr_spat[6][SIMD_WIDTH], retr_temp[3][SIMD_WIDTH];
+    int gid[SIMD_WIDTH];
+    
+    *spat = 0.0;
+    *temp = 0.0;
+    for (int gid0 = 0; gid0 < sites; gid0 += SIMD_WIDTH){
+        int count = (sites - gid0 < SIMD_WIDTH) ? (sites - gid0) : SIMD_WIDTH;
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            gid[l] = gid0 + ((l < count) ? l : (count - 1));   // tail lanes repeat the last site
+        
+        int p = 0;
+        for (int dir = 0; dir < nd - 2; dir++)
+            for (int dir1 = dir + 1; dir1 < nd - 1; dir1++)
+                plaquette_batch(latCPU, gid, dir, dir1, retr_spat[p++]);
+        for (int dir = 0; dir < nd - 1; dir++)
+            plaquette_batch(latCPU, gid, dir, nd - 1, retr_temp[dir]);
+        
+        for (int l = 0; l < count; l++){
+            for (int q = 0; q < p; q++)      *spat += retr_spat[q][l];
+            for (int q = 0; q < nd - 1; q++) *temp += retr_temp[q][l];
+        }
     }
+}
+
+template <typename su_n>
+hgpu_complex plqConf(modelCPU<su_n> *latCPU, hgpu_double *pplq){
+    hgpu_complex result;
+    
+    int nd = latCPU->lattice_ndCPU;
+    
+    plaquette_sums(latCPU, &result.re, &result.im);   // re - spat, im - temp
     
     *pplq = (result.re + result.im) / ((nd - 1) * nd / 2 * latCPU->lattice_sitesCPU);
     result.re /= ((nd - 2) * (nd - 1) / 2 * latCPU->lattice_sitesCPU);
@@ -42,52 +42,17 @@
 
 #include "../su2/algebra_su2.h"
 #include "../su3/algebra_su3.h"
+#include "Plq.h"
 
 template <typename su_n>
 hgpu_complex sConf(modelCPU<su_n> *latCPU, hgpu_double *pplq){
     hgpu_complex result;
-    result.re = 0.0; //spat
-    result.im = 0.0;//temp
     
     int nd = latCPU->lattice_ndCPU;
     int group = latCPU->lattice_group;
     hgpu_float bbeta = latCPU->beta;
     
-    su_n m1, m2, m3, m4;
-    int gid1;
-    
-    coords_4 lsize;
-    lsize.x = latCPU->lattice_size[0];
-    lsize.y = latCPU->lattice_size[1];
-    lsize.z = latCPU->lattice_size[2];
-    lsize.t = latCPU->lattice_size[3];
-    
-    for (int gid = 0; gid < latCPU->lattice_sitesCPU; gid++){
-    //--- spat ---------------------------------------------------------------------
-    for (int dir = 0; dir < nd - 2; dir++)
-        for (int dir1 = dir + 1; dir1 < nd - 1; dir1++){
-            m1 = latCPU->lattice_tableCPU[gid * nd + dir];
-            gid1 = lattice_neighbours_coords(lsize, gid, dir);
-            m2 = latCPU->lattice_tableCPU[gid1 * nd + dir1];
-            gid1 = lattice_neighbours_coords(lsize, gid, dir1);
-            m3 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-            m4 = Herm(latCPU->lattice_tableCPU[gid * nd + dir1]);
-        
-        result.re += ReTr(m1 * m2 * m3 * m4);
-    }
-    //--- temp ---------------------------------------------------------------------
-    for (int dir = 0; dir < nd - 1; dir++){
-        m1 = latCPU->lattice_tableCPU[gid * nd + dir];
-        gid1 = lattice_neighbours_coords(lsize, gid, dir);
-        m2 = latCPU->lattice_tableCPU[gid1 * nd + nd - 1];
-        gid1 = lattice_neighbours_coords(lsize, gid, nd - 1);
-        m3 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-        m4 = Herm(latCPU->lattice_tableCPU[gid * nd + nd - 1]);
-        
-        result.im += ReTr(m1 * m2 * m3 * m4);
-    }
-    //-------------------------------------------------------------------------------
-    }
+    plaquette_sums(latCPU, &result.re, &result.im);   // re - spat, im - temp
     
     *pplq = (result.re + result.im) / ((nd - 1) * nd / 2 * latCPU->lattice_sitesCPU);
     *pplq = bbeta * (1 - (*pplq) / group);
@@ -90,4 +90,18 @@ void lattice_estimates (data_analysis_cpp *Analysis){
         variance += pow((Analysis->data[i] - mean), 2) / length;
     Analysis->mean_value = mean;
     Analysis->variance = variance;
+    
+    // integrated autocorrelation time with automatic windowing (Madras-Sokal, window W >= 6 tau_int)
+    double tau = 0.5;
+    if (variance > 0.0)
+        for (int t = 1; t < length; t++){
+            double c = 0.0;
+            for (int i = 1; i + t < (int) Analysis->data_size; i++)
+                c += (Analysis->data[i] - mean) * (Analysis->data[i + t] - mean);
+            c /= (length - t) * variance;
+            if (c <= 0.0) break;                    // noise dominates beyond the first non-positive autocorrelation
+            tau += c;
+            if (t >= 6.0 * tau) break;
+        }
+    Analysis->tau_int = tau;
 }
@@ -48,6 +48,7 @@ typedef struct data_analysis_cpp {
                      double*   data;
                      double    mean_value;
                      double    variance;
+                     double    tau_int;         // integrated autocorrelation time (in measurements)
                       data_analysis_cpp(void){};
                      ~data_analysis_cpp(void){
                          free(data);
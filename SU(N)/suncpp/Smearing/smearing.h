@@ -0,0 +1,163 @@
+/******************************************************************************
+ * @file     smearing.h
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Spatial smearing (APE, stout) of a copy of the gauge field
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+
+#ifndef smearing_h
+#define smearing_h
+
+#include "../sunh.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+#define SMEAR_EXP_ORDER 6       // order of the truncated exponent in stout smearing
+
+template <typename su_n>
+su_n smear_scale(su_n a, hgpu_double c){
+    for (int r = 0; r < (int) (sizeof(su_n) / sizeof(hgpu_float)); r++)
+        ((hgpu_float*) &a)[r] *= (hgpu_float) c;
+    return a;
+}
+
+inline void smear_project(su_2 *a){
+    hgpu_double norm = sqrt((*a).u1.re * (*a).u1.re + (*a).u1.im * (*a).u1.im + (*a).u2.re * (*a).u2.re + (*a).u2.im * (*a).u2.im);
+    (*a).u1.re /= norm;
+    (*a).u1.im /= norm;
+    (*a).u2.re /= norm;
+    (*a).u2.im /= norm;
+    matrix_reconstruct(a);
+}
+
+inline void smear_project(su_3 *a){
+    GramSchmidt(a);
+}
+
+// sum of staples of link (gid, dir) in spatial planes only
+template <typename su_n>
+su_n smear_staple(modelCPU<su_n> *latCPU, int gid, int dir){
+    su_n stap, m1, m2, m3;
+    int gid1;
+    lattice_zero(&stap);
+    
+    for (int dir1 = 0; dir1 < (int) latCPU->lattice_ndCPU - 1; dir1++)
+        if (dir1 != dir){
+            gid1 = latCPU->neighbour(gid, dir);
+            m1 = latCPU->get_link(gid1, dir1);
+            gid1 = latCPU->neighbour(gid, dir1);
+            m2 = Herm(latCPU->get_link(gid1, dir));
+            m3 = Herm(latCPU->get_link(gid, dir1));
+            stap = stap + (m1 * m2 * m3);
+            
+            gid1 = latCPU->neighbour_backward(gid, dir1);
+            m3 = latCPU->get_link(gid1, dir1);
+            m2 = Herm(latCPU->get_link(gid1, dir));
+            gid1 = latCPU->neighbour(gid1, dir);
+            m1 = Herm(latCPU->get_link(gid1, dir1));
+            stap = stap + (m1 * m2 * m3);
+        }
+    
+    return stap;
+}
+
+// type 1 - APE:   U' = Proj[(1 - alpha) U + alpha / (2 (nd - 2)) S^+]
+// type 2 - stout: U' = exp(iQ) U, iQ = traceless antihermitian part of alpha (U S)^+
+template <typename su_n>
+su_n smear_link(su_n U, su_n stap, int type, hgpu_double alpha, int nd, int group){
+    su_n result;
+    if (type == 2){
+        su_n omega = smear_scale(Herm(U * stap), alpha);
+        su_n A = smear_scale(omega - Herm(omega), 0.5);
+        su_n one, E;
+        hgpu_complex tr = Tr(A);
+        for (int c = 0; c < group; c++)         // remove trace from the (imaginary) diagonal
+            ((hgpu_complex*) &A)[c * (group + 1)].im -= tr.im / group;
+        lattice_unity(&one);
+        E = one;
+        for (int k = SMEAR_EXP_ORDER; k > 0; k--)   // Horner scheme for the truncated exponent
+            E = one + smear_scale(A * E, 1.0 / k);
+        result = E * U;
+    } else
+        result = smear_scale(U, 1.0 - alpha) + smear_scale(Herm(stap), alpha / (2 * (nd - 2)));
+    smear_project(&result);
+    return result;
+}
+
+// one smearing step: spatial links of src are smeared into dst, temporal links are copied
+template <typename su_n>
+void smear_step(modelCPU<su_n> *src, modelCPU<su_n> *dst, int type, hgpu_double alpha){
+    int nd = src->lattice_ndCPU;
+    int sites = src->lattice_sitesCPU;
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(src->threads)
+#endif
+    for (int gid = 0; gid < sites; gid++){
+        for (int dir = 0; dir < nd - 1; dir++)
+            dst->set_link(gid, dir, smear_link(src->get_link(gid, dir), smear_staple(src, gid, dir), type, alpha, nd, src->lattice_group));
+        dst->set_link(gid, nd - 1, src->get_link(gid, nd - 1));
+    }
+}
+
+template <typename su_n>
+modelCPU<su_n>* smear_create(modelCPU<su_n> *latCPU){
+    modelCPU<su_n> *copy = new(modelCPU<su_n>);
+    *copy = *latCPU;
+    copy->create_latticeCPU();
+    return copy;
+}
+
+template <typename su_n>
+void smear_delete(modelCPU<su_n> *copy){
+    if (copy == NULL) return;
+    copy->delete_latticeCPU();
+    delete(copy);
+}
+
+// smears latCPU into ping-pong copies buf[0], buf[1] (allocated on first call) and returns the copy holding the result;
+// latCPU itself is only read, so the Markov chain is never touched
+template <typename su_n>
+modelCPU<su_n>* smear_lattice(modelCPU<su_n> *latCPU, modelCPU<su_n> **buf, int type, int steps, hgpu_double alpha){
+    if ((type <= 0) || (steps <= 0)) return latCPU;
+    if (buf[0] == NULL) buf[0] = smear_create(latCPU);
+    if ((buf[1] == NULL) && (steps > 1)) buf[1] = smear_create(latCPU);
+    
+    smear_step(latCPU, buf[0], type, alpha);
+    for (int k = 1; k < steps; k++)
+        smear_step(buf[(k - 1) % 2], buf[k % 2], type, alpha);
+    
+    return buf[(steps - 1) % 2];
+}
+#endif
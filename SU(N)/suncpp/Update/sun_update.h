@@ -39,18 +39,17 @@
 #define sun_update_h
 
 #include "../sunh.h"
+#include "../su3/simd_su3.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 
 template <typename su_n>
 su_n staple(modelCPU<su_n> *latCPU, int gid, int dir){
     su_n stap, stap1;
     lattice_zero(&stap);
     
-    coords_4 lsize;
-    lsize.x = latCPU->lattice_size[0];
-    lsize.y = latCPU->lattice_size[1];
-    lsize.z = latCPU->lattice_size[2];
-    lsize.t = latCPU->lattice_size[3];
-    
     su_n m1, m2, m3;
     
     int nd = latCPU->lattice_ndCPU;
@@ -58,62 +57,188 @@ su_n staple(modelCPU<su_n> *latCPU, int gid, int dir){
     
     for (int dir1 = 0; dir1 < nd; dir1++)
         if(dir1 != dir){
-            gid1 = lattice_neighbours_coords(lsize, gid, dir);
-            m1 = latCPU->lattice_tableCPU[gid1 * nd + dir1];
-            gid1 = lattice_neighbours_coords(lsize, gid, dir1);
-            m2 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-            m3 = Herm(latCPU->lattice_tableCPU[gid * nd + dir1]);
+            gid1 = latCPU->neighbour(gid, dir);
+            m1 = latCPU->get_link(gid1, dir1);
+            gid1 = latCPU->neighbour(gid, dir1);
+            m2 = Herm(latCPU->get_link(gid1, dir));
+            m3 = Herm(latCPU->get_link(gid, dir1));
             stap = stap + (m1 * m2 * m3);
             
-            gid1 = lattice_neighbours_coords_backward(lsize, gid, dir1);
-            m3 = latCPU->lattice_tableCPU[gid1 * nd + dir1];
-            m2 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir]);
-            gid1 = lattice_neighbours_coords(lsize, gid1, dir);
-            m1 = Herm(latCPU->lattice_tableCPU[gid1 * nd + dir1]);
+            gid1 = latCPU->neighbour_backward(gid, dir1);
+            m3 = latCPU->get_link(gid1, dir1);
+            m2 = Herm(latCPU->get_link(gid1, dir));
+            gid1 = latCPU->neighbour(gid1, dir);
+            m1 = Herm(latCPU->get_link(gid1, dir1));
             stap = stap + (m1 * m2 * m3);
         }
     
     return stap;
 }
 
+// Staples of SIMD_WIDTH sites of parity par (SoA layout); the generic version is scalar
 template <typename su_n>
-void lattice_update_even(modelCPU<su_n> *latCPU, int dir, PRNG_CL::PRNG *prngCPU){
-    su_n stap, U;
-    int gid;
+void staple_batch(modelCPU<su_n> *latCPU, const int *gid, int par, int dir, su_n *stap){
+    for (int l = 0; l < SIMD_WIDTH; l++)
+        stap[l] = staple(latCPU, gid[l], dir);
+}
+
+// SU(3): neighbours of a site have the opposite parity, so every link is gathered
+// straight from its (parity, direction) block and the products run on su3_pack
+template <>
+inline void staple_batch<su_3>(modelCPU<su_3> *latCPU, const int *gid, int par, int dir, su_3 *stap){
+    int nd = latCPU->lattice_ndCPU;
+    int hs = latCPU->lattice_half_stride;
+    int ps = latCPU->lattice_planes_stride;
+    int reals = latCPU->link_reals;
+    const hgpu_float *planes = latCPU->lattice_planes;
+    int block_same[4], block_opp[4];
+    int i1[SIMD_WIDTH], i2[SIMD_WIDTH], i3[SIMD_WIDTH];
+    su3_pack m1, m2, m3, m12, m123, sum;
     
+    for (int d = 0; d < nd; d++){
+        block_same[d] = (par * nd + d) * hs;
+        block_opp[d]  = ((par ^ 1) * nd + d) * hs;
+    }
+    
+    su3_pack_zero(&sum);
+    for (int dir1 = 0; dir1 < nd; dir1++)
+        if(dir1 != dir){
+            // U(x+dir, dir1) * U(x+dir1, dir)^+ * U(x, dir1)^+
+            for (int l = 0; l < SIMD_WIDTH; l++){
+                i1[l] = block_opp[dir1] + latCPU->neighbour(gid[l], dir) / 2;
+                i2[l] = block_opp[dir]  + latCPU->neighbour(gid[l], dir1) / 2;
+                i3[l] = block_same[dir1] + gid[l] / 2;
+            }
+            su3_pack_gather(&m1, planes, ps, i1, reals);
+            su3_pack_gather(&m2, planes, ps, i2, reals);
+            su3_pack_gather(&m3, planes, ps, i3, reals);
+            su3_pack_mul<false, true>(&m12, &m1, &m2);
+            su3_pack_mul<false, true>(&m123, &m12, &m3);
+            su3_pack_add(&sum, &m123);
+            
+            // U(x-dir1+dir, dir1)^+ * U(x-dir1, dir)^+ * U(x-dir1, dir1)
+            for (int l = 0; l < SIMD_WIDTH; l++){
+                int gid1 = latCPU->neighbour_backward(gid[l], dir1);
+                i3[l] = block_opp[dir1] + gid1 / 2;
+                i2[l] = block_opp[dir]  + gid1 / 2;
+                i1[l] = block_same[dir1] + latCPU->neighbour(gid1, dir) / 2;
+            }
+            su3_pack_gather(&m1, planes, ps, i1, reals);
+            su3_pack_gather(&m2, planes, ps, i2, reals);
+            su3_pack_gather(&m3, planes, ps, i3, reals);
+            su3_pack_mul<true, true>(&m12, &m1, &m2);
+            su3_pack_mul<false, false>(&m123, &m12, &m3);
+            su3_pack_add(&sum, &m123);
+        }
+    
+    su3_pack_to_su3(&sum, stap);
+}
+
+// Links of the same parity and direction do not enter each other's staples,
+// so the half-lattice is split between threads (static schedule: a fixed thread
+// count always gives the same site-to-thread mapping and the same PRNG stream per site)
+template <typename su_n>
+void lattice_update_parity(modelCPU<su_n> *latCPU, int dir, int par, PRNG_CL::PRNG *prngCPU){
     coords_4 lsize;
     lsize.x = latCPU->lattice_size[0];
     lsize.y = latCPU->lattice_size[1];
     lsize.z = latCPU->lattice_size[2];
     lsize.t = latCPU->lattice_size[3];
     
-    for (int i = 0; i < latCPU->lattice_sitesCPU / 2; i++){
-        gid = lattice_even_gid(lsize, i);
-        stap = staple(latCPU, gid, dir);
-        U = latCPU->lattice_tableCPU[gid * latCPU->lattice_ndCPU + dir];
-        update_link(&U, stap, (latCPU->beta / latCPU->lattice_group), latCPU->nhit, gid, (latCPU->ints == 2), latCPU->lattice_sitesCPU, 1, prngCPU);
-        latCPU->lattice_tableCPU[gid * latCPU->lattice_ndCPU + dir] = U;
+    int half_sites = latCPU->lattice_sitesCPU / 2;
+    
+    if (latCPU->layout != 1){
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(latCPU->threads)
+#endif
+        for (int i = 0; i < half_sites; i++){
+            su_n stap, U;
+            int gid;
+            PRNG_CL::PRNG *prng = prngCPU;
+#ifdef USE_OPENMP
+            if (latCPU->threads > 1) prng = latCPU->prng_threads[omp_get_thread_num()];
+#endif
+            gid = (par == 0) ? lattice_even_gid(lsize, i) : lattice_odd_gid(lsize, i);
+            stap = staple(latCPU, gid, dir);
+            U = latCPU->get_link(gid, dir);
+            if (prng->counter_based()) prng->PHILOX_keyed_start(latCPU->sweep, gid, dir);
+            update_link(&U, stap, (latCPU->beta / latCPU->lattice_group), latCPU->nhit, gid, (latCPU->ints == 2), latCPU->lattice_sitesCPU, 1, prng);
+            latCPU->set_link(gid, dir, U);
+        }
+        return;
+    }
+    
+    // SoA layout: staples are computed for SIMD_WIDTH consecutive sites of the block at once,
+    // heat bath stays per link and consumes random numbers in the same order as above
+    int batches = (half_sites + SIMD_WIDTH - 1) / SIMD_WIDTH;
+    int block = (par * latCPU->lattice_ndCPU + dir) * latCPU->lattice_half_stride;
+    
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(latCPU->threads)
+#endif
+    for (int b = 0; b < batches; b++){
+        su_n stap[SIMD_WIDTH], U;
+        int gid[SIMD_WIDTH];
+        PRNG_CL::PRNG *prng = prngCPU;
+#ifdef USE_OPENMP
+        if (latCPU->threads > 1) prng = latCPU->prng_threads[omp_get_thread_num()];
+#endif
+        int count = (half_sites - b * SIMD_WIDTH < SIMD_WIDTH) ? (half_sites - b * SIMD_WIDTH) : SIMD_WIDTH;
+        for (int l = 0; l < SIMD_WIDTH; l++){
+            int i = b * SIMD_WIDTH + ((l < count) ? l : (count - 1));  // tail lanes repeat the last site
+            gid[l] = (par == 0) ? lattice_even_gid(lsize, i) : lattice_odd_gid(lsize, i);
+        }
+        staple_batch(latCPU, gid, par, dir, stap);
+        for (int l = 0; l < count; l++){
+            int index = block + gid[l] / 2;
+            U = latCPU->get_plane_link(index);
+            if (prng->counter_based()) prng->PHILOX_keyed_start(latCPU->sweep, gid[l], dir);
+            update_link(&U, stap[l], (latCPU->beta / latCPU->lattice_group), latCPU->nhit, gid[l], (latCPU->ints == 2), latCPU->lattice_sitesCPU, 1, prng);
+            latCPU->set_plane_link(index, U);
+        }
     }
 }
 
+template <typename su_n>
+void lattice_update_even(modelCPU<su_n> *latCPU, int dir, PRNG_CL::PRNG *prngCPU){
+    lattice_update_parity(latCPU, dir, 0, prngCPU);
+}
+
 template <typename su_n>
 void lattice_update_odd(modelCPU<su_n> *latCPU, int dir, PRNG_CL::PRNG *prngCPU){
-    su_n stap, U;
-    int gid;
-    
+    lattice_update_parity(latCPU, dir, 1, prngCPU);
+}
+
+// over-relaxation of one (direction, parity) block: deterministic, so it neither touches the PRNG
+// nor depends on the thread count
+template <typename su_n>
+void lattice_overrelax_parity(modelCPU<su_n> *latCPU, int dir, int par){
     coords_4 lsize;
     lsize.x = latCPU->lattice_size[0];
     lsize.y = latCPU->lattice_size[1];
     lsize.z = latCPU->lattice_size[2];
     lsize.t = latCPU->lattice_size[3];
     
-    for (int i = 0; i < latCPU->lattice_sitesCPU / 2; i++){
-        gid = lattice_odd_gid(lsize, i);
-        stap = staple(latCPU, gid, dir);
-        U = latCPU->lattice_tableCPU[gid * latCPU->lattice_ndCPU + dir];
-        update_link(&U, stap, (latCPU->beta / latCPU->lattice_group), latCPU->nhit, gid, (latCPU->ints == 2), latCPU->lattice_sitesCPU, 1, prngCPU);
-        latCPU->lattice_tableCPU[gid * latCPU->lattice_ndCPU + dir] = U;
+    int half_sites = latCPU->lattice_sitesCPU / 2;
+    
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(latCPU->threads)
+#endif
+    for (int i = 0; i < half_sites; i++){
+        int gid = (par == 0) ? lattice_even_gid(lsize, i) : lattice_odd_gid(lsize, i);
+        su_n U = latCPU->get_link(gid, dir);
+        overrelax_link(&U, staple(latCPU, gid, dir), 1);
+        latCPU->set_link(gid, dir, U);
     }
 }
 
+// nor over-relaxation sweeps in the same odd/even, X..T order as the heat bath sweep
+template <typename su_n>
+void lattice_overrelax(modelCPU<su_n> *latCPU, int nor){
+    for (int k = 0; k < nor; k++)
+        for (int par = 1; par >= 0; par--)
+            for (int dir = X; dir <= T; dir++)
+                lattice_overrelax_parity(latCPU, dir, par);
+}
+
 #endif
@@ -78,7 +78,7 @@ void update_link(su_2 *a, su_2 stap, hgpu_double beta, int nhit, int gid, int gi
             rnd[1] = (float) (((double) rand()) / ((double) RAND_MAX + 1.0));
             rnd[2] = (float) (((double) rand()) / ((double) RAND_MAX + 1.0));
             rnd[3] = (float) (((double) rand()) / ((double) RAND_MAX + 1.0));*/
-            prngCPU->produce_CPU(rnd, 4);
+            prngCPU->produce_ring_CPU(rnd, 4);
         }
         cosrnd = cos(PI2 * rnd[1]);
         if(!gid_start){
@@ -98,7 +98,7 @@ void update_link(su_2 *a, su_2 stap, hgpu_double beta, int nhit, int gid, int gi
         } else {
             //rnd[0] = (float) (((double) rand()) / ((double) RAND_MAX + 1.0));
             //rnd[1] = (float) (((double) rand()) / ((double) RAND_MAX + 1.0));
-            prngCPU->produce_CPU(rnd, 2);
+            prngCPU->produce_ring_CPU(rnd, 2);
         }
             cosal = 1.0 - delta;
             costh = 2.0 * rnd[0] - 1.0;
@@ -124,3 +124,37 @@ void update_link(su_2 *a, su_2 stap, hgpu_double beta, int nhit, int gid, int gi
     if ((!final) && (!flag))
         lattice_unity(a);
 }
+
+// microcanonical over-relaxation (no random numbers): with V = stap / sqrt(det(stap)),
+// final = 1 (SU(2) link):        U -> V^+ U^+ V^+
+// final = 0 (SU(3) subgroup):    a -> V^+ V^+ (a is replaced by the subgroup rotation)
+// Re Tr(U stap) is unchanged in both cases
+void overrelax_link(su_2 *a, su_2 stap, int final){
+    su_2 aH;
+    hgpu_double Mx, My, Mz, Mw, det;
+    
+    Mx = (stap.u1.re + stap.v2.re);
+    My = (stap.u1.im - stap.v2.im);
+    Mz = (stap.u2.re - stap.v1.re);
+    Mw = (stap.u2.im + stap.v1.im);
+    
+    det = sqrt(Mx * Mx + My * My + Mz * Mz + Mw * Mw);
+    if (det <= 0.0){
+        if (!final) lattice_unity(a);
+        return;
+    }
+    
+    aH.u1.re =  Mx / det;
+    aH.u1.im = -My / det;
+    aH.u2.re = -Mz / det;
+    aH.u2.im = -Mw / det;
+    aH.v2.re =  aH.u1.re;
+    aH.v2.im = -aH.u1.im;
+    aH.v1.re = -aH.u2.re;
+    aH.v1.im =  aH.u2.im;
+    
+    if (final)
+        *a = aH * Herm(*a) * aH;
+    else
+        *a = aH * aH;
+}
@@ -42,5 +42,6 @@
 #include"../../random/random.h"
 
 void update_link(su_2 *U, su_2 stap, hgpu_double beta, int nhit, int gid, int gid_start, int fsites, int final, PRNG_CL::PRNG *prngCPU);
+void overrelax_link(su_2 *a, su_2 stap, int final);
 
 #endif
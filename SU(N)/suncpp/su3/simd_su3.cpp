@@ -0,0 +1,178 @@
+/******************************************************************************
+ * @file     simd_su3.cpp
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Structure-of-arrays SU(3) pack transfers and SIMD micro-benchmark
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+
+#include "simd_su3.h"
+#include <string.h>
+#include <time.h>
+
+// reals = 12 (compressed storage): the third row is not stored and is reconstructed
+void su3_pack_gather(su3_pack *a, const hgpu_float *planes, int stride, const int *index, int reals){
+    hgpu_float lane[SIMD_WIDTH];
+    for (int r = 0; r < reals; r++){
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            lane[l] = planes[r * stride + index[l]];
+        (*a).e[r] = simd_load(lane);
+    }
+    if (reals < SU3_REALS) su3_pack_reconstruct(a);
+}
+
+void su3_pack_load(su3_pack *a, const hgpu_float *planes, int stride, int index){
+    for (int r = 0; r < SU3_REALS; r++)
+        (*a).e[r] = simd_load(&planes[r * stride + index]);
+}
+
+void su3_pack_from_su3(su3_pack *a, const su_3 *m){
+    hgpu_float lane[SIMD_WIDTH];
+    for (int r = 0; r < SU3_REALS; r++){
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            lane[l] = ((const hgpu_float*) &m[l])[r];
+        (*a).e[r] = simd_load(lane);
+    }
+}
+
+void su3_pack_to_su3(const su3_pack *a, su_3 *m){
+    hgpu_float lane[SIMD_WIDTH];
+    for (int r = 0; r < SU3_REALS; r++){
+        simd_store(lane, (*a).e[r]);
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            ((hgpu_float*) &m[l])[r] = lane[l];
+    }
+}
+
+// Compares SIMD kernels with the scalar su_3 algebra bit by bit and measures matrix products per second
+void su3_simd_benchmark(int products){
+    const int count = 64 * SIMD_WIDTH;      // matrices per operand set (stays in L1/L2 cache)
+    su_3 *a  = (su_3*) calloc(count, sizeof(su_3));
+    su_3 *b  = (su_3*) calloc(count, sizeof(su_3));
+    su_3 *c  = (su_3*) calloc(count, sizeof(su_3));
+    su_3 *cs = (su_3*) calloc(count, sizeof(su_3));
+    hgpu_float *tr  = (hgpu_float*) calloc(count, sizeof(hgpu_float));
+    hgpu_float *trs = (hgpu_float*) calloc(count, sizeof(hgpu_float));
+    su3_pack pa, pb, pc;
+    
+    for (int i = 0; i < count; i++){
+        lattice_matrixGID(&a[i], i, 0, count);
+        lattice_matrixGID(&b[i], i, 1, count);
+    }
+    
+    printf("SU(3) SIMD kernels: %s, %i links per instruction, double precision\n", SIMD_ISA, SIMD_WIDTH);
+    
+    //--- bitwise check ------------------------------------------------------------
+    int mismatch_mul = 0, mismatch_herm = 0, mismatch_retr = 0, mismatch_rec = 0;
+    for (int i = 0; i < count; i += SIMD_WIDTH){
+        su3_pack_from_su3(&pa, &a[i]);
+        su3_pack_from_su3(&pb, &b[i]);
+        
+        su3_pack_mul<false, false>(&pc, &pa, &pb);
+        su3_pack_to_su3(&pc, &c[i]);
+        simd_store(&tr[i], su3_pack_retr(&pc));
+        for (int l = 0; l < SIMD_WIDTH; l++){
+            cs[i + l] = a[i + l] * b[i + l];
+            trs[i + l] = ReTr(cs[i + l]);
+        }
+        if (memcmp(&c[i], &cs[i], SIMD_WIDTH * sizeof(su_3)))           mismatch_mul++;
+        if (memcmp(&tr[i], &trs[i], SIMD_WIDTH * sizeof(hgpu_float)))   mismatch_retr++;
+        
+        su3_pack_mul<false, true>(&pc, &pa, &pb);
+        su3_pack_to_su3(&pc, &c[i]);
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            cs[i + l] = a[i + l] * Herm(b[i + l]);
+        if (memcmp(&c[i], &cs[i], SIMD_WIDTH * sizeof(su_3)))           mismatch_herm++;
+        
+        su3_pack_reconstruct(&pc);
+        su3_pack_to_su3(&pc, &c[i]);
+        for (int l = 0; l < SIMD_WIDTH; l++)
+            matrix_reconstruct(&cs[i + l]);
+        if (memcmp(&c[i], &cs[i], SIMD_WIDTH * sizeof(su_3)))           mismatch_rec++;
+    }
+    printf(" bitwise check (SIMD vs scalar): mul %s, Herm-mul %s, ReTr %s, reconstruct %s\n",
+        mismatch_mul  ? "FAILED" : "ok",
+        mismatch_herm ? "FAILED" : "ok",
+        mismatch_retr ? "FAILED" : "ok",
+        mismatch_rec  ? "FAILED" : "ok");
+    
+    //--- throughput ---------------------------------------------------------------
+    int rounds = products / count + 1;
+    hgpu_double checksum = 0.0;
+    
+    clock_t start = clock();
+    for (int k = 0; k < rounds; k++){
+        for (int i = 0; i < count; i++)
+            c[i] = a[i] * b[i];
+        checksum += c[k % count].u1.re;
+    }
+    double time_scalar = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+    
+    int packs = count / SIMD_WIDTH;
+    su3_pack *va = (su3_pack*) malloc(packs * sizeof(su3_pack) + 64);
+    su3_pack *vb = (su3_pack*) malloc(packs * sizeof(su3_pack) + 64);
+    su3_pack *vc = (su3_pack*) malloc(packs * sizeof(su3_pack) + 64);
+    su3_pack *pva = (su3_pack*) (((size_t) va + 63) & ~((size_t) 63));
+    su3_pack *pvb = (su3_pack*) (((size_t) vb + 63) & ~((size_t) 63));
+    su3_pack *pvc = (su3_pack*) (((size_t) vc + 63) & ~((size_t) 63));
+    
+    // packing of operands (AoS -> SoA) is timed on its own, the SIMD loop works on packed operands only
+    // and stores every product, as the scalar loop does
+    start = clock();
+    for (int k = 0; k < rounds; k++){
+        for (int i = 0; i < count; i += SIMD_WIDTH){
+            su3_pack_from_su3(&pva[i / SIMD_WIDTH], &a[i]);
+            su3_pack_from_su3(&pvb[i / SIMD_WIDTH], &b[i]);
+        }
+        simd_store(tr, pva[k % packs].e[0]);
+        checksum += tr[0];
+    }
+    double time_pack = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+    
+    start = clock();
+    for (int k = 0; k < rounds; k++){
+        for (int i = 0; i < packs; i++)
+            su3_pack_mul<false, false>(&pvc[i], &pva[i], &pvb[i]);
+        simd_store(tr, pvc[k % packs].e[0]);
+        checksum += tr[0];
+    }
+    double time_simd = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+    
+    double total = (double) rounds * count;
+    printf(" scalar : %12.0f products/s\n", (time_scalar > 0.0) ? total / time_scalar : 0.0);
+    printf(" SIMD   : %12.0f products/s (packed operands)\n", (time_simd > 0.0) ? total / time_simd : 0.0);
+    printf(" pack   : %12.0f operand pairs/s, SIMD with pack %12.0f products/s (checksum %f)\n",
+        (time_pack > 0.0) ? total / time_pack : 0.0, (time_simd + time_pack > 0.0) ? total / (time_simd + time_pack) : 0.0, checksum);
+    
+    free(va); free(vb); free(vc);
+    free(a); free(b); free(c); free(cs); free(tr); free(trs);
+}
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * @file     simd_su3.h
+ * @author   Vadim Demchik <vadimdi@yahoo.com>,
+ * @author   Natalia Kolomoyets <rknv7@mail.ru>
+ * @version  1.6
+ *
+ * @brief    [QCDGPU]
+ *           Structure-of-arrays SU(3) packs and SIMD (AVX2/AVX-512) matrix kernels for sequential CPU run
+ *
+ * @section  LICENSE
+ *
+ * Copyright (c) 2013-2016 Vadim Demchik, Natalia Kolomoyets
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *    Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *
+ *    Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * 
+ *****************************************************************************/
+
+#ifndef simd_su3_h
+#define simd_su3_h
+
+#include "algebra_su3.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// One SIMD register holds the same matrix element of SIMD_WIDTH links.
+// Host code always works with hgpu_float = double (see kernel/complex.h): AVX-512 - 8 links, AVX2 - 4, no SIMD - 1
+#if defined(__AVX512F__)
+#define SIMD_WIDTH      8
+#define SIMD_ISA        "AVX-512"
+typedef __m512d simd_float;
+inline simd_float simd_load(const hgpu_float *p)            {return _mm512_loadu_pd(p);}
+inline void       simd_store(hgpu_float *p, simd_float a)   {_mm512_storeu_pd(p, a);}
+inline simd_float simd_zero(void)                           {return _mm512_setzero_pd();}
+inline simd_float simd_add(simd_float a, simd_float b)      {return _mm512_add_pd(a, b);}
+inline simd_float simd_sub(simd_float a, simd_float b)      {return _mm512_sub_pd(a, b);}
+inline simd_float simd_mul(simd_float a, simd_float b)      {return _mm512_mul_pd(a, b);}
+inline simd_float simd_neg(simd_float a)                    {return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64((long long) 0x8000000000000000ULL)));}
+#elif defined(__AVX2__)
+#define SIMD_WIDTH      4
+#define SIMD_ISA        "AVX2"
+typedef __m256d simd_float;
+inline simd_float simd_load(const hgpu_float *p)            {return _mm256_loadu_pd(p);}
+inline void       simd_store(hgpu_float *p, simd_float a)   {_mm256_storeu_pd(p, a);}
+inline simd_float simd_zero(void)                           {return _mm256_setzero_pd();}
+inline simd_float simd_add(simd_float a, simd_float b)      {return _mm256_add_pd(a, b);}
+inline simd_float simd_sub(simd_float a, simd_float b)      {return _mm256_sub_pd(a, b);}
+inline simd_float simd_mul(simd_float a, simd_float b)      {return _mm256_mul_pd(a, b);}
+inline simd_float simd_neg(simd_float a)                    {return _mm256_xor_pd(a, _mm256_set1_pd(-0.0));}
+#else
+#define SIMD_WIDTH      1
+#define SIMD_ISA        "none"
+typedef hgpu_float simd_float;
+inline simd_float simd_load(const hgpu_float *p)            {return *p;}
+inline void       simd_store(hgpu_float *p, simd_float a)   {*p = a;}
+inline simd_float simd_zero(void)                           {return 0.0;}
+inline simd_float simd_add(simd_float a, simd_float b)      {return a + b;}
+inline simd_float simd_sub(simd_float a, simd_float b)      {return a - b;}
+inline simd_float simd_mul(simd_float a, simd_float b)      {return a * b;}
+inline simd_float simd_neg(simd_float a)                    {return -a;}
+#endif
+
+#define SU3_REALS   18      // reals per su_3 matrix (u1.re, u1.im, u2.re, ..., w3.im)
+
+// SIMD_WIDTH su_3 matrices in structure-of-arrays form: e[r] holds real number r of every link
+typedef struct su3_pack {
+                simd_float e[SU3_REALS];
+} su3_pack;
+
+    void su3_pack_gather(su3_pack *a, const hgpu_float *planes, int stride, const int *index, int reals);
+    void su3_pack_load(su3_pack *a, const hgpu_float *planes, int stride, int index);
+    void su3_pack_from_su3(su3_pack *a, const su_3 *m);
+    void su3_pack_to_su3(const su3_pack *a, su_3 *m);
+
+    void su3_simd_benchmark(int products);
+
+inline void su3_pack_zero(su3_pack *a){
+    for (int r = 0; r < SU3_REALS; r++) (*a).e[r] = simd_zero();
+}
+
+inline void su3_pack_add(su3_pack *a, const su3_pack *b){
+    for (int r = 0; r < SU3_REALS; r++) (*a).e[r] = simd_add((*a).e[r], (*b).e[r]);
+}
+
+// c = op(a) * op(b), op = Herm if herm_a/herm_b is set. Terms are summed in the order of
+// su_3 operator * (algebra_su3.cpp), and conjugation only flips signs, so every lane is
+// bitwise equal to the scalar product as long as the compiler does not contract mul/add into FMA
+template <bool herm_a, bool herm_b>
+inline void su3_pack_mul(su3_pack *c, const su3_pack *a, const su3_pack *b){
+    simd_float are[3][3], aim[3][3], bre[3][3], bim[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++){
+            are[i][j] = herm_a ? (*a).e[2 * (3 * j + i)] : (*a).e[2 * (3 * i + j)];
+            aim[i][j] = herm_a ? simd_neg((*a).e[2 * (3 * j + i) + 1]) : (*a).e[2 * (3 * i + j) + 1];
+            bre[i][j] = herm_b ? (*b).e[2 * (3 * j + i)] : (*b).e[2 * (3 * i + j)];
+            bim[i][j] = herm_b ? simd_neg((*b).e[2 * (3 * j + i) + 1]) : (*b).e[2 * (3 * i + j) + 1];
+        }
+    
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++){
+            simd_float re, im;
+            re = simd_mul(simd_neg(aim[i][0]), bim[0][j]);
+            re = simd_add(re, simd_mul(are[i][0], bre[0][j]));
+            re = simd_sub(re, simd_mul(aim[i][1], bim[1][j]));
+            re = simd_add(re, simd_mul(are[i][1], bre[1][j]));
+            re = simd_sub(re, simd_mul(aim[i][2], bim[2][j]));
+            re = simd_add(re, simd_mul(are[i][2], bre[2][j]));
+            
+            im = simd_mul(are[i][0], bim[0][j]);
+            im = simd_add(im, simd_mul(aim[i][0], bre[0][j]));
+            im = simd_add(im, simd_mul(are[i][1], bim[1][j]));
+            im = simd_add(im, simd_mul(aim[i][1], bre[1][j]));
+            im = simd_add(im, simd_mul(are[i][2], bim[2][j]));
+            im = simd_add(im, simd_mul(aim[i][2], bre[2][j]));
+            
+            (*c).e[2 * (3 * i + j)]     = re;
+            (*c).e[2 * (3 * i + j) + 1] = im;
+        }
+}
+
+// Third row from the first two, in the order of matrix_reconstruct (algebra_su3.cpp)
+inline void su3_pack_reconstruct(su3_pack *a){
+    simd_float *e = (*a).e;     // u1 = e[0,1], u2 = e[2,3], u3 = e[4,5], v1 = e[6,7], v2 = e[8,9], v3 = e[10,11]
+    e[12] = simd_add(simd_sub(simd_sub(simd_mul(e[5], e[9]), simd_mul(e[4], e[8])), simd_mul(e[3], e[11])), simd_mul(e[2], e[10]));
+    e[13] = simd_sub(simd_sub(simd_add(simd_mul(e[4], e[9]), simd_mul(e[5], e[8])), simd_mul(e[2], e[11])), simd_mul(e[3], e[10]));
+    e[14] = simd_sub(simd_add(simd_add(simd_mul(simd_neg(e[5]), e[7]), simd_mul(e[4], e[6])), simd_mul(e[1], e[11])), simd_mul(e[0], e[10]));
+    e[15] = simd_add(simd_add(simd_sub(simd_mul(simd_neg(e[4]), e[7]), simd_mul(e[5], e[6])), simd_mul(e[0], e[11])), simd_mul(e[1], e[10]));
+    e[16] = simd_add(simd_sub(simd_sub(simd_mul(e[3], e[7]), simd_mul(e[2], e[6])), simd_mul(e[1], e[9])), simd_mul(e[0], e[8]));
+    e[17] = simd_sub(simd_sub(simd_add(simd_mul(e[2], e[7]), simd_mul(e[3], e[6])), simd_mul(e[0], e[9])), simd_mul(e[1], e[8]));
+}
+
+inline simd_float su3_pack_retr(const su3_pack *a){
+    return simd_add(simd_add((*a).e[0], (*a).e[8]), (*a).e[16]);
+}
+
+#endif
@@ -112,3 +112,53 @@ void update_link(su_3 *U, su_3 stap, hgpu_double beta, int nhit, int gid, int gi
     
     *U = U0;
 }
+
+// over-relaxation of SU(3) link: microcanonical reflection in the three SU(2) subgroups (Cabibbo-Marinari order as in update_link)
+void overrelax_link(su_3 *U, su_3 stap, int final){
+    su_3 U0 = *U;
+    su_3 x0, Vg;
+    su_2 r0;
+    
+    x0 = U0 * stap;
+    
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  u2  0  \   //
+        r0.u2.re = x0.u2.re;    r0.u2.im = x0.u2.im;                               //   |  v1  v2  0  |   //
+        r0.v1.re = x0.v1.re;    r0.v1.im = x0.v1.im;                               //   \  0   0   1  /   //
+        r0.v2.re = x0.v2.re;    r0.v2.im = x0.v2.im;
+    overrelax_link(&r0, r0, 0);
+    
+    lattice_unity(&Vg);
+    Vg.u1 = r0.u1;  Vg.u2 = r0.u2;
+    Vg.v1 = r0.v1;  Vg.v2 = r0.v2;
+    
+    U0 = Vg * U0;
+    x0 = U0 * stap;
+    
+        r0.u1.re = x0.u1.re;    r0.u1.im = x0.u1.im;                               //   /  u1  0  u2  \   //
+        r0.u2.re = x0.u3.re;    r0.u2.im = x0.u3.im;                               //   |  0   1  0   |   //
+        r0.v1.re = x0.w1.re;    r0.v1.im = x0.w1.im;                               //   \  v1  0  v2  /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+    overrelax_link(&r0, r0, 0);
+    
+    lattice_unity(&Vg);
+    Vg.u1 = r0.u1;  Vg.u3 = r0.u2;
+    Vg.w1 = r0.v1;  Vg.w3 = r0.v2;
+    
+    U0 = Vg * U0;
+    x0 = U0 * stap;
+    
+        r0.u1.re = x0.v2.re;    r0.u1.im = x0.v2.im;                               //   /  1   0   0  \   //
+        r0.u2.re = x0.v3.re;    r0.u2.im = x0.v3.im;                               //   |  0   u1  u2 |   //
+        r0.v1.re = x0.w2.re;    r0.v1.im = x0.w2.im;                               //   \  0   v1  v2 /   //
+        r0.v2.re = x0.w3.re;    r0.v2.im = x0.w3.im;
+    overrelax_link(&r0, r0, 0);
+    
+    lattice_unity(&Vg);
+    Vg.v2 = r0.u1;  Vg.v3 = r0.u2;
+    Vg.w2 = r0.v1;  Vg.w3 = r0.v2;
+    
+    U0 = Vg * U0;
+    GramSchmidt(&U0);
+    
+    *U = U0;
+}
@@ -43,5 +43,6 @@
 #include"../../random/random.h"
 
 void update_link(su_3 *U, su_3 stap, hgpu_double beta, int nhit, int gid, int gid_start, int fsites, int final, PRNG_CL::PRNG *prngCPU);
+void overrelax_link(su_3 *U, su_3 stap, int final);
 
 #endif
@@ -45,11 +45,20 @@
 
 #include "su2/algebra_su2.h"
 #include "su3/algebra_su3.h"
+#include "su3/simd_su3.h"
 
 #include "Update/sun_update.h"
 #include "Measurements/Plq.h"
 #include "Measurements/S.h"
 #include "Measurements/analysis_cpp.h"
+#include "Smearing/smearing.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
 
 template <typename su_n>
 void lattice_simulateCPU(model_CL::model *lat, su_n *smth);
@@ -70,6 +79,28 @@ char*           get_current_datetime(time_t *ltime){
     return result;
 }
 
+// peak resident set size of the process in MB
+double          get_peak_rssCPU(void){
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return ((double) pmc.PeakWorkingSetSize) / (1024.0 * 1024.0);
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((double) usage.ru_maxrss) / 1024.0;    // ru_maxrss is in kB on Linux
+#endif
+}
+
+double          get_wtimeCPU(void){
+#ifdef USE_OPENMP
+    return omp_get_wtime();
+#else
+    return ((double) clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
 template <typename su_n>
 void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
         modelCPU<su_n> *latCPU = new(modelCPU<su_n>);
@@ -80,6 +111,7 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
             latCPU->lattice_size[i] = lat->lattice_full_size[i];
         latCPU->ints = (int)lat->ints;
         latCPU->nhit = (int)lat->NHIT;
+        latCPU->nor = (int)lat->NOR;
         latCPU->beta = (hgpu_float)lat->BETA;
         latCPU->lattice_group = (int)lat->lattice_group;
         latCPU->nav = (int)lat->NAV;
@@ -115,6 +147,23 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
         prngCPU->initialize_CPU();
         lat->PRNG0->initialize_CPU();
         
+#ifdef USE_OPENMP
+        if (lat->CPU_threads <= 0) lat->CPU_threads = omp_get_max_threads();
+#else
+        lat->CPU_threads = 1;
+#endif
+        latCPU->threads = lat->CPU_threads;
+        latCPU->create_prngCPU(lat->PRNG0);
+        latCPU->sweep = 0;
+        latCPU->neighbours_table = lat->CPU_neighbours_table;
+        latCPU->layout = lat->CPU_link_layout;
+        latCPU->compressed = lat->CPU_link_compress;
+        
+        if (lat->CPU_simd_benchmark > 0)
+            su3_simd_benchmark(lat->CPU_simd_benchmark);
+        if (lat->CPU_prng_benchmark > 0)
+            PRNG_CL::PRNG::benchmark_CPU(lat->CPU_prng_benchmark);
+        
         char* header = lat->lattice_make_header();
         printf("%s\n",header);
         
@@ -129,6 +178,10 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
         if(lat->get_actions_avr)
             meas->cs[0] = sConf(latCPU, &meas->ts[0]);
         
+        double time_update = 0.0;
+        double time_measurement = 0.0;
+        double time_stamp = get_wtimeCPU();
+        
         for(int n = 0; n < latCPU->nav; n++){
             lattice_update_odd(latCPU, X, lat->PRNG0);
             lattice_update_odd(latCPU, Y, lat->PRNG0);
@@ -139,11 +192,15 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
             lattice_update_even(latCPU, Y, lat->PRNG0);
             lattice_update_even(latCPU, Z, lat->PRNG0);
             lattice_update_even(latCPU, T, lat->PRNG0);
+            lattice_overrelax(latCPU, latCPU->nor);
+            latCPU->sweep++;
             
             if (n % 10 == 0) printf("\rCPU thermalization [%i]", n);
         }
+        time_update += get_wtimeCPU() - time_stamp;
         
         for(int i = 1; i < latCPU->iter; i++){
+            time_stamp = get_wtimeCPU();
             for(int n = 0; n < latCPU->niter; n++){
                 lattice_update_odd(latCPU, X, lat->PRNG0);
                 lattice_update_odd(latCPU, Y, lat->PRNG0);
@@ -154,12 +211,17 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
                 lattice_update_even(latCPU, Y, lat->PRNG0);
                 lattice_update_even(latCPU, Z, lat->PRNG0);
                 lattice_update_even(latCPU, T, lat->PRNG0);
+                lattice_overrelax(latCPU, latCPU->nor);
+                latCPU->sweep++;
             }
+            time_update += get_wtimeCPU() - time_stamp;
+            time_stamp = get_wtimeCPU();
             
             if(lat->get_plaquettes_avr)
                 meas->cplq[i] = plqConf(latCPU, &meas->tplq[i]);
             if(lat->get_actions_avr)
                 meas->cs[i] = sConf(latCPU, &meas->ts[i]);
+            time_measurement += get_wtimeCPU() - time_stamp;
             
             if (i % 10 == 0) printf("\rCPU working iteration [%u]",i);
         }
@@ -167,7 +229,24 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
         lat->timeend = get_current_datetime(&lat->ltimeend);
         printf("\rCPU simulations are done\n");
         
+        int sweeps = latCPU->nav + (latCPU->iter - 1) * latCPU->niter;
+        printf("Update time                 : %f seconds (%i sweeps, %f seconds per sweep)\n", time_update, sweeps, (sweeps > 0) ? time_update / sweeps : 0.0);
+        printf("Measurement time            : %f seconds\n", time_measurement);
+        printf("Lattice size                : %f MB (%i reals per link)\n", ((double) latCPU->lattice_memory) / (1024.0 * 1024.0), latCPU->link_reals);
+        printf("Peak RSS                    : %f MB\n", get_peak_rssCPU());
+        
+        if ((lat->smear_type > 0) && (lat->smear_steps > 0)){
+            modelCPU<su_n> *smear_buf[2] = {NULL, NULL};
+            hgpu_double smeared_plq;
+            modelCPU<su_n> *smeared = smear_lattice(latCPU, smear_buf, lat->smear_type, lat->smear_steps, lat->smear_alpha);
+            printf("Smeared spatial plaquette   : %.8f (%i steps)\n", plqConf(smeared, &smeared_plq).re, lat->smear_steps);
+            smear_delete(smear_buf[0]);
+            smear_delete(smear_buf[1]);
+        }
+        
         lattice_analysis_cpp(meas, Analysis);
+        if (meas->mask[0])
+            printf("Plaquette tau_int           : %f measurements (NITER = %i, NOR = %i)\n", Analysis[2].tau_int, latCPU->niter, latCPU->nor);
         
         int ii = 0;
         if (meas->mask[0]){
@@ -218,6 +297,7 @@ void lattice_simulateCPU(model_CL::model *lat, su_n *smth){
             ii += 3;
         }
 
+        latCPU->delete_prngCPU();
         delete (prngCPU);
         
         free(Analysis);
@@ -56,6 +56,8 @@
 
 #define N_MEAS_QUANTITIES 2
 
+#define LATTICE_SOA_PAD   8     // SoA block padding: widest SIMD register (AVX-512) holds 8 links
+
 template <typename su_n>
 class modelCPU{
 public:
@@ -63,6 +65,7 @@ public:
     int*    lattice_size;
     int     ints;
     int     nhit;
+    int     nor;
     hgpu_float beta;
     int     lattice_group;
     int nav;
@@ -73,9 +76,41 @@ public:
     
     su_n *lattice_tableCPU;
     
+    int layout;                     // link layout (0 - array of structs in lattice_tableCPU, 1 - structure of arrays in lattice_planes)
+    hgpu_float *lattice_planes;     // one plane per real number of su_n; plane = 2 parities x nd directions x lattice_half_stride links
+    int lattice_half_stride;        // half-lattice sites per (parity, direction) block, padded to a multiple of LATTICE_SOA_PAD
+    int lattice_planes_stride;      // reals per plane
+    int *lattice_plane_site;        // index of link (gid, dir = 0) in a plane: parity block + gid / 2 (link_index adds dir * lattice_half_stride)
+    
+    bool compressed;                // store lattice_group - 1 rows per link, the last row is rebuilt by matrix_reconstruct on load
+    int link_reals;                 // reals stored per link
+    hgpu_float *lattice_rowsCPU;    // compressed array of structs: link_reals per link (used instead of lattice_tableCPU)
+    size_t lattice_memory;          // bytes of link storage
+    
+    bool neighbours_table;          // use precomputed neighbour table (false - compute neighbours on the fly)
+    int *lattice_neighbours;        // neighbour table: 2 * nd gids per site (nd forward, then nd backward)
+    int lattice_stride[4];          // gid stride along each direction
+    
+    int threads;                    // number of threads for lattice update
+    PRNG_CL::PRNG **prng_threads;   // per-thread PRNG streams (prng_threads[0] is the master PRNG)
+    unsigned int sweep;             // number of finished sweeps (sweep part of PHILOX key)
+    
     void create_latticeCPU(void);
     void delete_latticeCPU(void);
     
+    inline int neighbour(int gid, int dir);
+    inline int neighbour_backward(int gid, int dir);
+    
+    inline int parity(int gid);
+    inline int link_index(int gid, int dir);
+    inline su_n get_link(int gid, int dir);
+    inline void set_link(int gid, int dir, su_n U);
+    inline su_n get_plane_link(int index);
+    inline void set_plane_link(int index, su_n U);
+    
+    void create_prngCPU(PRNG_CL::PRNG *prng);
+    void delete_prngCPU(void);
+    
     void lattice_initializeCPU(void);
 };
 
@@ -100,12 +135,156 @@ public:
 
 template <typename su_n>
 void modelCPU<su_n>::create_latticeCPU(void){
-    lattice_tableCPU = (su_n*)calloc(lattice_ndCPU * lattice_sitesCPU, sizeof(su_n));
+    lattice_tableCPU = NULL;
+    lattice_planes = NULL;
+    lattice_rowsCPU = NULL;
+    lattice_plane_site = NULL;
+    
+    // a row of su_n holds lattice_group complex numbers
+    link_reals = sizeof(su_n) / sizeof(hgpu_float);
+    if (compressed) link_reals -= 2 * lattice_group;
+    
+    if (layout == 1){
+        // even and odd sites come in pairs (gid = 2i, 2i + 1), so a site sits at gid / 2 inside its parity block
+        lattice_half_stride   = ((lattice_sitesCPU / 2 + LATTICE_SOA_PAD - 1) / LATTICE_SOA_PAD) * LATTICE_SOA_PAD;
+        lattice_planes_stride = 2 * lattice_ndCPU * lattice_half_stride;
+        lattice_memory = (size_t) link_reals * lattice_planes_stride * sizeof(hgpu_float);
+        lattice_planes = (hgpu_float*)calloc(link_reals * lattice_planes_stride, sizeof(hgpu_float));
+    } else if (compressed){
+        lattice_memory = (size_t) link_reals * lattice_ndCPU * lattice_sitesCPU * sizeof(hgpu_float);
+        lattice_rowsCPU = (hgpu_float*)calloc(link_reals * lattice_ndCPU * lattice_sitesCPU, sizeof(hgpu_float));
+    } else {
+        lattice_memory = (size_t) lattice_ndCPU * lattice_sitesCPU * sizeof(su_n);
+        lattice_tableCPU = (su_n*)calloc(lattice_ndCPU * lattice_sitesCPU, sizeof(su_n));
+    }
+    
+    // gid = y + z * Ny + t * Ny * Nz + x * Ny * Nz * Nt (see lattice_coords_to_gid)
+    lattice_stride[Y] = 1;
+    lattice_stride[Z] = lattice_size[1];
+    lattice_stride[T] = lattice_size[1] * lattice_size[2];
+    lattice_stride[X] = lattice_size[1] * lattice_size[2] * lattice_size[3];
+    
+    if (layout == 1){
+        // parity of a site costs nd div/mod pairs, so the plane index of every site is tabulated once
+        lattice_plane_site = (int*)calloc(lattice_sitesCPU, sizeof(int));
+        for (int gid = 0; gid < lattice_sitesCPU; gid++)
+            lattice_plane_site[gid] = parity(gid) * lattice_ndCPU * lattice_half_stride + gid / 2;
+    }
+    
+    lattice_neighbours = NULL;
+    if (neighbours_table){
+        coords_4 lsize;
+        lsize.x = lattice_size[0];
+        lsize.y = lattice_size[1];
+        lsize.z = lattice_size[2];
+        lsize.t = lattice_size[3];
+        
+        int nd2 = 2 * lattice_ndCPU;
+        lattice_neighbours = (int*)calloc(nd2 * lattice_sitesCPU, sizeof(int));
+        for (int gid = 0; gid < lattice_sitesCPU; gid++)
+            for (int dir = 0; dir < lattice_ndCPU; dir++){
+                lattice_neighbours[gid * nd2 + dir]                 = lattice_neighbours_coords(lsize, gid, dir);
+                lattice_neighbours[gid * nd2 + lattice_ndCPU + dir] = lattice_neighbours_coords_backward(lsize, gid, dir);
+            }
+    }
 };
 
 template <typename su_n>
 void modelCPU<su_n>::delete_latticeCPU(void){
-    free(lattice_tableCPU);
+    if (lattice_tableCPU) free(lattice_tableCPU);
+    if (lattice_planes) free(lattice_planes);
+    if (lattice_rowsCPU) free(lattice_rowsCPU);
+    if (lattice_neighbours) free(lattice_neighbours);
+    if (lattice_plane_site) free(lattice_plane_site);
+};
+
+template <typename su_n>
+inline int modelCPU<su_n>::parity(int gid){
+    int sum = 0;
+    for (int dir = 0; dir < lattice_ndCPU; dir++)
+        sum += (gid / lattice_stride[dir]) % lattice_size[dir];
+    return sum & 1;
+};
+
+template <typename su_n>
+inline int modelCPU<su_n>::link_index(int gid, int dir){
+    return lattice_plane_site[gid] + dir * lattice_half_stride;
+};
+
+template <typename su_n>
+inline su_n modelCPU<su_n>::get_plane_link(int index){
+    su_n U;
+    for (int r = 0; r < link_reals; r++)
+        ((hgpu_float*) &U)[r] = lattice_planes[r * lattice_planes_stride + index];
+    if (compressed) matrix_reconstruct(&U);
+    return U;
+};
+
+template <typename su_n>
+inline void modelCPU<su_n>::set_plane_link(int index, su_n U){
+    for (int r = 0; r < link_reals; r++)
+        lattice_planes[r * lattice_planes_stride + index] = ((hgpu_float*) &U)[r];
+};
+
+template <typename su_n>
+inline su_n modelCPU<su_n>::get_link(int gid, int dir){
+    if (layout == 1) return get_plane_link(link_index(gid, dir));
+    if (!compressed) return lattice_tableCPU[gid * lattice_ndCPU + dir];
+    
+    su_n U;
+    memcpy(&U, &lattice_rowsCPU[(gid * lattice_ndCPU + dir) * link_reals], link_reals * sizeof(hgpu_float));
+    matrix_reconstruct(&U);
+    return U;
+};
+
+template <typename su_n>
+inline void modelCPU<su_n>::set_link(int gid, int dir, su_n U){
+    if (layout == 1)
+        set_plane_link(link_index(gid, dir), U);
+    else if (!compressed)
+        lattice_tableCPU[gid * lattice_ndCPU + dir] = U;
+    else
+        memcpy(&lattice_rowsCPU[(gid * lattice_ndCPU + dir) * link_reals], &U, link_reals * sizeof(hgpu_float));
+};
+
+template <typename su_n>
+inline int modelCPU<su_n>::neighbour(int gid, int dir){
+    if (neighbours_table) return lattice_neighbours[gid * 2 * lattice_ndCPU + dir];
+    
+    int coord = (gid / lattice_stride[dir]) % lattice_size[dir];
+    return (coord == lattice_size[dir] - 1) ? (gid - coord * lattice_stride[dir]) : (gid + lattice_stride[dir]);
+};
+
+template <typename su_n>
+inline int modelCPU<su_n>::neighbour_backward(int gid, int dir){
+    if (neighbours_table) return lattice_neighbours[gid * 2 * lattice_ndCPU + lattice_ndCPU + dir];
+    
+    int coord = (gid / lattice_stride[dir]) % lattice_size[dir];
+    return (coord == 0) ? (gid + (lattice_size[dir] - 1) * lattice_stride[dir]) : (gid - lattice_stride[dir]);
+};
+
+template <typename su_n>
+void modelCPU<su_n>::create_prngCPU(PRNG_CL::PRNG *prng){
+    prng_threads = (PRNG_CL::PRNG**)calloc(threads, sizeof(PRNG_CL::PRNG*));
+    prng_threads[0] = prng;
+    // every additional thread gets its own stream, seeded by splitmix64 of (master series, thread),
+    // so a fixed RANDSERIES reproduces the run for a fixed number of threads;
+    // counter-based generators share the master seed (PHILOX key), their PRNs depend on the link only
+    for (int t = 1; t < threads; t++){
+        prng_threads[t] = new(PRNG_CL::PRNG);
+        prng_threads[t]->PRNG_generator = prng->PRNG_generator;
+        prng_threads[t]->PRNG_precision = prng->PRNG_precision;
+        prng_threads[t]->PRNG_randseries = prng->PRNG_srandtime;
+        prng_threads[t]->PRNG_stream     = t;
+        prng_threads[t]->initialize_CPU();
+    }
+};
+
+template <typename su_n>
+void modelCPU<su_n>::delete_prngCPU(void){
+    for (int t = 1; t < threads; t++)
+        delete(prng_threads[t]);
+    free(prng_threads);
 };
 
 template <typename su_n>
@@ -116,15 +295,21 @@ void modelCPU<su_n>::lattice_initializeCPU(void){
             break;
         case 1: 
             {
-                for (int gid = 0; gid < lattice_ndCPU * lattice_sitesCPU; gid++)
-                    lattice_unity(&lattice_tableCPU[gid]);
+                su_n U;
+                lattice_unity(&U);
+                for (int gid = 0; gid < lattice_sitesCPU; gid++)
+                    for (int dir = 0; dir < lattice_ndCPU; dir++)
+                        set_link(gid, dir, U);
             }
             break;
         case 2 :
             {
+                su_n U;
                 for (int gid = 0; gid < lattice_sitesCPU; gid++)
-                    for (int dir = 0; dir < lattice_ndCPU; dir++)
-                        lattice_matrixGID(&lattice_tableCPU[gid * lattice_ndCPU + dir], gid, dir, lattice_sitesCPU);
+                    for (int dir = 0; dir < lattice_ndCPU; dir++){
+                        lattice_matrixGID(&U, gid, dir, lattice_sitesCPU);
+                        set_link(gid, dir, U);
+                    }
             }
             break;
     }